@@ -37,29 +37,31 @@ struct LPF_CBQF {
 
 void LPF_init(struct LPF *lpf, Q15_t Q, Q15_t fc)
 {
-	lpf->iQ = RECIP_Q15(Q);
+	lpf->iQ = RECIP_QW(Q15_to_QW(Q));
 	lpf->fc = fc;
 }
 
 void LPF_setSamplingPeriod(struct LPF *lpf, Q15_t dT)
 {
 	
-	Q15_t tmp, k2;
-#if 1
+	Q15_t tmp;
+	QW_t k2;
+
 	tmp = MUL_Q15(q15_pi, lpf->fc);
 	tmp = MUL_Q15(tmp, dT);
-#else
-	tmp = MUL_Q15(q15_pi, q15_c1);
-#endif
-	lpf->K = tan_q15(tmp);
-	k2 = MUL_Q15(lpf->K, lpf->K);
+	/* K only sets the cut off, Q15 is plenty */
+	lpf->K = Q15_to_QW(tan_q15(tmp));
+	k2 = MUL_QW(lpf->K, lpf->K);
 	
-	lpf->iD = RECIP_Q15(k2 + MUL_Q15(lpf->K, lpf->iQ) + q15_c1);
-	lpf->a0 = MUL_Q15(k2, lpf->iD);
-	lpf->a1 = MUL_Q15(q15_c2, lpf->a0);
-	lpf->b1 = MUL_Q15(q15_c2, lpf->iD);
-	lpf->b1 = MUL_Q15(k2 - q15_c1, lpf->b1);
-	lpf->b2 = MUL_Q15(lpf->iD, (k2 - MUL_Q15(lpf->K, lpf->iQ) + q15_c1));
+	lpf->iD = RECIP_QW(k2 + MUL_QW(lpf->K, lpf->iQ) + QW_ONE);
+	lpf->a0 = MUL_QW(k2, lpf->iD);
+	lpf->a1 = 2 * lpf->a0;
+	lpf->b1 = MUL_QW(k2 - QW_ONE, 2 * lpf->iD);
+	/*
+	 * b2 = (k2 - K/Q + 1) * iD, but taken from 1 + b1 + b2 = 4*a0 so
+	 * that the rounding of the coefficients does not move the DC gain
+	 */
+	lpf->b2 = 4 * lpf->a0 - QW_ONE - lpf->b1;
 }
 
 Q15_t LPF_BQF_init(struct LPF *lpf, Q15_t x)
@@ -69,18 +71,27 @@ Q15_t LPF_BQF_init(struct LPF *lpf, Q15_t x)
 
 	lpf->y1 = x;
 	lpf->y2 = x;
+	lpf->err = 0;
 
 	return x;
 }
 
 Q15_t LPF_BQF_data(struct LPF *lpf, Q15_t x)
 {
+	int64_t acc;
 	Q15_t y;
 
-	y = MUL_Q15((x+lpf->x2), lpf->a0);
-	y += MUL_Q15(lpf->x1, lpf->a1);
-	y -= MUL_Q15(lpf->y1, lpf->b1);
-	y -= MUL_Q15(lpf->y2, lpf->b2);
+	/*
+	 * Q15 x QW. The part of the sum dropped by the shift is carried
+	 * into the next sample, otherwise the feedback holds a DC error
+	 * of up to 1/(1 + b1 + b2) lsb.
+	 */
+	acc = (int64_t)(x + lpf->x2) * lpf->a0 +
+		(int64_t)lpf->x1 * lpf->a1 -
+		(int64_t)lpf->y1 * lpf->b1 -
+		(int64_t)lpf->y2 * lpf->b2 + lpf->err;
+	y = acc >> QW_SHIFT;
+	lpf->err = acc - ((int64_t)y << QW_SHIFT);
 
 	lpf->x2 = lpf->x1;
 	lpf->y2 = lpf->y1;
@@ -90,6 +101,44 @@ Q15_t LPF_BQF_data(struct LPF *lpf, Q15_t x)
 	return y;
 }
 
+/*
+ * n samples, every stride'th Q15_t of in and out (in may be out).
+ * Same arithmetic as LPF_BQF_data, with coefficients and state kept
+ * in locals across the block. There is no packed 16 bit (M4 SIMD)
+ * form: the signal has 17 integer bits, each tap needs a 32x32->64
+ * multiply-accumulate (SMLAL on M3/M4).
+ */
+void LPF_BQF_block(struct LPF *lpf, const Q15_t *in, Q15_t *out, int n, int stride)
+{
+	const QW_t a0 = lpf->a0, a1 = lpf->a1, b1 = lpf->b1, b2 = lpf->b2;
+	Q15_t x1 = lpf->x1, x2 = lpf->x2, y1 = lpf->y1, y2 = lpf->y2;
+	int64_t err = lpf->err, acc;
+	Q15_t x, y;
+
+	while (n-- > 0) {
+		x = *in;
+		acc = (int64_t)(x + x2) * a0 +
+			(int64_t)x1 * a1 -
+			(int64_t)y1 * b1 -
+			(int64_t)y2 * b2 + err;
+		y = acc >> QW_SHIFT;
+		err = acc - ((int64_t)y << QW_SHIFT);
+		*out = y;
+
+		x2 = x1;
+		x1 = x;
+		y2 = y1;
+		y1 = y;
+		in += stride;
+		out += stride;
+	}
+
+	lpf->x1 = x1;
+	lpf->x2 = x2;
+	lpf->y1 = y1;
+	lpf->y2 = y2;
+	lpf->err = err;
+}
 
 void LPF_CBQF_init(struct LPF_CBQF *clpf, struct LPF *lpf, Q15_t x)
 {
@@ -106,6 +155,64 @@ Q15_t LPF_CBQF_data(struct LPF_CBQF *clpf, Q15_t x)
 	return LPF_BQF_data(&clpf->mB, LPF_BQF_data(&clpf->mA, x));
 }
 
+/*
+ * Both sections per sample, as LPF_CBQF_data. Running mA over the
+ * block and then mB leaves a single recursion per loop whose multiply
+ * and shift latency nothing else can hide; that was slower than the
+ * per sample filter of three axes. Two sections keep 18 values live.
+ */
+void LPF_CBQF_block(struct LPF_CBQF *clpf, const Q15_t *in, Q15_t *out, int n, int stride)
+{
+	struct LPF *A = &clpf->mA, *B = &clpf->mB;
+	const QW_t a0 = A->a0, a1 = A->a1, b1 = A->b1, b2 = A->b2;
+	const QW_t c0 = B->a0, c1 = B->a1, d1 = B->b1, d2 = B->b2;
+	Q15_t ax1 = A->x1, ax2 = A->x2, ay1 = A->y1, ay2 = A->y2;
+	Q15_t bx1 = B->x1, bx2 = B->x2, by1 = B->y1, by2 = B->y2;
+	int64_t aerr = A->err, berr = B->err, acc;
+	Q15_t x, y;
+
+	while (n-- > 0) {
+		x = *in;
+		acc = (int64_t)(x + ax2) * a0 +
+			(int64_t)ax1 * a1 -
+			(int64_t)ay1 * b1 -
+			(int64_t)ay2 * b2 + aerr;
+		y = acc >> QW_SHIFT;
+		aerr = acc - ((int64_t)y << QW_SHIFT);
+		ax2 = ax1;
+		ax1 = x;
+		ay2 = ay1;
+		ay1 = y;
+
+		x = y;
+		acc = (int64_t)(x + bx2) * c0 +
+			(int64_t)bx1 * c1 -
+			(int64_t)by1 * d1 -
+			(int64_t)by2 * d2 + berr;
+		y = acc >> QW_SHIFT;
+		berr = acc - ((int64_t)y << QW_SHIFT);
+		bx2 = bx1;
+		bx1 = x;
+		by2 = by1;
+		by1 = y;
+
+		*out = y;
+		in += stride;
+		out += stride;
+	}
+
+	A->x1 = ax1;
+	A->x2 = ax2;
+	A->y1 = ay1;
+	A->y2 = ay2;
+	A->err = aerr;
+	B->x1 = bx1;
+	B->x2 = bx2;
+	B->y1 = by1;
+	B->y2 = by2;
+	B->err = berr;
+}
+
 #if 0
 int main(int argc, char **argv)
 {
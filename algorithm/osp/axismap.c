@@ -0,0 +1,110 @@
+/*
+ * (C) Copyright 2015 HY Research LLC
+ *     Author: hy-git@hy-research.com
+ *
+ * Apache License.
+ *
+ */
+
+/*
+ * Sensor to device axis mapping. The AxisMapping[] of a sensor
+ * descriptor is resolved once, when the sensor is registered, into a
+ * permutation and a sign per device axis; each sample is then mapped
+ * without branches.
+ */
+#include "axismap.h"
+
+/*
+ * AxisMapping[i] names the device axis (and its sign) of sensor axis
+ * i. Device axes that no sensor axis maps to keep the identity.
+ */
+void OSP_axismap_compile(const AxisMapType_t mapping[3], struct AxisMap *map)
+{
+	int i, axis;
+
+	for (i = 0; i < 3; i++) {
+		map->idx[i] = i;
+		map->sign[i] = 1;
+	}
+	for (i = 0; i < 3; i++) {
+		if (mapping[i] < AXIS_MAP_POSITIVE_X ||
+			mapping[i] > AXIS_MAP_NEGATIVE_Z)
+			continue;
+		axis = (mapping[i] - AXIS_MAP_POSITIVE_X) >> 1;
+		map->idx[axis] = i;
+		map->sign[axis] = ((mapping[i] - AXIS_MAP_POSITIVE_X) & 1) ? -1 : 1;
+	}
+}
+
+/* The offset is indexed by sensor axis, as the mapping */
+void OSP_axismap_apply(const struct AxisMap *map, const int32_t in[3],
+			const int32_t offset[3], int32_t out[3])
+{
+	out[0] = map->sign[0] * in[map->idx[0]] - offset[map->idx[0]];
+	out[1] = map->sign[1] * in[map->idx[1]] - offset[map->idx[1]];
+	out[2] = map->sign[2] * in[map->idx[2]] - offset[map->idx[2]];
+}
+
+#ifdef TEST_AXISMAP
+/*
+ * Runs all 48 sensor orientations (6 axis permutations x 8 sign
+ * combinations) against the mapping they describe, e.g.
+ *	gcc -DTEST_AXISMAP -Iinclude -I../../include axismap.c
+ */
+#include <stdio.h>
+
+static const int perm[6][3] = {
+	{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+};
+
+int main(int argc, char **argv)
+{
+	static const int32_t in[3] = { 1000, -20000, 300000 };
+	static const int32_t offset[3] = { 7, -11, 13 };
+	AxisMapType_t mapping[3];
+	struct AxisMap map;
+	int32_t out[3], want[3];
+	int p, s, i, det, n = 0, rot = 0, fail = 0;
+
+	for (p = 0; p < 6; p++) {
+		for (s = 0; s < 8; s++) {
+			/* sensor axis i is device axis perm[p][i], negated if bit i of s */
+			for (i = 0; i < 3; i++) {
+				mapping[i] = AXIS_MAP_POSITIVE_X + 2 * perm[p][i] + ((s >> i) & 1);
+				want[perm[p][i]] = ((s >> i) & 1 ? -in[i] : in[i]) - offset[i];
+			}
+			OSP_axismap_compile(mapping, &map);
+			OSP_axismap_apply(&map, in, offset, out);
+			if (out[0] != want[0] || out[1] != want[1] || out[2] != want[2]) {
+				printf("FAIL mapping %d %d %d: %d %d %d, want %d %d %d\n",
+					mapping[0], mapping[1], mapping[2],
+					out[0], out[1], out[2], want[0], want[1], want[2]);
+				fail++;
+			}
+
+			/* proper rotations: permutation parity times sign parity */
+			det = (p == 0 || p == 3 || p == 4) ? 1 : -1;
+			for (i = 0; i < 3; i++)
+				det *= map.sign[i];
+			if (det > 0)
+				rot++;
+			n++;
+		}
+	}
+
+	/* unmapped axes stay in place */
+	mapping[0] = AXIS_MAP_NEGATIVE_Y;
+	mapping[1] = AXIS_MAP_UNUSED;
+	mapping[2] = AXIS_MAP_UNUSED;
+	OSP_axismap_compile(mapping, &map);
+	OSP_axismap_apply(&map, in, offset, out);
+	if (out[0] != in[0] - offset[0] || out[1] != -in[0] - offset[0] ||
+		out[2] != in[2] - offset[2]) {
+		printf("FAIL partial mapping: %d %d %d\n", out[0], out[1], out[2]);
+		fail++;
+	}
+
+	printf("%d orientations (%d rotations), %d failed\n", n, rot, fail);
+	return fail != 0;
+}
+#endif
@@ -0,0 +1,17 @@
+#ifndef _AXISMAP_H_
+#define _AXISMAP_H_
+
+#include <stdint.h>
+#include "osp-api.h"
+
+/* Device x, y, z = sign[k] * sensor axis idx[k] */
+struct AxisMap {
+	uint8_t idx[3];
+	int8_t sign[3];
+};
+
+void OSP_axismap_compile(const AxisMapType_t mapping[3], struct AxisMap *map);
+void OSP_axismap_apply(const struct AxisMap *map, const int32_t in[3],
+			const int32_t offset[3], int32_t out[3]);
+
+#endif
@@ -1,5 +1,6 @@
 /*
- * Approximate atan2
+ * Approximate atan2. Implementation selected by FP_ATAN_MODE, see
+ * fpsup.h.
  */
 
 #include <stdio.h>
@@ -7,35 +8,147 @@
 #include <stdlib.h>
 #include "fpsup.h"
 
+#define Q30(v)	((int64_t)((v) * (double)(1 << 30) + 0.5))
+
+/* rounded, M_PI may only be single precision */
+#define ATAN_PI		3.14159265358979323846
+static const Q15_t q15_pi_r = (Q15_t)(ATAN_PI * (1 << Q15_SHIFT) + 0.5);
+static const Q15_t q15_pi_2 = (Q15_t)(ATAN_PI/2.0 * (1 << Q15_SHIFT) + 0.5);
+
+#if (FP_ATAN_MODE == FP_MATH_TABLE)
+/* atan(i / ATAN_SEGMENTS), Q15 */
+#define ATAN_SEGMENTS	256
+
+static const uint16_t atan_table[ATAN_SEGMENTS + 1] = {
+	0, 128, 256, 384, 512, 640, 768, 896, 1024, 1152,
+	1279, 1407, 1535, 1663, 1790, 1918, 2045, 2173, 2300, 2428,
+	2555, 2682, 2809, 2936, 3063, 3190, 3317, 3443, 3570, 3696,
+	3823, 3949, 4075, 4201, 4327, 4452, 4578, 4703, 4829, 4954,
+	5079, 5204, 5329, 5453, 5578, 5702, 5826, 5950, 6073, 6197,
+	6320, 6444, 6567, 6689, 6812, 6935, 7057, 7179, 7301, 7422,
+	7544, 7665, 7786, 7907, 8027, 8148, 8268, 8388, 8508, 8627,
+	8746, 8865, 8984, 9102, 9221, 9339, 9456, 9574, 9691, 9808,
+	9925, 10041, 10158, 10274, 10389, 10505, 10620, 10735, 10849, 10964,
+	11078, 11192, 11305, 11418, 11531, 11644, 11756, 11868, 11980, 12092,
+	12203, 12314, 12424, 12535, 12645, 12754, 12864, 12973, 13082, 13190,
+	13298, 13406, 13514, 13621, 13728, 13835, 13941, 14047, 14153, 14258,
+	14363, 14468, 14573, 14677, 14781, 14884, 14987, 15090, 15193, 15295,
+	15397, 15499, 15600, 15701, 15801, 15902, 16002, 16101, 16201, 16300,
+	16398, 16497, 16595, 16693, 16790, 16887, 16984, 17080, 17176, 17272,
+	17368, 17463, 17557, 17652, 17746, 17840, 17933, 18027, 18119, 18212,
+	18304, 18396, 18488, 18579, 18670, 18760, 18851, 18941, 19030, 19120,
+	19209, 19297, 19386, 19474, 19561, 19649, 19736, 19823, 19909, 19995,
+	20081, 20166, 20252, 20336, 20421, 20505, 20589, 20673, 20756, 20839,
+	20922, 21004, 21086, 21168, 21249, 21331, 21411, 21492, 21572, 21652,
+	21732, 21811, 21890, 21969, 22047, 22126, 22203, 22281, 22358, 22435,
+	22512, 22588, 22664, 22740, 22815, 22891, 22966, 23040, 23115, 23189,
+	23262, 23336, 23409, 23482, 23555, 23627, 23699, 23771, 23842, 23914,
+	23985, 24055, 24126, 24196, 24266, 24335, 24405, 24474, 24542, 24611,
+	24679, 24747, 24815, 24882, 24950, 25017, 25083, 25150, 25216, 25282,
+	25347, 25413, 25478, 25543, 25607, 25672, 25736,
+};
+
 /*
- * arctan of y/x
+ * arctan of a/b, 0 <= a <= b, b > 0
  */
+static Q15_t atan_octant(Q15_t a, Q15_t b)
+{
+	int32_t pos, i, frac;
+
+	/* ratio in table segments, Q15 */
+	pos = ((int64_t)a << Q15_SHIFT) * ATAN_SEGMENTS / b;
+	i = pos >> Q15_SHIFT;
+	if (i >= ATAN_SEGMENTS)
+		return atan_table[ATAN_SEGMENTS];
+	frac = pos & ((1 << Q15_SHIFT) - 1);
 
-static const Q15_t q15_pi_4 = FP_to_Q15(M_PI/4.0);
+	return atan_table[i] +
+		((((int32_t)atan_table[i+1] - atan_table[i]) * frac + (1 << (Q15_SHIFT-1))) >> Q15_SHIFT);
+}
+
+#elif (FP_ATAN_MODE == FP_MATH_CORDIC)
+static Q15_t atan_octant(Q15_t a, Q15_t b)
+{
+	int32_t x = b, y = a, z = 0, t;
+	int i;
 
+	/* scale up to 28 bits, the gain of ~1.65 then still fits */
+	while (x < (1 << 27)) {
+		x <<= 1;
+		y <<= 1;
+	}
+	while (x >= (1 << 28)) {
+		x >>= 1;
+		y >>= 1;
+	}
+
+	/* rotate (b, a) onto the x axis */
+	for (i = 0; i < FP_CORDIC_ITERATIONS; i++) {
+		t = x;
+		if (y > 0) {
+			x += y >> i;
+			y -= t >> i;
+			z += fp_cordic_atan[i];
+		} else {
+			x -= y >> i;
+			y += t >> i;
+			z -= fp_cordic_atan[i];
+		}
+	}
+	return (z + (1 << (FP_CORDIC_Q - Q15_SHIFT - 1))) >> (FP_CORDIC_Q - Q15_SHIFT);
+}
+
+#elif (FP_ATAN_MODE == FP_MATH_POLY)
+/* minimax atan(x) on [-1, 1], odd, degree 11 */
+static const int64_t atan_coef[6] = {
+	Q30(0.9999772190822532), Q30(-0.3326228278902576),
+	Q30(0.19354037608393043), Q30(-0.11642648196997651),
+	Q30(0.05264735146589641), Q30(-0.011719135734256725)
+};
+
+static Q15_t atan_octant(Q15_t a, Q15_t b)
+{
+	int64_t x, x2, p;
+	int i;
+
+	x = ((int64_t)a << 30) / b;
+	x2 = (x * x) >> 30;
+	p = atan_coef[5];
+	for (i = 4; i >= 0; i--)
+		p = atan_coef[i] + ((p * x2) >> 30);
+	p = (p * x) >> 30;
+
+	return (p + (1 << (30 - Q15_SHIFT - 1))) >> (30 - Q15_SHIFT);
+}
+
+#else
+#error "Unknown FP_ATAN_MODE"
+#endif
+
+/*
+ * arctan of y/x
+ */
 Q15_t atan2_q15(Q15_t y, Q15_t x)
 {
-	const Q15_t q15_3_4_PI = FP_to_Q15(3.0*M_PI/4.0f);
-	Q15_t abs_y, r, rt, angle;
+	Q15_t abs_y, abs_x, angle;
 
-	if (y == 0 && x < 0) return q15_pi;
+	if (y == 0 && x < 0) return q15_pi_r;
 	if (y == 0 && x > 0) return 0;
-	if (y < 0  && x == 0) return -(q15_pi >> 1); /* -PI/2 */
-	if (y > 0  && x == 0) return (q15_pi >> 1);  /*  PI/2 */
-	if (y == 0 && x == 0) return q15_pi;
-	
+	if (y < 0  && x == 0) return -q15_pi_2; /* -PI/2 */
+	if (y > 0  && x == 0) return q15_pi_2;  /*  PI/2 */
+	if (y == 0 && x == 0) return q15_pi_r;
+
 	abs_y = abs_q15(y);
+	abs_x = abs_q15(x);
 
-	if (x >= 0) {
-		rt = RECIP_Q15(x+abs_y);
-		r = MUL_Q15((x-abs_y), rt);	
+	/* first octant, then mirror out */
+	if (abs_y <= abs_x)
+		angle = atan_octant(abs_y, abs_x);
+	else
+		angle = q15_pi_2 - atan_octant(abs_x, abs_y);
 
-		angle = q15_pi_4 - MUL_Q15(q15_pi_4, r);
-	} else {
-		rt = RECIP_Q15(abs_y-x);
-		r = MUL_Q15((x+abs_y), rt);
-		angle = q15_3_4_PI - MUL_Q15(q15_pi_4, r);
-	}
+	if (x < 0)
+		angle = q15_pi_r - angle;
 
 	if (y < 0)
 		return -angle;
@@ -43,40 +156,40 @@ Q15_t atan2_q15(Q15_t y, Q15_t x)
 		return angle;
 }
 #ifdef TEST
+#include <time.h>
+
+#define TEST_CALLS	2000000
+
 int main(int argc, char **argv)
 {
-	float ang;
-	float ang_rad;
-	Q15_t qy, qx, qat;
-	float fy, fx, fat;
-	float err = 0.0;
-
-	if (argc > 1) {
-		err = atof(argv[1]);
-		if (err > 2.0)
-			err = 0.0;
-	}
+	double e, max_err = 0.0;
+	volatile Q15_t sink;
+	clock_t t0;
+	Q15_t qx, qy;
+	int i;
 
-	fprintf(stderr, "Printing errors greater then %f\n", err);
+	/* all directions, short and long vectors */
+	for (i = 0; i < 3600 * 16; i++) {
+		double ang = (i % 3600) * M_PI / 1800.0 - M_PI;
+		double len = (i / 3600 + 1) * 0.5;
 
-	for (ang = 0; ang < 360.0f; ang+= 0.5) {
-		ang_rad = ang * M_PI/180.0f;
-		qx = q15_c1;
-		fx = 1.0;
-		fy = tan(ang_rad);
-		qy = FP_to_Q15(fy);
+		qx = FP_to_Q15(len * cos(ang));
+		qy = FP_to_Q15(len * sin(ang));
+		e = fabs(Q15_to_FP(atan2_q15(qy, qx)) -
+			atan2(Q15_to_FP(qy), Q15_to_FP(qx)));
+		if (e > M_PI) e = fabs(e - 2 * M_PI);
+		if (e > max_err) max_err = e;
+	}
+	printf("FP_ATAN_MODE %d max error: atan2 %.2e\n", FP_ATAN_MODE, max_err);
 
-		fat = atan2(fy, fx);
-		qat = atan2_q15(qy, qx);
-		if ((Q15_to_FP(qat)-fat) > err) {
+	t0 = clock();
+	for (i = 0; i < TEST_CALLS; i++)
+		sink = atan2_q15((i & 0xffff) - 0x8000, 0x5000);
+	printf("atan2_q15: %.1f ns/call\n",
+		1e9 * (clock() - t0) / CLOCKS_PER_SEC / TEST_CALLS);
+	(void)sink;
 
-			fprintf(stderr,
-				"ANG: %f - tan = %f (%f), atan() = %f (%f) err = %f\n",
-				ang, fy, Q15_to_FP(qy),
-				fat, Q15_to_FP(qat),
-				Q15_to_FP(qat)-fat);
-		}
-	}
+	return 0;
 }
 
 #endif
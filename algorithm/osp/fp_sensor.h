@@ -10,6 +10,7 @@
 #define Q15_to_NTPRECISE(x)	(x << (24-Q15_SHIFT))
 #define NTEXTENDED_to_Q15(x)	(x << (Q15_SHIFT-12))
 #define NTPRECISE_to_Q15(x)	(x >> (24-Q15_SHIFT))
+#define QW_to_NTPRECISE(x)	((x) << (24-QW_SHIFT))
 
 #define FLAG(x) (1 << x)
 
@@ -32,7 +33,7 @@ struct Quat {
 	Q15_t w;
 };
 
-#ifdef FEAT_ROTVEC_PRECISE
+#ifdef ENABLE_Q24
 struct Quat_precise {
 	Q24_t x;
 	Q24_t y;
@@ -41,6 +42,13 @@ struct Quat_precise {
 };
 #endif
 
+/* Quaternion in the working precision QW, see fpsup.h */
+#ifdef FP_PRECISION_Q24
+typedef struct Quat_precise QuatW_t;
+#else
+typedef struct Quat QuatW_t;
+#endif
+
 struct StepInfo {
 	int32_t	count;
 	int32_t detect;
@@ -50,13 +58,12 @@ struct Results {
 	union {
 		struct ThreeAxis result;
 		struct Euler euler;
-#ifdef FEAT_ROTVEC_PRECISE
-		struct Quat_precise quat;
-#else
-		struct Quat quat;
-#endif
+		QuatW_t quat;
 #ifdef FEAT_STEP
 		struct StepInfo step;
+#endif
+#ifdef ENABLE_Q24
+		struct Quat_precise quat24;
 #endif
 	} ResType;
 	uint32_t time;
@@ -4,95 +4,232 @@
  *
  * Apache License.
  *
- * Math support routines for sqrt.
+ * Math support routines for sqrt. Implementation selected by
+ * FP_SQRT_MODE, see fpsup.h.
  */
-/* Apache Licensed code from PebbleFit */
 #include <stdio.h>
 #include "fpsup.h"
 
-#ifdef ENABLE_Q12
-Q12_t sqrt_q12(Q12_t num)
+#if (FP_SQRT_MODE == FP_MATH_CORDIC)
+/*
+ * Bit serial (shift and subtract) square root, floor(sqrt(v)).
+ */
+static uint32_t isqrt64(uint64_t v)
 {
-	Q12_t a, p, e = FP_to_Q12(0.001f), b;
-	Q12_t t;
-	int nb = 0;
-
-	a = num;
-
-	p = MUL_Q12(a, a);;
-	while ((p - num >= e) && (nb++ < 40)) {
-		t = RECIP_Q12(a);
-		b = a + MUL_Q12(num, t);
-		a = b >> 1;
-		p = MUL_Q12(a, a);
+	uint64_t res = 0, bit = (uint64_t)1 << 62;
+
+	while (bit > v)
+		bit >>= 2;
+
+	while (bit) {
+		if (v >= res + bit) {
+			v -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
 	}
+	return (uint32_t)res;
+}
 
-	return a;
+#else
+/*
+ * Shifts v left by an even count 2k so that m = v << 2k is in
+ * [2^62, 2^64), i.e. m/2^64 in [0.25, 1). Then sqrt(v) = sqrt(m) >> k.
+ */
+static uint64_t normalize(uint64_t v, int *k)
+{
+	*k = 0;
+	while (v < ((uint64_t)1 << 54)) {
+		v <<= 8;
+		*k += 4;
+	}
+	while (v < ((uint64_t)1 << 62)) {
+		v <<= 2;
+		*k += 1;
+	}
+	return v;
 }
-#endif
-Q15_t sqrt_q15(Q15_t num)
+
+#if (FP_SQRT_MODE == FP_MATH_TABLE)
+/* sqrt(i / 256) for i = 64..256, Q31 */
+static const uint32_t sqrt_table[193] = {
+	1073741824, 1082097918, 1090389977, 1098619452, 1106787739, 1114896182,
+	1122946079, 1130938678, 1138875187, 1146756771, 1154584553, 1162359621,
+	1170083026, 1177755783, 1185378878, 1192953261, 1200479854, 1207959552,
+	1215393219, 1222781696, 1230125796, 1237426310, 1244684005, 1251899625,
+	1259073893, 1266207514, 1273301169, 1280355523, 1287371222, 1294348895,
+	1301289153, 1308192592, 1315059792, 1321891318, 1328687719, 1335449532,
+	1342177280, 1348871473, 1355532607, 1362161168, 1368757628, 1375322451,
+	1381856086, 1388358974, 1394831545, 1401274219, 1407687407, 1414071510,
+	1420426919, 1426754019, 1433053185, 1439324782, 1445569171, 1451786701,
+	1457977717, 1464142555, 1470281545, 1476395008, 1482483261, 1488546612,
+	1494585366, 1500599818, 1506590260, 1512556978, 1518500250, 1524420351,
+	1530317551, 1536192112, 1542044294, 1547874349, 1553682529, 1559469076,
+	1565234231, 1570978229, 1576701302, 1582403676, 1588085574, 1593747216,
+	1599388817, 1605010588, 1610612736, 1616195466, 1621758978, 1627303469,
+	1632829134, 1638336161, 1643824740, 1649295054, 1654747284, 1660181608,
+	1665598202, 1670997238, 1676378885, 1681743312, 1687090681, 1692421154,
+	1697734891, 1703032049, 1708312781, 1713577240, 1718825574, 1724057932,
+	1729274458, 1734475296, 1739660585, 1744830464, 1749985070, 1755124538,
+	1760249000, 1765358587, 1770453428, 1775533649, 1780599376, 1785650732,
+	1790687838, 1795710816, 1800719782, 1805714853, 1810696145, 1815663770,
+	1820617842, 1825558469, 1830485761, 1835399826, 1840300769, 1845188694,
+	1850063706, 1854925906, 1859775393, 1864612269, 1869436629, 1874248572,
+	1879048192, 1883835584, 1888610840, 1893374053, 1898125312, 1902864709,
+	1907592330, 1912308264, 1917012597, 1921705413, 1926386797, 1931056833,
+	1935715602, 1940363185, 1944999662, 1949625114, 1954239618, 1958843251,
+	1963436090, 1968018211, 1972589688, 1977150595, 1981701005, 1986240991,
+	1990770623, 1995289972, 1999799107, 2004298098, 2008787014, 2013265920,
+	2017734884, 2022193972, 2026643249, 2031082780, 2035512628, 2039932856,
+	2044343526, 2048744702, 2053136442, 2057518809, 2061891861, 2066255659,
+	2070610259, 2074955721, 2079292101, 2083619457, 2087937844, 2092247318,
+	2096547933, 2100839745, 2105122807, 2109397173, 2113662894, 2117920024,
+	2122168614, 2126408716, 2130640379, 2134863654, 2139078592, 2143285240,
+	2147483648,
+};
+
+static uint32_t isqrt64(uint64_t v)
 {
-	Q15_t ans;
-	LQ15_t a, b;
-	LQ15_t p, e = FP_to_Q15(0.0001f);
-	LQ15_t t, numl;
-	int nb = 0;
-
-	numl = num;
-	a = numl;
-
-	p = MUL_LQ15(a, a);
-	while ((abs_lq15(p - num) >= e) && (nb++ < 64)) {
-		t = RECIP_LQ15(a);
-		b = a + MUL_LQ15(numl, t);
-		a = b >> 1;
-		p = MUL_LQ15(a, a);
-		nb++;
+	uint64_t m, r;
+	uint32_t i, frac;
+	int k;
+
+	if (v == 0)
+		return 0;
+	m = normalize(v, &k);
+
+	/* top 8 bits index the table, the next 32 interpolate */
+	i = (uint32_t)(m >> 56) - 64;
+	frac = (uint32_t)(m >> 24);
+	r = sqrt_table[i] +
+		(((uint64_t)(sqrt_table[i+1] - sqrt_table[i]) * frac) >> 32);
+
+	/* sqrt(m) = r * 2^32 / 2^31 */
+	if (k == 0)
+		return (r >= 0x80000000) ? 0xffffffff : (uint32_t)(r << 1);
+	return (uint32_t)((r + ((uint64_t)1 << (k - 1)) / 2) >> (k - 1));
+}
+
+#elif (FP_SQRT_MODE == FP_MATH_POLY)
+#define Q30(v)	((int64_t)((v) * (double)(1 << 30)))
+
+/* minimax 1/sqrt(x) on [0.25, 1], quadratic, relative error 2.4% */
+static const int64_t rsqrt_coef[3] = {
+	Q30(2.670835388835633), Q30(-3.2853566191811048), Q30(1.6385678674669522)
+};
+
+static uint32_t isqrt64(uint64_t v)
+{
+	int64_t u, y, t;
+	int i, k;
+
+	if (v == 0)
+		return 0;
+	u = normalize(v, &k) >> 34;	/* [0.25, 1), Q30 */
+
+	/* 1/sqrt(u): polynomial seed, then y = y (3 - u y^2) / 2 */
+	y = rsqrt_coef[0] + ((rsqrt_coef[1] + ((rsqrt_coef[2] * u) >> 30)) * u >> 30);
+	for (i = 0; i < 3; i++) {
+		t = (((u * y) >> 30) * y) >> 30;
+		y = (y * ((3LL << 30) - t)) >> 31;
 	}
-	ans = a;
-#if 0
-	printf("SQRT: %f = %f nb = %i\n", LQ15_to_FP(numl), LQ15_to_FP(a), nb);
+
+	/* sqrt(u) = u / sqrt(u), sqrt(m) = sqrt(u) * 2^32 */
+	t = (u * y) >> 30;
+	if (k < 2)
+		return (t >= (1LL << 30)) ? 0xffffffff : (uint32_t)(t << (2 - k));
+	return (uint32_t)((t + ((int64_t)1 << (k - 2)) / 2) >> (k - 2));
+}
+
+#else
+#error "Unknown FP_SQRT_MODE"
+#endif
 #endif
-	return ans;
+
+#ifdef ENABLE_Q12
+Q12_t sqrt_q12(Q12_t num)
+{
+	if (num <= 0)
+		return 0;
+	return isqrt64((uint64_t)num << Q12_SHIFT);
+}
+#endif
+
+Q15_t sqrt_q15(Q15_t num)
+{
+	if (num <= 0)
+		return 0;
+	return isqrt64((uint64_t)num << Q15_SHIFT);
 }
 
 #ifdef ENABLE_Q24
 Q24_t sqrt_q24(Q24_t num)
 {
-	Q24_t a, p, e = FP_to_Q24(0.001f), b;
-	Q24_t t;
-	int nb = 0;
-
-	a = num;
-
-	p = MUL_Q24(a, a);;
-	while ((abs_q24(p - num) >= e) && (nb++ < 40)) {
-		t = RECIP_Q24(a);
-		b = a + MUL_Q24(num, t);
-		a = b >> 1;
-		p = MUL_Q24(a, a);
-		nb++;
-	}
-	return a;
+	if (num <= 0)
+		return 0;
+	return isqrt64((uint64_t)num << Q24_SHIFT);
 }
 #endif
 
+QW_t sqrt_qw(QW_t num)
+{
+	if (num <= 0)
+		return 0;
+	return isqrt64((uint64_t)num << QW_SHIFT);
+}
+
+/* Unit vector along (x, y, z) in QW, returns 0 for the zero vector */
+int unit_qw(Q15_t x, Q15_t y, Q15_t z, QW_t u[3])
+{
+	uint64_t n2;
+	uint32_t n;
+
+	n2 = (uint64_t)((int64_t)x * x) + (uint64_t)((int64_t)y * y) +
+		(uint64_t)((int64_t)z * z);
+	n = isqrt64(n2);	/* |v|, Q15 */
+	if (n == 0)
+		return 0;
+	u[0] = ((int64_t)x << QW_SHIFT) / n;
+	u[1] = ((int64_t)y << QW_SHIFT) / n;
+	u[2] = ((int64_t)z << QW_SHIFT) / n;
+	return 1;
+}
+
 #ifdef TEST_SQRT
 #include <math.h>
+#include <time.h>
+
+#define TEST_CALLS	2000000
+
 int main(int argc, char **argv)
 {
-	float testv[] = {
-		37483.949219f,
-		-1.0f
-	};
+	double e, exact, max_rel = 0.0, max_lsb = 0.0;
+	volatile Q15_t sink;
+	clock_t t0;
+	Q15_t q;
 	int i;
 
-	for (i = 0; testv[i] > 0; i++) {
-		printf("SQRT(%f) = (Q15: %f, float: %f)\n",
-				testv[i], Q15_to_FP(sqrt_q15(FP_to_Q15(testv[i]))),
-				sqrt(testv[i]));
+	/* over the whole positive Q15 range: error in lsb, and relative error from 1.0 up */
+	for (q = 1; q > 0 && q < 0x7fffffff - 997; q += 997 + (q >> 12)) {
+		exact = sqrt(Q15_to_FP(q));
+		e = fabs(Q15_to_FP(sqrt_q15(q)) - exact);
+		if (e * q15_c1 > max_lsb) max_lsb = e * q15_c1;
+		if (q >= q15_c1 && e / exact > max_rel) max_rel = e / exact;
 	}
+	printf("FP_SQRT_MODE %d max error: sqrt %.2f lsb, %.2e relative\n",
+		FP_SQRT_MODE, max_lsb, max_rel);
+
+	t0 = clock();
+	for (i = 0; i < TEST_CALLS; i++)
+		sink = sqrt_q15(i + 1);
+	printf("sqrt_q15: %.1f ns/call\n",
+		1e9 * (clock() - t0) / CLOCKS_PER_SEC / TEST_CALLS);
+	(void)sink;
+
 	return 0;
 }
 
 #endif
+
@@ -4,68 +4,166 @@
  *
  * Apache License.
  *
- * Table look up tan/sin/cos
+ * tan/sin/cos and their inverses. Implementation selected by
+ * FP_TRIG_MODE, see fpsup.h.
  */
 #include "fpsup.h"
+#if (FP_TRIG_MODE == FP_MATH_TABLE)
 #include "trig_sin.c"
+#endif
 
+#define Q30(v)	((int64_t)((v) * (double)(1 << 30) + 0.5))
 
-Q15_t sin_q15(Q15_t ang)
+/* angles are reduced in Q30, M_PI may only be single precision */
+#define TRIG_PI		3.14159265358979323846
+static const int64_t q30_pi = Q30(TRIG_PI);
+static const int64_t q30_pi_2 = Q30(TRIG_PI/2.0);
+static const int64_t q30_2pi = Q30(2.0*TRIG_PI);
+static const Q15_t q15_pi_2 = (Q15_t)(TRIG_PI/2.0 * (1 << Q15_SHIFT) + 0.5);
+
+/*
+ * Folds a Q30 angle into [-pi/2, pi/2] keeping its sine
+ */
+static int32_t fold_sin(int64_t ang)
 {
-	int adj = 1;
-	int i;
+	ang %= q30_2pi;
+	if (ang > q30_pi)
+		ang -= q30_2pi;
+	else if (ang < -q30_pi)
+		ang += q30_2pi;
+
+	/* Sine is symmetric about +-pi/2 */
+	if (ang > q30_pi_2)
+		ang = q30_pi - ang;
+	else if (ang < -q30_pi_2)
+		ang = -q30_pi - ang;
+
+	return (int32_t)ang;
+}
+
+#if (FP_TRIG_MODE == FP_MATH_TABLE)
+/* TRIG_SIN_SEGMENTS / (pi/2), Q16 */
+static const int64_t q16_sin_scale = (int64_t)(TRIG_SIN_SEGMENTS/(TRIG_PI/2.0) * 65536.0 + 0.5);
+
+static Q15_t sin_folded(int32_t ang)
+{
+	int32_t pos, i, frac, adj = 1;
 
-	do {
 	/* Sine is odd */
-		if (ang >=  q15_pi/2 && ang < q15_pi) {
-			ang -= q15_pi/2;
-			break;
-		} else if (ang >= q15_pi) {
-			ang -= q15_pi;
-			adj = -1 * adj;
-		} else if (ang < 0) {
-			ang += q15_pi;
-			adj = -1 * adj;
-		} else {
-			/* Between 0 - pi/2 */
-			break;
-		}
-	} while(1);
+	if (ang < 0) {
+		ang = -ang;
+		adj = -1;
+	}
+
+	/* position in table segments, Q15 */
+	pos = (int32_t)((ang * q16_sin_scale) >> (30 + 16 - Q15_SHIFT));
+	i = pos >> Q15_SHIFT;
+	if (i >= TRIG_SIN_SEGMENTS)
+		return trig_sin[TRIG_SIN_SEGMENTS] * adj;
+	frac = pos & ((1 << Q15_SHIFT) - 1);
+
+	return (trig_sin[i] +
+		((((int32_t)trig_sin[i+1] - trig_sin[i]) * frac + (1 << (Q15_SHIFT-1))) >> Q15_SHIFT)) * adj;
+}
+
+#elif (FP_TRIG_MODE == FP_MATH_CORDIC)
+/* 1/prod(sqrt(1 + 2^-2i)), Q29 */
+#define CORDIC_GAIN_INV		326016437
+
+static Q15_t sin_folded(int32_t ang)
+{
+	int32_t x = CORDIC_GAIN_INV, y = 0, t;
+	int32_t z = ang >> (30 - FP_CORDIC_Q);
+	int i;
 
-	for (i = 0; i < sizeof(trig_sin)/sizeof(struct TRIG_SIN); i++) {
-		if (ang < trig_sin[i].ang) {
-			return trig_sin[i].sin * adj;
+	/* rotate (1/K, 0) by ang */
+	for (i = 0; i < FP_CORDIC_ITERATIONS; i++) {
+		t = x;
+		if (z >= 0) {
+			x -= y >> i;
+			y += t >> i;
+			z -= fp_cordic_atan[i];
+		} else {
+			x += y >> i;
+			y -= t >> i;
+			z += fp_cordic_atan[i];
 		}
 	}
-	return 0;
+	return (y + (1 << (FP_CORDIC_Q - Q15_SHIFT - 1))) >> (FP_CORDIC_Q - Q15_SHIFT);
+}
+
+#elif (FP_TRIG_MODE == FP_MATH_POLY)
+/* minimax sin(x) on [-pi/2, pi/2], odd, degree 7 */
+static const int64_t sin_coef[4] = {
+	Q30(0.9999996185243668), Q30(-0.16665846902111398),
+	Q30(0.008313958681610629), Q30(-0.0001852322017248377)
+};
+
+static Q15_t sin_folded(int32_t ang)
+{
+	int64_t x, x2, p;
+
+	x = ang;
+	x2 = (x * x) >> 30;
+	p = sin_coef[3];
+	p = sin_coef[2] + ((p * x2) >> 30);
+	p = sin_coef[1] + ((p * x2) >> 30);
+	p = sin_coef[0] + ((p * x2) >> 30);
+	p = (p * x) >> 30;
+
+	return (p + (1 << (30 - Q15_SHIFT - 1))) >> (30 - Q15_SHIFT);
+}
+
+#else
+#error "Unknown FP_TRIG_MODE"
+#endif
+
+Q15_t sin_q15(Q15_t ang)
+{
+	return sin_folded(fold_sin((int64_t)ang << (30 - Q15_SHIFT)));
 }
 
 Q15_t cos_q15(Q15_t ang)
 {
-	return sin_q15(ang + q15_pi/2);
+	return sin_folded(fold_sin(((int64_t)ang << (30 - Q15_SHIFT)) + q30_pi_2));
 }
 
 Q15_t tan_q15(Q15_t ang)
 {
-	return DIV_Q15(sin_q15(ang),cos_q15(ang));
+	return DIV_Q15_SAT(sin_q15(ang), cos_q15(ang));
 }
 
 Q15_t arcsin_q15(Q15_t v)
 {
-	Q15_t l, ang;
-	int i, adj;
+	Q15_t l;
+	int adj;
 
 	if (v < 0) adj = -1; else adj = 1;
 	l = v * adj;
+	if (l >= q15_c1)
+		return q15_pi_2 * adj;
+
+#if (FP_TRIG_MODE == FP_MATH_TABLE)
+	{
+		/* Inverse look up: binary search then interpolate */
+		int32_t lo = 0, hi = TRIG_SIN_SEGMENTS, mid, pos;
 
-	for (i = 0; i < sizeof(trig_sin)/sizeof(struct TRIG_SIN); i++) {
-		if (l < trig_sin[i].sin) {
-			ang = trig_sin[i].ang;
-			break;
+		while (hi - lo > 1) {
+			mid = (lo + hi) >> 1;
+			if (l < trig_sin[mid])
+				hi = mid;
+			else
+				lo = mid;
 		}
-	}
-	return ang*adj;
+		pos = (lo << Q15_SHIFT) +
+			((l - trig_sin[lo]) << Q15_SHIFT) / (trig_sin[hi] - trig_sin[lo]);
 
+		/* segments to radians, (pi/2) / TRIG_SIN_SEGMENTS */
+		return (Q15_t)((pos * Q30(TRIG_PI/2.0/TRIG_SIN_SEGMENTS) + (1 << 29)) >> 30) * adj;
+	}
+#else
+	return atan2_q15(l, sqrt_q15(q15_c1 - MUL_Q15(l, l))) * adj;
+#endif
 }
 
 Q15_t arccos_q15(Q15_t v)
@@ -73,5 +171,51 @@ Q15_t arccos_q15(Q15_t v)
 	Q15_t ang;
 
 	ang = arcsin_q15(v);
-	return (q15_pi/2 - ang);
+	return (q15_pi_2 - ang);
+}
+
+#ifdef TEST_TRIG
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+#define TEST_CALLS	2000000
+
+int main(int argc, char **argv)
+{
+	double e, max_sin = 0.0, max_cos = 0.0, max_asin = 0.0, max_asin_999 = 0.0;
+	volatile Q15_t sink;
+	clock_t t0;
+	Q15_t q;
+	int i;
+
+	for (q = -FP_to_Q15(4*M_PI); q <= FP_to_Q15(4*M_PI); q++) {
+		e = fabs(Q15_to_FP(sin_q15(q)) - sin(Q15_to_FP(q)));
+		if (e > max_sin) max_sin = e;
+		e = fabs(Q15_to_FP(cos_q15(q)) - cos(Q15_to_FP(q)));
+		if (e > max_cos) max_cos = e;
+	}
+	for (q = -q15_c1; q <= q15_c1; q++) {
+		e = fabs(Q15_to_FP(arcsin_q15(q)) - asin(Q15_to_FP(q)));
+		if (e > max_asin) max_asin = e;
+		if (abs_q15(q) <= FP_to_Q15(0.999) && e > max_asin_999) max_asin_999 = e;
+	}
+	printf("FP_TRIG_MODE %d max error: sin %.2e cos %.2e asin %.2e (%.2e to |v| = 0.999)\n",
+		FP_TRIG_MODE, max_sin, max_cos, max_asin, max_asin_999);
+
+	t0 = clock();
+	for (i = 0; i < TEST_CALLS; i++)
+		sink = sin_q15(i & 0x1ffff);
+	printf("sin_q15: %.1f ns/call\n",
+		1e9 * (clock() - t0) / CLOCKS_PER_SEC / TEST_CALLS);
+
+	t0 = clock();
+	for (i = 0; i < TEST_CALLS; i++)
+		sink = arcsin_q15(i & 0x7fff);
+	printf("arcsin_q15: %.1f ns/call\n",
+		1e9 * (clock() - t0) / CLOCKS_PER_SEC / TEST_CALLS);
+	(void)sink;
+
+	return 0;
 }
+#endif
@@ -46,6 +46,15 @@ const Q24_t q24_half = FP_to_Q24(0.5f);
 const Q24_t q24_quarter = FP_to_Q24(0.25f);
 #endif
 
+#if (FP_TRIG_MODE == FP_MATH_CORDIC) || (FP_ATAN_MODE == FP_MATH_CORDIC)
+const int32_t fp_cordic_atan[FP_CORDIC_ITERATIONS] = {
+	421657428, 248918915, 131521918, 66762579, 33510843, 16771758,
+	8387925, 4194219, 2097141, 1048575, 524288, 262144,
+	131072, 65536, 32768, 16384, 8192, 4096,
+	2048, 1024, 512, 256, 128, 64,
+};
+#endif
+
 /* MUL_LQ15 */
 /*
  *  LQ15 - 64 bit storage:
@@ -136,184 +145,316 @@ LQ15_t MUL_LQ15(LQ15_t a, LQ15_t b)
 	return res0;
 }
 
-/* MUL_Q15 */
-
-Q15_t MUL_Q15(Q15_t a, Q15_t b)
+double Q15_to_FP(Q15_t v)
 {
-	int64_t tmp;
+	return ((double)v)/(double)(1<<Q15_SHIFT);
+}
 
-	tmp = (int64_t)a * (int64_t)b;
-	return tmp >> Q15_SHIFT;
+double LQ15_to_FP(LQ15_t v)
+{
+	return ((double)v)/(double)(1<<Q15_SHIFT);
 }
 
 #ifdef ENABLE_Q12
-Q12_t MUL_Q12(Q12_t a, Q12_t b)
+double Q12_to_FP(Q12_t v)
 {
-	int64_t tmp;
-
-	tmp = (int64_t)a * (int64_t)b;
-	return tmp >> Q12_SHIFT;
+	return ((double)v)/(double)(1<<Q12_SHIFT);
 }
 #endif
 
 #ifdef ENABLE_Q24
-/* MUL_Q24 */
-Q24_t MUL_Q24(Q24_t a, Q24_t b)
+double Q24_to_FP(Q24_t v)
 {
-	int64_t tmp;
-
-	tmp = (int64_t)a * (int64_t)b;
-	return tmp >> Q24_SHIFT;
+	return ((double)v)/(double)(1<<Q24_SHIFT);
 }
 #endif
-LQ15_t DIV_LQ15(LQ15_t a, LQ15_t b)
+LQ15_t abs_lq15(LQ15_t x)
 {
-	int64_t tmp;
-	tmp = (int64_t)a << Q15_SHIFT;
+	if (x < 0) return -x;
+	else return x;
+}
 
-	return tmp/b;
+Q15_t abs_q15(Q15_t x)
+{
+	if (x < 0) return -x;
+	else return x;
 }
-/* DIV_Q15 */
-Q15_t DIV_Q15(Q15_t a, Q15_t b)
+#if 0
+Q15_t atan2_q15(Q15_t x, Q15_t y)
 {
-	int64_t tmp;
-	tmp = (int64_t)a << Q15_SHIFT;
-
-	return tmp/b;
+	return FP_to_Q15(atan2(Q15_to_FP(x), Q15_to_FP(y)));
 }
-#ifdef ENABLE_Q12
-/* DIV_Q12 */
-Q12_t DIV_Q12(Q12_t a, Q12_t b)
+#endif
+#if 0
+Q15_t sqrt_q15(Q15_t r)
 {
-	int64_t tmp;
-	tmp = (int64_t)a << Q12_SHIFT;
-
-	return tmp/b;
+	return FP_to_Q15(sqrt(Q15_to_FP(r)));
 }
 #endif
-
-#ifdef ENABLE_Q24
-/* DIV_Q24 */
-Q24_t DIV_Q24(Q24_t a, Q24_t b)
+#if 0
+Q15_t pow_q15(Q15_t x, Q15_t y)
 {
-	int64_t tmp;
-	tmp = (int64_t)a << Q24_SHIFT;
-
-	return tmp/b;
+	return FP_to_Q15(pow(Q15_to_FP(x), Q15_to_FP(y)));
 }
 #endif
-/* RECIP_Q15 */
-
-LQ15_t RECIP_LQ15(LQ15_t a)
+#if 0
+Q15_t tan_q15(Q15_t a)
 {
-	return DIV_LQ15(FP_to_Q15(1.0f), a);
+	return FP_to_Q15(tan(Q15_to_FP(a)));
 }
+#endif
 
+#ifdef TEST_Q15
+/*
+ * Checks the inline helpers of fpsup.h against copies of the out of
+ * line versions fpsup.c had before they moved, over random operand
+ * pairs and edge operands, checks the _RND/_SAT variants, and times a
+ * filter tap loop both ways, e.g.
+ *	gcc -O2 -DTEST_Q15 -DENABLE_Q24 -Iinclude -I../../include fpsup.c -lm
+ * Add -DTEST_Q15_DSP to check the QADD/QSUB/SSAT path of the _SAT
+ * helpers on the host (host versions of the instructions).
+ */
+#include <time.h>
 
-Q15_t RECIP_Q15(Q15_t a)
-{
-	return DIV_Q15(q15_c1, a);
-}
+#define TEST_PAIRS	5000000
+#define TEST_TAPS	1024
+#define TEST_RUNS	20000
 
-#ifdef ENABLE_Q12
-Q12_t RECIP_Q12(Q12_t a)
+/* former fpsup.c versions, kept out of line as they were */
+#define OLD_FN	__attribute__((noinline))
+
+OLD_FN static Q15_t old_MUL_Q15(Q15_t a, Q15_t b)
 {
-	return DIV_Q12(q12_c1, a);
+	int64_t tmp;
+
+	tmp = (int64_t)a * (int64_t)b;
+	return tmp >> Q15_SHIFT;
 }
-#endif
 
-#ifdef ENABLE_Q24
-/* RECIP_Q24 */
-Q24_t RECIP_Q24(Q24_t a)
+OLD_FN static Q15_t old_DIV_Q15(Q15_t a, Q15_t b)
 {
-	return DIV_Q24(q24_c1, a);
+	int64_t tmp;
+	tmp = (int64_t)a << Q15_SHIFT;
+
+	return tmp/b;
 }
-#endif
 
-double Q15_to_FP(Q15_t v)
+OLD_FN static Q15_t old_RECIP_Q15(Q15_t a)
 {
-	return ((double)v)/(double)(1<<Q15_SHIFT);
+	return old_DIV_Q15(q15_c1, a);
 }
 
-double LQ15_to_FP(LQ15_t v)
+OLD_FN static LQ15_t old_DIV_LQ15(LQ15_t a, LQ15_t b)
 {
-	return ((double)v)/(double)(1<<Q15_SHIFT);
+	int64_t tmp;
+	tmp = (int64_t)a << Q15_SHIFT;
+
+	return tmp/b;
 }
 
-#ifdef ENABLE_Q12
-double Q12_to_FP(Q12_t v)
+OLD_FN static LQ15_t old_RECIP_LQ15(LQ15_t a)
 {
-	return ((double)v)/(double)(1<<Q12_SHIFT);
+	return old_DIV_LQ15(FP_to_Q15(1.0f), a);
 }
-#endif
 
 #ifdef ENABLE_Q24
-double Q24_to_FP(Q24_t v)
+OLD_FN static Q24_t old_MUL_Q24(Q24_t a, Q24_t b)
 {
-	return ((double)v)/(double)(1<<Q24_SHIFT);
+	int64_t tmp;
+
+	tmp = (int64_t)a * (int64_t)b;
+	return tmp >> Q24_SHIFT;
 }
-#endif
-LQ15_t abs_lq15(LQ15_t x)
+
+OLD_FN static Q24_t old_DIV_Q24(Q24_t a, Q24_t b)
 {
-	if (x < 0) return -x;
-	else return x;
+	int64_t tmp;
+	tmp = (int64_t)a << Q24_SHIFT;
+
+	return tmp/b;
 }
 
-Q15_t abs_q15(Q15_t x)
+OLD_FN static Q24_t old_RECIP_Q24(Q24_t a)
 {
-	if (x < 0) return -x;
-	else return x;
+	return old_DIV_Q24(q24_c1, a);
 }
-#if 0
-Q15_t atan2_q15(Q15_t x, Q15_t y)
+#endif
+
+static uint32_t test_seed = 2463534242u;
+
+/* xorshift32, operands of every magnitude */
+static int32_t test_rand(void)
 {
-	return FP_to_Q15(atan2(Q15_to_FP(x), Q15_to_FP(y)));
+	test_seed ^= test_seed << 13;
+	test_seed ^= test_seed >> 17;
+	test_seed ^= test_seed << 5;
+	return (int32_t)test_seed >> (test_seed & 31);
 }
-#endif
-#if 0
-Q15_t sqrt_q15(Q15_t r)
+
+/* saturation limits and the products/quotients next to them */
+static const int32_t test_edge[] = {
+	0, 1, -1, 2, -2, 255, -256, 0x7fff, -0x8000, 0x8000, -0x8001,
+	0xffff, 0x10000, -0x10000, 0x7fffff, -0x800000, 0x1000000,
+	0x3fffffff, -0x40000000, 0x40000000, INT32_MAX, INT32_MIN,
+	INT32_MAX - 1, INT32_MIN + 1,
+};
+
+static int test_fail(const char *name, int32_t a, int32_t b, int64_t got, int64_t want)
 {
-	return FP_to_Q15(sqrt(Q15_to_FP(r)));
+	printf("FAIL %s(%d, %d) = %lld, want %lld\n", name, a, b,
+		(long long)got, (long long)want);
+	return 1;
 }
-#endif
-#if 0
-Q15_t pow_q15(Q15_t x, Q15_t y)
+
+/* wide result clamped, as the _SAT variants should give */
+static int64_t test_clamp(int64_t v)
 {
-	return FP_to_Q15(pow(Q15_to_FP(x), Q15_to_FP(y)));
+	return (v > INT32_MAX) ? INT32_MAX : (v < INT32_MIN) ? INT32_MIN : v;
 }
-#endif
-#if 0
-Q15_t tan_q15(Q15_t a)
+
+static double test_ns(struct timespec *t0, struct timespec *t1)
 {
-	return FP_to_Q15(tan(Q15_to_FP(a)));
+	return ((t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec)) /
+		((double)TEST_RUNS * TEST_TAPS);
 }
-#endif
 
-#ifdef TEST_Q15
+static Q15_t tap_x[TEST_TAPS], tap_c[TEST_TAPS];
+
 int main(int argc, char **argv)
 {
 	double pi = 3.1415926;
 	double npi, n2d;
 	Q15_t	q;
 	Q15_t	n2;
+	int32_t a, b;
+	int64_t p;
+	int n_edge = sizeof(test_edge) / sizeof(test_edge[0]);
+	Q15_t acc;
+	volatile Q15_t sink;
+	struct timespec t0, t1;
+	double ns_old, ns_new;
+	int i, run, fail = 0;
 
 	q = FP_to_Q15(pi);
 	npi = Q15_to_FP(q);
 
 	n2 = MUL_Q15(FP_to_Q15(pi), FP_to_Q15(2.0f));
-	n2d = Q15_to_FP(n2);	
+	n2d = Q15_to_FP(n2);
+
+	printf("Values: %f - %f\n", n2d, npi * 2.0);
 
-	printf("Values: %f - %f\n", n2d, 1.0);
-	
 	n2 = DIV_Q15(FP_to_Q15(pi), FP_to_Q15(2.0f));
-	n2d = Q15_to_FP(n2);	
-	printf("Values: %f - %f\n", n2d, 1.0);
+	n2d = Q15_to_FP(n2);
+	printf("Values: %f - %f\n", n2d, npi / 2.0);
 
 	n2 = RECIP_Q15(FP_to_Q15(2.0f));
-	n2d = Q15_to_FP(n2);	
-	
-	printf("Values: %f - %f\n", n2d, 1.0);
+	n2d = Q15_to_FP(n2);
+
+	printf("Values: %f - %f\n", n2d, 0.5);
+
+#ifdef FP_HAVE_DSP
+	printf("_SAT helpers: DSP path\n");
+#else
+	printf("_SAT helpers: plain C\n");
+#endif
+	for (i = 0; i < TEST_PAIRS + n_edge * n_edge && fail < 10; i++) {
+		if (i < n_edge * n_edge) {
+			a = test_edge[i / n_edge];
+			b = test_edge[i % n_edge];
+		} else {
+			a = test_rand();
+			b = test_rand();
+		}
+
+		/* plain versions: bit exact with the former ones, wrap included */
+		if (MUL_Q15(a, b) != old_MUL_Q15(a, b))
+			fail += test_fail("MUL_Q15", a, b, MUL_Q15(a, b), old_MUL_Q15(a, b));
+#ifdef ENABLE_Q24
+		if (MUL_Q24(a, b) != old_MUL_Q24(a, b))
+			fail += test_fail("MUL_Q24", a, b, MUL_Q24(a, b), old_MUL_Q24(a, b));
+#endif
+		if (b != 0) {
+			if (DIV_Q15(a, b) != old_DIV_Q15(a, b))
+				fail += test_fail("DIV_Q15", a, b, DIV_Q15(a, b), old_DIV_Q15(a, b));
+			if (RECIP_Q15(b) != old_RECIP_Q15(b))
+				fail += test_fail("RECIP_Q15", 0, b, RECIP_Q15(b), old_RECIP_Q15(b));
+			if (DIV_LQ15(a, b) != old_DIV_LQ15(a, b))
+				fail += test_fail("DIV_LQ15", a, b, DIV_LQ15(a, b), old_DIV_LQ15(a, b));
+			if (RECIP_LQ15(b) != old_RECIP_LQ15(b))
+				fail += test_fail("RECIP_LQ15", 0, b, RECIP_LQ15(b), old_RECIP_LQ15(b));
+#ifdef ENABLE_Q24
+			if (DIV_Q24(a, b) != old_DIV_Q24(a, b))
+				fail += test_fail("DIV_Q24", a, b, DIV_Q24(a, b), old_DIV_Q24(a, b));
+			if (RECIP_Q24(b) != old_RECIP_Q24(b))
+				fail += test_fail("RECIP_Q24", 0, b, RECIP_Q24(b), old_RECIP_Q24(b));
+#endif
+		}
+
+		/* rounding adds the first dropped bit, saturation clamps */
+		p = (int64_t)a * b;
+		if (MUL_Q15_RND(a, b) != (Q15_t)((p >> Q15_SHIFT) + ((p >> (Q15_SHIFT-1)) & 1)))
+			fail += test_fail("MUL_Q15_RND", a, b, MUL_Q15_RND(a, b),
+				(Q15_t)((p >> Q15_SHIFT) + ((p >> (Q15_SHIFT-1)) & 1)));
+		if (MUL_Q15_SAT(a, b) != test_clamp(p >> Q15_SHIFT))
+			fail += test_fail("MUL_Q15_SAT", a, b, MUL_Q15_SAT(a, b), test_clamp(p >> Q15_SHIFT));
+#ifdef ENABLE_Q24
+		if (MUL_Q24_RND(a, b) != (Q24_t)((p >> Q24_SHIFT) + ((p >> (Q24_SHIFT-1)) & 1)))
+			fail += test_fail("MUL_Q24_RND", a, b, MUL_Q24_RND(a, b),
+				(Q24_t)((p >> Q24_SHIFT) + ((p >> (Q24_SHIFT-1)) & 1)));
+		if (MUL_Q24_SAT(a, b) != test_clamp(p >> Q24_SHIFT))
+			fail += test_fail("MUL_Q24_SAT", a, b, MUL_Q24_SAT(a, b), test_clamp(p >> Q24_SHIFT));
+#endif
+		if (ADD_SAT(a, b) != test_clamp((int64_t)a + b))
+			fail += test_fail("ADD_SAT", a, b, ADD_SAT(a, b), test_clamp((int64_t)a + b));
+		if (SUB_SAT(a, b) != test_clamp((int64_t)a - b))
+			fail += test_fail("SUB_SAT", a, b, SUB_SAT(a, b), test_clamp((int64_t)a - b));
+		if (b == 0) {
+			if (DIV_Q15_SAT(a, b) != ((a < 0) ? INT32_MIN : INT32_MAX))
+				fail += test_fail("DIV_Q15_SAT", a, b, DIV_Q15_SAT(a, b),
+					(a < 0) ? INT32_MIN : INT32_MAX);
+		} else if (DIV_Q15_SAT(a, b) != test_clamp(((int64_t)a << Q15_SHIFT) / b)) {
+			fail += test_fail("DIV_Q15_SAT", a, b, DIV_Q15_SAT(a, b),
+				test_clamp(((int64_t)a << Q15_SHIFT) / b));
+		}
+#ifdef ENABLE_Q24
+		if (b == 0) {
+			if (DIV_Q24_SAT(a, b) != ((a < 0) ? INT32_MIN : INT32_MAX))
+				fail += test_fail("DIV_Q24_SAT", a, b, DIV_Q24_SAT(a, b),
+					(a < 0) ? INT32_MIN : INT32_MAX);
+		} else if (DIV_Q24_SAT(a, b) != test_clamp(((int64_t)a << Q24_SHIFT) / b)) {
+			fail += test_fail("DIV_Q24_SAT", a, b, DIV_Q24_SAT(a, b),
+				test_clamp(((int64_t)a << Q24_SHIFT) / b));
+		}
+#endif
+	}
+	printf("%d operand pairs, %d failed\n", i, fail);
+
+	/* a filter tap loop, as in SecondOrderLPF.c and gravity_lin.c */
+	for (i = 0; i < TEST_TAPS; i++) {
+		tap_x[i] = test_rand() >> 8;
+		tap_c[i] = test_rand() >> 16;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (run = 0; run < TEST_RUNS; run++) {
+		acc = 0;
+		for (i = 0; i < TEST_TAPS; i++)
+			acc += old_MUL_Q15(tap_x[i], tap_c[i]);
+		sink = acc;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ns_old = test_ns(&t0, &t1);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (run = 0; run < TEST_RUNS; run++) {
+		acc = 0;
+		for (i = 0; i < TEST_TAPS; i++)
+			acc += MUL_Q15(tap_x[i], tap_c[i]);
+		sink = acc;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ns_new = test_ns(&t0, &t1);
+	(void)sink;
+	printf("MUL_Q15 tap: %.2f ns out of line, %.2f ns inline\n", ns_old, ns_new);
 
-	return 0;	
+	return fail != 0;
 }
 #endif
@@ -12,6 +12,11 @@ typedef int32_t	Q15_t;
 
 typedef int64_t LQ15_t;
 
+/* The Q24 working precision (see QW_t below) needs the Q24 helpers */
+#if defined(FP_PRECISION_Q24) && !defined(ENABLE_Q24)
+#define ENABLE_Q24	1
+#endif
+
 #ifdef ENABLE_Q24
 typedef int32_t	Q24_t;
 #define Q24_SHIFT	24
@@ -23,24 +28,217 @@ typedef int32_t	Q24_t;
 typedef int32_t Q12_t;
 #define Q12_SHIFT	12
 
-Q12_t MUL_Q12(Q12_t, Q12_t);
 Q12_t sqrt_q12(Q12_t);
 #define FP_to_Q12(v)	((v)*(1<<Q12_SHIFT))
 #define Q15_to_Q12(x) ((x) >> (Q15_SHIFT-Q12_SHIFT))
 #define Q12_to_Q15(x) ((x) << (Q15_SHIFT-Q12_SHIFT))
-Q12_t RECIP_Q12(Q12_t);
-Q12_t DIV_Q12(Q12_t, Q12_t);
 #endif
 
 #define MAX_Q15	0x7fffffff
 #define MIN_Q15	0x80000000
 
-Q15_t DIV_Q15(Q15_t, Q15_t);
-LQ15_t DIV_LQ15(LQ15_t, LQ15_t);
-Q15_t MUL_Q15(Q15_t, Q15_t);
+/*
+ * Multiply, divide and reciprocal are called for every filter tap, so
+ * they are inlined here. The plain versions truncate and wrap exactly
+ * like the former out of line versions in fpsup.c did. _RND versions
+ * round to nearest, _SAT versions clamp to the int32_t range instead of
+ * wrapping (division by zero gives the limit of the dividend's sign).
+ * On cores with the DSP extension (Cortex-M4/M7) the saturating ones use
+ * QADD/QSUB and an SSAT range check of the high word instead of 64-bit
+ * compares; elsewhere they are plain C. TEST_Q15 in fpsup.c checks both
+ * against the former versions (-DTEST_Q15_DSP builds the DSP path on the
+ * host) and times them.
+ */
+static __inline int32_t SAT_Q31(int64_t v)
+{
+	if (v > (int64_t)INT32_MAX) return INT32_MAX;
+	if (v < (int64_t)INT32_MIN) return INT32_MIN;
+	return (int32_t)v;
+}
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#define FP_HAVE_DSP	1
+#if defined(__CORTEX_M)		/* CMSIS core_cm4_simd.h is in */
+#define FP_QADD(a, b)	((int32_t)__QADD(a, b))
+#define FP_QSUB(a, b)	((int32_t)__QSUB(a, b))
+#define FP_SSAT(v, n)	((int32_t)__SSAT(v, n))
+#else
+#include <arm_acle.h>
+#define FP_QADD(a, b)	__qadd(a, b)
+#define FP_QSUB(a, b)	__qsub(a, b)
+#define FP_SSAT(v, n)	__ssat(v, n)
+#endif
+#elif defined(TEST_Q15_DSP)
+/* host build of the DSP path, for TEST_Q15 in fpsup.c */
+#define FP_HAVE_DSP	1
+#define FP_QADD(a, b)	SAT_Q31((int64_t)(a) + (b))
+#define FP_QSUB(a, b)	SAT_Q31((int64_t)(a) - (b))
+#define FP_SSAT(v, n)	SSAT_HOST(v, n)
+
+static __inline int32_t SSAT_HOST(int32_t v, int n)
+{
+	if (v > (1 << (n-1)) - 1) return (1 << (n-1)) - 1;
+	if (v < -(1 << (n-1))) return -(1 << (n-1));
+	return v;
+}
+#endif
+
+static __inline int32_t ADD_SAT(int32_t a, int32_t b)
+{
+#ifdef FP_HAVE_DSP
+	return FP_QADD(a, b);
+#else
+	return SAT_Q31((int64_t)a + b);
+#endif
+}
+
+static __inline int32_t SUB_SAT(int32_t a, int32_t b)
+{
+#ifdef FP_HAVE_DSP
+	return FP_QSUB(a, b);
+#else
+	return SAT_Q31((int64_t)a - b);
+#endif
+}
+
+static __inline Q15_t MUL_Q15(Q15_t a, Q15_t b)
+{
+	return ((int64_t)a * (int64_t)b) >> Q15_SHIFT;
+}
+
+static __inline Q15_t MUL_Q15_RND(Q15_t a, Q15_t b)
+{
+	return ((int64_t)a * (int64_t)b + (1 << (Q15_SHIFT-1))) >> Q15_SHIFT;
+}
+
+static __inline Q15_t MUL_Q15_SAT(Q15_t a, Q15_t b)
+{
+#ifdef FP_HAVE_DSP
+	int64_t p = (int64_t)a * (int64_t)b;
+	int32_t hi = (int32_t)(p >> 32);
+
+	/* p >> 15 fits in 32 bits iff the high word fits in 15 */
+	if (FP_SSAT(hi, Q15_SHIFT) != hi)
+		return (hi < 0) ? INT32_MIN : INT32_MAX;
+	return (int32_t)(p >> Q15_SHIFT);
+#else
+	return SAT_Q31(((int64_t)a * (int64_t)b) >> Q15_SHIFT);
+#endif
+}
+
+static __inline Q15_t DIV_Q15(Q15_t a, Q15_t b)
+{
+	return ((int64_t)a << Q15_SHIFT) / b;
+}
+
+static __inline Q15_t DIV_Q15_SAT(Q15_t a, Q15_t b)
+{
+#ifdef FP_HAVE_DSP
+	int64_t q;
+	int32_t hi;
+
+	if (b == 0) return (a < 0) ? INT32_MIN : INT32_MAX;
+	q = ((int64_t)a << Q15_SHIFT) / b;
+	/* |q| <= 2^46, so q >> 16 fits a word; q fits iff that fits in 16 */
+	hi = (int32_t)(q >> (Q15_SHIFT+1));
+	if (FP_SSAT(hi, 31-Q15_SHIFT) != hi)
+		return (hi < 0) ? INT32_MIN : INT32_MAX;
+	return (int32_t)q;
+#else
+	if (b == 0) return (a < 0) ? INT32_MIN : INT32_MAX;
+	return SAT_Q31(((int64_t)a << Q15_SHIFT) / b);
+#endif
+}
+
+static __inline Q15_t RECIP_Q15(Q15_t a)
+{
+	return DIV_Q15(INT_to_Q15(1), a);
+}
+
+static __inline LQ15_t DIV_LQ15(LQ15_t a, LQ15_t b)
+{
+	return (a << Q15_SHIFT) / b;
+}
+
+static __inline LQ15_t RECIP_LQ15(LQ15_t a)
+{
+	return DIV_LQ15(INT_to_Q15(1), a);
+}
+
 LQ15_t MUL_LQ15(LQ15_t, LQ15_t);
-Q15_t RECIP_Q15(Q15_t);
-LQ15_t RECIP_LQ15(LQ15_t);
+
+#ifdef ENABLE_Q12
+static __inline Q12_t MUL_Q12(Q12_t a, Q12_t b)
+{
+	return ((int64_t)a * (int64_t)b) >> Q12_SHIFT;
+}
+
+static __inline Q12_t DIV_Q12(Q12_t a, Q12_t b)
+{
+	return ((int64_t)a << Q12_SHIFT) / b;
+}
+
+static __inline Q12_t RECIP_Q12(Q12_t a)
+{
+	return DIV_Q12(1 << Q12_SHIFT, a);
+}
+#endif
+
+#ifdef ENABLE_Q24
+static __inline Q24_t MUL_Q24(Q24_t a, Q24_t b)
+{
+	return ((int64_t)a * (int64_t)b) >> Q24_SHIFT;
+}
+
+static __inline Q24_t MUL_Q24_RND(Q24_t a, Q24_t b)
+{
+	return ((int64_t)a * (int64_t)b + (1 << (Q24_SHIFT-1))) >> Q24_SHIFT;
+}
+
+static __inline Q24_t MUL_Q24_SAT(Q24_t a, Q24_t b)
+{
+#ifdef FP_HAVE_DSP
+	int64_t p = (int64_t)a * (int64_t)b;
+	int32_t hi = (int32_t)(p >> 32);
+
+	/* p >> 24 fits in 32 bits iff the high word fits in 24 */
+	if (FP_SSAT(hi, Q24_SHIFT) != hi)
+		return (hi < 0) ? INT32_MIN : INT32_MAX;
+	return (int32_t)(p >> Q24_SHIFT);
+#else
+	return SAT_Q31(((int64_t)a * (int64_t)b) >> Q24_SHIFT);
+#endif
+}
+
+static __inline Q24_t DIV_Q24(Q24_t a, Q24_t b)
+{
+	return ((int64_t)a << Q24_SHIFT) / b;
+}
+
+static __inline Q24_t DIV_Q24_SAT(Q24_t a, Q24_t b)
+{
+#ifdef FP_HAVE_DSP
+	int64_t q;
+	int32_t hi;
+
+	if (b == 0) return (a < 0) ? INT32_MIN : INT32_MAX;
+	q = ((int64_t)a << Q24_SHIFT) / b;
+	/* |q| <= 2^55, so q >> 25 fits a word; q fits iff that fits in 7 */
+	hi = (int32_t)(q >> (Q24_SHIFT+1));
+	if (FP_SSAT(hi, 31-Q24_SHIFT) != hi)
+		return (hi < 0) ? INT32_MIN : INT32_MAX;
+	return (int32_t)q;
+#else
+	if (b == 0) return (a < 0) ? INT32_MIN : INT32_MAX;
+	return SAT_Q31(((int64_t)a << Q24_SHIFT) / b);
+#endif
+}
+
+static __inline Q24_t RECIP_Q24(Q24_t a)
+{
+	return DIV_Q24(1 << Q24_SHIFT, a);
+}
+#endif
 
 extern const Q15_t q15_pi;
 extern const Q15_t q15_c360;
@@ -52,29 +250,25 @@ extern const Q15_t q15_half;
 extern const Q15_t q15_quarter;
 
 #ifdef ENABLE_Q12
-const Q12_t q12_pi;
-const Q12_t q12_c360;
-const Q12_t q12_c180;
-const Q12_t q12_c90;
-const Q12_t q12_c1;
-const Q12_t q12_c2;
-const Q12_t q12_half;
-const Q12_t q12_quarter;
+extern const Q12_t q12_pi;
+extern const Q12_t q12_c360;
+extern const Q12_t q12_c180;
+extern const Q12_t q12_c90;
+extern const Q12_t q12_c1;
+extern const Q12_t q12_c2;
+extern const Q12_t q12_half;
+extern const Q12_t q12_quarter;
 #endif
 
 #ifdef ENABLE_Q24
-Q24_t DIV_Q24(Q24_t, Q24_t);
-Q24_t MUL_Q24(Q24_t, Q24_t);
-Q24_t RECIP_Q24(Q24_t);
-
-const Q24_t q24_pi;
-const Q24_t q24_c360;
-const Q24_t q24_c180;
-const Q24_t q24_c90;
-const Q24_t q24_c1;
-const Q24_t q24_c2;
-const Q24_t q24_half;
-const Q24_t q24_quarter;
+extern const Q24_t q24_pi;
+extern const Q24_t q24_c360;
+extern const Q24_t q24_c180;
+extern const Q24_t q24_c90;
+extern const Q24_t q24_c1;
+extern const Q24_t q24_c2;
+extern const Q24_t q24_half;
+extern const Q24_t q24_quarter;
 
 double Q24_to_FP(Q24_t);
 #endif
@@ -85,15 +279,108 @@ double LQ15_to_FP(LQ15_t);
 double Q12_to_FP(Q12_t);
 #endif
 
+/*
+ * Trig, atan2 and sqrt each come in three implementations, selected at
+ * compile time per build target (e.g. -DFP_MATH_MODE=FP_MATH_POLY, or
+ * per family with FP_TRIG_MODE, FP_ATAN_MODE, FP_SQRT_MODE). Max
+ * errors in radians (sqrt: Q15 lsb), measured against libm with the
+ * TEST_TRIG/TEST/TEST_SQRT mains in fp_trig.c, fp_atan2.c and
+ * fp_sqrt.c, which also print the time per call:
+ *
+ *           sin/cos    asin/acos    atan2      sqrt
+ * TABLE     3.1e-05    1.7e-03 (*)  3.8e-05    1.9e-05 relative
+ * CORDIC    1.5e-05    1.4e-04      2.4e-05    1 lsb (truncates)
+ * POLY      1.7e-05    1.5e-04      2.6e-05    0.5 lsb
+ *
+ * (Q15 lsb is 3.1e-05.) TABLE interpolates linearly in 256 segment
+ * tables and is the fastest, CORDIC uses 24 shift-and-add iterations
+ * (bit serial shift and subtract for sqrt) and needs no multiplier,
+ * POLY evaluates minimax polynomials in Q30: sin degree 7, atan
+ * degree 11, sqrt as u/sqrt(u) from a quadratic seed and 3 Newton
+ * steps.
+ * (*) 3.0e-04 up to |v| = 0.999, the table is coarse next to 1.
+ */
+#define FP_MATH_TABLE	1
+#define FP_MATH_CORDIC	2
+#define FP_MATH_POLY	3
+
+#ifndef FP_MATH_MODE
+#define FP_MATH_MODE	FP_MATH_TABLE
+#endif
+#ifndef FP_TRIG_MODE
+#define FP_TRIG_MODE	FP_MATH_MODE
+#endif
+#ifndef FP_ATAN_MODE
+#define FP_ATAN_MODE	FP_MATH_MODE
+#endif
+#ifndef FP_SQRT_MODE
+#ifdef FP_PRECISION_Q24
+/* the table is good to ~2e-5 only, short of Q24 */
+#define FP_SQRT_MODE	FP_MATH_POLY
+#else
+#define FP_SQRT_MODE	FP_MATH_MODE
+#endif
+#endif
+
+#if (FP_TRIG_MODE == FP_MATH_CORDIC) || (FP_ATAN_MODE == FP_MATH_CORDIC)
+/* atan(2^-i), Q29 */
+#define FP_CORDIC_ITERATIONS	24
+#define FP_CORDIC_Q		29
+extern const int32_t fp_cordic_atan[FP_CORDIC_ITERATIONS];
+#endif
+
 Q15_t atan2_q15(Q15_t, Q15_t);
+Q15_t sin_q15(Q15_t);
+Q15_t cos_q15(Q15_t);
 Q15_t tan_q15(Q15_t);
 Q15_t sqrt_q15(Q15_t);
 Q15_t arccos_q15(Q15_t);
 Q15_t arcsin_q15(Q15_t);
 #ifdef ENABLE_Q24
-Q15_t sqrt_q24(Q15_t);
+Q24_t sqrt_q24(Q24_t);
 #endif
 
+/*
+ * Working precision of the algorithm layer (rotation vector, gravity
+ * and linear acceleration filters, tilt), chosen per build with
+ * PRECISION=q15|q24 in the Makefile (-DFP_PRECISION_Q24). Q15 is the
+ * fast build for cores without a single cycle long multiply (M0+),
+ * Q24 keeps 9 more fraction bits (M3/M4). Signals stay Q15_t in
+ * struct ThreeAxis so that their range does not change; filter
+ * coefficients, unit vectors and quaternions are QW_t.
+ */
+#ifdef FP_PRECISION_Q24
+typedef Q24_t	QW_t;
+#define QW_SHIFT	Q24_SHIFT
+#else
+typedef Q15_t	QW_t;
+#define QW_SHIFT	Q15_SHIFT
+#endif
+#define FP_to_QW(v)	((v)*(1<<QW_SHIFT))
+#define QW_to_FP(v)	((double)(v) / (1 << QW_SHIFT))
+#define Q15_to_QW(v)	((v) << (QW_SHIFT-Q15_SHIFT))
+#define QW_to_Q15(v)	((v) >> (QW_SHIFT-Q15_SHIFT))
+#define QW_ONE		(1 << QW_SHIFT)
+
+/* also scales a value of any Q format by a QW coefficient */
+static __inline QW_t MUL_QW(QW_t a, QW_t b)
+{
+	return ((int64_t)a * (int64_t)b) >> QW_SHIFT;
+}
+
+static __inline QW_t DIV_QW(QW_t a, QW_t b)
+{
+	return ((int64_t)a << QW_SHIFT) / b;
+}
+
+static __inline QW_t RECIP_QW(QW_t a)
+{
+	return DIV_QW(QW_ONE, a);
+}
+
+QW_t sqrt_qw(QW_t);
+int unit_qw(Q15_t x, Q15_t y, Q15_t z, QW_t u[3]);
+
 Q15_t pow_q15(Q15_t, Q15_t);
 Q15_t abs_q15(Q15_t);
 LQ15_t abs_lq15(LQ15_t);
@@ -0,0 +1,325 @@
+/*
+ * (C) Copyright 2015 HY Research LLC
+ *     Author: hy-git@hy-research.com
+ *
+ * Apache License.
+ *
+ */
+
+/*
+ * Game rotation vector: gyro integrated attitude quaternion, Q24.
+ *
+ * Each gyro sample rotates the quaternion by w*dt (first order
+ * update plus a first order renormalization, 23 multiplies). The
+ * accelerometer pulls the estimated gravity direction towards the
+ * measured one at a lower rate (complementary filter), so tilt does
+ * not drift. There is no magnetometer, the heading is relative to
+ * the start.
+ *
+ * q = (w, x, y, z) rotates device coordinates to world coordinates
+ * (z up), the same convention as rotvec.c.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "fpsup.h"
+#include "fp_sensor.h"
+#include "gamerotvec.h"
+
+/* Time stamps are seconds, Q24 */
+#define GRV_MAX_DT		(1 << 23)	/* 0.5s, larger gaps are not integrated */
+#define GRV_CORR_PERIOD		(1 << 19)	/* accel correction at most every 1/32s */
+
+/* Correction gain, 1/s. Tilt error decays with a time constant of 1/GRV_KP */
+#define GRV_KP			(1 << 23)	/* 0.5 */
+
+/* Accel is only trusted within this band around 1g, (m/s^2)^2 Q15 */
+#define GRV_ACC_MIN2		((int64_t)FP_to_Q15(8.0 * 8.0))
+#define GRV_ACC_MAX2		((int64_t)FP_to_Q15(11.6 * 11.6))
+
+static Q24_t q[4];		/* w, x, y, z */
+static Q24_t corr[3];		/* correction rate, rad/s */
+static uint32_t lastGyrTime, lastCorrTime;
+static int haveGyr, haveAtt;
+
+/* rounds a product (or sum of products) of two Q24 values */
+#define Q48_to_Q24(a) ((Q24_t)(((a) + (1 << (Q24_SHIFT-1))) >> Q24_SHIFT))
+
+void OSP_game_rotvec_init(void)
+{
+	q[0] = 1 << Q24_SHIFT;
+	q[1] = q[2] = q[3] = 0;
+	corr[0] = corr[1] = corr[2] = 0;
+	haveGyr = 0;
+	haveAtt = 0;
+}
+
+/* Unit vector along acc, Q24. Returns 0 if acc is too far from 1g */
+static int normalizeAcc(struct ThreeAxis *acc, Q24_t a[3])
+{
+	int64_t n2;
+	Q15_t n;
+
+	n2 = ((int64_t)acc->x * acc->x + (int64_t)acc->y * acc->y +
+		(int64_t)acc->z * acc->z) >> Q15_SHIFT;
+	if (n2 < GRV_ACC_MIN2 || n2 > GRV_ACC_MAX2)
+		return 0;
+	n = sqrt_q15((Q15_t)n2);
+
+	a[0] = ((int64_t)acc->x << Q24_SHIFT) / n;
+	a[1] = ((int64_t)acc->y << Q24_SHIFT) / n;
+	a[2] = ((int64_t)acc->z << Q24_SHIFT) / n;
+	return 1;
+}
+
+/* Attitude with the measured gravity up and zero heading */
+static void initAttitude(Q24_t a[3])
+{
+	int64_t n2;
+	Q24_t n;
+
+	/* shortest rotation taking a to z: (1 + a.z, a x z) */
+	q[0] = (1 << Q24_SHIFT) + a[2];
+	q[1] = a[1];
+	q[2] = -a[0];
+	q[3] = 0;
+	n2 = (int64_t)q[0] * q[0] + (int64_t)q[1] * q[1] + (int64_t)q[2] * q[2];
+	if (n2 < ((int64_t)1 << (2*Q24_SHIFT - 20))) {
+		/* upside down, any axis in the xy plane will do */
+		q[0] = 0;
+		q[1] = 1 << Q24_SHIFT;
+		q[2] = 0;
+		return;
+	}
+	n = sqrt_q24(Q48_to_Q24(n2));
+	q[0] = DIV_Q24(q[0], n);
+	q[1] = DIV_Q24(q[1], n);
+	q[2] = DIV_Q24(q[2], n);
+}
+
+void OSP_game_rotvec_acc(struct ThreeAxis *acc, uint32_t time)
+{
+	Q24_t a[3], v[3];
+
+	if (haveAtt && (uint32_t)(time - lastCorrTime) < GRV_CORR_PERIOD)
+		return;
+
+	if (!normalizeAcc(acc, a)) {
+		corr[0] = corr[1] = corr[2] = 0;
+		return;
+	}
+	lastCorrTime = time;
+
+	if (!haveAtt) {
+		initAttitude(a);
+		haveAtt = 1;
+		return;
+	}
+
+	/* gravity in device coordinates as estimated: third row of R(q) */
+	v[0] = Q48_to_Q24(2 * ((int64_t)q[1] * q[3] - (int64_t)q[0] * q[2]));
+	v[1] = Q48_to_Q24(2 * ((int64_t)q[2] * q[3] + (int64_t)q[0] * q[1]));
+	v[2] = Q48_to_Q24((int64_t)q[0] * q[0] - (int64_t)q[1] * q[1] -
+			(int64_t)q[2] * q[2] + (int64_t)q[3] * q[3]);
+
+	/* rotation rate that turns v towards a: KP * (a x v) */
+	corr[0] = MUL_Q24(Q48_to_Q24((int64_t)a[1] * v[2] - (int64_t)a[2] * v[1]), GRV_KP);
+	corr[1] = MUL_Q24(Q48_to_Q24((int64_t)a[2] * v[0] - (int64_t)a[0] * v[2]), GRV_KP);
+	corr[2] = MUL_Q24(Q48_to_Q24((int64_t)a[0] * v[1] - (int64_t)a[1] * v[0]), GRV_KP);
+}
+
+int OSP_game_rotvec_gyro(struct ThreeAxis *gyr, uint32_t time, struct Quat_precise *rot)
+{
+	uint32_t dt;
+	Q24_t h[3], d[4], s;
+	int64_t n2;
+
+	dt = time - lastGyrTime;
+	lastGyrTime = time;
+	if (!haveGyr) {
+		haveGyr = 1;
+		return 0;
+	}
+	if (!haveAtt || dt == 0 || dt > GRV_MAX_DT)
+		return 0;
+
+	/* half rotation angle, rad */
+	h[0] = MUL_Q24(q15_to_q24(gyr->x) + corr[0], dt) >> 1;
+	h[1] = MUL_Q24(q15_to_q24(gyr->y) + corr[1], dt) >> 1;
+	h[2] = MUL_Q24(q15_to_q24(gyr->z) + corr[2], dt) >> 1;
+
+	/* q += q * (0, h) */
+	d[0] = Q48_to_Q24(-(int64_t)q[1] * h[0] - (int64_t)q[2] * h[1] - (int64_t)q[3] * h[2]);
+	d[1] = Q48_to_Q24( (int64_t)q[0] * h[0] + (int64_t)q[2] * h[2] - (int64_t)q[3] * h[1]);
+	d[2] = Q48_to_Q24( (int64_t)q[0] * h[1] - (int64_t)q[1] * h[2] + (int64_t)q[3] * h[0]);
+	d[3] = Q48_to_Q24( (int64_t)q[0] * h[2] + (int64_t)q[1] * h[1] - (int64_t)q[2] * h[0]);
+	q[0] += d[0];
+	q[1] += d[1];
+	q[2] += d[2];
+	q[3] += d[3];
+
+	/* |q| stays close to 1: 1/|q| ~ (3 - |q|^2) / 2 */
+	n2 = (int64_t)q[0] * q[0] + (int64_t)q[1] * q[1] +
+		(int64_t)q[2] * q[2] + (int64_t)q[3] * q[3];
+	s = (3 << (Q24_SHIFT-1)) - Q48_to_Q24(n2 >> 1);
+	q[0] = Q48_to_Q24((int64_t)q[0] * s);
+	q[1] = Q48_to_Q24((int64_t)q[1] * s);
+	q[2] = Q48_to_Q24((int64_t)q[2] * s);
+	q[3] = Q48_to_Q24((int64_t)q[3] * s);
+
+	/* q and -q are the same rotation, report w >= 0 like rotvec.c */
+	if (q[0] < 0) {
+		rot->w = -q[0]; rot->x = -q[1]; rot->y = -q[2]; rot->z = -q[3];
+	} else {
+		rot->w = q[0]; rot->x = q[1]; rot->y = q[2]; rot->z = q[3];
+	}
+	return 1;
+}
+
+#ifdef TEST_GAMEROTVEC
+/*
+ * Compares against the accel/mag rotation vector of rotvec.c
+ * on recorded data, read from stdin as lines of
+ *	<a|g|m> <time, s> <x> <y> <z>
+ * in Android units, sorted by time. The step example logs convert with
+ *	cd embedded/projects/step-example
+ *	for s in accel:a gyro:g mag:m; do awk -v t=${s#*:} '/}, \/\// \
+ *		{gsub("[{},/]", " "); print t, $4, $8, $9, $10}' \
+ *		steps_${s%:*}.dat; done | sort -k2 -g > /tmp/steps.txt
+ * and build with
+ *	gcc -DFP_PRECISION_Q24 -DTEST_GAMEROTVEC -Iinclude \
+ *		-I../../include gamerotvec.c rotvec.c fp_*.c fpsup.c -lm
+ *
+ * The reference is only valid while the device is still, so only
+ * those samples are compared. Reported are the difference in tilt and
+ * the full attitude difference after removing the heading offset seen
+ * at the first comparison (the game rotation vector has no absolute
+ * heading), which includes its heading drift.
+ */
+#include <math.h>
+#include <time.h>
+#include "rotvec.h"
+
+#define TEST_SETTLE	2.0	/* s, skipped at the start */
+#define TEST_STILL_ACC	0.3	/* m/s^2, max deviation of |a| from 1g */
+#define TEST_STILL_GYR	0.1	/* rad/s, max |w| */
+#define TEST_CALLS	2000000
+
+static void toDouble(struct Quat_precise *r, double q[4])
+{
+	q[0] = Q24_to_FP(r->w);
+	q[1] = Q24_to_FP(r->x);
+	q[2] = Q24_to_FP(r->y);
+	q[3] = Q24_to_FP(r->z);
+}
+
+/* a * conj(b) */
+static void mulConj(double a[4], double b[4], double r[4])
+{
+	r[0] =  a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+	r[1] = -a[0]*b[1] + a[1]*b[0] - a[2]*b[3] + a[3]*b[2];
+	r[2] = -a[0]*b[2] + a[1]*b[3] + a[2]*b[0] - a[3]*b[1];
+	r[3] = -a[0]*b[3] - a[1]*b[2] + a[2]*b[1] + a[3]*b[0];
+}
+
+static double rotAngle(double q[4])
+{
+	double n = sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+
+	return 2.0 * acos(fmin(fabs(q[0]) / n, 1.0)) * 180.0 / M_PI;
+}
+
+static void gravityAxis(double q[4], double g[3])
+{
+	g[0] = 2*(q[1]*q[3] - q[0]*q[2]);
+	g[1] = 2*(q[2]*q[3] + q[0]*q[1]);
+	g[2] = q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3];
+}
+
+int main(int argc, char **argv)
+{
+	struct ThreeAxis acc = {0, 0, 0}, mag = {0, 0, 0}, v;
+	struct Quat_precise grv, ref;
+	double t, x, y, z, t0 = -1.0, an = 0.0, wn;
+	double q1[4], q2[4], d[4], d0[4], e[4], g1[3], g2[3], err;
+	double max_tilt = 0.0, sum_tilt = 0.0, max_att = 0.0, sum_att = 0.0;
+	int i, n = 0, haveAcc = 0, haveMag = 0;
+	uint32_t ts = 0;
+	char type;
+	clock_t c;
+
+	OSP_game_rotvec_init();
+	OSP_rotvec_init();
+
+	while (scanf(" %c %lf %lf %lf %lf", &type, &t, &x, &y, &z) == 5) {
+		if (t0 < 0)
+			t0 = t;
+
+		switch (type) {
+		case 'a':
+			acc.x = FP_to_Q15(x);
+			acc.y = FP_to_Q15(y);
+			acc.z = FP_to_Q15(z);
+			an = sqrt(x*x + y*y + z*z);
+			haveAcc = 1;
+			OSP_game_rotvec_acc(&acc, (uint32_t)(t * (1 << 24)));
+			break;
+		case 'm':
+			mag.x = FP_to_Q15(x);
+			mag.y = FP_to_Q15(y);
+			mag.z = FP_to_Q15(z);
+			haveMag = 1;
+			break;
+		case 'g':
+			v.x = FP_to_Q15(x);
+			v.y = FP_to_Q15(y);
+			v.z = FP_to_Q15(z);
+			ts = (uint32_t)(t * (1 << 24));
+			if (!OSP_game_rotvec_gyro(&v, ts, &grv))
+				break;
+
+			wn = sqrt(x*x + y*y + z*z);
+			if (!haveAcc || !haveMag || t - t0 < TEST_SETTLE ||
+				fabs(an - 9.80665) > TEST_STILL_ACC || wn > TEST_STILL_GYR)
+				break;
+
+			OSP_rotvec_process(&mag, &acc, &ref);
+
+			toDouble(&grv, q1);
+			toDouble(&ref, q2);
+			gravityAxis(q1, g1);
+			gravityAxis(q2, g2);
+			err = acos(fmin(g1[0]*g2[0] + g1[1]*g2[1] + g1[2]*g2[2], 1.0)) * 180.0 / M_PI;
+			if (err > max_tilt) max_tilt = err;
+			sum_tilt += err * err;
+
+			/* difference in world coordinates, constant heading offset if they agree */
+			mulConj(q1, q2, d);
+			if (n == 0)
+				memcpy(d0, d, sizeof(d));
+			mulConj(d, d0, e);
+			err = rotAngle(e);
+			if (err > max_att) max_att = err;
+			sum_att += err * err;
+			n++;
+			break;
+		}
+	}
+	if (n == 0) {
+		printf("no data\n");
+		return 1;
+	}
+	printf("%d still samples: tilt difference max %.2f rms %.2f deg, attitude difference max %.2f rms %.2f deg\n",
+		n, max_tilt, sqrt(sum_tilt / n), max_att, sqrt(sum_att / n));
+
+	/* 100Hz */
+	c = clock();
+	for (i = 0; i < TEST_CALLS; i++) {
+		ts += 167772;
+		OSP_game_rotvec_gyro(&v, ts, &grv);
+	}
+	printf("OSP_game_rotvec_gyro: %.1f ns/call\n",
+		1e9 * (clock() - c) / CLOCKS_PER_SEC / TEST_CALLS);
+
+	return 0;
+}
+#endif
@@ -0,0 +1,11 @@
+#ifndef _GAMEROTVEC_H_
+#define _GAMEROTVEC_H_
+
+#include "fp_sensor.h"
+
+/* Needs ENABLE_Q24, the attitude is kept in Q24 (NTPRECISE) */
+void OSP_game_rotvec_init(void);
+void OSP_game_rotvec_acc(struct ThreeAxis *acc, uint32_t time);
+int OSP_game_rotvec_gyro(struct ThreeAxis *gyr, uint32_t time, struct Quat_precise *rot);
+
+#endif
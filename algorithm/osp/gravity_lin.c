@@ -44,6 +44,15 @@ void OSP_gravity_process(struct ThreeAxis *acc, struct ThreeAxis *res)
 	res->z = LPF_CBQF_data(&zclpf, acc->z);
 };
 
+/* n samples at once, gives the same results as n OSP_gravity_process() */
+void OSP_gravity_process_block(const struct ThreeAxis *acc,
+				struct ThreeAxis *res, int n)
+{
+	LPF_CBQF_block(&xclpf, &acc->x, &res->x, n, 3);
+	LPF_CBQF_block(&yclpf, &acc->y, &res->y, n, 3);
+	LPF_CBQF_block(&zclpf, &acc->z, &res->z, n, 3);
+}
+
 void OSP_linear_acc_process(struct ThreeAxis *acc,
 				struct ThreeAxis *gravity,
 				struct ThreeAxis *res)
@@ -52,3 +61,135 @@ void OSP_linear_acc_process(struct ThreeAxis *acc,
 	res->y = acc->y - (gravity->y);
 	res->z = acc->z - (gravity->z);
 }
+
+void OSP_linear_acc_process_block(const struct ThreeAxis *acc,
+				const struct ThreeAxis *gravity,
+				struct ThreeAxis *res, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		res[i].x = acc[i].x - gravity[i].x;
+		res[i].y = acc[i].y - gravity[i].y;
+		res[i].z = acc[i].z - gravity[i].z;
+	}
+}
+
+#ifdef TEST_GRAVITY
+/*
+ * Compares the gravity filter with the same cascaded biquad in double.
+ * Build once per precision, e.g.
+ *	gcc [-DFP_PRECISION_Q24] -DTEST_GRAVITY -Iinclude -I../../include \
+ *		gravity_lin.c SecondOrderLPF.c fp_*.c fpsup.c -lm
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define TEST_SAMPLES	3000	/* 60s at 50Hz */
+#define TEST_BLOCK	25	/* e.g. a FIFO read */
+#define TEST_RUNS	200
+#define TEST_REPEAT	5
+
+struct RefBQF {
+	double a0, a1, b1, b2, x1, x2, y1, y2;
+};
+
+static void refInit(struct RefBQF *f, double Q, double fc, double dT, double x)
+{
+	double K = tan(M_PI * fc * dT), k2 = K * K, iD = 1.0 / (k2 + K / Q + 1.0);
+
+	f->a0 = k2 * iD;
+	f->a1 = 2.0 * f->a0;
+	f->b1 = 2.0 * (k2 - 1.0) * iD;
+	f->b2 = (k2 - K / Q + 1.0) * iD;
+	f->x1 = f->x2 = f->y1 = f->y2 = x;
+}
+
+static double refData(struct RefBQF *f, double x)
+{
+	double y = f->a0 * (x + f->x2) + f->a1 * f->x1 - f->b1 * f->y1 - f->b2 * f->y2;
+
+	f->x2 = f->x1;
+	f->y2 = f->y1;
+	f->x1 = x;
+	f->y1 = y;
+	return y;
+}
+
+int main(int argc, char **argv)
+{
+	struct RefBQF fa, fb;
+	struct ThreeAxis acc, grav;
+	static struct ThreeAxis in[TEST_SAMPLES], one[TEST_SAMPLES], blk[TEST_SAMPLES];
+	double t, x, ref, e, max_err = 0.0, max_dc = 0.0;
+	clock_t t0;
+	double t_one, t_blk;
+	int i, r, k;
+
+	OSP_gravity_init();
+	refInit(&fa, 0.707107, 1.5, 0.020, 9.8);
+	refInit(&fb, 0.707107, 1.5, 0.020, 9.8);
+
+	for (i = 0; i < TEST_SAMPLES; i++) {
+		/* tilting device: slow swing of z plus 8Hz hand shake */
+		t = i * 0.020;
+		x = 9.8 * cos(0.6 * sin(0.3 * t)) + 1.5 * sin(2 * M_PI * 8.0 * t);
+		acc.x = acc.y = 0;
+		acc.z = FP_to_Q15(x);
+
+		OSP_gravity_process(&acc, &grav);
+		ref = refData(&fb, refData(&fa, Q15_to_FP(acc.z)));
+
+		e = fabs(Q15_to_FP(grav.z) - ref);
+		if (e > max_err) max_err = e;
+	}
+
+	/* DC gain: settle on a constant */
+	acc.z = FP_to_Q15(9.80665);
+	for (i = 0; i < TEST_SAMPLES; i++) {
+		OSP_gravity_process(&acc, &grav);
+		if (i > TEST_SAMPLES / 2) {
+			e = fabs(Q15_to_FP(grav.z) - 9.80665);
+			if (e > max_dc) max_dc = e;
+		}
+	}
+	printf("QW_SHIFT %d gravity error: max %.2e m/s^2, DC %.2e m/s^2\n",
+		QW_SHIFT, max_err, max_dc);
+
+	/* Block filter must match the per sample one bit for bit */
+	for (i = 0; i < TEST_SAMPLES; i++) {
+		t = i * 0.020;
+		in[i].x = FP_to_Q15(2.0 * sin(0.7 * t) + 0.5 * sin(2 * M_PI * 6.0 * t));
+		in[i].y = FP_to_Q15(-1.0 + 3.0 * cos(0.2 * t));
+		in[i].z = FP_to_Q15(9.8 * cos(0.6 * sin(0.3 * t)) + 1.5 * sin(2 * M_PI * 8.0 * t));
+	}
+	/* best of TEST_REPEAT, single runs are noisy at these times */
+	t_one = t_blk = 1e30;
+	for (k = 0; k < TEST_REPEAT; k++) {
+		t0 = clock();
+		for (r = 0; r < TEST_RUNS; r++) {
+			OSP_gravity_init();
+			for (i = 0; i < TEST_SAMPLES; i++)
+				OSP_gravity_process(&in[i], &one[i]);
+		}
+		t = (double)(clock() - t0) / CLOCKS_PER_SEC;
+		if (t < t_one) t_one = t;
+		t0 = clock();
+		for (r = 0; r < TEST_RUNS; r++) {
+			OSP_gravity_init();
+			for (i = 0; i < TEST_SAMPLES; i += TEST_BLOCK)
+				OSP_gravity_process_block(&in[i], &blk[i], TEST_BLOCK);
+		}
+		t = (double)(clock() - t0) / CLOCKS_PER_SEC;
+		if (t < t_blk) t_blk = t;
+	}
+	printf("block of %d: %s, %.1f ns/sample (per sample %.1f ns/sample)\n",
+		TEST_BLOCK, memcmp(one, blk, sizeof(one)) ? "MISMATCH" : "bit exact",
+		1e9 * t_blk / TEST_RUNS / TEST_SAMPLES,
+		1e9 * t_one / TEST_RUNS / TEST_SAMPLES);
+
+	return 0;
+}
+#endif
@@ -4,10 +4,20 @@
 
 void OSP_gravity_init(void);
 void OSP_gravity_process(struct ThreeAxis *acc, struct ThreeAxis *res);
+/*
+ * n samples at once, bit exact with n OSP_gravity_process(). Used by
+ * OSP_ProcessBlock() for the accel samples of each chunk; TEST_GRAVITY
+ * in gravity_lin.c checks it against the per sample filter.
+ */
+void OSP_gravity_process_block(const struct ThreeAxis *acc,
+			struct ThreeAxis *res, int n);
 
 void OSP_linear_acc_init(void);
 void OSP_linear_acc_process(struct ThreeAxis *acc,
 			struct ThreeAxis *gravity,
 			struct ThreeAxis *res);
+void OSP_linear_acc_process_block(const struct ThreeAxis *acc,
+			const struct ThreeAxis *gravity,
+			struct ThreeAxis *res, int n);
 
 #endif
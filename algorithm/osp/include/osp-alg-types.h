@@ -57,9 +57,10 @@ typedef struct StepDataOSP_t{
     uint32_t numStepsSinceWalking;
 } StepDataOSP_t;
 
-typedef void (*OSP_StepSegmentResultCallback_t)(StepSegment_t * segment);
-typedef void (*OSP_StepResultCallback_t)(StepDataOSP_t* stepData);
-typedef void (*OSP_EventResultCallback_t)(NTTIME * eventTime);
+// Result callbacks get back the context pointer given when the algorithm instance was initialized
+typedef void (*OSP_StepSegmentResultCallback_t)(void * pContext, StepSegment_t * segment);
+typedef void (*OSP_StepResultCallback_t)(void * pContext, StepDataOSP_t* stepData);
+typedef void (*OSP_EventResultCallback_t)(void * pContext, NTTIME * eventTime);
 
 /*-------------------------------------------------------------------------------------------------*\
  |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
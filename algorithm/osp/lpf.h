@@ -1,20 +1,22 @@
 #ifndef LPF_H
 #define LPF_H	1
 
+/* Coefficients in the working precision QW, signal and state in Q15 */
 struct LPF {
-	Q15_t iQ;
+	QW_t iQ;
 	Q15_t fc;
-	Q15_t K;
-	Q15_t iD;
-	Q15_t a0;
-	Q15_t a1;
-	Q15_t b1;
-	Q15_t b2;
+	QW_t K;
+	QW_t iD;
+	QW_t a0;
+	QW_t a1;
+	QW_t b1;
+	QW_t b2;
 
 	Q15_t x1;
 	Q15_t x2;
 	Q15_t y1;
 	Q15_t y2;
+	QW_t err;	/* rounding error carried to the next sample */
 };
 
 struct LPF_CBQF {
@@ -28,6 +30,8 @@ Q15_t LPF_BQF_init(struct LPF *lpf, Q15_t x);
 Q15_t LPF_BQF_data(struct LPF *lpf, Q15_t x);
 void LPF_CBQF_init(struct LPF_CBQF *clpf, struct LPF *lpf, Q15_t x);
 Q15_t LPF_CBQF_data(struct LPF_CBQF *clpf, Q15_t x);
+void LPF_BQF_block(struct LPF *lpf, const Q15_t *in, Q15_t *out, int n, int stride);
+void LPF_CBQF_block(struct LPF_CBQF *clpf, const Q15_t *in, Q15_t *out, int n, int stride);
 
 
 
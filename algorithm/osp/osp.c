@@ -32,17 +32,20 @@
 #include "significantmotiondetector.h"
 #include "stepdetector.h"
 #include "tilt.h"
-
-#define CLEAN		0
-#define DIRTY_IN	(1<<0)
-#define DIRTY_OUT	(1<<1)
+#include "axismap.h"
+#ifdef ENABLE_Q24
+#include "gamerotvec.h"
+#endif
 
 #define SEN_ENABLE	1
 
 static struct Results RESULTS[NUM_ANDROID_SENSOR_TYPE];
-static unsigned char dirty[NUM_ANDROID_SENSOR_TYPE];
+/* FLAG() of the results updated since the last foreground pass */
+static uint64_t dirty;
 //static SystemDescriptor_t const *sys;
 static SensorDescriptor_t const *InputSensors[NUM_INPUT_SENSORS];
+/* AxisMapping[] of each registered input, resolved at registration */
+static struct AxisMap axisMap[NUM_INPUT_SENSORS];
 
 static const OSP_Library_Version_t libVersion = {
 	.VersionNumber = (OSP_VERSION_MAJOR << 16) | (OSP_VERSION_MINOR << 8) | (OSP_VERSION_PATCH),
@@ -58,13 +61,14 @@ static const uint64_t depend[NUM_ANDROID_SENSOR_TYPE] =
 	[SENSOR_ROTATION_VECTOR] = FLAG(SENSOR_GRAVITY)|FLAG(SENSOR_MAGNETIC_FIELD),
 	[SENSOR_GEOMAGNETIC_ROTATION_VECTOR] = FLAG(SENSOR_GRAVITY)|FLAG(SENSOR_MAGNETIC_FIELD),
 	[SENSOR_GRAVITY] = FLAG(SENSOR_ACCELEROMETER),
-	[SENSOR_LINEAR_ACCELERATION] = FLAG(SENSOR_ACCELEROMETER),
+	[SENSOR_LINEAR_ACCELERATION] = FLAG(SENSOR_ACCELEROMETER)|FLAG(SENSOR_GRAVITY),
 	[SENSOR_GYROSCOPE] = FLAG(SENSOR_GYROSCOPE),
 	[SENSOR_PRESSURE] = FLAG(SENSOR_PRESSURE),
-	[SENSOR_STEP_DETECTOR] = FLAG(SENSOR_ACCELEROMETER),
+	[SENSOR_STEP_DETECTOR] = FLAG(SENSOR_STEP_COUNTER),
 	[SENSOR_STEP_COUNTER] = FLAG(SENSOR_ACCELEROMETER),
 	[SENSOR_SIGNIFICANT_MOTION] = FLAG(SENSOR_ACCELEROMETER),
 	[SENSOR_TILT_DETECTOR] = FLAG(SENSOR_ACCELEROMETER),
+	[SENSOR_GAME_ROTATION_VECTOR] = FLAG(SENSOR_GYROSCOPE)|FLAG(SENSOR_ACCELEROMETER),
 };
 
 
@@ -73,13 +77,18 @@ static ResultDescriptor_t * resHandles[NUM_ANDROID_SENSOR_TYPE];
 static uint8_t sensor_state[NUM_ANDROID_SENSOR_TYPE];
 static void (*readyCB[NUM_ANDROID_SENSOR_TYPE])(struct Results *, int);
 
+/* Embedded algorithm instances */
+static SignalGenerator_t SigGen;
+static SigMotionDetector_t SigMot;
+static StepDetector_t StepDet;
+
 static void OSP_SetDataMag(Q15_t x, Q15_t y, Q15_t z, NTTIME time)
 {
 	RESULTS[SENSOR_MAGNETIC_FIELD].ResType.result.x = x;
 	RESULTS[SENSOR_MAGNETIC_FIELD].ResType.result.y = y;
 	RESULTS[SENSOR_MAGNETIC_FIELD].ResType.result.z = z;
 	RESULTS[SENSOR_MAGNETIC_FIELD].time = time;
-	dirty[SENSOR_MAGNETIC_FIELD] = DIRTY_IN | DIRTY_OUT;
+	dirty |= FLAG(SENSOR_MAGNETIC_FIELD);
 }
 
 static void OSP_SetDataAcc(Q15_t x, Q15_t y, Q15_t z, NTTIME time)
@@ -92,22 +101,22 @@ static void OSP_SetDataAcc(Q15_t x, Q15_t y, Q15_t z, NTTIME time)
 	RESULTS[SENSOR_ACCELEROMETER].ResType.result.y = y;
 	RESULTS[SENSOR_ACCELEROMETER].ResType.result.z = z;
 	RESULTS[SENSOR_ACCELEROMETER].time = time;
-	dirty[SENSOR_ACCELEROMETER] = DIRTY_IN | DIRTY_OUT;
+	dirty |= FLAG(SENSOR_ACCELEROMETER);
 
 	measurementFloat[0] = Q15_to_FP(x);
 	measurementFloat[1] = Q15_to_FP(y);
 	measurementFloat[2] = Q15_to_FP(z);
 
-	if (SignalGenerator_SetAccelerometerData(measurementFloat,
+	if (SignalGenerator_SetAccelerometerData(&SigGen, measurementFloat,
 						measurementFiltered)){
 		filterTime -= SIGNAL_GENERATOR_DELAY;
 
 		//update significant motion alg
 		SignificantMotDetector_SetFilteredAccelerometerMeasurement(
-							filterTime,
+							&SigMot, filterTime,
 							measurementFiltered);
 
-		StepDetector_SetFilteredAccelerometerMeasurement(filterTime, 
+		StepDetector_SetFilteredAccelerometerMeasurement(&StepDet, filterTime, 
 							measurementFiltered);
 	}
 }
@@ -118,7 +127,7 @@ static void OSP_SetDataGyr(Q15_t x, Q15_t y, Q15_t z, NTTIME time)
 	RESULTS[SENSOR_GYROSCOPE].ResType.result.y = y;
 	RESULTS[SENSOR_GYROSCOPE].ResType.result.z = z;
 	RESULTS[SENSOR_GYROSCOPE].time = time;
-	dirty[SENSOR_GYROSCOPE] = DIRTY_IN | DIRTY_OUT;
+	dirty |= FLAG(SENSOR_GYROSCOPE);
 }
 
 void OSPalg_SetDataBaro(Q15_t p, Q15_t t, NTTIME time)
@@ -126,7 +135,334 @@ void OSPalg_SetDataBaro(Q15_t p, Q15_t t, NTTIME time)
 	RESULTS[SENSOR_PRESSURE].ResType.result.x = p;
 	RESULTS[SENSOR_PRESSURE].ResType.result.z = t;
 	RESULTS[SENSOR_PRESSURE].time = time;
-	dirty[SENSOR_PRESSURE] = DIRTY_IN | DIRTY_OUT;
+	dirty |= FLAG(SENSOR_PRESSURE);
+}
+
+/*
+ * Fusion stages combine streams that arrive at different rates and
+ * times. Rather than running on whatever sample of each was seen last,
+ * they run on a common tick: every stream they read is buffered with
+ * its time stamp and interpolated (or held, past its newest sample) to
+ * the tick time. The tick period is the smallest OutputRateInSeconds
+ * of the subscribed fusion results, 0 ticks on every new input.
+ * Filters and integrators (gravity, step, tilt, game rotation vector)
+ * keep running on every sample. Fusion results feed no other stage.
+ */
+static const uint64_t fused = FLAG(SENSOR_ORIENTATION)|FLAG(SENSOR_ROTATION_VECTOR);
+
+#define ALIGN_STREAMS	4		/* streams read by fusion stages */
+#define ALIGN_DEPTH	16		/* samples kept per stream */
+#define ALIGN_MAX_WAIT	(1 << 21)	/* Q24 sec, hold a stream this late */
+#define ALIGN_MAX_TICKS	4		/* ticks caught up per foreground pass */
+
+#define TIME_AFTER_EQ(a, b)	((int32_t)((a) - (b)) >= 0)
+
+struct AlignBuf {
+	uint32_t time[ALIGN_DEPTH];
+	struct ThreeAxis v[ALIGN_DEPTH];
+	int head;			/* next slot to write */
+	int count;
+	struct ThreeAxis at;		/* value at the current tick */
+};
+
+static struct AlignBuf alignBuf[ALIGN_STREAMS];
+static signed char alignSlot[NUM_ANDROID_SENSOR_TYPE];
+static uint64_t alignMask;	/* FLAG() of the buffered streams */
+static uint64_t fuseRun;	/* FLAG() of the fusion stages in the run list */
+static uint32_t fusePeriod;	/* Q24 sec, 0 = on every new input */
+static uint32_t fuseTick;	/* time of the next (or current) tick */
+static int fuseStarted;
+
+#define ALIGNED(s)	(&alignBuf[alignSlot[s]].at)
+
+static void alignPush(int sensor)
+{
+	struct AlignBuf *b = &alignBuf[alignSlot[sensor]];
+
+	b->time[b->head] = RESULTS[sensor].time;
+	b->v[b->head] = RESULTS[sensor].ResType.result;
+	b->head = (b->head + 1) % ALIGN_DEPTH;
+	if (b->count < ALIGN_DEPTH)
+		b->count++;
+}
+
+static uint32_t alignLatest(struct AlignBuf *b)
+{
+	return b->time[(b->head + ALIGN_DEPTH - 1) % ALIGN_DEPTH];
+}
+
+static Q15_t lerp_q15(Q15_t a, Q15_t b, int32_t f)
+{
+	return a + (Q15_t)(((int64_t)(b - a) * f) >> Q15_SHIFT);
+}
+
+/* Sets b->at to the stream at time t */
+static void alignAt(struct AlignBuf *b, uint32_t t)
+{
+	int i, k, prev;
+	uint32_t t0, t1;
+	int32_t f;
+
+	k = (b->head + ALIGN_DEPTH - 1) % ALIGN_DEPTH;
+	if (TIME_AFTER_EQ(t, b->time[k])) {
+		b->at = b->v[k];
+		return;
+	}
+	/* Walk back to the samples either side of t */
+	for (i = 1; i < b->count; i++) {
+		prev = (k + ALIGN_DEPTH - 1) % ALIGN_DEPTH;
+		t0 = b->time[prev];
+		t1 = b->time[k];
+		if (TIME_AFTER_EQ(t, t0)) {
+			f = (int32_t)(((uint64_t)(t - t0) << Q15_SHIFT) / (t1 - t0));
+			b->at.x = lerp_q15(b->v[prev].x, b->v[k].x, f);
+			b->at.y = lerp_q15(b->v[prev].y, b->v[k].y, f);
+			b->at.z = lerp_q15(b->v[prev].z, b->v[k].z, f);
+			return;
+		}
+		k = prev;
+	}
+	b->at = b->v[k];
+}
+
+/*
+ * Derived results. Each stage computes its result from the results
+ * in its depend[] entry and returns non zero if it produced a new
+ * output. Input sensors have no stage.
+ */
+static int stage_gravity(void)
+{
+	OSP_gravity_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
+			&RESULTS[SENSOR_GRAVITY].ResType.result);
+	RESULTS[SENSOR_GRAVITY].time = RESULTS[SENSOR_ACCELEROMETER].time;
+	return 1;
+}
+
+static int stage_linear_acc(void)
+{
+	OSP_linear_acc_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
+			&RESULTS[SENSOR_GRAVITY].ResType.result,
+			&RESULTS[SENSOR_LINEAR_ACCELERATION].ResType.result);
+	RESULTS[SENSOR_LINEAR_ACCELERATION].time = RESULTS[SENSOR_ACCELEROMETER].time;
+	return 1;
+}
+
+static int stage_orientation(void)
+{
+	OSP_ecompass_process(ALIGNED(SENSOR_MAGNETIC_FIELD),
+			ALIGNED(SENSOR_GRAVITY),
+			&RESULTS[SENSOR_ORIENTATION].ResType.euler);
+	RESULTS[SENSOR_ORIENTATION].time = fuseTick;
+	return 1;
+}
+
+static int stage_rotvec(void)
+{
+	OSP_rotvec_process(ALIGNED(SENSOR_MAGNETIC_FIELD),
+			ALIGNED(SENSOR_GRAVITY),
+			&RESULTS[SENSOR_ROTATION_VECTOR].ResType.quat);
+	RESULTS[SENSOR_ROTATION_VECTOR].time = fuseTick;
+	return 1;
+}
+
+static int stage_tilt(void)
+{
+	OSP_tilt_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
+			RESULTS[SENSOR_ACCELEROMETER].time,
+			&RESULTS[SENSOR_TILT_DETECTOR].ResType.result);
+	RESULTS[SENSOR_TILT_DETECTOR].time = RESULTS[SENSOR_ACCELEROMETER].time;
+	/* tilt is an event, report it only when detected */
+	return RESULTS[SENSOR_TILT_DETECTOR].ResType.result.x;
+}
+
+#ifdef ENABLE_Q24
+/* Accel only corrects the attitude, a new output comes with each gyro sample */
+static int stage_game_rotvec(void)
+{
+	if (dirty & FLAG(SENSOR_ACCELEROMETER))
+		OSP_game_rotvec_acc(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
+				RESULTS[SENSOR_ACCELEROMETER].time);
+	if (!(dirty & FLAG(SENSOR_GYROSCOPE)))
+		return 0;
+
+	RESULTS[SENSOR_GAME_ROTATION_VECTOR].time = RESULTS[SENSOR_GYROSCOPE].time;
+	return OSP_game_rotvec_gyro(&RESULTS[SENSOR_GYROSCOPE].ResType.result,
+			RESULTS[SENSOR_GYROSCOPE].time,
+			&RESULTS[SENSOR_GAME_ROTATION_VECTOR].ResType.quat24);
+}
+#endif
+
+#ifdef FEAT_STEP
+static int stage_step(void)
+{
+	OSP_step_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
+			&RESULTS[SENSOR_STEP_COUNTER].ResType.step);
+	RESULTS[SENSOR_STEP_COUNTER].time = RESULTS[SENSOR_ACCELEROMETER].time;
+	return RESULTS[SENSOR_STEP_COUNTER].ResType.step.detect;
+}
+
+static int stage_step_detect(void)
+{
+	RESULTS[SENSOR_STEP_DETECTOR].ResType.step = RESULTS[SENSOR_STEP_COUNTER].ResType.step;
+	RESULTS[SENSOR_STEP_DETECTOR].time = RESULTS[SENSOR_STEP_COUNTER].time;
+	return 1;
+}
+#endif
+
+static int (* const stage[NUM_ANDROID_SENSOR_TYPE])(void) =
+{
+	[SENSOR_GRAVITY] = stage_gravity,
+	[SENSOR_LINEAR_ACCELERATION] = stage_linear_acc,
+	[SENSOR_ORIENTATION] = stage_orientation,
+	[SENSOR_ROTATION_VECTOR] = stage_rotvec,
+	[SENSOR_TILT_DETECTOR] = stage_tilt,
+#ifdef ENABLE_Q24
+	[SENSOR_GAME_ROTATION_VECTOR] = stage_game_rotvec,
+#endif
+#ifdef FEAT_STEP
+	[SENSOR_STEP_COUNTER] = stage_step,
+	[SENSOR_STEP_DETECTOR] = stage_step_detect,
+#endif
+};
+
+/*
+ * Stages to run, in dependency order. Rebuilt when the subscriptions
+ * change, it holds only the stages a subscribed result needs.
+ */
+static unsigned char runList[NUM_ANDROID_SENSOR_TYPE];
+static int runCount;
+static uint64_t runMask;	/* FLAG() of the stages in runList[] */
+
+static void OSPalg_BuildRunList(void)
+{
+	uint64_t need = 0, prev, done;
+	int i, added;
+
+	/* Subscribed results and everything they depend on */
+	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++)
+		if (readyCB[i])
+			need |= FLAG(i);
+	do {
+		prev = need;
+		for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++)
+			if (need & FLAG(i))
+				need |= depend[i];
+	} while (need != prev);
+
+	/* Inputs and results not needed are never waited for */
+	done = 0;
+	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++)
+		if (!stage[i] || !(need & FLAG(i)))
+			done |= FLAG(i);
+
+	/* Topological sort: repeatedly take the stages whose inputs are done */
+	runCount = 0;
+	runMask = 0;
+	do {
+		added = 0;
+		for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++) {
+			if (done & FLAG(i))
+				continue;
+			if (depend[i] & ~done)
+				continue;
+			runList[runCount++] = i;
+			runMask |= FLAG(i);
+			done |= FLAG(i);
+			added = 1;
+		}
+	} while (added);
+
+	/* Streams the fusion stages read and the tick period they want */
+	fuseRun = fused & need;
+	prev = alignMask;
+	alignMask = 0;
+	fusePeriod = 0;
+	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++) {
+		if (!(fuseRun & FLAG(i)))
+			continue;
+		alignMask |= depend[i];
+		if (readyCB[i] && resHandles[i] &&
+			resHandles[i]->OutputRateInSeconds > 0 &&
+			(fusePeriod == 0 ||
+			 (uint32_t)resHandles[i]->OutputRateInSeconds < fusePeriod))
+			fusePeriod = resHandles[i]->OutputRateInSeconds;
+	}
+	if (alignMask != prev) {
+		added = 0;
+		for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++) {
+			alignSlot[i] = -1;
+			if ((alignMask & FLAG(i)) && added < ALIGN_STREAMS)
+				alignSlot[i] = added++;
+		}
+		memset(alignBuf, 0, sizeof(alignBuf));
+	}
+	fuseStarted = 0;
+}
+
+/* Runs the fusion stages on their inputs at time t */
+static void OSPalg_FuseTick(uint32_t t)
+{
+	int i, n;
+
+	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++)
+		if (alignMask & FLAG(i))
+			alignAt(&alignBuf[alignSlot[i]], t);
+	fuseTick = t;
+
+	for (n = 0; n < runCount; n++) {
+		i = runList[n];
+		if (!(fuseRun & FLAG(i)) || !stage[i]())
+			continue;
+		if (readyCB[i] && sensor_state[i] == SEN_ENABLE)
+			(readyCB[i])(&RESULTS[i], i);
+	}
+}
+
+/*
+ * Runs the fusion ticks that are due. A tick is due once every stream
+ * has a sample at or past it, or once any stream is ALIGN_MAX_WAIT
+ * past it, the streams behind are then held at their last sample.
+ */
+static void OSPalg_Fuse(uint64_t updated)
+{
+	uint32_t oldest = 0, newest = 0, t;
+	int i, first = 1, ticks;
+
+	if (!fuseRun)
+		return;
+	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++) {
+		if (!(alignMask & FLAG(i)))
+			continue;
+		if (alignBuf[alignSlot[i]].count == 0)
+			return;
+		t = alignLatest(&alignBuf[alignSlot[i]]);
+		if (first || !TIME_AFTER_EQ(t, oldest))
+			oldest = t;
+		if (first || TIME_AFTER_EQ(t, newest))
+			newest = t;
+		first = 0;
+	}
+
+	if (fusePeriod == 0) {
+		if (updated & alignMask)
+			OSPalg_FuseTick(newest);
+		return;
+	}
+
+	if (!fuseStarted) {
+		fuseTick = newest;
+		fuseStarted = 1;
+	}
+	for (ticks = 0; ticks < ALIGN_MAX_TICKS; ticks++) {
+		if (!TIME_AFTER_EQ(oldest, fuseTick) &&
+			!TIME_AFTER_EQ(newest, fuseTick + ALIGN_MAX_WAIT))
+			return;
+		OSPalg_FuseTick(fuseTick);
+		fuseTick += fusePeriod;
+	}
+	/* Too far behind, drop the missed ticks */
+	if (TIME_AFTER_EQ(oldest, fuseTick))
+		fuseTick = oldest + fusePeriod;
 }
 
 static void OSPalg_EnableSensor(unsigned int sensor)
@@ -149,91 +485,111 @@ static void OSPalg_EnableSensor(unsigned int sensor)
 	sensor_state[sensor] = SEN_ENABLE;
 }
 
+/*
+ * While OSP_ProcessBlock() runs, results go to the caller's array
+ * instead of the result callbacks.
+ */
+static OSP_ResultSample_t *blockOut;
+static uint32_t blockCount, blockMax;
+
+static void OSPalg_BlockResult(int sensor, const void *data, size_t len)
+{
+	if (blockCount < blockMax) {
+		blockOut[blockCount].SensorType = sensor;
+		memcpy(&blockOut[blockCount].Data, data, len);
+	}
+	blockCount++;
+}
+
 /* Dispatch data in the different esoteric structure */
 static void ResultReadyCB(struct Results *res, int sensor)
 {
-	union {
-		Android_TriAxisPreciseData_t calresult;
-		Android_TriAxisExtendedData_t calmag;
-		Android_UncalibratedTriAxisPreciseData_t uncalresult;
-		Android_UncalibratedTriAxisExtendedData_t uncalmag;
-		Android_BooleanResultData_t sigmot;
-		Android_OrientationResultData_t orient;
-		Android_RotationVectorResultData_t rotvec;
-	} r;
+	OSP_ResultData_t r;
 
 	if (!resHandles[sensor])
 		return;
 	switch(sensor) {
 	case SENSOR_ACCELEROMETER:
-		r.calresult.X = Q15_to_NTPRECISE(res->ResType.result.x);
-		r.calresult.Y = Q15_to_NTPRECISE(res->ResType.result.y);
-		r.calresult.Z = Q15_to_NTPRECISE(res->ResType.result.z);
-		r.calresult.TimeStamp = res->time;
+		r.q24data.X = Q15_to_NTPRECISE(res->ResType.result.x);
+		r.q24data.Y = Q15_to_NTPRECISE(res->ResType.result.y);
+		r.q24data.Z = Q15_to_NTPRECISE(res->ResType.result.z);
+		r.q24data.TimeStamp = res->time;
 		break;
 	case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
-		r.uncalmag.X = Q15_to_NTPRECISE(res->ResType.result.x);
-		r.uncalmag.Y = Q15_to_NTPRECISE(res->ResType.result.y);
-		r.uncalmag.Z = Q15_to_NTPRECISE(res->ResType.result.z);
-		r.uncalmag.TimeStamp = res->time;
+		r.uncal_q12data.X = Q15_to_NTPRECISE(res->ResType.result.x);
+		r.uncal_q12data.Y = Q15_to_NTPRECISE(res->ResType.result.y);
+		r.uncal_q12data.Z = Q15_to_NTPRECISE(res->ResType.result.z);
+		r.uncal_q12data.TimeStamp = res->time;
 		break;
 	case SENSOR_MAGNETIC_FIELD:
-		r.calmag.X = Q15_to_NTEXTENDED(res->ResType.result.x);
-		r.calmag.Y = Q15_to_NTEXTENDED(res->ResType.result.y);
-		r.calmag.Z = Q15_to_NTEXTENDED(res->ResType.result.z);
-		r.calmag.TimeStamp = res->time;
+		r.q12data.X = Q15_to_NTEXTENDED(res->ResType.result.x);
+		r.q12data.Y = Q15_to_NTEXTENDED(res->ResType.result.y);
+		r.q12data.Z = Q15_to_NTEXTENDED(res->ResType.result.z);
+		r.q12data.TimeStamp = res->time;
 		break;
 	case SENSOR_GYROSCOPE_UNCALIBRATED:
-		r.uncalresult.X = Q15_to_NTPRECISE(res->ResType.result.x);
-		r.uncalresult.Y = Q15_to_NTPRECISE(res->ResType.result.y);
-		r.uncalresult.Z = Q15_to_NTPRECISE(res->ResType.result.z);
-		r.uncalresult.TimeStamp = res->time;
+		r.uncal_q24data.X = Q15_to_NTPRECISE(res->ResType.result.x);
+		r.uncal_q24data.Y = Q15_to_NTPRECISE(res->ResType.result.y);
+		r.uncal_q24data.Z = Q15_to_NTPRECISE(res->ResType.result.z);
+		r.uncal_q24data.TimeStamp = res->time;
 		break;
 	case SENSOR_GYROSCOPE:
-		r.calresult.X = Q15_to_NTPRECISE(res->ResType.result.x);
-		r.calresult.Y = Q15_to_NTPRECISE(res->ResType.result.y);
-		r.calresult.Z = Q15_to_NTPRECISE(res->ResType.result.z);
-		r.calresult.TimeStamp = res->time;
+		r.q24data.X = Q15_to_NTPRECISE(res->ResType.result.x);
+		r.q24data.Y = Q15_to_NTPRECISE(res->ResType.result.y);
+		r.q24data.Z = Q15_to_NTPRECISE(res->ResType.result.z);
+		r.q24data.TimeStamp = res->time;
 		break;
 	case SENSOR_ORIENTATION:
-		r.orient.Pitch = Q15_to_NTEXTENDED(res->ResType.euler.pitch);
-		r.orient.Roll = Q15_to_NTEXTENDED(res->ResType.euler.roll);
-		r.orient.Yaw = Q15_to_NTEXTENDED(res->ResType.euler.yaw);
-		r.orient.TimeStamp = res->time;
+		r.orientdata.Pitch = Q15_to_NTEXTENDED(res->ResType.euler.pitch);
+		r.orientdata.Roll = Q15_to_NTEXTENDED(res->ResType.euler.roll);
+		r.orientdata.Yaw = Q15_to_NTEXTENDED(res->ResType.euler.yaw);
+		r.orientdata.TimeStamp = res->time;
 		break;
 	case SENSOR_PRESSURE:
 		return;
 	case SENSOR_GRAVITY:
 	case SENSOR_LINEAR_ACCELERATION:
-		r.calresult.X = Q15_to_NTPRECISE(res->ResType.result.x);
-		r.calresult.Y = Q15_to_NTPRECISE(res->ResType.result.y);
-		r.calresult.Z = Q15_to_NTPRECISE(res->ResType.result.z);
-		r.calresult.TimeStamp = res->time;
+		r.q24data.X = Q15_to_NTPRECISE(res->ResType.result.x);
+		r.q24data.Y = Q15_to_NTPRECISE(res->ResType.result.y);
+		r.q24data.Z = Q15_to_NTPRECISE(res->ResType.result.z);
+		r.q24data.TimeStamp = res->time;
 		break;
 
 	case SENSOR_ROTATION_VECTOR:
-		r.rotvec.X = Q15_to_NTPRECISE(res->ResType.quat.x);
-		r.rotvec.Y = Q15_to_NTPRECISE(res->ResType.quat.y);
-		r.rotvec.Z = Q15_to_NTPRECISE(res->ResType.quat.z);
-		r.rotvec.W = Q15_to_NTPRECISE(res->ResType.quat.w);
+		r.rotvec.X = QW_to_NTPRECISE(res->ResType.quat.x);
+		r.rotvec.Y = QW_to_NTPRECISE(res->ResType.quat.y);
+		r.rotvec.Z = QW_to_NTPRECISE(res->ResType.quat.z);
+		r.rotvec.W = QW_to_NTPRECISE(res->ResType.quat.w);
+		r.rotvec.TimeStamp = res->time;
+		break;
+#ifdef ENABLE_Q24
+	case SENSOR_GAME_ROTATION_VECTOR:
+		/* already NTPRECISE */
+		r.rotvec.X = res->ResType.quat24.x;
+		r.rotvec.Y = res->ResType.quat24.y;
+		r.rotvec.Z = res->ResType.quat24.z;
+		r.rotvec.W = res->ResType.quat24.w;
 		r.rotvec.TimeStamp = res->time;
 		break;
+#endif
 	case SENSOR_SIGNIFICANT_MOTION:
 	case SENSOR_TILT_DETECTOR:
-		r.sigmot.data = true;
-		r.sigmot.TimeStamp = res->time;
+		r.booldata.data = true;
+		r.booldata.TimeStamp = res->time;
 		break;
 	default:
 		return;
 	}
-	if (resHandles[sensor]->pResultReadyCallback) {
+	if (blockOut) {
+		OSPalg_BlockResult(sensor, &r, sizeof(r));
+	} else if (resHandles[sensor]->pResultReadyCallback) {
 		printf("Calling: %i\n", sensor);
 		resHandles[sensor]->pResultReadyCallback(resHandles[sensor],
 			&r);
 	}
 }
 
-static void OnStepResultsReady( StepDataOSP_t* stepData )
+static void OnStepResultsReady(void *pContext, StepDataOSP_t* stepData)
 {
 	if (resHandles[SENSOR_STEP_COUNTER]) {
 		Android_StepCounterResultData_t callbackData;
@@ -241,13 +597,17 @@ static void OnStepResultsReady( StepDataOSP_t* stepData )
 		callbackData.StepCount = stepData->numStepsTotal;
 		callbackData.TimeStamp = stepData->startTime; //!TODO - Double check if start time or stop time
 
+		if (blockOut) {
+			OSPalg_BlockResult(SENSOR_STEP_COUNTER, &callbackData, sizeof(callbackData));
+			return;
+		}
 		resHandles[SENSOR_STEP_COUNTER]->pResultReadyCallback(
 			resHandles[SENSOR_STEP_COUNTER],
 			&callbackData);
 	}
 }
 
-static void OnSignificantMotionResult(NTTIME * eventTime)
+static void OnSignificantMotionResult(void *pContext, NTTIME * eventTime)
 {
 	if (resHandles[SENSOR_SIGNIFICANT_MOTION]) {
 		Android_BooleanResultData_t callbackData;
@@ -255,6 +615,10 @@ static void OnSignificantMotionResult(NTTIME * eventTime)
 		callbackData.data = true;
 		callbackData.TimeStamp = *eventTime;
 
+		if (blockOut) {
+			OSPalg_BlockResult(SENSOR_SIGNIFICANT_MOTION, &callbackData, sizeof(callbackData));
+			return;
+		}
 		resHandles[SENSOR_SIGNIFICANT_MOTION]->pResultReadyCallback(
 			resHandles[SENSOR_SIGNIFICANT_MOTION],
 			&callbackData);
@@ -266,6 +630,7 @@ static void OSPalg_EnableSensorCB(unsigned int sensor,
 {
 	readyCB[sensor] = ready;
 	OSPalg_EnableSensor(sensor);
+	OSPalg_BuildRunList();
 }
 
 static void OSPalg_DisableSensor(unsigned int sensor)
@@ -276,6 +641,9 @@ static void OSPalg_DisableSensor(unsigned int sensor)
 	if (sensor_state[sensor] != SEN_ENABLE)
 		return;
 
+	readyCB[sensor] = NULL;
+	OSPalg_BuildRunList();
+
 	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++) {
 		if (i == sensor) continue;
 
@@ -301,76 +669,231 @@ OSP_STATUS_t OSP_DoBackgroundProcessing(void)
 
 OSP_STATUS_t OSP_DoForegroundProcessing(void)
 {
-	int i;
-	if (sensor_state[SENSOR_GRAVITY] == SEN_ENABLE) 
-		if (dirty[SENSOR_ACCELEROMETER] & DIRTY_IN) {
-			OSP_gravity_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
-					&RESULTS[SENSOR_GRAVITY].ResType.result);
-			dirty[SENSOR_GRAVITY] = DIRTY_IN|DIRTY_OUT;
-			RESULTS[SENSOR_GRAVITY].time = RESULTS[SENSOR_ACCELEROMETER].time;
+	uint64_t pending;
+	int i, n;
+
+	/* Buffer the new inputs the fusion stages read */
+	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++)
+		if (dirty & alignMask & FLAG(i))
+			alignPush(i);
+
+	/* Run the stages whose inputs changed, their outputs feed later stages */
+	for (n = 0; n < runCount; n++) {
+		i = runList[n];
+		if (fuseRun & FLAG(i))
+			continue;
+		if ((depend[i] & dirty) && stage[i]()) {
+			dirty |= FLAG(i);
+			if (alignMask & FLAG(i))
+				alignPush(i);
 		}
+	}
 
-	if (sensor_state[SENSOR_LINEAR_ACCELERATION] == SEN_ENABLE) 
-		if (dirty[SENSOR_ACCELEROMETER] & DIRTY_IN || 
-			dirty[SENSOR_GRAVITY] & DIRTY_IN) {
-			OSP_linear_acc_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
-				&RESULTS[SENSOR_GRAVITY].ResType.result,
-				&RESULTS[SENSOR_LINEAR_ACCELERATION].ResType.result);
-			dirty[SENSOR_LINEAR_ACCELERATION] = DIRTY_IN|DIRTY_OUT;
-			RESULTS[SENSOR_LINEAR_ACCELERATION].time = RESULTS[SENSOR_ACCELEROMETER].time;
-		}
+	/* Fusion stages report from their own ticks */
+	OSPalg_Fuse(dirty);
 
-	if (sensor_state[SENSOR_ORIENTATION] == SEN_ENABLE)
-		if (dirty[SENSOR_MAGNETIC_FIELD] & DIRTY_IN ||
-			dirty[SENSOR_GRAVITY] & DIRTY_IN) {
-			OSP_ecompass_process(&RESULTS[SENSOR_MAGNETIC_FIELD].ResType.result,
-				&RESULTS[SENSOR_GRAVITY].ResType.result,
-				&RESULTS[SENSOR_ORIENTATION].ResType.euler);
-			dirty[SENSOR_ORIENTATION] = DIRTY_IN|DIRTY_OUT;
-			RESULTS[SENSOR_ORIENTATION].time = RESULTS[SENSOR_GRAVITY].time;
-		}
+	pending = dirty;
+	dirty = 0;
+	for (i = 0; pending; i++, pending >>= 1) {
+		if ((pending & 1) && readyCB[i] && sensor_state[i] == SEN_ENABLE)
+			(readyCB[i])(&RESULTS[i], i);
+	}
+
+	return OSP_STATUS_IDLE;
+}
+
+/*
+ * Converts one input sample to Q15 in the body frame. Sets *type to the
+ * input sensor; pressure is not used yet and is left unconverted.
+ */
+static OSP_STATUS_t OSPalg_ConvertInput(InputSensorHandle_t handle,
+	const OSP_InputSensorData_t *data, InputSensor_t *type,
+	struct ThreeAxis *v)
+{
+	SensorDescriptor_t *s, **h;
+	const struct AxisMap *map;
+	int32_t raw[3];
+
+	if (!handle) return OSP_STATUS_INVALID_HANDLE;
+	if (!data) return OSP_STATUS_NULL_POINTER;
+	h = handle;
+	s = *h;
+	if (!s) return OSP_STATUS_SENSOR_NOT_REGISTERED;
+	map = &axisMap[h - (SensorDescriptor_t **)InputSensors];
+
+	*type = s->SensorType;
+	if (s->SensorType == PRESSURE_INPUT_SENSOR)
+		return OSP_STATUS_OK;
 
-	if (sensor_state[SENSOR_ROTATION_VECTOR] == SEN_ENABLE)
-		if (dirty[SENSOR_MAGNETIC_FIELD] & DIRTY_IN ||
-			dirty[SENSOR_GRAVITY] & DIRTY_IN) {
-			OSP_rotvec_process(&RESULTS[SENSOR_MAGNETIC_FIELD].ResType.result,
-				&RESULTS[SENSOR_GRAVITY].ResType.result,
-				 &RESULTS[SENSOR_ROTATION_VECTOR].ResType.quat);
-			dirty[SENSOR_ROTATION_VECTOR] = DIRTY_IN|DIRTY_OUT;
-			RESULTS[SENSOR_ROTATION_VECTOR].time = RESULTS[SENSOR_GRAVITY].time;
+	OSP_axismap_apply(map, data->rawdata.data, s->ConversionOffset, raw);
+	v->x = MUL_Q15(INT_to_Q15(raw[0]), NTPRECISE_to_Q15(s->ConversionScale[map->idx[0]]));
+	v->y = MUL_Q15(INT_to_Q15(raw[1]), NTPRECISE_to_Q15(s->ConversionScale[map->idx[1]]));
+	v->z = MUL_Q15(INT_to_Q15(raw[2]), NTPRECISE_to_Q15(s->ConversionScale[map->idx[2]]));
+	return OSP_STATUS_OK;
+}
+
+/* Hands a converted sample to its input, as OSP_SetInputData() */
+static void OSPalg_SetInput(InputSensor_t type, const struct ThreeAxis *v,
+	NTTIME ts)
+{
+	switch(type) {
+	case ACCEL_INPUT_SENSOR:
+		OSP_SetDataAcc(v->x, v->y, v->z, ts);
+		break;
+	case MAG_INPUT_SENSOR:
+		OSP_SetDataMag(v->x, v->y, v->z, ts);
+		break;
+	case GYRO_INPUT_SENSOR:
+		OSP_SetDataGyr(v->x, v->y, v->z, ts);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * OSP_ProcessBlock() takes the samples BLOCK_CHUNK at a time: the chunk
+ * is converted up front and, when gravity and linear acceleration are
+ * the only stages to run, those are filtered for all the accel samples
+ * of the chunk in one go and written out directly. Other stages need
+ * the foreground pass after every sample.
+ */
+#define BLOCK_CHUNK	32
+#define BLOCK_STAGES	(FLAG(SENSOR_GRAVITY)|FLAG(SENSOR_LINEAR_ACCELERATION))
+
+static uint64_t blockEmit;	/* FLAG() of the results written out */
+
+/* Writes out a three axis result as ResultReadyCB() would */
+static void OSPalg_BlockTriAxis(int sensor, const struct ThreeAxis *v,
+	uint32_t time)
+{
+	OSP_ResultSample_t *o;
+
+	if (!(blockEmit & FLAG(sensor)))
+		return;
+	if (blockCount < blockMax) {
+		o = &blockOut[blockCount];
+		o->SensorType = sensor;
+		if (sensor == SENSOR_MAGNETIC_FIELD) {
+			o->Data.q12data.X = Q15_to_NTEXTENDED(v->x);
+			o->Data.q12data.Y = Q15_to_NTEXTENDED(v->y);
+			o->Data.q12data.Z = Q15_to_NTEXTENDED(v->z);
+			o->Data.q12data.TimeStamp = time;
+		} else {
+			o->Data.q24data.X = Q15_to_NTPRECISE(v->x);
+			o->Data.q24data.Y = Q15_to_NTPRECISE(v->y);
+			o->Data.q24data.Z = Q15_to_NTPRECISE(v->z);
+			o->Data.q24data.TimeStamp = time;
 		}
-	if (sensor_state[SENSOR_TILT_DETECTOR] == SEN_ENABLE)
-		if (dirty[SENSOR_ACCELEROMETER] & DIRTY_IN || 
-			dirty[SENSOR_TILT_DETECTOR] & DIRTY_IN) {
-			OSP_tilt_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
-				&RESULTS[SENSOR_TILT_DETECTOR].ResType.result);
-			dirty[SENSOR_TILT_DETECTOR] = DIRTY_IN|DIRTY_OUT;
-			RESULTS[SENSOR_TILT_DETECTOR].time = RESULTS[SENSOR_ACCELEROMETER].time;
+	}
+	blockCount++;
+}
+
+/*
+ * One chunk through the gravity and linear acceleration stages only.
+ * Per sample the results come out in the order of the foreground pass,
+ * the input first, then gravity and linear acceleration.
+ */
+static void OSPalg_BlockChunk(const OSP_InputSample_t *in,
+	const InputSensor_t *type, const struct ThreeAxis *v, int n)
+{
+	struct ThreeAxis acc[BLOCK_CHUNK], grav[BLOCK_CHUNK], lin[BLOCK_CHUNK];
+	uint32_t t = 0;
+	int k, na = 0;
+
+	for (k = 0; k < n; k++)
+		if (type[k] == ACCEL_INPUT_SENSOR)
+			acc[na++] = v[k];
+	if (runMask & FLAG(SENSOR_GRAVITY))
+		OSP_gravity_process_block(acc, grav, na);
+	if (runMask & FLAG(SENSOR_LINEAR_ACCELERATION))
+		OSP_linear_acc_process_block(acc, grav, lin, na);
+
+	na = 0;
+	for (k = 0; k < n; k++) {
+		/* Also runs the step and significant motion detectors */
+		OSPalg_SetInput(type[k], &v[k], in[k].Data.rawdata.TimeStamp);
+		switch (type[k]) {
+		case ACCEL_INPUT_SENSOR:
+			t = RESULTS[SENSOR_ACCELEROMETER].time;
+			OSPalg_BlockTriAxis(SENSOR_ACCELEROMETER, &v[k], t);
+			OSPalg_BlockTriAxis(SENSOR_GRAVITY, &grav[na], t);
+			OSPalg_BlockTriAxis(SENSOR_LINEAR_ACCELERATION, &lin[na], t);
+			na++;
+			break;
+		case MAG_INPUT_SENSOR:
+			OSPalg_BlockTriAxis(SENSOR_MAGNETIC_FIELD, &v[k],
+					RESULTS[SENSOR_MAGNETIC_FIELD].time);
+			break;
+		case GYRO_INPUT_SENSOR:
+			OSPalg_BlockTriAxis(SENSOR_GYROSCOPE, &v[k],
+					RESULTS[SENSOR_GYROSCOPE].time);
+			break;
+		default:
+			break;
 		}
+	}
+	dirty = 0;
 
-#ifdef FEAT_STEP
-	if (sensor_state[SENSOR_STEP_COUNTER] == SEN_ENABLE ||
-		sensor_state[SENSOR_STEP_DETECTOR] == SEN_ENABLE) 
-		if (dirty[SENSOR_ACCELEROMETER] & DIRTY_IN) {
-			OSP_step_process(&RESULTS[SENSOR_ACCELEROMETER].ResType.result,
-					&RESULTS[SENSOR_STEP_COUNTER].ResType.step);
-			if (RESULTS[SENSOR_STEP_DETECTOR].ResType.step.detect) {
-				dirty[SENSOR_STEP_COUNTER] = DIRTY_IN|DIRTY_OUT;
-				dirty[SENSOR_STEP_DETECTOR] = DIRTY_IN|DIRTY_OUT;
-			}
-			RESULTS[SENSOR_STEP_DETECTOR].time = RESULTS[SENSOR_ACCELEROMETER].time;
+	/* Leave the stage results as the last foreground pass would */
+	if (na == 0)
+		return;
+	if (runMask & FLAG(SENSOR_GRAVITY)) {
+		RESULTS[SENSOR_GRAVITY].ResType.result = grav[na - 1];
+		RESULTS[SENSOR_GRAVITY].time = t;
+	}
+	if (runMask & FLAG(SENSOR_LINEAR_ACCELERATION)) {
+		RESULTS[SENSOR_LINEAR_ACCELERATION].ResType.result = lin[na - 1];
+		RESULTS[SENSOR_LINEAR_ACCELERATION].time = t;
+	}
+}
+
+OSP_STATUS_t OSP_ProcessBlock(const OSP_InputSample_t *inputs, uint32_t n,
+		OSP_ResultSample_t *outputs, uint32_t maxOutputs,
+		uint32_t *pOutputCount)
+{
+	InputSensor_t type[BLOCK_CHUNK];
+	struct ThreeAxis v[BLOCK_CHUNK];
+	OSP_STATUS_t ret = OSP_STATUS_OK;
+	uint32_t i, m, k;
+	int sensor;
+
+	if (!inputs || !outputs || !pOutputCount)
+		return OSP_STATUS_NULL_POINTER;
+
+	blockEmit = 0;
+	for (sensor = 0; sensor < NUM_ANDROID_SENSOR_TYPE; sensor++)
+		if (readyCB[sensor] && sensor_state[sensor] == SEN_ENABLE &&
+			resHandles[sensor])
+			blockEmit |= FLAG(sensor);
+
+	blockOut = outputs;
+	blockMax = maxOutputs;
+	blockCount = 0;
+	for (i = 0; i < n && ret == OSP_STATUS_OK; i += m) {
+		/* Convert the chunk, up to the first sample that fails */
+		for (m = 0; m < BLOCK_CHUNK && i + m < n; m++) {
+			ret = OSPalg_ConvertInput(inputs[i + m].Handle,
+					&inputs[i + m].Data, &type[m], &v[m]);
+			if (ret != OSP_STATUS_OK)
+				break;
 		}
-#endif
-	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++) {
-		if (dirty[i]) {	
-			if (readyCB[i] && sensor_state[i] == SEN_ENABLE)  {
-				(readyCB[i])(&RESULTS[i], i);
-			}
-			dirty[i] = CLEAN;
+		if (!(runMask & ~BLOCK_STAGES)) {
+			OSPalg_BlockChunk(&inputs[i], type, v, m);
+			continue;
+		}
+		for (k = 0; k < m; k++) {
+			OSPalg_SetInput(type[k], &v[k],
+					inputs[i + k].Data.rawdata.TimeStamp);
+			OSP_DoForegroundProcessing();
 		}
 	}
+	blockOut = NULL;
 
-	return OSP_STATUS_IDLE;
+	*pOutputCount = blockCount;
+	if (ret == OSP_STATUS_OK && blockCount > maxOutputs)
+		ret = OSP_STATUS_BUFFER_TOO_SMALL;
+	return ret;
 }
 
 OSP_STATUS_t OSP_RegisterInputSensor(SensorDescriptor_t *SenDesc,
@@ -386,6 +909,8 @@ OSP_STATUS_t OSP_RegisterInputSensor(SensorDescriptor_t *SenDesc,
 		if (InputSensors[SenDesc->SensorType])
 			return OSP_STATUS_SENSOR_ALREADY_REGISTERED;
 		InputSensors[SenDesc->SensorType] = SenDesc;
+		OSP_axismap_compile(SenDesc->AxisMapping,
+				&axisMap[SenDesc->SensorType]);
 		*rHandle = &InputSensors[SenDesc->SensorType];
 		return OSP_STATUS_OK;
 	default:
@@ -400,75 +925,14 @@ OSP_STATUS_t OSP_RegisterInputSensor(SensorDescriptor_t *SenDesc,
 OSP_STATUS_t OSP_SetInputData(InputSensorHandle_t handle,
 	OSP_InputSensorData_t *data)
 {
-	SensorDescriptor_t *s, **v;
-	Q15_t x, y, z;
-	int32_t rawX, rawY, rawZ;
-	int32_t xidx = 0, yidx = 1, zidx = 2;
-	int32_t xs = 1, ys = 1, zs = 1;
-	int i;
-	int val[5]; //, vallen;
-	unsigned long long ts;
-
-	if (!handle) return OSP_STATUS_INVALID_HANDLE;
-	v = handle;
-	s = *v;
-	//vallen = extractOSP(s->SensorType, data, &ts, val);
-
-	for (i = 0; i < 3; i++) {
-		switch (s->AxisMapping[i]) {
-		case AXIS_MAP_POSITIVE_X:
-			xidx = i;
-			xs = 1;
-			break;
-		case AXIS_MAP_NEGATIVE_X:
-			xidx = i;
-			xs = -1;
-			break;
-		case AXIS_MAP_POSITIVE_Y:
-			yidx = i;
-			ys = 1;
-			break;
-		case AXIS_MAP_NEGATIVE_Y:
-			yidx = i;
-			ys = -1;
-			break;
-		case AXIS_MAP_POSITIVE_Z:
-			zidx = i;
-			zs = 1;
-			break;
-		case AXIS_MAP_NEGATIVE_Z:
-			zidx = i;
-			zs = -1;
-			break;
-		default:
-			break;
-		}
-	}
-	rawX = xs*val[xidx] - s->ConversionOffset[xidx];
-	rawY = ys*val[yidx] - s->ConversionOffset[yidx];
-	rawZ = zs*val[zidx] - s->ConversionOffset[zidx];
-	x = MUL_Q15(INT_to_Q15(rawX), NTPRECISE_to_Q15(s->ConversionScale[xidx]));
-	y = MUL_Q15(INT_to_Q15(rawY), NTPRECISE_to_Q15(s->ConversionScale[yidx]));
-	z = MUL_Q15(INT_to_Q15(rawZ), NTPRECISE_to_Q15(s->ConversionScale[zidx]));
-
-	switch(s->SensorType) {
-	case SENSOR_ACCELEROMETER:
-		OSP_SetDataAcc(x, y, z, ts);
-		break;
-	case SENSOR_MAGNETIC_FIELD:
-	case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
-		OSP_SetDataMag(x, y, z, ts);
-		break;
-	case SENSOR_GYROSCOPE:
-	case SENSOR_GYROSCOPE_UNCALIBRATED:
-		OSP_SetDataGyr(x, y, z, ts);
-		break;
-	case SENSOR_PRESSURE:
-		/* Ignore for now */
-		break;
-	default:
-		break;
-	}
+	InputSensor_t type;
+	struct ThreeAxis v;
+	OSP_STATUS_t ret;
+
+	ret = OSPalg_ConvertInput(handle, data, &type, &v);
+	if (ret != OSP_STATUS_OK)
+		return ret;
+	OSPalg_SetInput(type, &v, data->rawdata.TimeStamp);
 	return OSP_STATUS_OK;
 }
 
@@ -487,6 +951,9 @@ OSP_STATUS_t OSP_SubscribeSensorResult(ResultDescriptor_t *ResDesc,
 	case SENSOR_GRAVITY:
 	case SENSOR_LINEAR_ACCELERATION:
 	case SENSOR_ROTATION_VECTOR:
+#ifdef ENABLE_Q24
+	case SENSOR_GAME_ROTATION_VECTOR:
+#endif
 		if (resHandles[ResDesc->SensorType] != NULL) 
 			return OSP_STATUS_RESULT_IN_USE;
 		resHandles[ResDesc->SensorType] = ResDesc;
@@ -500,19 +967,20 @@ OSP_STATUS_t OSP_SubscribeSensorResult(ResultDescriptor_t *ResDesc,
 			return OSP_STATUS_RESULT_IN_USE;
 		resHandles[ResDesc->SensorType] = ResDesc;
 
-		StepDetector_Init(OnStepResultsReady, NULL);
+		StepDetector_Init(&StepDet, OnStepResultsReady, NULL, NULL);
 		break;
 	case SENSOR_SIGNIFICANT_MOTION:
 		if (resHandles[ResDesc->SensorType] != NULL) 
 			return OSP_STATUS_RESULT_IN_USE;
 		resHandles[ResDesc->SensorType] = ResDesc;
-		SignificantMotDetector_Init(OnSignificantMotionResult);
+		SignificantMotDetector_Init(&SigMot, OnSignificantMotionResult, NULL);
 		break;
 	case SENSOR_TILT_DETECTOR:
 		if (resHandles[ResDesc->SensorType] != NULL) 
 			return OSP_STATUS_RESULT_IN_USE;
 		resHandles[ResDesc->SensorType] = ResDesc;
 		OSP_tilt_init();
+		OSPalg_EnableSensorCB(SENSOR_TILT_DETECTOR, ResultReadyCB);
 		break;
 	default:
 		return OSP_STATUS_SENSOR_INVALID_TYPE;
@@ -535,9 +1003,9 @@ OSP_STATUS_t OSP_UnsubscribeSensorResult(ResultHandle_t ResHandle)
 		OSP_tilt_init();
 
 	if ((*rd)->SensorType == SENSOR_SIGNIFICANT_MOTION)
-		SignificantMotDetector_Init(NULL);
+		SignificantMotDetector_Init(&SigMot, NULL, NULL);
 	if ((*rd)->SensorType == SENSOR_STEP_COUNTER)
-		StepDetector_Init(NULL, NULL);
+		StepDetector_Init(&StepDet, NULL, NULL, NULL);
 
 	/* Do magic with disabling callbacks */
 	OSPalg_DisableSensor((*rd)->SensorType);
@@ -557,12 +1025,16 @@ OSP_STATUS_t OSP_Initialize(const SystemDescriptor_t *sysdesc)
 	}
 
 	for (i = 0; i < NUM_ANDROID_SENSOR_TYPE; i++) {
-		dirty[i] = CLEAN;
 		sensor_state[i] = 0;
 		readyCB[i] = NULL;
 		resHandles[i] = NULL;
 		memset(&RESULTS[i], 0, sizeof(struct Results));
 	}
+	dirty = 0;
+	runCount = 0;
+	fuseRun = 0;
+	alignMask = 0;
+	fuseStarted = 0;
 	OSP_gravity_init();
 	OSP_ecompass_init();
 	OSP_rotvec_init();
@@ -571,12 +1043,15 @@ OSP_STATUS_t OSP_Initialize(const SystemDescriptor_t *sysdesc)
 	OSP_step_init();
 #endif
 	OSP_tilt_init();
+#ifdef ENABLE_Q24
+	OSP_game_rotvec_init();
+#endif
 	//Initialize signal generator
-	SignalGenerator_Init();
+	SignalGenerator_Init(&SigGen);
 
 	//Initialize algs
-	SignificantMotDetector_Init(NULL);
-	StepDetector_Init(NULL, NULL);
+	SignificantMotDetector_Init(&SigMot, NULL, NULL);
+	StepDetector_Init(&StepDet, NULL, NULL, NULL);
 
 
 	return OSP_STATUS_OK;
@@ -9,7 +9,8 @@
 
 /*
  * Compute rotation vector from accel/mag.
- * Based on Android implementation. Converted to fixed point.
+ * Based on Android implementation. Converted to fixed point, in the
+ * working precision QW (Q15 or Q24, see fpsup.h).
  */
 
 #include <stdio.h>
@@ -17,16 +18,16 @@
 #include "fp_sensor.h"
 #include "rotvec.h"
 
-#include <math.h>
+static const QW_t qw_min_h = FP_to_QW(0.1);
 
-static Q15_t copysign_q15(Q15_t v, Q15_t s)
+static QW_t copysign_qw(QW_t v, QW_t s)
 {
 	if (s < 0) return -v;
 	else return v;
 }
 
 
-static Q15_t clamp_q15(Q15_t v)
+static QW_t clamp_qw(QW_t v)
 {
 	if (v < 0) return 0;
 	return v;
@@ -39,116 +40,199 @@ void OSP_rotvec_init()
 void OSP_rotvec_process(
 	struct ThreeAxis *mag,
 	struct ThreeAxis *acc,
-	struct Quat *rot)
+	QuatW_t *rot)
 {
-	Q15_t normH;
-	Q15_t accMag2;
-
-	Q15_t magMag2;
-	Q15_t Hx, Hy, Hz;
-	Q15_t Ex, Ey, Ez;
-
-	Q15_t invA;
-	Q15_t invH;
-
-	Q15_t Ax, Ay, Az;
-	Q15_t Mx, My, Mz;
-
-	Q15_t qw, qx, qy, qz;
-
-	Ax = acc->x;
-	Ay = acc->y;
-	Az = acc->z;
-
-	if (Ax == 0 && Ay == 0 && Az == 0) return;
-
-	Ex = mag->x;
-	Ey = mag->y;
-	Ez = mag->z;
-
-#if 0
-	printf("RV using: Ax: %f Ay: %f: Az: %f, Mx: %f, My: %f, Mz: %f\n",
-			Q15_to_FP(Ax), Q15_to_FP(Ay), Q15_to_FP(Az),
-			Q15_to_FP(Ex), Q15_to_FP(Ey), Q15_to_FP(Ez));
-#endif
-	Hx = MUL_Q15(Ey, Az) - MUL_Q15(Ez, Ay);
-	Hy = MUL_Q15(Ez, Ax) - MUL_Q15(Ex, Az);
-	Hz = MUL_Q15(Ex, Ay) - MUL_Q15(Ey, Ax);
-
-
-	magMag2 = MUL_Q15(Hx,Hx);
-	magMag2 += MUL_Q15(Hy, Hy);
-	magMag2 += MUL_Q15(Hz, Hz);
-
-	normH = sqrt_q15(magMag2);
-
-	if (normH < FP_to_Q15(0.1f)) {
-		printf("Bad mag? %f (from %f)\n", Q15_to_FP(normH), Q15_to_FP(magMag2));
-		printf("RV using: Ax: %f Ay: %f: Az: %f, Mx: %f, My: %f, Mz: %f Hx: %f Hy: %f Hz: %f (%f, %f, %f)\n",
-			Q15_to_FP(Ax), Q15_to_FP(Ay), Q15_to_FP(Az),
-			Q15_to_FP(Ex), Q15_to_FP(Ey), Q15_to_FP(Ez),
-			Q15_to_FP(Hx), Q15_to_FP(Hy), Q15_to_FP(Hz),
-			Q15_to_FP(MUL_Q15(Hx,Hx)),
-			Q15_to_FP(MUL_Q15(Hy,Hy)),
-			Q15_to_FP(MUL_Q15(Hz,Hz))
-			);
+	QW_t normH;
+	QW_t A[3], E[3];
+	QW_t Hx, Hy, Hz;
+	QW_t Ax, Ay, Az;
+	QW_t Mx, My, Mz;
+	QW_t qw, qx, qy, qz;
+
+	/*
+	 * Work on unit vectors: the raw field (uT) and acceleration
+	 * (m/s^2) would not fit the Q24 range once multiplied.
+	 */
+	if (!unit_qw(acc->x, acc->y, acc->z, A))
+		return;
+	if (!unit_qw(mag->x, mag->y, mag->z, E))
+		return;
+	Ax = A[0];
+	Ay = A[1];
+	Az = A[2];
+
+	Hx = MUL_QW(E[1], Az) - MUL_QW(E[2], Ay);
+	Hy = MUL_QW(E[2], Ax) - MUL_QW(E[0], Az);
+	Hz = MUL_QW(E[0], Ay) - MUL_QW(E[1], Ax);
+
+	/* |H| is the sine of the angle between field and gravity */
+	normH = sqrt_qw(MUL_QW(Hx, Hx) + MUL_QW(Hy, Hy) + MUL_QW(Hz, Hz));
+	if (normH < qw_min_h) {
+		printf("Bad mag? %f\n", QW_to_FP(normH));
 		return;
 	}
-	invH = RECIP_Q15(normH);
-	if (invH <= 0) {
-		printf("OF/UF?\n");
-	}
-
-	accMag2 = MUL_Q15(Ax, Ax);
-	accMag2 += MUL_Q15(Ay, Ay);
-	accMag2 += MUL_Q15(Az, Az);
 
-	if (accMag2 < 0) {
-		printf("OF? - 2\n");
+	Hx = DIV_QW(Hx, normH);
+	Hy = DIV_QW(Hy, normH);
+	Hz = DIV_QW(Hz, normH);
+
+	Mx = MUL_QW(Ay, Hz) - MUL_QW(Az, Hy);
+	My = MUL_QW(Az, Hx) - MUL_QW(Ax, Hz);
+	Mz = MUL_QW(Ax, Hy) - MUL_QW(Ay, Hx);
+
+	qw = sqrt_qw(clamp_qw( Hx+My+Az+QW_ONE) >> 2);
+	qx = sqrt_qw(clamp_qw( Hx-My-Az+QW_ONE) >> 2);
+	qy = sqrt_qw(clamp_qw(-Hx+My-Az+QW_ONE) >> 2);
+	qz = sqrt_qw(clamp_qw(-Hx-My+Az+QW_ONE) >> 2);
+
+	/*
+	 * The signs follow from the off diagonal sums. Taking them
+	 * relative to w, as Android does, is noise when w is near 0
+	 * (turns close to 180 degrees), so then take them relative to
+	 * the largest component and make w >= 0 afterwards.
+	 */
+	if (qw >= qx && qw >= qy && qw >= qz) {
+		qx = copysign_qw(qx, Ay - Mz);
+		qy = copysign_qw(qy, Hz - Ax);
+		qz = copysign_qw(qz, Mx - Hy);
+	} else {
+		if (qx >= qy && qx >= qz) {
+			qy = copysign_qw(qy, Hy + Mx);
+			qz = copysign_qw(qz, Hz + Ax);
+			qw = copysign_qw(qw, Ay - Mz);
+		} else if (qy >= qz) {
+			qx = copysign_qw(qx, Hy + Mx);
+			qz = copysign_qw(qz, Mz + Ay);
+			qw = copysign_qw(qw, Hz - Ax);
+		} else {
+			qx = copysign_qw(qx, Hz + Ax);
+			qy = copysign_qw(qy, Mz + Ay);
+			qw = copysign_qw(qw, Mx - Hy);
+		}
+		if (qw < 0) {
+			qw = -qw; qx = -qx; qy = -qy; qz = -qz;
+		}
 	}
 
-	invA = RECIP_Q15(sqrt_q15(accMag2));
-
-	Hx = DIV_Q15(Hx, normH);
-	Hy = DIV_Q15(Hy, normH);
-	Hz = DIV_Q15(Hz, normH);
+	rot->x = qx;
+	rot->y = qy;
+	rot->z = qz;
+	rot->w = qw;
+}
 
-	Ax = MUL_Q15(Ax, invA);
-	Ay = MUL_Q15(Ay, invA);
-	Az = MUL_Q15(Az, invA);
+#ifdef TEST_ROTVEC
+/*
+ * Compares with the same algorithm in double on random attitudes.
+ * Build once per precision, e.g.
+ *	gcc [-DFP_PRECISION_Q24] -DTEST_ROTVEC -Iinclude -I../../include \
+ *		rotvec.c fp_*.c fpsup.c -lm
+ */
+#include <math.h>
+#include <time.h>
 
-	Mx = MUL_Q15(Ay, Hz) - MUL_Q15(Az, Hy);
-	My = MUL_Q15(Az, Hx) - MUL_Q15(Ax, Hz);
-	Mz = MUL_Q15(Ax, Hy) - MUL_Q15(Ay, Hx);
-#if 0
-	qw = sqrt_q12(MUL_Q12(clamp_q12( Hx+My+Az+q12_c1), q12_quarter));
-	qx = sqrt_q12(MUL_Q12(clamp_q12( Hx-My-Az+q12_c1), q12_quarter));
-	qy = sqrt_q12(MUL_Q12(clamp_q12(-Hx+My-Az+q12_c1), q12_quarter));
-	qz = sqrt_q12(MUL_Q12(clamp_q12(-Hx-My+Az+q12_c1), q12_quarter));
-#else
-	{
-		Q15_t t;
+#define TEST_COUNT	100000
 
-		t = MUL_Q15(clamp_q15( Hx+My+Az+q15_c1), q15_quarter);
-		qw = sqrt_q15(t);
+static double rnd(void)
+{
+	static uint32_t seed = 12345;
 
-		t = MUL_Q15(clamp_q15( Hx-My-Az+q15_c1), q15_quarter);
-		qx = sqrt_q15(t);
+	seed = seed * 1664525 + 1013904223;
+	return (double)seed / 4294967296.0;
+}
 
-		t = MUL_Q15(clamp_q15(-Hx+My-Az+q15_c1), q15_quarter);
-		qy = sqrt_q15(t);
+/* Android getQuaternionFromVector() on the rotation matrix, in double */
+static void reference(const double E[3], const double A[3], double q[4])
+{
+	double H[3], M[3], a[3], n;
+	int i;
+
+	H[0] = E[1]*A[2] - E[2]*A[1];
+	H[1] = E[2]*A[0] - E[0]*A[2];
+	H[2] = E[0]*A[1] - E[1]*A[0];
+	n = sqrt(H[0]*H[0] + H[1]*H[1] + H[2]*H[2]);
+	for (i = 0; i < 3; i++) H[i] /= n;
+	n = sqrt(A[0]*A[0] + A[1]*A[1] + A[2]*A[2]);
+	for (i = 0; i < 3; i++) a[i] = A[i] / n;
+	M[0] = a[1]*H[2] - a[2]*H[1];
+	M[1] = a[2]*H[0] - a[0]*H[2];
+	M[2] = a[0]*H[1] - a[1]*H[0];
+
+	/* Shepperd: signs relative to the largest component */
+	q[0] = sqrt(fmax( H[0]+M[1]+a[2]+1, 0.0) / 4);
+	q[1] = sqrt(fmax( H[0]-M[1]-a[2]+1, 0.0) / 4);
+	q[2] = sqrt(fmax(-H[0]+M[1]-a[2]+1, 0.0) / 4);
+	q[3] = sqrt(fmax(-H[0]-M[1]+a[2]+1, 0.0) / 4);
+	if (q[0] >= q[1] && q[0] >= q[2] && q[0] >= q[3]) {
+		q[1] = copysign(q[1], a[1] - M[2]);
+		q[2] = copysign(q[2], H[2] - a[0]);
+		q[3] = copysign(q[3], M[0] - H[1]);
+	} else if (q[1] >= q[2] && q[1] >= q[3]) {
+		q[0] = copysign(q[0], a[1] - M[2]);
+		q[2] = copysign(q[2], H[1] + M[0]);
+		q[3] = copysign(q[3], H[2] + a[0]);
+	} else if (q[2] >= q[3]) {
+		q[0] = copysign(q[0], H[2] - a[0]);
+		q[1] = copysign(q[1], H[1] + M[0]);
+		q[3] = copysign(q[3], M[2] + a[1]);
+	} else {
+		q[0] = copysign(q[0], M[0] - H[1]);
+		q[1] = copysign(q[1], H[2] + a[0]);
+		q[2] = copysign(q[2], M[2] + a[1]);
+	}
+}
 
-		t = MUL_Q15(clamp_q15(-Hx-My+Az+q15_c1), q15_quarter);
-		qz = sqrt_q15(t);
+int main(int argc, char **argv)
+{
+	struct ThreeAxis acc, mag;
+	QuatW_t rot;
+	double q[4], r[4], A[3], E[3], d, e, max_err = 0.0, sum_err = 0.0;
+	double w, x, y, z;
+	clock_t c;
+	int i;
+
+	for (i = 0; i < TEST_COUNT; i++) {
+		/* random attitude, world field 22uT north, 40uT down */
+		do {
+			w = 2*rnd()-1; x = 2*rnd()-1; y = 2*rnd()-1; z = 2*rnd()-1;
+			d = sqrt(w*w + x*x + y*y + z*z);
+		} while (d > 1.0 || d < 0.1);
+		w /= d; x /= d; y /= d; z /= d;
+		/* device coordinates: rows of R(q) dotted with the world vector */
+		A[0] = 9.81 * 2*(x*z - w*y);
+		A[1] = 9.81 * 2*(y*z + w*x);
+		A[2] = 9.81 * (w*w - x*x - y*y + z*z);
+		E[0] = 22.0 * 2*(x*y + w*z) - 40.0 * 2*(x*z - w*y);
+		E[1] = 22.0 * (w*w - x*x + y*y - z*z) - 40.0 * 2*(y*z + w*x);
+		E[2] = 22.0 * 2*(y*z - w*x) - 40.0 * (w*w - x*x - y*y + z*z);
+
+		acc.x = FP_to_Q15(A[0]); acc.y = FP_to_Q15(A[1]); acc.z = FP_to_Q15(A[2]);
+		mag.x = FP_to_Q15(E[0]); mag.y = FP_to_Q15(E[1]); mag.z = FP_to_Q15(E[2]);
+
+		/* the reference sees the same quantized inputs */
+		A[0] = Q15_to_FP(acc.x); A[1] = Q15_to_FP(acc.y); A[2] = Q15_to_FP(acc.z);
+		E[0] = Q15_to_FP(mag.x); E[1] = Q15_to_FP(mag.y); E[2] = Q15_to_FP(mag.z);
+		reference(E, A, r);
+
+		OSP_rotvec_process(&mag, &acc, &rot);
+		q[0] = QW_to_FP(rot.w); q[1] = QW_to_FP(rot.x);
+		q[2] = QW_to_FP(rot.y); q[3] = QW_to_FP(rot.z);
+
+		/* rotation angle between the two */
+		d = fabs(q[0]*r[0] + q[1]*r[1] + q[2]*r[2] + q[3]*r[3]) /
+			sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+		e = 2.0 * acos(fmin(d, 1.0)) * 180.0 / M_PI;
+		if (e > max_err) max_err = e;
+		sum_err += e * e;
 	}
-#endif
+	printf("QW_SHIFT %d rotvec error: max %.4f rms %.4f deg\n",
+		QW_SHIFT, max_err, sqrt(sum_err / TEST_COUNT));
 
-	qx = copysign_q15(qx, Ay - Mz);
-	qy = copysign_q15(qy, Hz - Ax);
-	qz = copysign_q15(qz, Mx - Hy);
+	c = clock();
+	for (i = 0; i < TEST_COUNT; i++)
+		OSP_rotvec_process(&mag, &acc, &rot);
+	printf("OSP_rotvec_process: %.1f ns/call\n",
+		1e9 * (clock() - c) / CLOCKS_PER_SEC / TEST_COUNT);
 
-	rot->x = qx;
-	rot->y = qy;
-	rot->z = qz;
-	rot->w = qw;
+	return 0;
 }
+#endif
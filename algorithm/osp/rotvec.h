@@ -4,10 +4,6 @@
 #include "fp_sensor.h"
 
 void OSP_rotvec_init(void);
-#ifdef FEAT_ROTVEC_PRECISE
-void OSP_rotvec_process(struct ThreeAxis *, struct ThreeAxis *, struct Quat_precise *);
-#else
-void OSP_rotvec_process(struct ThreeAxis *, struct ThreeAxis *, struct Quat *);
-#endif
+void OSP_rotvec_process(struct ThreeAxis *, struct ThreeAxis *, QuatW_t *);
 
 #endif
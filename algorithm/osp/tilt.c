@@ -6,107 +6,124 @@
  *
  */
 
-/* Compute a tilt sensor as defined by Android */
+/*
+ * Compute a tilt sensor as defined by Android: an event each time the
+ * direction of the 2 second average of gravity has changed by 35
+ * degrees since activation or the last event.
+ *
+ * Samples are summed into blocks of TILT_BLOCK_TIME and the window is
+ * a running sum over the last TILT_WINDOW_BLOCKS blocks. The windows
+ * are sized from the time stamps, so the per sample cost and the
+ * memory are the same at any accelerometer rate.
+ */
 #include "fpsup.h"
+#include <string.h>
 #include "tilt.h"
 
-#define NUM_SAMPLE2	50
-#define NUM_SAMPLE1	25
+/* Time stamps are seconds, Q24 */
+#define TILT_BLOCK_TIME		(1 << 21)	/* 0.125s */
+#define TILT_WINDOW_BLOCKS	16		/* 2s window */
 
-static struct ThreeAxis accHist[NUM_SAMPLE2];
-static struct ThreeAxis prevMean;
-int sampcount;
-int samp_head, samp_tail;
+struct TiltBlock {
+	int64_t x, y, z;
+	int32_t count;
+};
 
-#define ABS(x) ((x > 0)?x:-x)
+static struct TiltBlock blocks[TILT_WINDOW_BLOCKS];
+static struct TiltBlock cur;		/* block being filled */
+static struct TiltBlock window;		/* sum of blocks[] */
+static int blk_head, blk_count;
+static uint32_t blk_start;
+static struct ThreeAxis refMean;
+static int haveRef;
+
+/* cos(35 deg), compared with the dot product of unit vectors */
+static const QW_t qw_cos_tilt = FP_to_QW(0.81915204428899178968);
 
 void OSP_tilt_init(void)
 {
-	sampcount = 0;
-	samp_head = 49, samp_tail = 0;
+	memset(blocks, 0, sizeof(blocks));
+	memset(&cur, 0, sizeof(cur));
+	memset(&window, 0, sizeof(window));
+	blk_head = 0;
+	blk_count = 0;
+	haveRef = 0;
 }
 
-static void computeMean(struct ThreeAxis *mean, struct ThreeAxis *buf, int beg, int end)
+static void computeMean(struct ThreeAxis *mean, struct TiltBlock *sum)
 {
-	int i, count;
-
-	count = 0;
-	mean->x = 0; mean->y = 0; mean->z = 0;
-	for (i = beg; i != end; i++, i %= NUM_SAMPLE2) {
-		mean->x += buf[i].x;
-		mean->y += buf[i].y;
-		mean->z += buf[i].z;
-		count++;
-	}
-	mean->x = DIV_Q15(mean->x, INT_to_Q15(count));
-	mean->y = DIV_Q15(mean->y, INT_to_Q15(count));
-	mean->z = DIV_Q15(mean->z, INT_to_Q15(count));
+	mean->x = (Q15_t)(sum->x / sum->count);
+	mean->y = (Q15_t)(sum->y / sum->count);
+	mean->z = (Q15_t)(sum->z / sum->count);
 }
 
-static Q15_t dotProduct(struct ThreeAxis *v1, struct ThreeAxis *v2)
+/* Angle between v1 and v2 larger than the tilt angle */
+static int tilted(struct ThreeAxis *v1, struct ThreeAxis *v2)
 {
-	Q15_t res;
+	QW_t u1[3], u2[3];
 
-	res = MUL_Q15(v1->x, v2->x);	
-	res += MUL_Q15(v1->y, v2->y);	
-	res += MUL_Q15(v1->z, v2->z);	
+	if (!unit_qw(v1->x, v1->y, v1->z, u1) ||
+		!unit_qw(v2->x, v2->y, v2->z, u2))
+		return 0;
 
-	return res;
+	return (MUL_QW(u1[0], u2[0]) + MUL_QW(u1[1], u2[1]) +
+		MUL_QW(u1[2], u2[2])) < qw_cos_tilt;
 }
 
-static Q15_t norm(struct ThreeAxis *v1)
+/* Move the finished block into the window, dropping the oldest one */
+static void pushBlock(void)
 {
-	Q15_t sum;
-
-	sum = MUL_Q15(v1->x, v1->x);
-	sum += MUL_Q15(v1->y, v1->y);
-	sum += MUL_Q15(v1->z, v1->z);
-	return sqrt_q15(sum);
+	struct TiltBlock *old = &blocks[blk_head];
+
+	window.x += cur.x - old->x;
+	window.y += cur.y - old->y;
+	window.z += cur.z - old->z;
+	window.count += cur.count - old->count;
+	*old = cur;
+	blk_head++;
+	blk_head %= TILT_WINDOW_BLOCKS;
+	if (blk_count < TILT_WINDOW_BLOCKS)
+		blk_count++;
+	memset(&cur, 0, sizeof(cur));
 }
 
-static Q15_t computeAngle(struct ThreeAxis *v1, struct ThreeAxis *v2)
+static void addSample(struct ThreeAxis *acc, uint32_t time)
 {
-	Q15_t v, n;
-
-	v = dotProduct(v1, v2);
-	n = MUL_Q15(norm(v1), norm(v2));
-	v = DIV_Q15(v, n);
-
-	return arccos_q15(v);	
+	if (cur.count == 0)
+		blk_start = time;
+	cur.x += acc->x;
+	cur.y += acc->y;
+	cur.z += acc->z;
+	cur.count++;
 }
 
-/* Assumes the sensor runs at 50Hz */
-void OSP_tilt_process(struct ThreeAxis *acc, struct ThreeAxis *tilt)
+void OSP_tilt_process(struct ThreeAxis *acc, uint32_t time, struct ThreeAxis *tilt)
 {
-	struct ThreeAxis cur;
-	int ang = 0;
+	struct ThreeAxis mean;
+
+	tilt->x = 0;
 
-	if (sampcount > 10000) {
-		tilt->x = 0;
+	/* unsigned difference, time stamps wrap */
+	if (cur.count == 0 || (uint32_t)(time - blk_start) < TILT_BLOCK_TIME) {
+		addSample(acc, time);
 		return;
 	}
 
+	/* this sample starts the next block */
+	pushBlock();
+	addSample(acc, time);
+	if (blk_count < TILT_WINDOW_BLOCKS)
+		return;
 
-	accHist[samp_head] = *acc;		
-
-	if (sampcount < (NUM_SAMPLE2-1)) {
-		if (sampcount == (NUM_SAMPLE1-1)) {
-			computeMean(&prevMean, accHist, 0, NUM_SAMPLE1);
-		}
-		sampcount++;
-		samp_head++;
-		samp_head %= NUM_SAMPLE2;
-		tilt->x = 0;
+	computeMean(&mean, &window);
+	if (!haveRef) {
+		refMean = mean;
+		haveRef = 1;
 		return;
 	}
 
-	computeMean(&cur, accHist, samp_tail, samp_head);
-	samp_head++; samp_head %= NUM_SAMPLE2;
-	samp_tail++; samp_tail %= NUM_SAMPLE2;
-	ang = computeAngle(&cur, &prevMean);
-	if (ABS(ang) > INT_to_Q15(35)) {
+	if (tilted(&mean, &refMean)) {
 		tilt->x = 1;
-		sampcount = 99999;	
+		refMean = mean;
 	}
-	return;
 }
@@ -4,6 +4,6 @@
 #include "fp_sensor.h"
 void OSP_tilt_init(void);
 
-void OSP_tilt_process(struct ThreeAxis *acc, struct ThreeAxis *tilt);
+void OSP_tilt_process(struct ThreeAxis *acc, uint32_t time, struct ThreeAxis *tilt);
 
 #endif
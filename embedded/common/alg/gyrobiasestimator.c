@@ -0,0 +1,302 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include "gyrobiasestimator.h"
+#include "osp-alg-types.h"
+#include <string.h>
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E   C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+// mean absolute deviation below which a sensor is considered still
+#define GYRO_STILL_DEVIATION        TOFIX_PRECISE(0.02f)    // rad/s
+#define ACC_STILL_DEVIATION         TOFIX_PRECISE(0.1f)     // m/s^2
+
+// a mean rate above this is rotation, not bias
+#define GYRO_BIAS_MAX               TOFIX_PRECISE(0.1745f)  // rad/s (10 deg/s)
+
+// seconds of stillness before samples are averaged into the bias
+#define GYRO_STILL_TIME             TOFIX_TIME(0.5f)
+
+#define GYRO_BIAS_AVERAGE_COUNT     (1 << GYRO_BIAS_AVERAGE_2N)
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E   T Y P E   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E     F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/****************************************************************************************************
+ * @fn      UpdateRunningFilters
+ *          Updates the running mean and mean absolute deviation of a 3-axis signal. The first
+ *          sample seeds the mean and starts the deviation at twice the threshold, so the signal is
+ *          only judged still once the filters have settled.
+ *
+ * @return  TRUE if the deviation of every axis is below the threshold
+ *
+ ***************************************************************************************************/
+static osp_bool_t UpdateRunningFilters(NTPRECISE mean[3], NTPRECISE deviation[3], osp_bool_t *pPrimed,
+                                       const NTPRECISE sample[3], NTPRECISE threshold){
+    osp_bool_t still = TRUE;
+    int64_t diff;
+    int64_t absDiff;
+    uint8_t i;
+
+    for(i = 0; i < 3; i++){
+        if(!*pPrimed){
+            mean[i] = sample[i];
+            deviation[i] = threshold << 1;
+        } else {
+            //64 bit so that full scale swings can't overflow
+            diff = (int64_t)sample[i] - mean[i];
+            mean[i] += (NTPRECISE)(diff >> GYRO_BIAS_FILTER_2N);
+
+            absDiff = (diff < 0) ? -diff : diff;
+            deviation[i] += (NTPRECISE)((absDiff - deviation[i]) >> GYRO_BIAS_FILTER_2N);
+        }
+        if(deviation[i] >= threshold){
+            still = FALSE;
+        }
+    }
+    *pPrimed = TRUE;
+
+    return still;
+}
+
+
+/****************************************************************************************************
+ * @fn      RestartStillBlock
+ *          Drops the partial block of still samples and restarts the stillness timer
+ *
+ ***************************************************************************************************/
+static void RestartStillBlock(GyroBiasEstimator_t * pGyroBias, const NTTIME tstamp){
+    pGyroBias->stillStartTime = tstamp;
+    pGyroBias->sumCount = 0;
+    pGyroBias->gyroSum[0] = 0;
+    pGyroBias->gyroSum[1] = 0;
+    pGyroBias->gyroSum[2] = 0;
+}
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C     F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/****************************************************************************************************
+ * @fn      GyroBiasEstimator_Init
+ *          Initializes the estimator with no bias estimate
+ *
+ ***************************************************************************************************/
+void GyroBiasEstimator_Init(GyroBiasEstimator_t * pGyroBias){
+    memset(pGyroBias, 0, sizeof(GyroBiasEstimator_t));
+    GyroBiasEstimator_Reset(pGyroBias);
+}
+
+
+/****************************************************************************************************
+ * @fn      GyroBiasEstimator_Reset
+ *          Restarts stillness detection. The current bias estimate is kept.
+ *
+ ***************************************************************************************************/
+void GyroBiasEstimator_Reset(GyroBiasEstimator_t * pGyroBias){
+    pGyroBias->gyroPrimed = FALSE;
+    pGyroBias->accelPrimed = FALSE;
+    pGyroBias->accelStill = TRUE;       //gate on the gyro alone until accelerometer data comes in
+    RestartStillBlock(pGyroBias, 0);
+}
+
+
+/****************************************************************************************************
+ * @fn      GyroBiasEstimator_SetAccelerometerMeasurement
+ *          Feeds an accelerometer sample into stillness detection. Optional, but without it a slow
+ *          steady rotation can't be told apart from bias.
+ *
+ ***************************************************************************************************/
+void GyroBiasEstimator_SetAccelerometerMeasurement(GyroBiasEstimator_t * pGyroBias, const NTTIME tstamp, const NTPRECISE acc[NUM_ACCEL_AXES]){
+    pGyroBias->accelStill = UpdateRunningFilters(pGyroBias->accMean, pGyroBias->accDeviation,
+                                                 &pGyroBias->accelPrimed, acc, ACC_STILL_DEVIATION);
+}
+
+
+/****************************************************************************************************
+ * @fn      GyroBiasEstimator_SetGyroscopeMeasurement
+ *          Feeds a gyroscope sample into the estimator. Constant work per sample.
+ *
+ * @return  TRUE if this sample completed a block and the bias estimate was updated
+ *
+ ***************************************************************************************************/
+osp_bool_t GyroBiasEstimator_SetGyroscopeMeasurement(GyroBiasEstimator_t * pGyroBias, const NTTIME tstamp, const NTPRECISE gyro[NUM_GYRO_AXES]){
+    osp_bool_t still;
+    NTPRECISE average;
+    uint8_t i;
+
+    still = UpdateRunningFilters(pGyroBias->gyroMean, pGyroBias->gyroDeviation,
+                                 &pGyroBias->gyroPrimed, gyro, GYRO_STILL_DEVIATION);
+
+    for(i = 0; i < NUM_GYRO_AXES; i++){
+        if((pGyroBias->gyroMean[i] > GYRO_BIAS_MAX) || (pGyroBias->gyroMean[i] < -GYRO_BIAS_MAX)){
+            still = FALSE;
+        }
+    }
+
+    if(!still || !pGyroBias->accelStill){
+        RestartStillBlock(pGyroBias, tstamp);
+        return FALSE;
+    }
+
+    //wait for the filters to settle on the still signal
+    if((tstamp - pGyroBias->stillStartTime) < GYRO_STILL_TIME){
+        return FALSE;
+    }
+
+    for(i = 0; i < NUM_GYRO_AXES; i++){
+        pGyroBias->gyroSum[i] += gyro[i];
+    }
+    if(++pGyroBias->sumCount < GYRO_BIAS_AVERAGE_COUNT){
+        return FALSE;
+    }
+
+    //block complete, blend its average into the estimate
+    for(i = 0; i < NUM_GYRO_AXES; i++){
+        average = (NTPRECISE)(pGyroBias->gyroSum[i] >> GYRO_BIAS_AVERAGE_2N);
+        if(pGyroBias->haveBias){
+            pGyroBias->bias[i] += (average - pGyroBias->bias[i]) >> GYRO_BIAS_BLEND_2N;
+        } else {
+            pGyroBias->bias[i] = average;
+        }
+        pGyroBias->gyroSum[i] = 0;
+    }
+    pGyroBias->sumCount = 0;
+    pGyroBias->haveBias = TRUE;
+
+    return TRUE;
+}
+
+
+/****************************************************************************************************
+ * @fn      GyroBiasEstimator_GetBias
+ *          Returns the current bias estimate
+ *
+ ***************************************************************************************************/
+osp_bool_t GyroBiasEstimator_GetBias(const GyroBiasEstimator_t * pGyroBias, NTPRECISE bias[NUM_GYRO_AXES]){
+    bias[0] = pGyroBias->bias[0];
+    bias[1] = pGyroBias->bias[1];
+    bias[2] = pGyroBias->bias[2];
+
+    return pGyroBias->haveBias;
+}
+#ifdef TEST_GYROBIAS
+/*
+ * Replays the recorded MPU6050 gyro data of the step example (table, hand, pocket, walk, stand at
+ * 50Hz) through the estimator; reports each bias update, the final estimate next to the bias the
+ * recording was calibrated with, and the cost per sample, e.g.
+ *  gcc -O2 -DTEST_GYROBIAS -I. -I../../../include gyrobiasestimator.c -o gyrobias
+ *  ./gyrobias ../../projects/step-example/steps_gyro.dat
+ */
+#include <stdio.h>
+#include <time.h>
+
+#define TEST_MAX_SAMPLES        4096
+#define TEST_RUNS               1000
+#define TEST_GYRO_SCALE         (0.001064225f)      // MPU6050 rad/s per count, as in the recording
+
+static NTPRECISE TestGyro[TEST_MAX_SAMPLES][NUM_GYRO_AXES];
+static NTTIME TestTime[TEST_MAX_SAMPLES];
+
+int main(int argc, char **argv)
+{
+    const char *path = (argc > 1) ? argv[1] : "../../projects/step-example/steps_gyro.dat";
+    GyroBiasEstimator_t est;
+    NTPRECISE bias[NUM_GYRO_AXES];
+    char line[256];
+    int raw[3], n = 0, i, run, updates = 0;
+    double t, rx, ry, rz, cx, cy, cz, ref[3] = { 0, 0, 0 }, ns;
+    struct timespec t0, t1;
+    FILE *fp;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+    while ((n < TEST_MAX_SAMPLES) && fgets(line, sizeof(line), fp)) {
+        // {raw x, raw y, raw z}, // tstamp, raw x, raw y, raw z, cal x, cal y, cal z (rad/s)
+        if (sscanf(line, " {%d, %d, %d}, // %lf, %lf, %lf, %lf, %lf, %lf, %lf", &raw[0], &raw[1], &raw[2],
+                   &t, &rx, &ry, &rz, &cx, &cy, &cz) != 10)
+            continue;
+        for (i = 0; i < NUM_GYRO_AXES; i++)
+            TestGyro[n][i] = TOFIX_PRECISE(raw[i] * TEST_GYRO_SCALE);
+        TestTime[n++] = TOFIX_TIME(t);
+        ref[0] = rx - cx;                   // bias the recording was calibrated with
+        ref[1] = ry - cy;
+        ref[2] = rz - cz;
+    }
+    fclose(fp);
+
+    GyroBiasEstimator_Init(&est);
+    for (i = 0; i < n; i++) {
+        if (GyroBiasEstimator_SetGyroscopeMeasurement(&est, TestTime[i], TestGyro[i])) {
+            GyroBiasEstimator_GetBias(&est, bias);
+            if (updates++ < 20)
+                printf("%10.3f s  bias %9.6f %9.6f %9.6f\n", TOFLT_TIME(TestTime[i]),
+                       TOFLT_PRECISE(bias[0]), TOFLT_PRECISE(bias[1]), TOFLT_PRECISE(bias[2]));
+        }
+    }
+    if (!GyroBiasEstimator_GetBias(&est, bias))
+        printf("no bias estimate\n");
+    printf("%d samples, %d updates\n", n, updates);
+    printf("estimate  %9.6f %9.6f %9.6f rad/s\n",
+           TOFLT_PRECISE(bias[0]), TOFLT_PRECISE(bias[1]), TOFLT_PRECISE(bias[2]));
+    printf("recording %9.6f %9.6f %9.6f rad/s\n", ref[0], ref[1], ref[2]);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (run = 0; run < TEST_RUNS; run++) {
+        GyroBiasEstimator_Init(&est);
+        for (i = 0; i < n; i++)
+            GyroBiasEstimator_SetGyroscopeMeasurement(&est, TestTime[i], TestGyro[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ((double)TEST_RUNS * n);
+    printf("%.1f ns per sample\n", ns);
+
+    return !est.haveBias;
+}
+#endif
+
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,106 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _GYROBIASESTIMATOR_H_
+#define _GYROBIASESTIMATOR_H_
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include "osp-alg-types.h"
+
+/*
+ * This module estimates the gyroscope bias while the device is still. It is all fixed point with
+ * constant work and memory per sample, so it can run in background processing on cores without
+ * an FPU. Stillness is judged from the mean absolute deviation of the gyro (and, if fed, the
+ * accelerometer) about a running mean; once still long enough, gyro samples are averaged in
+ * fixed size blocks and each block average is blended into the bias estimate.
+ *
+ * Data is expected in Android convention: gyro in rad/s, accel in m/s^2, both NTPRECISE.
+ */
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+#define NUM_GYRO_AXES                       (3)
+
+/* running mean and deviation filters are 1st order IIR with a gain of 2^-N */
+#define GYRO_BIAS_FILTER_2N                 (3)
+
+/* gyro samples averaged into each bias update */
+#define GYRO_BIAS_AVERAGE_2N                (6)
+
+/* gain of each block average blended into the bias estimate is 2^-N */
+#define GYRO_BIAS_BLEND_2N                  (2)
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    T Y P E   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+//! Gyro bias estimator state, one per algorithm instance
+typedef struct {
+    NTPRECISE gyroMean[NUM_GYRO_AXES];      // running mean
+    NTPRECISE gyroDeviation[NUM_GYRO_AXES]; // running mean absolute deviation about the mean
+    NTPRECISE accMean[NUM_ACCEL_AXES];
+    NTPRECISE accDeviation[NUM_ACCEL_AXES];
+
+    osp_bool_t accelStill;                  // last accelerometer sample was still (TRUE if never fed)
+    osp_bool_t gyroPrimed;                  // running gyro filters hold data
+    osp_bool_t accelPrimed;                 // running accel filters hold data
+
+    NTTIME stillStartTime;                  // time stillness began
+    int64_t gyroSum[NUM_GYRO_AXES];         // sum of still samples in the current block
+    uint16_t sumCount;                      // samples in the current block
+
+    NTPRECISE bias[NUM_GYRO_AXES];          // current bias estimate
+    osp_bool_t haveBias;                    // bias holds an estimate
+} GyroBiasEstimator_t;
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Constructor and reset methods
+void GyroBiasEstimator_Init(GyroBiasEstimator_t * pGyroBias);
+void GyroBiasEstimator_Reset(GyroBiasEstimator_t * pGyroBias);
+
+// Set methods, gyroscope returns TRUE when the bias estimate was updated
+void GyroBiasEstimator_SetAccelerometerMeasurement(GyroBiasEstimator_t * pGyroBias, const NTTIME tstamp, const NTPRECISE acc[NUM_ACCEL_AXES]);
+osp_bool_t GyroBiasEstimator_SetGyroscopeMeasurement(GyroBiasEstimator_t * pGyroBias, const NTTIME tstamp, const NTPRECISE gyro[NUM_GYRO_AXES]);
+
+// Get methods, returns FALSE (and zero bias) until a first estimate is available
+osp_bool_t GyroBiasEstimator_GetBias(const GyroBiasEstimator_t * pGyroBias, NTPRECISE bias[NUM_GYRO_AXES]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_GYROBIASESTIMATOR_H_
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,302 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include "magcalibrator.h"
+#include "osp-alg-types.h"
+#include <string.h>
+#include <math.h>
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E   C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+// Samples are summed in uT Q4. With every axis limited to MAG_CAL_MAX_FIELD the largest term,
+// sumYY, stays below 2^62 for MAG_CAL_WINDOW samples.
+#define MAG_CAL_Q                   (4)
+#define MAG_CAL_INPUT_SHIFT         (QFIXEDPOINTEXTENDED - MAG_CAL_Q)
+#define MAG_CAL_ONE                 (1 << MAG_CAL_Q)
+
+#define MAG_CAL_MAX_FIELD           (400 * MAG_CAL_ONE)     // uT, larger samples are disturbances
+#define MAG_CAL_MIN_STEP            (5 * MAG_CAL_ONE)       // uT, distance to the last sample taken
+
+// solve requirements
+#define MAG_CAL_MIN_SAMPLES         (32)
+#define MAG_CAL_MIN_SPREAD          (10 * MAG_CAL_ONE)      // uT, standard deviation left on each axis
+#define MAG_CAL_MIN_FIELD           (15.0)                  // uT, earth field is 25..65 uT
+#define MAG_CAL_MAX_FIELD_STRENGTH  (100.0)                 // uT
+#define MAG_CAL_MAX_RELATIVE_ERROR  (0.05)                  // rms radial error / field strength
+
+// a fit has to move the offset this much to replace the current calibration
+#define MAG_CAL_MIN_CHANGE          TOFIX_EXTENDED(0.5f)    // uT
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E   T Y P E   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E     F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/****************************************************************************************************
+ * @fn      HalveSums
+ *          Halves the weight of all samples in the sums, which forgets old samples exponentially
+ *
+ ***************************************************************************************************/
+static void HalveSums(MagCalibrator_t * pMagCal){
+    uint8_t i;
+
+    for(i = 0; i < NUM_MAG_AXES; i++){
+        pMagCal->sumM[i] >>= 1;
+        pMagCal->sumMY[i] >>= 1;
+    }
+    for(i = 0; i < 6; i++){
+        pMagCal->sumMM[i] >>= 1;
+    }
+    pMagCal->sumY >>= 1;
+    pMagCal->sumYY >>= 1;
+    pMagCal->count >>= 1;
+}
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C     F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/****************************************************************************************************
+ * @fn      MagCalibrator_Init
+ *          Initializes the calibrator with no calibration
+ *
+ ***************************************************************************************************/
+void MagCalibrator_Init(MagCalibrator_t * pMagCal){
+    memset(pMagCal, 0, sizeof(MagCalibrator_t));
+}
+
+
+/****************************************************************************************************
+ * @fn      MagCalibrator_Reset
+ *          Drops all samples collected so far. The current calibration is kept.
+ *
+ ***************************************************************************************************/
+void MagCalibrator_Reset(MagCalibrator_t * pMagCal){
+    MagCalibration_t cal = pMagCal->cal;
+    osp_bool_t haveCal = pMagCal->haveCal;
+
+    memset(pMagCal, 0, sizeof(MagCalibrator_t));
+    pMagCal->cal = cal;
+    pMagCal->haveCal = haveCal;
+}
+
+
+/****************************************************************************************************
+ * @fn      MagCalibrator_SetMagnetometerMeasurement
+ *          Adds a magnetometer sample to the fit. Constant work per sample; samples too close to
+ *          the last one taken add nothing but weight on one spot and are skipped.
+ *
+ * @return  TRUE if enough samples were added since the last solve that a new one is due
+ *
+ ***************************************************************************************************/
+osp_bool_t MagCalibrator_SetMagnetometerMeasurement(MagCalibrator_t * pMagCal, const NTTIME tstamp, const NTEXTENDED mag[NUM_MAG_AXES]){
+    int32_t m[NUM_MAG_AXES];
+    int32_t step = 0;
+    int64_t y;
+    uint8_t i;
+
+    for(i = 0; i < NUM_MAG_AXES; i++){
+        m[i] = mag[i] >> MAG_CAL_INPUT_SHIFT;
+        if((m[i] > MAG_CAL_MAX_FIELD) || (m[i] < -MAG_CAL_MAX_FIELD)){
+            return FALSE;
+        }
+        step += (m[i] > pMagCal->lastSample[i]) ? (m[i] - pMagCal->lastSample[i]) : (pMagCal->lastSample[i] - m[i]);
+    }
+
+    if(pMagCal->haveLastSample && (step < MAG_CAL_MIN_STEP)){
+        return FALSE;
+    }
+    pMagCal->lastSample[0] = m[0];
+    pMagCal->lastSample[1] = m[1];
+    pMagCal->lastSample[2] = m[2];
+    pMagCal->haveLastSample = TRUE;
+
+    if(pMagCal->count >= MAG_CAL_WINDOW){
+        HalveSums(pMagCal);
+    }
+
+    y = (int64_t)m[0]*m[0] + (int64_t)m[1]*m[1] + (int64_t)m[2]*m[2];
+
+    for(i = 0; i < NUM_MAG_AXES; i++){
+        pMagCal->sumM[i] += m[i];
+        pMagCal->sumMY[i] += m[i]*y;
+    }
+    pMagCal->sumMM[0] += (int64_t)m[0]*m[0];
+    pMagCal->sumMM[1] += (int64_t)m[0]*m[1];
+    pMagCal->sumMM[2] += (int64_t)m[0]*m[2];
+    pMagCal->sumMM[3] += (int64_t)m[1]*m[1];
+    pMagCal->sumMM[4] += (int64_t)m[1]*m[2];
+    pMagCal->sumMM[5] += (int64_t)m[2]*m[2];
+    pMagCal->sumY += y;
+    pMagCal->sumYY += y*y;
+    pMagCal->count++;
+
+    return (++pMagCal->sinceSolve >= MAG_CAL_SOLVE_INTERVAL) ? TRUE : FALSE;
+}
+
+
+/****************************************************************************************************
+ * @fn      MagCalibrator_Solve
+ *          Fits a sphere to the samples in the sums. With the samples centered the offset c solves
+ *              Cov(m) 2c = Cov(m, |m|^2)
+ *          which is done with an LDL' decomposition; its pivots are the spread of the samples left
+ *          on each axis and must be large enough for the offset to be observable. The fit is
+ *          accepted if its field strength is plausible and the samples lie close to the sphere.
+ *          Bounded cost, independent of the number of samples, but in double precision, so meant
+ *          for background processing.
+ *
+ * @return  TRUE if the fit was accepted and changed the calibration
+ *
+ ***************************************************************************************************/
+osp_bool_t MagCalibrator_Solve(MagCalibrator_t * pMagCal){
+    osp_dbl_t n, mean[NUM_MAG_AXES], yMean;
+    osp_dbl_t c00, c01, c02, c11, c12, c22;     // Cov(m)
+    osp_dbl_t d[NUM_MAG_AXES];                  // Cov(m, y)
+    osp_dbl_t l10, l20, l21, p0, p1, p2;        // LDL' of Cov(m)
+    osp_dbl_t z1, z2, g[NUM_MAG_AXES];          // g = 2c
+    osp_dbl_t radius2, residual, radius, fitError;
+    const osp_dbl_t minPivot = (osp_dbl_t)MAG_CAL_MIN_SPREAD * MAG_CAL_MIN_SPREAD;
+    const osp_dbl_t toUT = 1.0 / MAG_CAL_ONE;
+    NTEXTENDED offset[NUM_MAG_AXES];
+    osp_bool_t changed;
+    uint8_t i;
+
+    pMagCal->sinceSolve = 0;
+    if(pMagCal->count < MAG_CAL_MIN_SAMPLES){
+        return FALSE;
+    }
+
+    n = (osp_dbl_t)pMagCal->count;
+    for(i = 0; i < NUM_MAG_AXES; i++){
+        mean[i] = (osp_dbl_t)pMagCal->sumM[i] / n;
+    }
+    yMean = (osp_dbl_t)pMagCal->sumY / n;
+
+    c00 = (osp_dbl_t)pMagCal->sumMM[0] / n - mean[0]*mean[0];
+    c01 = (osp_dbl_t)pMagCal->sumMM[1] / n - mean[0]*mean[1];
+    c02 = (osp_dbl_t)pMagCal->sumMM[2] / n - mean[0]*mean[2];
+    c11 = (osp_dbl_t)pMagCal->sumMM[3] / n - mean[1]*mean[1];
+    c12 = (osp_dbl_t)pMagCal->sumMM[4] / n - mean[1]*mean[2];
+    c22 = (osp_dbl_t)pMagCal->sumMM[5] / n - mean[2]*mean[2];
+    for(i = 0; i < NUM_MAG_AXES; i++){
+        d[i] = (osp_dbl_t)pMagCal->sumMY[i] / n - mean[i]*yMean;
+    }
+
+    //decompose, bailing out if the samples don't span all three axes
+    p0 = c00;
+    if(p0 < minPivot){
+        return FALSE;
+    }
+    l10 = c01 / p0;
+    l20 = c02 / p0;
+    p1 = c11 - l10*l10*p0;
+    if(p1 < minPivot){
+        return FALSE;
+    }
+    l21 = (c12 - l20*l10*p0) / p1;
+    p2 = c22 - l20*l20*p0 - l21*l21*p1;
+    if(p2 < minPivot){
+        return FALSE;
+    }
+
+    //forward, diagonal and back substitution
+    z1 = d[1] - l10*d[0];
+    z2 = d[2] - l20*d[0] - l21*z1;
+    g[2] = z2 / p2;
+    g[1] = z1 / p1 - l21*g[2];
+    g[0] = d[0] / p0 - l10*g[1] - l20*g[2];
+
+    //|m - c|^2 = r^2 with k = r^2 - |c|^2 = mean(y) - 2c.mean(m)
+    radius2 = yMean - (g[0]*mean[0] + g[1]*mean[1] + g[2]*mean[2])
+            + 0.25*(g[0]*g[0] + g[1]*g[1] + g[2]*g[2]);
+    if(radius2 <= 0.0){
+        return FALSE;
+    }
+    radius = sqrt(radius2);
+
+    //mean squared error of y left by the fit, and the radial error it amounts to
+    residual = (osp_dbl_t)pMagCal->sumYY / n - yMean*yMean - (g[0]*d[0] + g[1]*d[1] + g[2]*d[2]);
+    if(residual < 0.0){
+        residual = 0.0;
+    }
+    fitError = sqrt(residual) / (2.0 * radius);
+
+    if((radius*toUT < MAG_CAL_MIN_FIELD) || (radius*toUT > MAG_CAL_MAX_FIELD_STRENGTH) ||
+       (fitError > radius*MAG_CAL_MAX_RELATIVE_ERROR)){
+        return FALSE;
+    }
+
+    changed = !pMagCal->haveCal;
+    for(i = 0; i < NUM_MAG_AXES; i++){
+        offset[i] = TOFIX_EXTENDED(0.5*g[i]*toUT);
+        if((offset[i] - pMagCal->cal.HardIronOffset[i] > MAG_CAL_MIN_CHANGE) ||
+           (pMagCal->cal.HardIronOffset[i] - offset[i] > MAG_CAL_MIN_CHANGE)){
+            changed = TRUE;
+        }
+    }
+    if(!changed){
+        return FALSE;
+    }
+
+    for(i = 0; i < NUM_MAG_AXES; i++){
+        pMagCal->cal.HardIronOffset[i] = offset[i];
+    }
+    pMagCal->cal.FieldStrength = TOFIX_EXTENDED(radius*toUT);
+    pMagCal->cal.FitError = TOFIX_EXTENDED(fitError*toUT);
+    pMagCal->haveCal = TRUE;
+
+    return TRUE;
+}
+
+
+/****************************************************************************************************
+ * @fn      MagCalibrator_GetCalibration
+ *          Returns the current calibration
+ *
+ ***************************************************************************************************/
+osp_bool_t MagCalibrator_GetCalibration(const MagCalibrator_t * pMagCal, MagCalibration_t * pCal){
+    *pCal = pMagCal->cal;
+
+    return pMagCal->haveCal;
+}
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
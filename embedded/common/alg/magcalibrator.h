@@ -0,0 +1,112 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef _MAGCALIBRATOR_H_
+#define _MAGCALIBRATOR_H_
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include "osp-alg-types.h"
+
+/*
+ * This module estimates the magnetometer hard iron offset on line. Each sample that has moved far
+ * enough from the last one taken is added to a running least squares sphere fit
+ *     |m|^2 = 2 c.m + k,   offset c, field strength sqrt(k + |c|^2)
+ * at constant cost; the sums are halved whenever the window fills so that the fit follows changes
+ * in the magnetic environment. Every MAG_CAL_SOLVE_INTERVAL samples a solve is due, which the caller
+ * runs with MagCalibrator_Solve(); its cost is bounded (one 3x3 Cholesky solve).
+ *
+ * Data is expected in Android convention, uT in NTEXTENDED.
+ */
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+#define NUM_MAG_AXES                        (3)
+
+/* accepted samples between solves */
+#define MAG_CAL_SOLVE_INTERVAL              (16)
+
+/* the sums are halved once they hold this many samples */
+#define MAG_CAL_WINDOW                      (256)
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    T Y P E   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+//! Magnetometer calibration result, also the record handed to the calibration (NVM) callback
+typedef struct {
+    NTEXTENDED HardIronOffset[NUM_MAG_AXES];    // uT, to be subtracted from the raw field
+    NTEXTENDED FieldStrength;                   // uT, radius of the fitted sphere
+    NTEXTENDED FitError;                        // uT, rms radial error of the fit
+} MagCalibration_t;
+
+//! Magnetometer calibrator state, one per algorithm instance
+typedef struct {
+    // running sums of the sphere fit, field in uT Q4 (see magcalibrator.c)
+    int64_t sumM[NUM_MAG_AXES];                 // m
+    int64_t sumMM[6];                           // m m', xx xy xz yy yz zz
+    int64_t sumY;                               // y = |m|^2
+    int64_t sumMY[NUM_MAG_AXES];                // m y
+    int64_t sumYY;                              // y^2
+    uint16_t count;                             // samples in the sums
+    uint16_t sinceSolve;                        // samples added since the last solve
+
+    int32_t lastSample[NUM_MAG_AXES];           // last sample taken, uT Q4
+    osp_bool_t haveLastSample;
+
+    MagCalibration_t cal;                       // current calibration
+    osp_bool_t haveCal;                         // cal holds an accepted fit
+} MagCalibrator_t;
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Constructor and reset methods
+void MagCalibrator_Init(MagCalibrator_t * pMagCal);
+void MagCalibrator_Reset(MagCalibrator_t * pMagCal);
+
+// Set methods, returns TRUE when a solve is due
+osp_bool_t MagCalibrator_SetMagnetometerMeasurement(MagCalibrator_t * pMagCal, const NTTIME tstamp, const NTEXTENDED mag[NUM_MAG_AXES]);
+
+// Solves the fit, returns TRUE if it was accepted and moved the calibration
+osp_bool_t MagCalibrator_Solve(MagCalibrator_t * pMagCal);
+
+// Get methods, returns FALSE (and zero offset) until a first fit is accepted
+osp_bool_t MagCalibrator_GetCalibration(const MagCalibrator_t * pMagCal, MagCalibration_t * pCal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_MAGCALIBRATOR_H_
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
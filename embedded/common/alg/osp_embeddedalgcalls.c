@@ -39,9 +39,6 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-static OSP_StepResultCallback_t _fpStepResultCallback = NULL;
-static OSP_StepSegmentResultCallback_t _fpStepSegmentResultCallback = NULL;
-static OSP_EventResultCallback_t _fpSigMotCallback = NULL;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
@@ -64,13 +61,20 @@ static OSP_EventResultCallback_t _fpSigMotCallback = NULL;
  *          Call to initialize the algorithms implementation.
  *
  ***************************************************************************************************/
-void OSP_InitializeAlgorithms(void){
+void OSP_InitializeAlgorithms(OSP_AlgContext_t * pAlg, void * pCallbackContext){
+    //No results registered yet
+    pAlg->fpStepResultCallback = NULL;
+    pAlg->fpStepSegmentResultCallback = NULL;
+    pAlg->fpSigMotCallback = NULL;
+    pAlg->pCallbackContext = pCallbackContext;
+
     //Initialize signal generator
-    SignalGenerator_Init();
+    SignalGenerator_Init(&pAlg->SigGen);
 
     //Initialize algs
-    SignificantMotDetector_Init(_fpSigMotCallback);
-    StepDetector_Init(_fpStepResultCallback, _fpStepSegmentResultCallback);
+    SignificantMotDetector_Init(&pAlg->SigMot, pAlg->fpSigMotCallback, pAlg->pCallbackContext);
+    StepDetector_Init(&pAlg->StepDet, pAlg->fpStepResultCallback, pAlg->fpStepSegmentResultCallback,
+                      pAlg->pCallbackContext);
 }
 
 
@@ -79,10 +83,10 @@ void OSP_InitializeAlgorithms(void){
  *          Call this to reset the algorithms to initial startup state
  *
  ***************************************************************************************************/
-void OSP_ResetAlgorithms(void){
-    SignalGenerator_Init();
-    StepDetector_Reset();
-    SignificantMotDetector_Reset();
+void OSP_ResetAlgorithms(OSP_AlgContext_t * pAlg){
+    SignalGenerator_Init(&pAlg->SigGen);
+    StepDetector_Reset(&pAlg->StepDet);
+    SignificantMotDetector_Reset(&pAlg->SigMot);
 }
 
 
@@ -91,9 +95,9 @@ void OSP_ResetAlgorithms(void){
  *          Call this function before exit to shutdown the algorithms properly
  *
  ***************************************************************************************************/
-void OSP_DestroyAlgorithms(void){
-    StepDetector_CleanUp();
-    SignificantMotDetector_CleanUp();
+void OSP_DestroyAlgorithms(OSP_AlgContext_t * pAlg){
+    StepDetector_CleanUp(&pAlg->StepDet);
+    SignificantMotDetector_CleanUp(&pAlg->SigMot);
 }
 
 
@@ -102,7 +106,7 @@ void OSP_DestroyAlgorithms(void){
  *          API to feed accelerometer data into the algorithms
  *
  ***************************************************************************************************/
-void OSP_SetAccelerometerMeasurement(const NTTIME timeInSeconds, const NTPRECISE measurementInMetersPerSecondSquare[NUM_ACCEL_AXES]){
+void OSP_SetAccelerometerMeasurement(OSP_AlgContext_t * pAlg, const NTTIME timeInSeconds, const NTPRECISE measurementInMetersPerSecondSquare[NUM_ACCEL_AXES]){
     //convert sensor data to floating point
     osp_float_t measurementFloat[NUM_ACCEL_AXES];
     osp_float_t measurementFiltered[NUM_ACCEL_AXES];
@@ -113,15 +117,15 @@ void OSP_SetAccelerometerMeasurement(const NTTIME timeInSeconds, const NTPRECISE
     measurementFloat[2] = TOFLT_PRECISE(measurementInMetersPerSecondSquare[2]);
 
     //update signal generator
-    if(SignalGenerator_SetAccelerometerData(measurementFloat, measurementFiltered)){
+    if(SignalGenerator_SetAccelerometerData(&pAlg->SigGen, measurementFloat, measurementFiltered)){
 
         filterTime -= SIGNAL_GENERATOR_DELAY;
 
         //update significant motion alg
-        SignificantMotDetector_SetFilteredAccelerometerMeasurement(filterTime,
+        SignificantMotDetector_SetFilteredAccelerometerMeasurement(&pAlg->SigMot, filterTime,
                                                                    measurementFiltered);
         //update step detector alg
-        StepDetector_SetFilteredAccelerometerMeasurement(filterTime, measurementFiltered);
+        StepDetector_SetFilteredAccelerometerMeasurement(&pAlg->StepDet, filterTime, measurementFiltered);
     }
 
 }
@@ -132,9 +136,10 @@ void OSP_SetAccelerometerMeasurement(const NTTIME timeInSeconds, const NTPRECISE
  *          Register step segment call back with the algorithms
  *
  ***************************************************************************************************/
-void OSP_RegisterStepSegmentCallback(OSP_StepSegmentResultCallback_t fpCallback){
-    _fpStepSegmentResultCallback = fpCallback;
-    StepDetector_Init(_fpStepResultCallback, _fpStepSegmentResultCallback);
+void OSP_RegisterStepSegmentCallback(OSP_AlgContext_t * pAlg, OSP_StepSegmentResultCallback_t fpCallback){
+    pAlg->fpStepSegmentResultCallback = fpCallback;
+    StepDetector_Init(&pAlg->StepDet, pAlg->fpStepResultCallback, pAlg->fpStepSegmentResultCallback,
+                      pAlg->pCallbackContext);
 }
 
 
@@ -143,9 +148,10 @@ void OSP_RegisterStepSegmentCallback(OSP_StepSegmentResultCallback_t fpCallback)
  *          Register step result call back with the algorithms
  *
  ***************************************************************************************************/
-void OSP_RegisterStepCallback(OSP_StepResultCallback_t fpCallback){
-    _fpStepResultCallback = fpCallback;
-    StepDetector_Init(_fpStepResultCallback, _fpStepSegmentResultCallback);
+void OSP_RegisterStepCallback(OSP_AlgContext_t * pAlg, OSP_StepResultCallback_t fpCallback){
+    pAlg->fpStepResultCallback = fpCallback;
+    StepDetector_Init(&pAlg->StepDet, pAlg->fpStepResultCallback, pAlg->fpStepSegmentResultCallback,
+                      pAlg->pCallbackContext);
 }
 
 
@@ -154,9 +160,9 @@ void OSP_RegisterStepCallback(OSP_StepResultCallback_t fpCallback){
  *          Register significant motion call back with the algorithms
  *
  ***************************************************************************************************/
-void OSP_RegisterSignificantMotionCallback(OSP_EventResultCallback_t fpCallback){
-    _fpSigMotCallback = fpCallback;
-    SignificantMotDetector_Init(_fpSigMotCallback);
+void OSP_RegisterSignificantMotionCallback(OSP_AlgContext_t * pAlg, OSP_EventResultCallback_t fpCallback){
+    pAlg->fpSigMotCallback = fpCallback;
+    SignificantMotDetector_Init(&pAlg->SigMot, pAlg->fpSigMotCallback, pAlg->pCallbackContext);
 }
 
 /*-------------------------------------------------------------------------------------------------*\
@@ -22,6 +22,9 @@
  |    I N C L U D E   F I L E S
 \*-------------------------------------------------------------------------------------------------*/
 #include "osp-alg-types.h"
+#include "signalgenerator.h"
+#include "significantmotiondetector.h"
+#include "stepdetector.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,18 +34,21 @@ extern "C" {
  * This is the embedded API for OSP algorithms.
  * Note that all data passed in/out is in fixed point formats.
  *
+ * All algorithm state lives in an OSP_AlgContext_t owned by the caller, so several independent
+ * instances may run side by side. Result callbacks get back the context pointer given at start-up.
+ *
  * On start-up, call:
- * -) OSP_InitializeAlgorithms();
+ * -) OSP_InitializeAlgorithms(pAlg, pCallbackContext);
  *
  * When registering for a result, call:
- * -) OSP_RegisterXXCallback(); (for all XX results desired)
- * -) OSP_ResetAlgorithms();
+ * -) OSP_RegisterXXCallback(pAlg, ...); (for all XX results desired)
+ * -) OSP_ResetAlgorithms(pAlg);
  *
  * On new accel data, call:
- * -) OSP_SetAccelerometerMeasurement(time, acc);
+ * -) OSP_SetAccelerometerMeasurement(pAlg, time, acc);
  *
  * On shut-down, call:
- * -) OSP_DestroyAlgorithms();
+ * -) OSP_DestroyAlgorithms(pAlg);
  *
  */
 
@@ -53,6 +59,17 @@ extern "C" {
 /*-------------------------------------------------------------------------------------------------*\
  |    T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
+//! State of one instance of the embedded algorithms
+typedef struct {
+    SignalGenerator_t SigGen;
+    SigMotionDetector_t SigMot;
+    StepDetector_t StepDet;
+
+    OSP_StepResultCallback_t fpStepResultCallback;
+    OSP_StepSegmentResultCallback_t fpStepSegmentResultCallback;
+    OSP_EventResultCallback_t fpSigMotCallback;
+    void * pCallbackContext;        // handed back to the result callbacks
+} OSP_AlgContext_t;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
@@ -66,19 +83,24 @@ extern "C" {
  |    P U B L I C   F U N C T I O N   D E C L A R A T I O N S
 \*-------------------------------------------------------------------------------------------------*/
 //! Initialize call for algorithm code
-void OSP_InitializeAlgorithms(void);
+/*!
+*  \param pAlg IN algorithm instance to initialize.
+*  \param pCallbackContext IN context pointer handed back to the result callbacks.
+*/
+void OSP_InitializeAlgorithms(OSP_AlgContext_t * pAlg, void * pCallbackContext);
 
 //! Call to reset algorithm internal state
-void OSP_ResetAlgorithms(void);
+void OSP_ResetAlgorithms(OSP_AlgContext_t * pAlg);
 
 //! Tears down algorithm setup
-void OSP_DestroyAlgorithms(void);
+void OSP_DestroyAlgorithms(OSP_AlgContext_t * pAlg);
 
 //! Sends sensor data into the underlying algorithms for processing
 /*!
 *  Passes raw accelerometer sensor data into the algorithm code for processing.
 *  When a result is triggered, the appropriate callback will be called.
 *
+*  \param pAlg IN algorithm instance.
 *  \param timeInSeconds IN timestamp of the corresponding sensor measurement.
 *         Expected data format NTTIME is fixed point format 64 bit, Q24.
 *  \param measurementInMetersPerSecondSquare IN raw 3-axis accelerometer sensor
@@ -86,7 +108,7 @@ void OSP_DestroyAlgorithms(void);
 *         Expected data format NTPRECISE is fixed point format 32 bit, Q24.
 *
 */
-void OSP_SetAccelerometerMeasurement(const NTTIME timeInSeconds, const NTPRECISE measurementInMetersPerSecondSquare[NUM_ACCEL_AXES]);
+void OSP_SetAccelerometerMeasurement(OSP_AlgContext_t * pAlg, const NTTIME timeInSeconds, const NTPRECISE measurementInMetersPerSecondSquare[NUM_ACCEL_AXES]);
 
 //! Registers a callback for step detection results
 /*!
@@ -95,7 +117,7 @@ void OSP_SetAccelerometerMeasurement(const NTTIME timeInSeconds, const NTPRECISE
 *
 *  \param fpCallback IN function pointer for step result callback.
 */
-void OSP_RegisterStepCallback(OSP_StepResultCallback_t fpCallback);
+void OSP_RegisterStepCallback(OSP_AlgContext_t * pAlg, OSP_StepResultCallback_t fpCallback);
 
 
 //! Registers a callback for step segment results
@@ -105,7 +127,7 @@ void OSP_RegisterStepCallback(OSP_StepResultCallback_t fpCallback);
 *
 *  \param fpCallback IN function pointer for step segment callback.
 */
-void OSP_RegisterStepSegmentCallback(OSP_StepSegmentResultCallback_t fpCallback);
+void OSP_RegisterStepSegmentCallback(OSP_AlgContext_t * pAlg, OSP_StepSegmentResultCallback_t fpCallback);
 
 
 //! Registers a callback for significant motion results
@@ -115,7 +137,7 @@ void OSP_RegisterStepSegmentCallback(OSP_StepSegmentResultCallback_t fpCallback)
 *
 *  \param fpCallback IN function pointer for significant motion callback.
 */
-void OSP_RegisterSignificantMotionCallback(OSP_EventResultCallback_t fpCallback);
+void OSP_RegisterSignificantMotionCallback(OSP_AlgContext_t * pAlg, OSP_EventResultCallback_t fpCallback);
 
 #ifdef __cplusplus
 }
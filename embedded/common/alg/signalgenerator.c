@@ -38,23 +38,15 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    P R I V A T E   T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-typedef struct {
-    uint16_t callcounter;
-
-    osp_float_t accbuf[NUM_ACCEL_AXES][AVERAGING_FILTER_BUF_SIZE];
-    osp_float_t accAccumulator[NUM_ACCEL_AXES];
-
-} SignalGenerator_t;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-static SignalGenerator_t _signalGenerator;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-static osp_bool_t PerformFiltering(const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t* accFilteredOut);
+static osp_bool_t PerformFiltering(SignalGenerator_t * pSigGen, const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t* accFilteredOut);
 
 /*-------------------------------------------------------------------------------------------------*\
  |    P U B L I C   V A R I A B L E S   D E F I N I T I O N S
@@ -69,8 +61,8 @@ static osp_bool_t PerformFiltering(const osp_float_t accInMetersPerSecondSquare[
  *          Initializes memory for signal generator structure
  *
  ***************************************************************************************************/
-void SignalGenerator_Init(void) {
-    memset(&_signalGenerator,0,sizeof(_signalGenerator));
+void SignalGenerator_Init(SignalGenerator_t * pSigGen) {
+    memset(pSigGen,0,sizeof(SignalGenerator_t));
 }
 
 /****************************************************************************************************
@@ -80,8 +72,8 @@ void SignalGenerator_Init(void) {
  *          when the accFilteredOut variable has been updated.
  *
  ***************************************************************************************************/
-osp_bool_t SignalGenerator_SetAccelerometerData(const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t* accFilteredOut){
-    return PerformFiltering(accInMetersPerSecondSquare, accFilteredOut);
+osp_bool_t SignalGenerator_SetAccelerometerData(SignalGenerator_t * pSigGen, const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t* accFilteredOut){
+    return PerformFiltering(pSigGen, accInMetersPerSecondSquare, accFilteredOut);
 }
 
 /****************************************************************************************************
@@ -104,28 +96,28 @@ osp_float_t SignalGenerator_UpdateMovingWindowMean(osp_float_t * buffer, osp_flo
  *          Returns true if filtered data was updated.
  *
  ***************************************************************************************************/
-osp_bool_t PerformFiltering(const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t *accFilteredOut) {
+osp_bool_t PerformFiltering(SignalGenerator_t * pSigGen, const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t *accFilteredOut) {
     uint8_t iAxis;
     osp_bool_t success = FALSE;
 
-    const uint16_t movingWindowIdx = _signalGenerator.callcounter & (uint16_t)AVERAGING_FILTER_BUF_MASK;
+    const uint16_t movingWindowIdx = pSigGen->callcounter & (uint16_t)AVERAGING_FILTER_BUF_MASK;
 
     // Compute moving average of input acceleration data
     for (iAxis = 0; iAxis < NUM_ACCEL_AXES; iAxis++) {
-        accFilteredOut[iAxis] = SignalGenerator_UpdateMovingWindowMean(_signalGenerator.accbuf[iAxis],
-                                                                    &_signalGenerator.accAccumulator[iAxis],
+        accFilteredOut[iAxis] = SignalGenerator_UpdateMovingWindowMean(pSigGen->accbuf[iAxis],
+                                                                    &pSigGen->accAccumulator[iAxis],
                                                                     accInMetersPerSecondSquare[iAxis],
                                                                     movingWindowIdx,
                                                                     AVERAGING_FILTER_BUF_SIZE_2N);
     }
 
     /// Decimate
-    if ((_signalGenerator.callcounter > AVERAGING_FILTER_BUF_SIZE-1) &&
-        ((_signalGenerator.callcounter & DECIMATION_MASK) == DECIMATION_MASK)) {
+    if ((pSigGen->callcounter > AVERAGING_FILTER_BUF_SIZE-1) &&
+        ((pSigGen->callcounter & DECIMATION_MASK) == DECIMATION_MASK)) {
         success = TRUE;
     }
 
-    _signalGenerator.callcounter++;
+    pSigGen->callcounter++;
 
     return success;
 }
@@ -46,6 +46,14 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
+//! Signal generator (prefilter) state, one per algorithm instance
+typedef struct {
+    uint16_t callcounter;
+
+    osp_float_t accbuf[NUM_ACCEL_AXES][AVERAGING_FILTER_BUF_SIZE];
+    osp_float_t accAccumulator[NUM_ACCEL_AXES];
+
+} SignalGenerator_t;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
@@ -64,10 +72,10 @@ extern "C" {
 #endif
 
 // Constructor
-void SignalGenerator_Init(void);
+void SignalGenerator_Init(SignalGenerator_t * pSigGen);
 
 // Returns true if filtered signal is updated
-osp_bool_t SignalGenerator_SetAccelerometerData(const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t* accFilteredOut);
+osp_bool_t SignalGenerator_SetAccelerometerData(SignalGenerator_t * pSigGen, const osp_float_t accInMetersPerSecondSquare[NUM_ACCEL_AXES], osp_float_t* accFilteredOut);
 
 // Moving average function
 osp_float_t SignalGenerator_UpdateMovingWindowMean(osp_float_t * buffer, osp_float_t * pMeanAccumulator,
@@ -31,9 +31,6 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    P R I V A T E   C O N S T A N T S   &   M A C R O S
 \*-------------------------------------------------------------------------------------------------*/
-/* moving window size for mean and noise - assumed input rate between 6-8Hz */
-#define MOVING_WINDOW_MEAN_BUF_SIZE_2N (3)
-#define MOVING_WINDOW_MEAN_BUF_SIZE (1 << MOVING_WINDOW_MEAN_BUF_SIZE_2N)
 #define MOVING_WINDOW_MEAN_BUF_MASK (MOVING_WINDOW_MEAN_BUF_SIZE - 1)
 
 // thresholds for triggering significant motion
@@ -55,26 +52,10 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    P R I V A T E   T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-// struct for containing significant motion detector data
-typedef struct {
-    OSP_EventResultCallback_t sigMotCallback;
-
-    osp_float_t meanbuf[NUM_ACCEL_AXES][MOVING_WINDOW_MEAN_BUF_SIZE];
-    osp_float_t meanaccumulator[NUM_ACCEL_AXES];
-
-    osp_float_t energybuf[MOVING_WINDOW_MEAN_BUF_SIZE];
-    osp_float_t energyaccumulator;
-
-    osp_bool_t isSignificantMotion;
-
-    uint8_t motionCounter;
-    uint8_t signalCounter;
-} SigMotionDetector_t;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-static SigMotionDetector_t _sigMotData;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
@@ -87,8 +68,8 @@ static SigMotionDetector_t _sigMotData;
 /*-------------------------------------------------------------------------------------------------*\
  |    P R I V A T E     F U N C T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-static osp_float_t UpdateSignals(const osp_float_t sigIn[NUM_ACCEL_AXES]);
-static void SignificantMotionStateMachine(const NTTIME time, const osp_float_t energy);
+static osp_float_t UpdateSignals(SigMotionDetector_t * pSigMot, const osp_float_t sigIn[NUM_ACCEL_AXES]);
+static void SignificantMotionStateMachine(SigMotionDetector_t * pSigMot, const NTTIME time, const osp_float_t energy);
 
 
 /****************************************************************************************************
@@ -96,11 +77,13 @@ static void SignificantMotionStateMachine(const NTTIME time, const osp_float_t e
  *          Initializes callback function variable and all underlying private variables
  *
  ***************************************************************************************************/
-void SignificantMotDetector_Init(OSP_EventResultCallback_t pSigMotionCallback){
-    _sigMotData.sigMotCallback = pSigMotionCallback;    
+void SignificantMotDetector_Init(SigMotionDetector_t * pSigMot, OSP_EventResultCallback_t pSigMotionCallback,
+                                 void * pCallbackContext){
+    pSigMot->sigMotCallback = pSigMotionCallback;
+    pSigMot->pCallbackContext = pCallbackContext;
 
     //Reset buffers
-    SignificantMotDetector_Reset();
+    SignificantMotDetector_Reset(pSigMot);
 }
 
 /****************************************************************************************************
@@ -108,8 +91,8 @@ void SignificantMotDetector_Init(OSP_EventResultCallback_t pSigMotionCallback){
  *          Clears callback function variable
  *
  ***************************************************************************************************/
-void SignificantMotDetector_CleanUp(void){
-    _sigMotData.sigMotCallback = NULL;
+void SignificantMotDetector_CleanUp(SigMotionDetector_t * pSigMot){
+    pSigMot->sigMotCallback = NULL;
 }
 
 /****************************************************************************************************
@@ -117,10 +100,12 @@ void SignificantMotDetector_CleanUp(void){
  *          Resets filter variables
  *
  ***************************************************************************************************/
-void SignificantMotDetector_Reset(void){
-    OSP_EventResultCallback_t callback = _sigMotData.sigMotCallback;
-    memset(&_sigMotData,0,sizeof(_sigMotData));
-    _sigMotData.sigMotCallback = callback;
+void SignificantMotDetector_Reset(SigMotionDetector_t * pSigMot){
+    OSP_EventResultCallback_t callback = pSigMot->sigMotCallback;
+    void * pCallbackContext = pSigMot->pCallbackContext;
+    memset(pSigMot,0,sizeof(SigMotionDetector_t));
+    pSigMot->sigMotCallback = callback;
+    pSigMot->pCallbackContext = pCallbackContext;
 }
 
 /****************************************************************************************************
@@ -128,14 +113,14 @@ void SignificantMotDetector_Reset(void){
  *          Main worker of significant motion detector. Results are only produced when this is called
  *
  ***************************************************************************************************/
-void SignificantMotDetector_SetFilteredAccelerometerMeasurement(const NTTIME tstamp, const osp_float_t acc[NUM_ACCEL_AXES]){
+void SignificantMotDetector_SetFilteredAccelerometerMeasurement(SigMotionDetector_t * pSigMot, const NTTIME tstamp, const osp_float_t acc[NUM_ACCEL_AXES]){
     osp_float_t totalEnergy;
 
-    totalEnergy = UpdateSignals(acc);
+    totalEnergy = UpdateSignals(pSigMot, acc);
 
     //Run state machine once buffers have been filled
-    if(_sigMotData.signalCounter >= MOVING_WINDOW_MEAN_BUF_SIZE){
-        SignificantMotionStateMachine(tstamp, totalEnergy);
+    if(pSigMot->signalCounter >= MOVING_WINDOW_MEAN_BUF_SIZE){
+        SignificantMotionStateMachine(pSigMot, tstamp, totalEnergy);
     }
 }
 
@@ -144,8 +129,8 @@ void SignificantMotDetector_SetFilteredAccelerometerMeasurement(const NTTIME tst
  *          Computes energy signal used for significant motion detection
  *
  ***************************************************************************************************/
-osp_float_t UpdateSignals(const osp_float_t accIn[NUM_ACCEL_AXES]) {
-    const uint16_t movingWindowIdx = _sigMotData.signalCounter & (uint16_t)MOVING_WINDOW_MEAN_BUF_MASK;
+osp_float_t UpdateSignals(SigMotionDetector_t * pSigMot, const osp_float_t accIn[NUM_ACCEL_AXES]) {
+    const uint16_t movingWindowIdx = pSigMot->signalCounter & (uint16_t)MOVING_WINDOW_MEAN_BUF_MASK;
     uint8_t i;    
     osp_float_t absAccMinusMean[NUM_ACCEL_AXES];
     osp_float_t mean[NUM_ACCEL_AXES];
@@ -156,8 +141,8 @@ osp_float_t UpdateSignals(const osp_float_t accIn[NUM_ACCEL_AXES]) {
     for (i = 0; i < NUM_ACCEL_AXES; i++) {
 
         // mean of filtered accel over window
-        mean[i] = SignalGenerator_UpdateMovingWindowMean(_sigMotData.meanbuf[i],
-                                                         &_sigMotData.meanaccumulator[i],
+        mean[i] = SignalGenerator_UpdateMovingWindowMean(pSigMot->meanbuf[i],
+                                                         &pSigMot->meanaccumulator[i],
                                                          accIn[i],
                                                          movingWindowIdx,
                                                          MOVING_WINDOW_MEAN_BUF_SIZE_2N);
@@ -169,8 +154,8 @@ osp_float_t UpdateSignals(const osp_float_t accIn[NUM_ACCEL_AXES]) {
     }
 
     //filter energy signal
-    temp = SignalGenerator_UpdateMovingWindowMean(_sigMotData.energybuf,
-                                                  &_sigMotData.energyaccumulator,
+    temp = SignalGenerator_UpdateMovingWindowMean(pSigMot->energybuf,
+                                                  &pSigMot->energyaccumulator,
                                                   totalEnergy,
                                                   movingWindowIdx,
                                                   MOVING_WINDOW_MEAN_BUF_SIZE_2N);
@@ -180,7 +165,7 @@ osp_float_t UpdateSignals(const osp_float_t accIn[NUM_ACCEL_AXES]) {
         totalEnergy = ENERGY_FLOOR;
     }
 
-    _sigMotData.signalCounter++;
+    pSigMot->signalCounter++;
 
     return totalEnergy;
 }
@@ -190,31 +175,31 @@ osp_float_t UpdateSignals(const osp_float_t accIn[NUM_ACCEL_AXES]) {
  *          Detects significant motion based on threshold crossing and callbacks to subscribers
  *
  ***************************************************************************************************/
-void SignificantMotionStateMachine(const NTTIME time, const osp_float_t energy) {
+void SignificantMotionStateMachine(SigMotionDetector_t * pSigMot, const NTTIME time, const osp_float_t energy) {
 
     osp_bool_t isSignificantMotion = FALSE;
     NTTIME eventTime = time - SIGNIFICANT_MOTION_DETECTOR_DELAY;
 
     //get max signal
     if (energy >= ENERGY_THRESHOLD_FOR_SIG_MOTION) {
-        _sigMotData.motionCounter++;
+        pSigMot->motionCounter++;
     }
     else {
-        _sigMotData.motionCounter = 0;
+        pSigMot->motionCounter = 0;
     }
 
     //check threshold crossing for significant motion
-    if (_sigMotData.motionCounter > NUM_COUNTS_MOTION_FOR_SIGNIFICANT_DECISION) {
+    if (pSigMot->motionCounter > NUM_COUNTS_MOTION_FOR_SIGNIFICANT_DECISION) {
         isSignificantMotion = TRUE;
-        _sigMotData.motionCounter = NUM_COUNTS_MOTION_FOR_SIGNIFICANT_DECISION;
+        pSigMot->motionCounter = NUM_COUNTS_MOTION_FOR_SIGNIFICANT_DECISION;
     }
 
     //callback only if significant motion was just triggered
-    if(isSignificantMotion && !_sigMotData.isSignificantMotion && _sigMotData.sigMotCallback){
-        _sigMotData.sigMotCallback(&eventTime);
+    if(isSignificantMotion && !pSigMot->isSignificantMotion && pSigMot->sigMotCallback){
+        pSigMot->sigMotCallback(pSigMot->pCallbackContext, &eventTime);
     }
 
-    _sigMotData.isSignificantMotion = isSignificantMotion;
+    pSigMot->isSignificantMotion = isSignificantMotion;
 }
 
 
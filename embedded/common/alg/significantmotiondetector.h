@@ -30,10 +30,29 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    C O N S T A N T S   &   M A C R O S
 \*-------------------------------------------------------------------------------------------------*/
+/* moving window size for mean and noise - assumed input rate between 6-8Hz */
+#define MOVING_WINDOW_MEAN_BUF_SIZE_2N (3)
+#define MOVING_WINDOW_MEAN_BUF_SIZE (1 << MOVING_WINDOW_MEAN_BUF_SIZE_2N)
 
 /*-------------------------------------------------------------------------------------------------*\
  |    T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
+// struct for containing significant motion detector data, one per algorithm instance
+typedef struct {
+    OSP_EventResultCallback_t sigMotCallback;
+    void * pCallbackContext;
+
+    osp_float_t meanbuf[NUM_ACCEL_AXES][MOVING_WINDOW_MEAN_BUF_SIZE];
+    osp_float_t meanaccumulator[NUM_ACCEL_AXES];
+
+    osp_float_t energybuf[MOVING_WINDOW_MEAN_BUF_SIZE];
+    osp_float_t energyaccumulator;
+
+    osp_bool_t isSignificantMotion;
+
+    uint8_t motionCounter;
+    uint8_t signalCounter;
+} SigMotionDetector_t;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
@@ -52,13 +71,14 @@ extern "C" {
 #endif
 
 // Constructor, destructor and reset methods
-void SignificantMotDetector_Init(OSP_EventResultCallback_t pSigMotionCallback);
+void SignificantMotDetector_Init(SigMotionDetector_t * pSigMot, OSP_EventResultCallback_t pSigMotionCallback,
+                                 void * pCallbackContext);
 
-void SignificantMotDetector_CleanUp(void);
-void SignificantMotDetector_Reset(void);
+void SignificantMotDetector_CleanUp(SigMotionDetector_t * pSigMot);
+void SignificantMotDetector_Reset(SigMotionDetector_t * pSigMot);
 
 // Set methods
-void SignificantMotDetector_SetFilteredAccelerometerMeasurement(const NTTIME tstamp, const osp_float_t acc[NUM_ACCEL_AXES]);
+void SignificantMotDetector_SetFilteredAccelerometerMeasurement(SigMotionDetector_t * pSigMot, const NTTIME tstamp, const osp_float_t acc[NUM_ACCEL_AXES]);
 
 #ifdef __cplusplus
 }
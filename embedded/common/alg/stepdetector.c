@@ -34,26 +34,10 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    P R I V A T E   T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-//struct for containing step generation data
-typedef struct {
-    //step segmenter
-    StepSegmenter_t stepSegmenter;
-
-    //step data
-    StepDataOSP_t step;
-
-    //first step time
-    NTTIME startWalkTime;
-
-    //callback variables
-    OSP_StepResultCallback_t stepResultReadyCallback;
-    OSP_StepSegmentResultCallback_t stepSegmentResultReadyCallback;
-} StepDetector_t;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-static StepDetector_t stepDetectData;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
@@ -72,31 +56,32 @@ static StepDetector_t stepDetectData;
  *          <brief>
  *
  ***************************************************************************************************/
-static void SetNewStepSegment(StepSegment_t * segment){
+static void SetNewStepSegment(void * pContext, StepSegment_t * segment){
+    StepDetector_t * pStepDet = (StepDetector_t *)pContext;
     NTTIME dt;
 
     //Check for start of walk sequence
     if(segment->type == firstStep){
-        stepDetectData.startWalkTime = segment->startTime;
-        stepDetectData.step.numStepsSinceWalking = 0;
+        pStepDet->startWalkTime = segment->startTime;
+        pStepDet->step.numStepsSinceWalking = 0;
     }
 
     //Set times and increment counters
-    stepDetectData.step.startTime = segment->startTime;
-    stepDetectData.step.stopTime = segment->stopTime;
-    stepDetectData.step.numStepsTotal++;
-    stepDetectData.step.numStepsSinceWalking++;
+    pStepDet->step.startTime = segment->startTime;
+    pStepDet->step.stopTime = segment->stopTime;
+    pStepDet->step.numStepsTotal++;
+    pStepDet->step.numStepsSinceWalking++;
 
     //Estimate step frequency and length
-    dt = segment->stopTime - stepDetectData.startWalkTime;
-    stepDetectData.step.stepFrequency = ((osp_float_t)stepDetectData.step.numStepsSinceWalking)/TOFLT_TIME(dt);
+    dt = segment->stopTime - pStepDet->startWalkTime;
+    pStepDet->step.stepFrequency = ((osp_float_t)pStepDet->step.numStepsSinceWalking)/TOFLT_TIME(dt);
 
     //Callback to subscribers if any
-    if(stepDetectData.stepResultReadyCallback){
-        stepDetectData.stepResultReadyCallback(&stepDetectData.step);
+    if(pStepDet->stepResultReadyCallback){
+        pStepDet->stepResultReadyCallback(pStepDet->pCallbackContext, &pStepDet->step);
     }
-    if(stepDetectData.stepSegmentResultReadyCallback){
-        stepDetectData.stepSegmentResultReadyCallback(segment);
+    if(pStepDet->stepSegmentResultReadyCallback){
+        pStepDet->stepSegmentResultReadyCallback(pStepDet->pCallbackContext, segment);
     }
 }
 
@@ -110,16 +95,18 @@ static void SetNewStepSegment(StepSegment_t * segment){
  *          <brief>
  *
  ***************************************************************************************************/
-void StepDetector_Init(OSP_StepResultCallback_t pStepResultReadyCallback, OSP_StepSegmentResultCallback_t pStepSegmentResultReadyCallback){
+void StepDetector_Init(StepDetector_t * pStepDet, OSP_StepResultCallback_t pStepResultReadyCallback,
+                      OSP_StepSegmentResultCallback_t pStepSegmentResultReadyCallback, void * pCallbackContext){
     //Set up callbacks
-    stepDetectData.stepResultReadyCallback = pStepResultReadyCallback;
-    stepDetectData.stepSegmentResultReadyCallback = pStepSegmentResultReadyCallback;
+    pStepDet->stepResultReadyCallback = pStepResultReadyCallback;
+    pStepDet->stepSegmentResultReadyCallback = pStepSegmentResultReadyCallback;
+    pStepDet->pCallbackContext = pCallbackContext;
 
     //initialize sub-structs
-    StepSegmenter_Init(&stepDetectData.stepSegmenter, &SetNewStepSegment);
+    StepSegmenter_Init(&pStepDet->stepSegmenter, &SetNewStepSegment, pStepDet);
 
     //reset
-    StepDetector_Reset();
+    StepDetector_Reset(pStepDet);
 }
 
 
@@ -128,11 +115,11 @@ void StepDetector_Init(OSP_StepResultCallback_t pStepResultReadyCallback, OSP_St
  *          <brief>
  *
  ***************************************************************************************************/
-void StepDetector_CleanUp(void){
-    stepDetectData.stepResultReadyCallback = NULL;
-    stepDetectData.stepSegmentResultReadyCallback = NULL;
+void StepDetector_CleanUp(StepDetector_t * pStepDet){
+    pStepDet->stepResultReadyCallback = NULL;
+    pStepDet->stepSegmentResultReadyCallback = NULL;
 
-    StepSegmenter_CleanUp(&stepDetectData.stepSegmenter);
+    StepSegmenter_CleanUp(&pStepDet->stepSegmenter);
 }
 
 
@@ -141,9 +128,9 @@ void StepDetector_CleanUp(void){
  *          <brief>
  *
  ***************************************************************************************************/
-void StepDetector_Reset(void){
+void StepDetector_Reset(StepDetector_t * pStepDet){
     //reset step data
-    StepDataOSP_t * step = &stepDetectData.step;
+    StepDataOSP_t * step = &pStepDet->step;
     step->startTime = TOFIX_TIME(-1.f);
     step->stopTime = TOFIX_TIME(-1.f);
     step->stepFrequency = 0;
@@ -151,7 +138,7 @@ void StepDetector_Reset(void){
     step->numStepsSinceWalking = 0;
 
     //reset signal generation and segmentation code
-    StepSegmenter_Reset(&stepDetectData.stepSegmenter);
+    StepSegmenter_Reset(&pStepDet->stepSegmenter);
 }
 
 
@@ -160,14 +147,14 @@ void StepDetector_Reset(void){
  *          Set method
  *
  ***************************************************************************************************/
-void StepDetector_SetFilteredAccelerometerMeasurement(const NTTIME tstamp, const osp_float_t filteredAcc[3]){
+void StepDetector_SetFilteredAccelerometerMeasurement(StepDetector_t * pStepDet, const NTTIME tstamp, const osp_float_t filteredAcc[3]){
     osp_float_t accNorm = sqrtf(filteredAcc[0]*filteredAcc[0] + 
                           filteredAcc[1]*filteredAcc[1] + 
                           filteredAcc[2]*filteredAcc[2]);
     NTTIME tFilter = tstamp;
 
     //Update step segmenter
-    StepSegmenter_UpdateAndCheckForSegment(&stepDetectData.stepSegmenter, accNorm, tFilter);
+    StepSegmenter_UpdateAndCheckForSegment(&pStepDet->stepSegmenter, accNorm, tFilter);
 }
 
 /*-------------------------------------------------------------------------------------------------*\
@@ -22,6 +22,7 @@
  |    I N C L U D E   F I L E S
 \*-------------------------------------------------------------------------------------------------*/
 #include "osp-alg-types.h"
+#include "stepsegmenter.h"
 
 /*
  * This module detects steps and produces corresponding step segments and step
@@ -39,6 +40,22 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
+//struct for containing step generation data, one per algorithm instance
+typedef struct {
+    //step segmenter
+    StepSegmenter_t stepSegmenter;
+
+    //step data
+    StepDataOSP_t step;
+
+    //first step time
+    NTTIME startWalkTime;
+
+    //callback variables
+    OSP_StepResultCallback_t stepResultReadyCallback;
+    OSP_StepSegmentResultCallback_t stepSegmentResultReadyCallback;
+    void * pCallbackContext;
+} StepDetector_t;
 
 /*-------------------------------------------------------------------------------------------------*\
  |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
@@ -56,13 +73,14 @@ extern "C" {
 #endif
 
 // Constructor, destructor and reset methods
-void StepDetector_Init(OSP_StepResultCallback_t pStepResultReadyCallback, OSP_StepSegmentResultCallback_t);
+void StepDetector_Init(StepDetector_t * pStepDet, OSP_StepResultCallback_t pStepResultReadyCallback,
+                      OSP_StepSegmentResultCallback_t pStepSegmentResultReadyCallback, void * pCallbackContext);
 
-void StepDetector_CleanUp(void);
-void StepDetector_Reset(void);
+void StepDetector_CleanUp(StepDetector_t * pStepDet);
+void StepDetector_Reset(StepDetector_t * pStepDet);
 
 // Set methods
-void StepDetector_SetFilteredAccelerometerMeasurement(NTTIME tstamp, const osp_float_t filteredAcc[NUM_ACCEL_AXES]);
+void StepDetector_SetFilteredAccelerometerMeasurement(StepDetector_t * pStepDet, NTTIME tstamp, const osp_float_t filteredAcc[NUM_ACCEL_AXES]);
 
 #ifdef __cplusplus
 }
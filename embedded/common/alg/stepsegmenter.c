@@ -256,7 +256,7 @@ static void AddStep(StepSegmenter_t * pStruct, StepSegment_t segment){
         //if we just ended walking, send out final step
         if(initState == midWalk && pStruct->resultReadyCallback){
             pStruct->storedSteps[stepIdx].type = lastStep;
-            pStruct->resultReadyCallback(&pStruct->stepSegment);
+            pStruct->resultReadyCallback(pStruct->objPtr, &pStruct->stepSegment);
         }
         break;
 
@@ -283,10 +283,10 @@ static void AddStep(StepSegmenter_t * pStruct, StepSegment_t segment){
             if(pStruct->resultReadyCallback){
                 uint8_t i;
                 for(i = 0; i < NUM_STEPS_BEFORE_REPORTING; i++){
-                    pStruct->resultReadyCallback(&pStruct->storedSteps[i]);
+                    pStruct->resultReadyCallback(pStruct->objPtr, &pStruct->storedSteps[i]);
                 }
             }
-            pStruct->resultReadyCallback(&pStruct->stepSegment);
+            pStruct->resultReadyCallback(pStruct->objPtr, &pStruct->stepSegment);
             pStruct->segmenterState = midWalk;
         }
         break;
@@ -294,7 +294,7 @@ static void AddStep(StepSegmenter_t * pStruct, StepSegment_t segment){
 
     case midWalk:
         if(pStruct->resultReadyCallback){
-            pStruct->resultReadyCallback(&pStruct->stepSegment);
+            pStruct->resultReadyCallback(pStruct->objPtr, &pStruct->stepSegment);
         }
         break;
     }
@@ -366,10 +366,11 @@ static osp_bool_t CheckForPotentialNewStep(StepSegmenter_t *pStruct, EExtremaTyp
  *          Initialize segmenter struct initialization variables
  *
  ***************************************************************************************************/
-void StepSegmenter_Init(StepSegmenter_t * pStruct, OSP_StepSegmentResultCallback_t pResultReadyCallback){
+void StepSegmenter_Init(StepSegmenter_t * pStruct, OSP_StepSegmentResultCallback_t pResultReadyCallback, void * objPtr){
 
     //Set up callback
     pStruct->resultReadyCallback= pResultReadyCallback;
+    pStruct->objPtr = objPtr;
 
     //reset remaining parameters
     StepSegmenter_Reset(pStruct);
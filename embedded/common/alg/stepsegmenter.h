@@ -81,7 +81,7 @@ typedef struct {
 
     //callback variables
     OSP_StepSegmentResultCallback_t resultReadyCallback;
-    void * objPtr;
+    void * objPtr;                  // context handed back to resultReadyCallback
 
 } StepSegmenter_t;
 
@@ -101,7 +101,7 @@ extern "C" {
 #endif
 
 // Constructor/destructor
-void StepSegmenter_Init(StepSegmenter_t * pStruct, OSP_StepSegmentResultCallback_t pResultReadyCallback);
+void StepSegmenter_Init(StepSegmenter_t * pStruct, OSP_StepSegmentResultCallback_t pResultReadyCallback, void * objPtr);
 void StepSegmenter_CleanUp(StepSegmenter_t * pStruct);
 
 // Reset functions
@@ -18,10 +18,12 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    I N C L U D E   F I L E S
 \*-------------------------------------------------------------------------------------------------*/
+#define OSP_CONTEXT_API                 // context API of osp-api.h
 #include "common.h"
 #include "osp-api.h"
 #include <string.h>
 #include "osp_embeddedalgcalls.h"
+#include "osp-context.h"
 #include "osp-version.h"
 
 
@@ -33,10 +35,10 @@
  |    P R I V A T E   C O N S T A N T S   &   M A C R O S
 \*-------------------------------------------------------------------------------------------------*/
 #define RESULT_FLAG_PAUSED              (1 << 0)
-#define MAX_SENSOR_DESCRIPTORS          8
-#define MAX_RESULT_DESCRIPTORS          5
-#define SENSOR_FG_DATA_Q_SIZE           8
-#define SENSOR_BG_DATA_Q_SIZE           8
+// Packets per foreground/background budget batch, capped so the batch arrays stay small on the stack
+#define MAX_BUDGET_BATCH                8
+#define FG_BATCH_SIZE                   (((SENSOR_DATA_Q_SIZE / 2) < MAX_BUDGET_BATCH) ? (SENSOR_DATA_Q_SIZE / 2) : MAX_BUDGET_BATCH)
+#define BG_BATCH_SIZE                   (((SENSOR_DATA_Q_SIZE / 4) < MAX_BUDGET_BATCH) ? (SENSOR_DATA_Q_SIZE / 4) : MAX_BUDGET_BATCH)
 #define MAX_SENSORS_PER_RESULT          5
 
 //Sensor flags for internal use
@@ -44,6 +46,7 @@
 #define SENSOR_FLAG_HAVE_CTL_CALLBACK   (1 << 1)
 #define SENSOR_FLAG_HAVE_CAL_CALLBACK   (1 << 2)
 #define SENSOR_FLAG_NEEDS_DECIMATION    (1 << 3)
+#define SENSOR_FLAG_HAVE_CONV_PLAN      (1 << 4)
 
 /* Result codes for local functions */
 #ifdef NO_ERROR
@@ -58,20 +61,45 @@
 
 #define Q32DIFF (32 - QFIXEDPOINTPRECISE)
 
+/* Counter to time multiply: native 128-bit on hosts that have it, UMULL/UMLAL on cores with a long
+ * multiply, 16x16 partial products (UMul32) otherwise */
+#if defined(__SIZEOF_INT128__)
+# define TIME_MUL_INT128
+#elif defined(__CORTEX_M) && (__CORTEX_M >= 0x03)
+# define TIME_MUL_LONG
+#endif
+
+/* DWT cycle counter for the foreground processing budget (not present on Cortex-M0/M0+) */
+#if defined(__CORTEX_M) && (__CORTEX_M >= 0x03)
+# define CYCLE_COUNTER_ENABLE()         do { CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+                                             DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; } while(0)
+# define GET_CYCLE_COUNT()              (DWT->CYCCNT)
+#else
+# define CYCLE_COUNTER_ENABLE()
+# define GET_CYCLE_COUNT()              (0)
+#endif
+
+/* Cortex-M4 raw data conversion kernel; also built on the host for the conversion test, with a C
+ * saturating subtract */
+#if defined(__CORTEX_M) && (__CORTEX_M == 0x04)
+# define CONVERT_M4
+#elif defined(TEST_CONVERT) && !defined(__CORTEX_M)
+# define CONVERT_M4
+# define __QSUB(a, b)                   QSubHost(a, b)
+#endif
+
+/* Orders the data and sequence count accesses of the latest data buffers */
+#if defined(__CORTEX_M)
+# define MEMORY_BARRIER()               __DMB()
+#elif defined(__GNUC__)
+# define MEMORY_BARRIER()               __sync_synchronize()
+#else
+# define MEMORY_BARRIER()
+#endif
+
 /*-------------------------------------------------------------------------------------------------*\
  |    P R I V A T E   T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-/* Local structure for keeping tab on active sensors and results */
-typedef struct {
-    SensorDescriptor_t *pSenDesc;
-    uint16_t Flags;                 // in-use, etc
-} _SenDesc_t;
-
-typedef struct {
-    SensorDescriptor_t *pResDesc;
-    uint16_t Flags;                 // Paused, etc
-} _ResDesc_t;
-
 typedef struct {
     InputSensorHandle_t Handle;     // handle for this sensor
     TriAxisSensorRawData_t Data;    // raw data & time stamp from sensor
@@ -89,16 +117,6 @@ typedef union {
     Android_UncalibratedGyroOutputData_t  ucGyro;
 } AndroidUnCalResult_t;
 
-/* Common bridge between the different data types for base sensors (Accel/Mag/Gyro) */
-typedef struct  {
-    NTTIME TimeStamp;               // time stamp
-    uint8_t accuracy;
-    union {
-        NTEXTENDED  extendedData[3];    // processed sensor data
-        NTPRECISE   preciseData[3];     // processed sensor data
-    } data;
-} Common_3AxisResult_t;
-
 
 /*-------------------------------------------------------------------------------------------------*\
  |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
@@ -108,46 +126,6 @@ static const OSP_Library_Version_t libVersion = {
     OSP_VERSION_STRING
 };
 
-static uint64_t _SubscribedResults;   // bit field of currently subscribed results, bit positions
-                                      // same as SensorType_t
-// pointer to platform descriptor structure
-SystemDescriptor_t const *_pPlatformDesc = NULL;
-
-// pointers to sensor data structures, and local flags
-static  _SenDesc_t _SensorTable[MAX_SENSOR_DESCRIPTORS];
-
-// pointers to result data structures, and local flags
-static _ResDesc_t _ResultTable[MAX_RESULT_DESCRIPTORS];
-
-// Raw sensor data queue for foreground processing
-static _SensorDataBuffer_t _SensorFgDataQueue[SENSOR_FG_DATA_Q_SIZE];
-static int16_t _SensorFgDataQCnt;          // number of data packets in the queue
-static uint16_t _SensorFgDataNqPtr = SENSOR_FG_DATA_Q_SIZE - 1; // where the last data packet was put into the queue
-static uint16_t _SensorFgDataDqPtr;         // where to remove next data packet from the queue
-
-
-// Raw sensor data queue for background processing
-static _SensorDataBuffer_t _SensorBgDataQueue[SENSOR_BG_DATA_Q_SIZE];
-static int16_t _SensorBgDataQCnt;          // number of data packets in the queue
-static uint16_t _SensorBgDataNqPtr = SENSOR_BG_DATA_Q_SIZE - 1; // where the last data packet was put into the queue
-static uint16_t _SensorBgDataDqPtr;         // where to remove next data packet from the queue
-
-static uint32_t _sensorLastForegroundTimeStamp = 0;             // keep the last time stamp here, we will use it to check for rollover
-static uint32_t _sensorLastForegroundTimeStampExtension = 0;    // we will re-create a larger raw time stamp here
-
-static uint32_t _sensorLastBackgroundTimeStamp = 0;             // keep the last time stamp here, we will use it to check for rollover
-static uint32_t _sensorLastBackgroundTimeStampExtension = 0;    // we will re-create a larger raw time stamp here
-
-static NTPRECISE _accel_bias[3] = {0, 0, 0};   // bias in sensor ticks
-static NTPRECISE _gyro_bias[3]  = {0, 0, 0};   // bias in sensor ticks
-static NTEXTENDED _mag_bias[3]  = {0, 0, 0};   // bias in sensor ticks
-
-// copy of last data that was sent to the alg. We will
-// use this for when the user _polls_ for calibrated sensor data.
-static Common_3AxisResult_t _LastAccelCookedData;
-static Common_3AxisResult_t _LastMagCookedData;
-static Common_3AxisResult_t _LastGyroCookedData;
-
 // table of result to resource maps. 1 entry for each result that describes which sensor types
 // that it needs, which callback routine to use, etc.
 static const _ResultResourceMap_t _ResultResourceMap[] = {
@@ -163,10 +141,7 @@ static const _ResultResourceMap_t _ResultResourceMap[] = {
  |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
 \*-------------------------------------------------------------------------------------------------*/
 static osp_status_t NullRoutine(void);
-/* callback for entering/exiting a critical section of code (i.e. disable/enable task switch) */
-OSP_CriticalSectionCallback_t EnterCritical = (OSP_CriticalSectionCallback_t)&NullRoutine;
-OSP_CriticalSectionCallback_t ExitCritical = (OSP_CriticalSectionCallback_t)&NullRoutine;
-static int16_t FindResultTableIndexByType(SensorType_t Type);
+static int16_t FindResultTableIndexByType(OSP_Context_t *pCtx, SensorType_t Type);
 
 /*-------------------------------------------------------------------------------------------------*\
  |    P U B L I C   V A R I A B L E S   D E F I N I T I O N S
@@ -189,20 +164,23 @@ __inline static uint32_t mult_uint16_uint16(uint16_t a, uint16_t b)
 
 /****************************************************************************************************
  * @fn      OnStepResultsReady
- *          Local callback used for Step Counter results from algorithm
+ *          Local callback used for Step Counter results from algorithm. The callback context is the
+ *          library context the algorithms belong to.
  *
  ***************************************************************************************************/
-static void OnStepResultsReady( StepDataOSP_t* stepData )
+static void OnStepResultsReady( void * pContext, StepDataOSP_t* stepData )
 {
-    if(_SubscribedResults & (1 << SENSOR_STEP_COUNTER)) {
+    OSP_Context_t *pCtx = (OSP_Context_t *)pContext;
+
+    if(pCtx->SubscribedResults & (1 << SENSOR_STEP_COUNTER)) {
         int16_t index;
         Android_StepCounterOutputData_t callbackData;
 
         callbackData.StepCount = stepData->numStepsTotal;
         callbackData.TimeStamp = stepData->startTime; //!TODO - Double check if start time or stop time
 
-        index = FindResultTableIndexByType(SENSOR_STEP_COUNTER);
-        _ResultTable[index].pResDesc->pOutputReadyCallback((OutputSensorHandle_t)&_ResultTable[index],
+        index = FindResultTableIndexByType(pCtx, SENSOR_STEP_COUNTER);
+        pCtx->ResultTable[index].pResDesc->pOutputReadyCallback((OutputSensorHandle_t)&pCtx->ResultTable[index],
             &callbackData);
     }
 }
@@ -210,20 +188,23 @@ static void OnStepResultsReady( StepDataOSP_t* stepData )
 
 /****************************************************************************************************
  * @fn      OnSignificantMotionResult
- *          Local callback used for Significant motion results from algorithm
+ *          Local callback used for Significant motion results from algorithm. The callback context is
+ *          the library context the algorithms belong to.
  *
  ***************************************************************************************************/
-static void OnSignificantMotionResult( NTTIME * eventTime )
+static void OnSignificantMotionResult( void * pContext, NTTIME * eventTime )
 {
-    if(_SubscribedResults & (1 << SENSOR_CONTEXT_DEVICE_MOTION)) {
+    OSP_Context_t *pCtx = (OSP_Context_t *)pContext;
+
+    if(pCtx->SubscribedResults & (1 << SENSOR_CONTEXT_DEVICE_MOTION)) {
         int16_t index;
         Android_SignificantMotionOutputData_t callbackData;
 
         callbackData.significantMotionDetected = true;
         callbackData.TimeStamp = *eventTime;
 
-        index = FindResultTableIndexByType(SENSOR_CONTEXT_DEVICE_MOTION);
-        _ResultTable[index].pResDesc->pOutputReadyCallback((OutputSensorHandle_t)&_ResultTable[index],
+        index = FindResultTableIndexByType(pCtx, SENSOR_CONTEXT_DEVICE_MOTION);
+        pCtx->ResultTable[index].pResDesc->pOutputReadyCallback((OutputSensorHandle_t)&pCtx->ResultTable[index],
             &callbackData);
     }
 }
@@ -259,14 +240,14 @@ static int16_t ValidateSystemDescriptor(SystemDescriptor_t const *pSystemDescrip
  *          Given a sensor type, return the index into the sensor table
  *
  ***************************************************************************************************/
-static int16_t FindSensorTableIndexByType(SensorType_t Type)
+static int16_t FindSensorTableIndexByType(OSP_Context_t *pCtx, SensorType_t Type)
 {
     int16_t i;
 
     for(i = 0; i < MAX_SENSOR_DESCRIPTORS; i++) {
-        if(_SensorTable[i].pSenDesc == NULL)
+        if(pCtx->SensorTable[i].pSenDesc == NULL)
             continue;
-        if(Type == ((SensorDescriptor_t *)(_SensorTable[i].pSenDesc))->SensorType)
+        if(Type == ((SensorDescriptor_t *)(pCtx->SensorTable[i].pSenDesc))->SensorType)
             return i;
     }
     return ERROR;
@@ -278,12 +259,12 @@ static int16_t FindSensorTableIndexByType(SensorType_t Type)
  *          Find 1st available empty sensor table slot, return the index into the sensor table
  *
  ***************************************************************************************************/
-static int16_t FindEmptySensorTableIndex(void)
+static int16_t FindEmptySensorTableIndex(OSP_Context_t *pCtx)
 {
     int16_t i;
 
     for(i = 0; i < MAX_SENSOR_DESCRIPTORS; i++) {
-        if(_SensorTable[i].pSenDesc == NULL)
+        if(pCtx->SensorTable[i].pSenDesc == NULL)
             return i;
     }
     return ERROR;
@@ -295,15 +276,14 @@ static int16_t FindEmptySensorTableIndex(void)
  *          Given a sensor handle, return the index into the sensor table
  *
  ***************************************************************************************************/
-static int16_t FindSensorTableIndexByHandle(InputSensorHandle_t Handle)
+static int16_t FindSensorTableIndexByHandle(OSP_Context_t *pCtx, InputSensorHandle_t Handle)
 {
-    int16_t i;
+    uintptr_t offset = (uintptr_t)Handle - (uintptr_t)&pCtx->SensorTable[0];
 
-    for(i = 0; i < MAX_SENSOR_DESCRIPTORS; i++) {
-        if(Handle == (InputSensorHandle_t)&_SensorTable[i])
-            return i;
-    }
-    return ERROR;
+    // handles are table entry addresses, the index follows directly
+    if((offset >= sizeof(pCtx->SensorTable)) || (offset % sizeof(_SenDesc_t)))
+        return ERROR;
+    return (int16_t)(offset / sizeof(_SenDesc_t));
 }
 
 
@@ -312,14 +292,14 @@ static int16_t FindSensorTableIndexByHandle(InputSensorHandle_t Handle)
  *          Given a result type, return the index into the result table
  *
  ***************************************************************************************************/
-static int16_t FindResultTableIndexByType(SensorType_t Type)
+static int16_t FindResultTableIndexByType(OSP_Context_t *pCtx, SensorType_t Type)
 {
     int16_t i;
 
     for(i = 0; i < MAX_RESULT_DESCRIPTORS; i++) {
-        if(_ResultTable[i].pResDesc == NULL)
+        if(pCtx->ResultTable[i].pResDesc == NULL)
             continue;
-        if(Type == ((SensorDescriptor_t *)(_ResultTable[i].pResDesc))->SensorType)
+        if(Type == ((SensorDescriptor_t *)(pCtx->ResultTable[i].pResDesc))->SensorType)
             return i;
     }
     return ERROR;
@@ -331,12 +311,12 @@ static int16_t FindResultTableIndexByType(SensorType_t Type)
  *          Find 1st available empty result table slot, return the index into the sensor table
  *
  ***************************************************************************************************/
-static int16_t FindEmptyResultTableIndex(void)
+static int16_t FindEmptyResultTableIndex(OSP_Context_t *pCtx)
 {
     int16_t i;
 
     for(i = 0; i < MAX_RESULT_DESCRIPTORS; i++) {
-        if(_ResultTable[i].pResDesc == NULL)
+        if(pCtx->ResultTable[i].pResDesc == NULL)
             return i;
     }
     return ERROR;
@@ -348,15 +328,14 @@ static int16_t FindEmptyResultTableIndex(void)
  *          Given a result handle, return the index into the result table
  *
  ***************************************************************************************************/
-static int16_t FindResultTableIndexByHandle(OutputSensorHandle_t Handle)
+static int16_t FindResultTableIndexByHandle(OSP_Context_t *pCtx, OutputSensorHandle_t Handle)
 {
-    int16_t i;
+    uintptr_t offset = (uintptr_t)Handle - (uintptr_t)&pCtx->ResultTable[0];
 
-    for(i = 0; i < MAX_RESULT_DESCRIPTORS; i++) {
-        if(Handle == (OutputSensorHandle_t)&_ResultTable[i])
-            return i;
-    }
-    return ERROR;
+    // handles are table entry addresses, the index follows directly
+    if((offset >= sizeof(pCtx->ResultTable)) || (offset % sizeof(_ResDesc_t)))
+        return ERROR;
+    return (int16_t)(offset / sizeof(_ResDesc_t));
 }
 
 
@@ -378,6 +357,49 @@ static int16_t FindResourceMapIndexByType(SensorType_t ResultType)
 }
 
 
+/****************************************************************************************************
+ * @fn      AddResultDispatch
+ *          Adds a result table entry to the dispatch list of the input sensor type feeding it
+ *
+ ***************************************************************************************************/
+static int16_t AddResultDispatch(OSP_Context_t *pCtx, SensorType_t InputType, _ResDesc_t *pResult)
+{
+    _ResultDispatch_t *pDispatch = &pCtx->ResultDispatch[InputType];
+
+    if(pDispatch->Count >= MAX_RESULT_DESCRIPTORS)
+        return ERROR;
+
+    pCtx->EnterCritical();                                  // dispatch lists are walked by foreground processing
+    pDispatch->pResult[pDispatch->Count++] = pResult;
+    pCtx->ExitCritical();
+    return NO_ERROR;
+}
+
+
+/****************************************************************************************************
+ * @fn      RemoveResultDispatch
+ *          Removes a result table entry from all input sensor dispatch lists, keeping the order of
+ *          the remaining entries
+ *
+ ***************************************************************************************************/
+static void RemoveResultDispatch(OSP_Context_t *pCtx, _ResDesc_t *pResult)
+{
+    _ResultDispatch_t *pDispatch;
+    uint16_t type, i, j;
+
+    pCtx->EnterCritical();                                  // dispatch lists are walked by foreground processing
+    for(type = 0; type < SENSOR_ENUM_COUNT; type++) {
+        pDispatch = &pCtx->ResultDispatch[type];
+        for(i = 0, j = 0; i < pDispatch->Count; i++) {
+            if(pDispatch->pResult[i] != pResult)
+                pDispatch->pResult[j++] = pDispatch->pResult[i];
+        }
+        pDispatch->Count = j;
+    }
+    pCtx->ExitCritical();
+}
+
+
 /****************************************************************************************************
  * @fn      ValidateSensorDescriptor
  *          Given a pointer to a sensor descriptor, validate it's contents
@@ -475,20 +497,187 @@ static int16_t ValidateResultDescriptor(SensorDescriptor_t *pResultDescriptor)
  *          Invalidates the handles for the sensor data in the queue so that the data is discarded
  *
  ***************************************************************************************************/
-static void InvalidateQueuedDataByHandle(InputSensorHandle_t Handle)
+static void InvalidateQueuedDataByHandle(OSP_Context_t *pCtx, InputSensorHandle_t Handle)
+{
+    uint16_t i;
+
+    pCtx->EnterCritical();
+    for(i = 0; i < SENSOR_DATA_Q_SIZE; i++ ) {
+        if(pCtx->SensorDataQHandle[i] == Handle)
+            pCtx->SensorDataQHandle[i] = NULL;
+    }
+    pCtx->ExitCritical();
+}
+
+
+/****************************************************************************************************
+ * @fn      OverrunSensorDataCursor
+ *          Makes room for a new data packet in the shared queue as far as the consumer owning the
+ *          given cursor is concerned. Must be called within critical section.
+ *
+ * @return  NO_ERROR if there was room, ERROR if the consumer's oldest data packet was given up
+ *
+ ***************************************************************************************************/
+static int16_t OverrunSensorDataCursor(_SensorDataCursor_t *pCursor)
+{
+    if(pCursor->QCnt < SENSOR_DATA_Q_SIZE)
+        return NO_ERROR;
+
+    pCursor->OverrunCnt++;
+    pCursor->QCnt--;
+    if(++pCursor->DqPtr == SENSOR_DATA_Q_SIZE)
+        pCursor->DqPtr = 0;
+
+    return ERROR;
+}
+
+
+/****************************************************************************************************
+ * @fn      EnQueueSensorData
+ *          Puts a data packet in the shared sensor data queue. If a consumer is a full queue behind,
+ *          its oldest data packet is given up to make room and counted as its overrun. Must be called
+ *          within critical section.
+ *
+ * @return  OSP_STATUS_OK or OSP_STATUS_QUEUE_FULL if a consumer lost data
+ *
+ ***************************************************************************************************/
+static osp_status_t EnQueueSensorData(OSP_Context_t *pCtx, InputSensorHandle_t Handle, TriAxisSensorRawData_t *data)
 {
+    osp_status_t status = OSP_STATUS_OK;
+
+    // a consumer that hasn't passed the slot we need gives up its oldest data packet
+    if(OverrunSensorDataCursor(&pCtx->SensorFgDataCursor) == ERROR)
+        status = OSP_STATUS_QUEUE_FULL;
+    if(OverrunSensorDataCursor(&pCtx->SensorBgDataCursor) == ERROR)
+        status = OSP_STATUS_QUEUE_FULL;
+
+    if(++pCtx->SensorDataNqPtr == SENSOR_DATA_Q_SIZE)          // bump the enqueue pointer and check for pointer wrap
+        pCtx->SensorDataNqPtr = 0;
+    pCtx->SensorDataQHandle[pCtx->SensorDataNqPtr] = Handle;
+    memcpy(&pCtx->SensorDataQueue[pCtx->SensorDataNqPtr], data, sizeof(TriAxisSensorRawData_t));
+
+    pCtx->SensorFgDataCursor.QCnt++;                           // one more to be seen by each consumer
+    pCtx->SensorBgDataCursor.QCnt++;
+
+    return status;
+}
+
+
+/****************************************************************************************************
+ * @fn      EnQueueSensorDataBurst
+ *          Puts as many data packets of a burst in the shared sensor data queue as there is room for
+ *          with neither consumer losing data. The burst is copied in at most two contiguous blocks
+ *          (queue wrap). Must be called within critical section.
+ *
+ * @return  Number of data packets queued
+ *
+ ***************************************************************************************************/
+static uint16_t EnQueueSensorDataBurst(OSP_Context_t *pCtx, InputSensorHandle_t Handle,
+    TriAxisSensorRawData_t *data, uint16_t count)
+{
+    uint16_t room;
+    uint16_t first;
+    uint16_t start;
     uint16_t i;
 
-    EnterCritical();
-    for(i = 0; i < SENSOR_FG_DATA_Q_SIZE; i++ ) {
-        if(_SensorFgDataQueue[i].Handle == Handle)
-            _SensorFgDataQueue[i].Handle = NULL;
+    // room is what the consumer furthest behind has already passed
+    room = SENSOR_DATA_Q_SIZE - ((pCtx->SensorFgDataCursor.QCnt > pCtx->SensorBgDataCursor.QCnt) ?
+        pCtx->SensorFgDataCursor.QCnt : pCtx->SensorBgDataCursor.QCnt);
+    if(count > room)
+        count = room;
+    if(count == 0)
+        return 0;
+
+    start = pCtx->SensorDataNqPtr + 1;
+    if(start == SENSOR_DATA_Q_SIZE)
+        start = 0;
+
+    first = SENSOR_DATA_Q_SIZE - start;                         // slots up to queue wrap
+    if(first > count)
+        first = count;
+
+    memcpy(&pCtx->SensorDataQueue[start], data, first * sizeof(TriAxisSensorRawData_t));
+    if(count > first)
+        memcpy(&pCtx->SensorDataQueue[0], &data[first], (count - first) * sizeof(TriAxisSensorRawData_t));
+
+    for(i = 0; i < count; i++) {                                // tag the slots, leaving enqueue pointer at last
+        if(++pCtx->SensorDataNqPtr == SENSOR_DATA_Q_SIZE)
+            pCtx->SensorDataNqPtr = 0;
+        pCtx->SensorDataQHandle[pCtx->SensorDataNqPtr] = Handle;
+    }
+
+    pCtx->SensorFgDataCursor.QCnt += count;                    // burst to be seen by each consumer
+    pCtx->SensorBgDataCursor.QCnt += count;
+
+    return count;
+}
+
+
+/****************************************************************************************************
+ * @fn      DeQueueSensorData
+ *          Gets the next data packet from the shared sensor data queue for the consumer owning the
+ *          given cursor. Data packets marked as stale are skipped.
+ *
+ * @return  NO_ERROR if a data packet was returned, ERROR if there is nothing left for the consumer
+ *
+ ***************************************************************************************************/
+static int16_t DeQueueSensorData(OSP_Context_t *pCtx, _SensorDataCursor_t *pCursor, _SensorDataBuffer_t *pData)
+{
+    pCtx->EnterCritical();                                  // no interrupts while we diddle the queue
+
+    // ignore any data marked as stale.
+    while( (pCursor->QCnt != 0) && (pCtx->SensorDataQHandle[pCursor->DqPtr] == NULL) ) {
+        pCursor->QCnt--;                                    // stale data, show one less in the queue
+        if(++pCursor->DqPtr == SENSOR_DATA_Q_SIZE)          //  and check for pointer wrap, rewind if so
+            pCursor->DqPtr = 0;
+    }
+
+    // now see if there is any data to process.
+    if(pCursor->QCnt == 0) {                                // check for queue empty
+        pCtx->ExitCritical();
+        return ERROR;
     }
-    for(i = 0; i < SENSOR_BG_DATA_Q_SIZE; i++ ) {
-        if(_SensorBgDataQueue[i].Handle == Handle)
-            _SensorBgDataQueue[i].Handle = NULL;
+
+    // There is at least 1 data packet in the queue, get it.
+    pData->Handle = pCtx->SensorDataQHandle[pCursor->DqPtr];
+    memcpy(&pData->Data, &pCtx->SensorDataQueue[pCursor->DqPtr], sizeof(TriAxisSensorRawData_t));
+    pCursor->QCnt--;                                        // show one less in the queue
+    if(++pCursor->DqPtr == SENSOR_DATA_Q_SIZE)              //  and check for pointer wrap, rewind if so
+        pCursor->DqPtr = 0;
+    pCtx->ExitCritical();
+
+    return NO_ERROR;
+}
+
+
+/****************************************************************************************************
+ * @fn      DeQueueSensorDataBatch
+ *          Gets up to maxCount data packets from the shared sensor data queue for the consumer
+ *          owning the given cursor, under a single critical section. Stale data packets are skipped.
+ *
+ * @return  number of data packets returned
+ *
+ ***************************************************************************************************/
+static uint16_t DeQueueSensorDataBatch(OSP_Context_t *pCtx, _SensorDataCursor_t *pCursor, _SensorDataBuffer_t *pData,
+    uint16_t maxCount)
+{
+    uint16_t count = 0;
+
+    pCtx->EnterCritical();                                  // no interrupts while we diddle the queue
+
+    while( (pCursor->QCnt != 0) && (count < maxCount) ) {
+        if(pCtx->SensorDataQHandle[pCursor->DqPtr] != NULL) { // ignore any data marked as stale
+            pData[count].Handle = pCtx->SensorDataQHandle[pCursor->DqPtr];
+            memcpy(&pData[count].Data, &pCtx->SensorDataQueue[pCursor->DqPtr], sizeof(TriAxisSensorRawData_t));
+            count++;
+        }
+        pCursor->QCnt--;                                    // show one less in the queue
+        if(++pCursor->DqPtr == SENSOR_DATA_Q_SIZE)          //  and check for pointer wrap, rewind if so
+            pCursor->DqPtr = 0;
     }
-    ExitCritical();
+    pCtx->ExitCritical();
+
+    return count;
 }
 
 
@@ -497,17 +686,17 @@ static void InvalidateQueuedDataByHandle(InputSensorHandle_t Handle)
  *          Turns on sensors indicated by sensorsMask (bit mask based on SensorType_t bit position
  *
  ***************************************************************************************************/
-static int16_t TurnOnSensors(uint32_t sensorsMask)
+static int16_t TurnOnSensors(OSP_Context_t *pCtx, uint32_t sensorsMask)
 {
     SensorControl_t SenCtl;
 
     //  Check for control callback
-    if(_pPlatformDesc->SensorsControl != NULL) {
+    if(pCtx->pPlatformDesc->SensorsControl != NULL) {
         // send a sensor off command
         SenCtl.Handle = NULL;
         SenCtl.Command = SENSOR_CONTROL_SENSOR_ON;
         SenCtl.Data = sensorsMask;
-        _pPlatformDesc->SensorsControl(&SenCtl);
+        pCtx->pPlatformDesc->SensorsControl(&SenCtl);
     }
     return NO_ERROR;
 }
@@ -518,17 +707,17 @@ static int16_t TurnOnSensors(uint32_t sensorsMask)
  *          Turns off sensors indicated by sensorsMask (bit mask based on SensorType_t bit position
  *
  ***************************************************************************************************/
-static int16_t TurnOffSensors(uint32_t sensorsMask)
+static int16_t TurnOffSensors(OSP_Context_t *pCtx, uint32_t sensorsMask)
 {
     SensorControl_t SenCtl;
 
     //  does it have a control callback?
-    if(_pPlatformDesc->SensorsControl != NULL) {
+    if(pCtx->pPlatformDesc->SensorsControl != NULL) {
         // send a sensor off command
         SenCtl.Handle = NULL;
         SenCtl.Command = SENSOR_CONTROL_SENSOR_OFF;
         SenCtl.Data = sensorsMask;
-        _pPlatformDesc->SensorsControl(&SenCtl);
+        pCtx->pPlatformDesc->SensorsControl(&SenCtl);
     }
     return NO_ERROR;
 }
@@ -542,7 +731,7 @@ static int16_t TurnOffSensors(uint32_t sensorsMask)
  *          it is available.
  *
  ***************************************************************************************************/
-static int16_t ActivateResultSensors(SensorType_t ResultType)
+static int16_t ActivateResultSensors(OSP_Context_t *pCtx, SensorType_t ResultType)
 {
     int16_t i,j;
     int16_t index;
@@ -555,12 +744,12 @@ static int16_t ActivateResultSensors(SensorType_t ResultType)
     for (i =  0; i < RESOURCE_MAP_COUNT; i++) {
         if (_ResultResourceMap[i].ResultType == ResultType) {
             for(j = 0; j < _ResultResourceMap[i].SensorCount; j++) {
-                index = FindSensorTableIndexByType(_ResultResourceMap[i].Sensors[j]);
+                index = FindSensorTableIndexByType(pCtx, _ResultResourceMap[i].Sensors[j]);
                 if(index == ERROR)
                     return ERROR;                // sensor is not registered, exit with error
                 // if this sensor is not active, mark it as such and send a command to it to go active.
-                if((_SensorTable[index].Flags & SENSOR_FLAG_IN_USE) == 0) {
-                    _SensorTable[index].Flags |= SENSOR_FLAG_IN_USE; // mark sensor as "in use"
+                if((pCtx->SensorTable[index].Flags & SENSOR_FLAG_IN_USE) == 0) {
+                    pCtx->SensorTable[index].Flags |= SENSOR_FLAG_IN_USE; // mark sensor as "in use"
                     //                  TurnOnSensor(_ResultResourceMap[i].Sensors[j]);
                     sensorsMask |= (1 << _ResultResourceMap[i].Sensors[j]);
                 }
@@ -569,7 +758,7 @@ static int16_t ActivateResultSensors(SensorType_t ResultType)
         }
     }
 
-    if (sensorsMask) TurnOnSensors(sensorsMask);
+    if (sensorsMask) TurnOnSensors(pCtx, sensorsMask);
 
     return NO_ERROR;
 }
@@ -581,7 +770,7 @@ static int16_t ActivateResultSensors(SensorType_t ResultType)
  *          this result if they are not in use by any another active result.
  *
  ***************************************************************************************************/
-static int16_t DeactivateResultSensors(SensorType_t ResultType)
+static int16_t DeactivateResultSensors(OSP_Context_t *pCtx, SensorType_t ResultType)
 {
     int16_t i,j,k,l;
     int16_t index;
@@ -601,8 +790,8 @@ static int16_t DeactivateResultSensors(SensorType_t ResultType)
     for(i = 0; i < _ResultResourceMap[index].SensorCount; i++ ) { // for each of our sensors
         NeedSensor = FALSE;                                       // assume no other result uses this sensor
         for(k = 0; k < MAX_RESULT_DESCRIPTORS; k++) {
-            if((_ResultTable[k].pResDesc != NULL) && (_ResultTable[k].pResDesc->SensorType != ResultType)) { // search active results (but not ours)
-                j = FindResourceMapIndexByType(_ResultTable[k].pResDesc->SensorType);
+            if((pCtx->ResultTable[k].pResDesc != NULL) && (pCtx->ResultTable[k].pResDesc->SensorType != ResultType)) { // search active results (but not ours)
+                j = FindResourceMapIndexByType(pCtx->ResultTable[k].pResDesc->SensorType);
                 if(j == ERROR)
                     return ERROR;
                 for(l = 0; l < _ResultResourceMap[j].SensorCount; l++) { // for each sensor in this active result
@@ -618,18 +807,20 @@ static int16_t DeactivateResultSensors(SensorType_t ResultType)
         if(NeedSensor == FALSE) {
             // if we get here, no other result uses this sensor type, mark it "not in use" and send
             // a "turn off" command to it, and mark all data in the input queues as stale
-            j = FindSensorTableIndexByType(_ResultResourceMap[index].Sensors[i]);
-            _SensorTable[j].Flags &= ~SENSOR_FLAG_IN_USE;   // Mark sensor "not in use"
+            j = FindSensorTableIndexByType(pCtx, _ResultResourceMap[index].Sensors[i]);
+            pCtx->SensorTable[j].Flags &= ~SENSOR_FLAG_IN_USE; // Mark sensor "not in use"
             // mark all previously queued data for this sensor type as invalid
-            InvalidateQueuedDataByHandle((InputSensorHandle_t)&_SensorTable[j]);
+            InvalidateQueuedDataByHandle(pCtx, (InputSensorHandle_t)&pCtx->SensorTable[j]);
             sensorsMask |= (1 << _ResultResourceMap[index].Sensors[i]);
         }
     }
-    if (sensorsMask) TurnOffSensors(sensorsMask);
+    if (sensorsMask) TurnOffSensors(pCtx, sensorsMask);
     return NO_ERROR;
 }
 
 
+/* The time conversion test builds every multiply variant to compare them */
+#if !defined(TIME_MUL_INT128) && !defined(TIME_MUL_LONG) || defined(TEST_TIMECONV)
 /****************************************************************************************************
  * @fn      UMul32
  *          Helper routine for 32-bit saturating multiply. This maybe optimized in assembly if needed
@@ -681,66 +872,158 @@ static void UMul32(uint32_t x,uint32_t y, uint32_t * pHigh, uint32_t * pLow)
     *pHigh = high;
     *pLow = low;
 }
+#endif
 
 
+#if defined(TIME_MUL_INT128)
 /****************************************************************************************************
- * @fn      GetTimeFromCounter
- *          Helper routine for time conversion
+ * @fn      MulTimeCounterInt128
+ *          Multiplies a 64-bit counter by the U32Q32 counter to time factor into a 96-bit product
  *
  ***************************************************************************************************/
-static osp_bool_t GetTimeFromCounter(
-    NTTIME * pTime,
-    TIMECOEFFICIENT counterToTimeConversionFactor,
+static void MulTimeCounterInt128(
+    uint32_t factor,
     uint32_t counterHigh,
-    uint32_t counterLow)
+    uint32_t counterLow,
+    uint64_t *pProdHigh,
+    uint32_t *pProdLow)
+{
+    unsigned __int128 product;
+
+    product = (unsigned __int128)factor * ((((uint64_t)counterHigh) << 32) | counterLow);
+    *pProdLow = (uint32_t)product;
+    *pProdHigh = (uint64_t)(product >> 32);
+}
+#endif
+
+
+#if defined(TIME_MUL_LONG) || defined(TEST_TIMECONV)
+/****************************************************************************************************
+ * @fn      MulTimeCounterLong
+ *          MulTimeCounter with two 32x32->64 multiplies (UMULL, UMLAL)
+ *
+ ***************************************************************************************************/
+static void MulTimeCounterLong(
+    uint32_t factor,
+    uint32_t counterHigh,
+    uint32_t counterLow,
+    uint64_t *pProdHigh,
+    uint32_t *pProdLow)
+{
+    uint64_t low;
+
+    low = (uint64_t)factor * counterLow;                                // UMULL
+    *pProdLow = (uint32_t)low;
+    *pProdHigh = (uint64_t)factor * counterHigh + (uint32_t)(low >> 32); // UMLAL, cannot overflow
+}
+#endif
+
+
+#if !defined(TIME_MUL_INT128) && !defined(TIME_MUL_LONG) || defined(TEST_TIMECONV)
+/****************************************************************************************************
+ * @fn      MulTimeCounter32
+ *          MulTimeCounter with 16x16 partial products only
+ *
+ ***************************************************************************************************/
+static void MulTimeCounter32(
+    uint32_t factor,
+    uint32_t counterHigh,
+    uint32_t counterLow,
+    uint64_t *pProdHigh,
+    uint32_t *pProdLow)
 {
-    NTTIME ret = 0;
     uint32_t high1,low1;
     uint32_t high2,low2;
-    const uint32_t roundfactor = (1 << (Q32DIFF-1)) ;
-    if (counterToTimeConversionFactor & 0x80000000) {
-        counterToTimeConversionFactor = ~counterToTimeConversionFactor + 1;
-    }
 
-    UMul32(counterToTimeConversionFactor, counterLow, &high1, &low1);
-    UMul32(counterToTimeConversionFactor, counterHigh, &high2, &low2);
+    UMul32(factor, counterLow, &high1, &low1);
+    UMul32(factor, counterHigh, &high2, &low2);
 
     low2 += high1;
     if (low2 < high1) {
         high2++;
     }
+    *pProdLow = low1;
+    *pProdHigh = (((uint64_t)high2) << 32) | low2;
+}
+#endif
 
-    //round things
-    low1 += roundfactor;
+#if defined(TIME_MUL_INT128)
+# define MulTimeCounter                 MulTimeCounterInt128
+#elif defined(TIME_MUL_LONG)
+# define MulTimeCounter                 MulTimeCounterLong
+#else
+# define MulTimeCounter                 MulTimeCounter32
+#endif
 
-    //check overflow
-    if (low1 < roundfactor) {
-        low2++;
-        if (low2 ==0) {
-            high2++;
-        }
-    }
 
-    //right shift by Q32DIFF to make this into a Q24 number from a Q32 number
-    low1 >>= Q32DIFF;
-    low1 |= (low2 << (32 -  Q32DIFF) );
-    low2 >>= Q32DIFF;
-    low2 |= (high2 << (32 -  Q32DIFF) );
-    high2 >>= Q32DIFF;
+/****************************************************************************************************
+ * @fn      TimeFromProduct
+ *          Rounds and scales a 96-bit Q32 counter x factor product into NTTIME (Q24)
+ *
+ * @return  TRUE, or FALSE if the time saturated
+ *
+ ***************************************************************************************************/
+static osp_bool_t TimeFromProduct(NTTIME *pTime, uint64_t prodHigh, uint32_t prodLow)
+{
+    const uint32_t roundfactor = (1 << (Q32DIFF-1)) ;
 
-    if (high2 || low2 & 0x80000000) {
+    //round things
+    prodLow += roundfactor;
+    if (prodLow < roundfactor) {
+        prodHigh++;
+    }
+
+    //anything that does not fit a positive 64-bit number after the shift saturates
+    if (prodHigh >> (31 + Q32DIFF)) {
         //saturation!!!!!
         *pTime = 0x7FFFFFFFFFFFFFFFLL;
         return FALSE;
     }
 
-    ret = low2;
-    ret <<= 32;
-    ret |= low1;
+    //right shift by Q32DIFF to make this into a Q24 number from a Q32 number
+    *pTime = (NTTIME)((prodHigh << (32 - Q32DIFF)) | (prodLow >> Q32DIFF));
+    return TRUE;
+}
 
-    *pTime = ret;
 
-    return TRUE;
+/****************************************************************************************************
+ * @fn      GetTimeFromCounter
+ *          Helper routine for time conversion. Keeps the last counter x factor product in the given
+ *          extender. A counter that moved forward by less than 2^32 counts only needs a 32x32
+ *          multiply of the delta; anything else (first use, factor change, counter moved back)
+ *          redoes the full multiply.
+ *
+ ***************************************************************************************************/
+static osp_bool_t GetTimeFromCounter(
+    _TimeExtender_t *pExtender,
+    NTTIME * pTime,
+    TIMECOEFFICIENT counterToTimeConversionFactor,
+    uint32_t counterHigh,
+    uint32_t counterLow)
+{
+    uint64_t counter = (((uint64_t)counterHigh) << 32) | counterLow;
+    uint64_t delta = counter - pExtender->Counter;
+    uint64_t prodHigh;
+    uint32_t prodLow;
+
+    if (counterToTimeConversionFactor & 0x80000000) {
+        counterToTimeConversionFactor = ~counterToTimeConversionFactor + 1;
+    }
+
+    if (!pExtender->Valid || (pExtender->Factor != counterToTimeConversionFactor) ||
+        (counter < pExtender->Counter) || (delta >> 32)) {
+        MulTimeCounter(counterToTimeConversionFactor, counterHigh, counterLow,
+            &pExtender->ProdHigh, &pExtender->ProdLow);
+        pExtender->Factor = counterToTimeConversionFactor;
+        pExtender->Valid = TRUE;
+    } else {
+        MulTimeCounter(counterToTimeConversionFactor, 0, (uint32_t)delta, &prodHigh, &prodLow);
+        pExtender->ProdLow += prodLow;
+        pExtender->ProdHigh += prodHigh + (pExtender->ProdLow < prodLow);
+    }
+    pExtender->Counter = counter;
+
+    return TimeFromProduct(pTime, pExtender->ProdHigh, pExtender->ProdLow);
 }
 
 
@@ -778,120 +1061,526 @@ static int32_t ScaleSensorData(
 
 
 /****************************************************************************************************
- * @fn      ConvertSensorData
- *          Given a pointer to a raw sensor data packet from the input queue of type
- *          _SensorDataBuffer_t and a pointer to a sensor output data packet of type
- *          TriAxisSensorCookedData_t, apply translations and conversions into a format per Android
- *          conventions. Accuracy must be either QFIXEDPOINTPRECISE or QFIXEDPOINTEXTENDED
+ * @fn      BuildSensorConvPlan
+ *          Resolves the axis mapping, offsets, scale factors and data width of an input sensor into
+ *          a conversion plan for ConvertSensorDataBlock(). Accuracy must be either
+ *          QFIXEDPOINTPRECISE or QFIXEDPOINTEXTENDED
+ *
+ * @return  NO_ERROR or ERROR if the sensor descriptor has an invalid axis mapping
  *
  ***************************************************************************************************/
-static int16_t ConvertSensorData(
-    _SensorDataBuffer_t *pRawData,
-    Common_3AxisResult_t *pCookedData,
+static int16_t BuildSensorConvPlan(
+    InputSensorSpecificData_t *pInpSensData,
     uint8_t accuracy,
-    uint32_t *sensorTimeStamp,
-    uint32_t *sensorTimeStampExtension)
+    _SensorConvPlan_t *pPlan)
 {
     uint16_t i;
-    unsigned char negative;
-    unsigned char source;
-    InputSensorSpecificData_t *pInpSensData;
+    uint32_t mask = pInpSensData->DataWidthMask;
 
-    switch( ((_SenDesc_t *)(pRawData->Handle))->pSenDesc->SensorType ) {
-    case SENSOR_ACCELEROMETER_UNCALIBRATED:
-    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
-    case SENSOR_GYROSCOPE_UNCALIBRATED:
+    switch (accuracy) {
+    case QFIXEDPOINTPRECISE:
+    case QFIXEDPOINTEXTENDED:
         break;
-
     default:
         return ERROR;
     }
 
-    // apply axis conversion and data width 1st, then offset, then gain (scaling), finally convert the time stamp.
-    pCookedData->accuracy = accuracy;
-    pInpSensData =  ((_SenDesc_t *)(pRawData->Handle))->pSenDesc->pSensorSpecificData;
+    pPlan->Accuracy = accuracy;
+    pPlan->Mask = mask;
+    pPlan->SignShift = -1;
+    if ((mask != 0) && ((mask & (mask + 1)) == 0)) {
+        // contiguous mask from bit 0, masking & sign extension can be done with a pair of shifts
+        for (pPlan->SignShift = 0; !(mask & 0x80000000UL); mask <<= 1)
+            pPlan->SignShift++;
+    }
 
     for (i = 0; i < 3; i++) {
-        negative = 0;
-        switch (pInpSensData->AxisMapping[i]) {
+        pPlan->Negate[i] = 0;
+        pPlan->Offset[i] = pInpSensData->ConversionOffset[i];
+        pPlan->Scale[i] = pInpSensData->ConversionScale[i];
 
+        switch (pInpSensData->AxisMapping[i]) {
         case AXIS_MAP_UNUSED:
-            switch (accuracy) {
-            case QFIXEDPOINTPRECISE:
-                pCookedData->data.preciseData[i] = CONST_PRECISE(0.0f);
-                break;
-            case QFIXEDPOINTEXTENDED:
-                pCookedData->data.extendedData[i] = CONST_EXTENDED(0.0f);
-                break;
-            default:
-                return ERROR;
-            }
-            continue;
+            pPlan->Source[i] = -1;
+            break;
         case AXIS_MAP_NEGATIVE_X:
-            negative = 1;
+            pPlan->Negate[i] = 1;
+            /* fall through */
         case AXIS_MAP_POSITIVE_X:
-            source = 0;
+            pPlan->Source[i] = 0;
             break;
 
         case AXIS_MAP_NEGATIVE_Y:
-            negative = 1;
+            pPlan->Negate[i] = 1;
+            /* fall through */
         case AXIS_MAP_POSITIVE_Y:
-            source = 1;
+            pPlan->Source[i] = 1;
             break;
 
         case AXIS_MAP_NEGATIVE_Z:
-            negative = 1;
+            pPlan->Negate[i] = 1;
+            /* fall through */
         case AXIS_MAP_POSITIVE_Z:
-            source = 2;
+            pPlan->Source[i] = 2;
             break;
 
         default:
             return ERROR;
         }
+    }
+    return NO_ERROR;
+}
 
-        switch (accuracy) {
-        case QFIXEDPOINTPRECISE:
-            // mask, sign extend (if needed), apply offset and scale factor
-            pCookedData->data.preciseData[i] = ScaleSensorData(pRawData->Data.Data[source],
-                pInpSensData->DataWidthMask,
-                pInpSensData->ConversionOffset[i],
-                pInpSensData->ConversionScale[i]);
-            if (negative)
-                pCookedData->data.preciseData[i] = -pCookedData->data.preciseData[i];
 
-            break;
-        case QFIXEDPOINTEXTENDED:
-            // mask, sign extend (if needed), apply offset and scale factor
-            pCookedData->data.extendedData[i] = ScaleSensorData(pRawData->Data.Data[source],
-                pInpSensData->DataWidthMask,
-                pInpSensData->ConversionOffset[i],
-                pInpSensData->ConversionScale[i]);
-            if (negative)
-                pCookedData->data.extendedData[i] = -pCookedData->data.extendedData[i];
-            break;
-        default:
-            return ERROR;
+/****************************************************************************************************
+ * @fn      ConvertSensorDataBlockRef
+ *          Portable reference of the block conversion. Applies axis mapping, data width & sign
+ *          extension, offset and scaling to count raw samples of one sensor. Time stamps are not
+ *          touched.
+ *
+ ***************************************************************************************************/
+static void ConvertSensorDataBlockRef(
+    const _SensorConvPlan_t *pPlan,
+    const TriAxisSensorRawData_t * const pRaw[],
+    Common_3AxisResult_t *pCooked,
+    uint16_t count)
+{
+    uint16_t n, i;
+    int32_t value;
+
+    for (n = 0; n < count; n++) {
+        pCooked[n].accuracy = pPlan->Accuracy;
+        for (i = 0; i < 3; i++) {
+            if (pPlan->Source[i] < 0) {
+                value = 0;
+            } else {
+                // mask, sign extend (if needed), apply offset and scale factor
+                value = ScaleSensorData(pRaw[n]->Data[pPlan->Source[i]],
+                    pPlan->Mask,
+                    pPlan->Offset[i],
+                    pPlan->Scale[i]);
+                if (pPlan->Negate[i])
+                    value = (value == (int32_t)SATURATE_INT_MIN) ? (int32_t)SATURATE_INT_MAX : -value;
+            }
+            // NTPRECISE and NTEXTENDED share the same storage, accuracy tells them apart
+            pCooked[n].data.preciseData[i] = value;
         }
     }
+}
 
-    // scale time stamp into seconds
+
+#if defined(CONVERT_M4)
+#if !defined(__CORTEX_M)
+/****************************************************************************************************
+ * @fn      QSubHost
+ *          Saturating 32-bit subtract, as QSUB
+ *
+ ***************************************************************************************************/
+static int32_t QSubHost(int32_t a, int32_t b)
+{
+    int64_t llTemp = (int64_t)a - b;
+
+    if(llTemp > SATURATE_INT_MAX )
+        llTemp = SATURATE_INT_MAX;
+    if(llTemp < SATURATE_INT_MIN )
+        llTemp = SATURATE_INT_MIN;
+    return (int32_t)llTemp;
+}
+#endif
+
+
+/****************************************************************************************************
+ * @fn      ConvertSensorDataBlock
+ *          Cortex-M4 block conversion. Same results as ConvertSensorDataBlockRef(); masking and sign
+ *          extension are a shift pair, the scaling a single SMULL with the saturation taken from the
+ *          high word, and axis inversion a saturating QSUB.
+ *
+ ***************************************************************************************************/
+static void ConvertSensorDataBlock(
+    const _SensorConvPlan_t *pPlan,
+    const TriAxisSensorRawData_t * const pRaw[],
+    Common_3AxisResult_t *pCooked,
+    uint16_t count)
+{
+    uint16_t n, i;
+    int32_t value, high;
+    int64_t llTemp;
+    const uint32_t shift = pPlan->SignShift;
+
+    if (pPlan->SignShift < 0) {
+        ConvertSensorDataBlockRef(pPlan, pRaw, pCooked, count);    // odd data width mask
+        return;
+    }
+
+    for (n = 0; n < count; n++) {
+        pCooked[n].accuracy = pPlan->Accuracy;
+        for (i = 0; i < 3; i++) {
+            if (pPlan->Source[i] < 0) {
+                pCooked[n].data.preciseData[i] = 0;
+                continue;
+            }
+            value = (int32_t)((uint32_t)pRaw[n]->Data[pPlan->Source[i]] - (uint32_t)pPlan->Offset[i]);
+            value = (int32_t)((uint32_t)value << shift) >> shift;       // mask & sign extend
+
+            llTemp = (int64_t)value * pPlan->Scale[i];
+            value = (int32_t)llTemp;
+            high = (int32_t)(llTemp >> 32);
+            if (high != (value >> 31))
+                value = (high < 0) ? (int32_t)SATURATE_INT_MIN : (int32_t)SATURATE_INT_MAX;
+
+            if (pPlan->Negate[i])
+                value = __QSUB(0, value);
+            pCooked[n].data.preciseData[i] = value;
+        }
+    }
+}
+#else
+# define ConvertSensorDataBlock         ConvertSensorDataBlockRef
+#endif
+
+
+/****************************************************************************************************
+ * @fn      ExtendSensorTimeStamp
+ *          Extends a raw sensor time stamp with the rollover count of the given consumer and scales it
+ *          into seconds. Must be called in queue order.
+ *
+ ***************************************************************************************************/
+static void ExtendSensorTimeStamp(
+    OSP_Context_t *pCtx,
+    uint32_t rawTimeStamp,
+    NTTIME *pTimeStamp,
+    uint32_t *sensorTimeStamp,
+    uint32_t *sensorTimeStampExtension,
+    _TimeExtender_t *pExtender)
+{
     // check for user timestamp rollover, if so bump our timestamp extension word
     // !!WARNING!!: The time stamp extension scheme will need to be changed if timer capture is used
     // for sensor time-stamping. Current scheme will cause time jumps if two sensors are timer-captured
     // before & after rollover but the sensor that was captured after rollover is queued before the
     // sensor that was captured before timer rollover
-    EnterCritical();
-    if( ((int32_t)(*sensorTimeStamp) < 0) && ((int32_t)pRawData->Data.TimeStamp >= 0) ) {
+    pCtx->EnterCritical();
+    if( ((int32_t)(*sensorTimeStamp) < 0) && ((int32_t)rawTimeStamp >= 0) ) {
         (*sensorTimeStampExtension)++;
     }
-    *sensorTimeStamp = pRawData->Data.TimeStamp;
-    ExitCritical();
+    *sensorTimeStamp = rawTimeStamp;
+    pCtx->ExitCritical();
 
-    GetTimeFromCounter(&pCookedData->TimeStamp, _pPlatformDesc->TstampConversionToSeconds,
+    GetTimeFromCounter(pExtender, pTimeStamp, pCtx->pPlatformDesc->TstampConversionToSeconds,
         *sensorTimeStampExtension, *sensorTimeStamp);
+}
+
+
+/****************************************************************************************************
+ * @fn      ConvertSensorData
+ *          Given a pointer to a raw sensor data packet from the input queue of type
+ *          _SensorDataBuffer_t and a pointer to a sensor output data packet of type
+ *          TriAxisSensorCookedData_t, apply translations and conversions into a format per Android
+ *          conventions, using the conversion plan built when the sensor was registered
+ *
+ ***************************************************************************************************/
+static int16_t ConvertSensorData(
+    OSP_Context_t *pCtx,
+    _SensorDataBuffer_t *pRawData,
+    Common_3AxisResult_t *pCookedData,
+    uint32_t *sensorTimeStamp,
+    uint32_t *sensorTimeStampExtension,
+    _TimeExtender_t *pExtender)
+{
+    const _SenDesc_t *pSensor = (const _SenDesc_t *)pRawData->Handle;
+    const TriAxisSensorRawData_t *pRaw = &pRawData->Data;
+
+    if (!(pSensor->Flags & SENSOR_FLAG_HAVE_CONV_PLAN))
+        return ERROR;
+
+    // apply axis conversion and data width 1st, then offset, then gain (scaling), finally convert the time stamp.
+    ConvertSensorDataBlock(&pSensor->ConvPlan, &pRaw, pCookedData, 1);
+
+    // scale time stamp into seconds
+    ExtendSensorTimeStamp(pCtx, pRawData->Data.TimeStamp, &pCookedData->TimeStamp,
+        sensorTimeStamp, sensorTimeStampExtension, pExtender);
     return NO_ERROR;
 }
 
+
+/****************************************************************************************************
+ * @fn      CheckForegroundData
+ *          Checks if a data packet taken off the queue has foreground processing.
+ *
+ * @return  OSP_STATUS_OK if the packet is to be converted, OSP_STATUS_IDLE if the sensor has no
+ *          foreground processing, OSP_STATUS_NOT_IMPLEMENTED if the data convention is not supported
+ *
+ ***************************************************************************************************/
+static osp_status_t CheckForegroundData(_SensorDataBuffer_t *pData)
+{
+    switch( ((_SenDesc_t*)pData->Handle)->pSenDesc->SensorType ) {
+    case SENSOR_ACCELEROMETER_UNCALIBRATED:
+    case SENSOR_GYROSCOPE_UNCALIBRATED:
+    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
+        break;
+
+    default:
+        return OSP_STATUS_IDLE;
+    }
+
+    if (((_SenDesc_t*)pData->Handle)->pSenDesc->DataConvention != DATA_CONVENTION_RAW) {
+        //!TODO - Other data conventions support not implemented yet
+        return OSP_STATUS_NOT_IMPLEMENTED;
+    }
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      PublishLatestData
+ *          Stores a sample as the latest for polling. Must only be called from one task (foreground
+ *          processing); readers go through OSP_GetLatestData().
+ *
+ ***************************************************************************************************/
+static void PublishLatestData(_LatestData_t *pLatest, const Common_3AxisResult_t *pData)
+{
+    uint32_t seq = pLatest->Completed + 1;
+
+    // announce the write before touching the buffer a reader of seq-2 may still be copying
+    pLatest->Started = seq;
+    MEMORY_BARRIER();
+    memcpy(&pLatest->Buf[seq & 1], pData, sizeof(Common_3AxisResult_t));
+    MEMORY_BARRIER();
+    pLatest->Completed = seq;
+}
+
+
+/****************************************************************************************************
+ * @fn      DispatchForegroundData
+ *          Sends converted (Android convention) sensor data to the results subscribed on this input
+ *          sensor's dispatch entry and, in algorithm convention, on to the foreground algorithms.
+ *
+ * @param   [IN] Type - sensor type of the data
+ * @param   [IN] pAndroidData - converted sensor data
+ *
+ * @return  status as specified in OSP_Types.h
+ *
+ ***************************************************************************************************/
+static osp_status_t DispatchForegroundData(OSP_Context_t *pCtx, SensorType_t Type, Common_3AxisResult_t *pAndroidData)
+{
+    AndroidUnCalResult_t AndoidUncalProcessedData;
+    Common_3AxisResult_t algConvention;
+    const _ResultDispatch_t *pDispatch = &pCtx->ResultDispatch[Type];
+    uint16_t i;
+
+    switch( Type ) {
+
+    case SENSOR_ACCELEROMETER_UNCALIBRATED:
+        // Do uncalibrated accel call back here (Android conventions)
+        if (pDispatch->Count != 0) {
+            memcpy(&AndoidUncalProcessedData.ucAccel.X,
+                pAndroidData->data.preciseData,
+                (sizeof(NTPRECISE)*3));
+            memcpy(&AndoidUncalProcessedData.ucAccel.X_offset,
+                pCtx->AccelBias, (sizeof(NTPRECISE)*3));
+            AndoidUncalProcessedData.ucAccel.TimeStamp = pAndroidData->TimeStamp;
+
+            for (i = 0; i < pDispatch->Count; i++)
+                pDispatch->pResult[i]->pResDesc->pOutputReadyCallback(
+                    (OutputSensorHandle_t)pDispatch->pResult[i], &AndoidUncalProcessedData.ucAccel);
+        }
+
+        // convert to algorithm convention before feeding data to algorithms.
+        algConvention.accuracy = QFIXEDPOINTPRECISE;
+        algConvention.data.preciseData[0] = pAndroidData->data.preciseData[1];  // x (ALG) =  Y (Android)
+        algConvention.data.preciseData[1] = -pAndroidData->data.preciseData[0]; // y (ALG) = -X (Android)
+        algConvention.data.preciseData[2] = pAndroidData->data.preciseData[2];  // z (ALG) =  Z (Android)
+        algConvention.TimeStamp = pAndroidData->TimeStamp;
+
+        PublishLatestData(&pCtx->LastAccelCookedData, &algConvention);
+
+        //OSP_SetForegroundAccelerometerMeasurement(algConvention.TimeStamp, algConvention.data.preciseData);
+        // Send data on to algorithms
+        OSP_SetAccelerometerMeasurement(&pCtx->Alg, algConvention.TimeStamp, algConvention.data.preciseData);
+
+        // Do linear accel and gravity processing if needed
+        // ... TODO
+        break;
+
+    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
+        // Do uncalibrated mag call back here (Android conventions)
+        if (pDispatch->Count != 0) {
+            memcpy(&AndoidUncalProcessedData.ucMag.X,
+                pAndroidData->data.extendedData,
+                (sizeof(NTEXTENDED)*3));
+            memcpy(&AndoidUncalProcessedData.ucMag.X_hardIron_offset,
+                pCtx->MagBias, (sizeof(NTEXTENDED)*3));
+            AndoidUncalProcessedData.ucMag.TimeStamp = pAndroidData->TimeStamp;
+
+            for (i = 0; i < pDispatch->Count; i++)
+                pDispatch->pResult[i]->pResDesc->pOutputReadyCallback(
+                    (OutputSensorHandle_t)pDispatch->pResult[i], &AndoidUncalProcessedData.ucMag);
+        }
+
+        // remove the hard iron offset and convert to algorithm convention before feeding data to algs.
+        algConvention.accuracy = QFIXEDPOINTEXTENDED;
+        algConvention.data.extendedData[0] = pAndroidData->data.extendedData[1] - pCtx->MagBias[1];     // x (ALG) =  Y (Android)
+        algConvention.data.extendedData[1] = -(pAndroidData->data.extendedData[0] - pCtx->MagBias[0]);  // y (ALG) = -X (Android)
+        algConvention.data.extendedData[2] = pAndroidData->data.extendedData[2] - pCtx->MagBias[2];     // z (ALG) =  Z (Android)
+        algConvention.TimeStamp = pAndroidData->TimeStamp;
+
+        PublishLatestData(&pCtx->LastMagCookedData, &algConvention);
+
+        //OSP_SetForegroundMagnetometerMeasurement(pAndroidData->TimeStamp, algConvention.data.extendedData);
+        break;
+
+    case SENSOR_GYROSCOPE_UNCALIBRATED:
+        // Do uncalibrated gyro call back here (Android conventions)
+        if (pDispatch->Count != 0) {
+            memcpy(&AndoidUncalProcessedData.ucGyro.X,
+                pAndroidData->data.preciseData,
+                (sizeof(NTPRECISE)*3));
+            memcpy(&AndoidUncalProcessedData.ucGyro.X_drift_offset,
+                pCtx->GyroBias, (sizeof(NTPRECISE)*3));
+            AndoidUncalProcessedData.ucGyro.TimeStamp = pAndroidData->TimeStamp;
+
+            for (i = 0; i < pDispatch->Count; i++)
+                pDispatch->pResult[i]->pResDesc->pOutputReadyCallback(
+                    (OutputSensorHandle_t)pDispatch->pResult[i], &AndoidUncalProcessedData.ucGyro);
+        }
+
+        // remove the bias and convert to algorithm convention before feeding data to algs.
+        algConvention.accuracy = QFIXEDPOINTPRECISE;
+        algConvention.data.preciseData[0] = pAndroidData->data.preciseData[1] - pCtx->GyroBias[1];     // x (ALG) =  Y (Android)
+        algConvention.data.preciseData[1] = -(pAndroidData->data.preciseData[0] - pCtx->GyroBias[0]);  // y (ALG) = -X (Android)
+        algConvention.data.preciseData[2] = pAndroidData->data.preciseData[2] - pCtx->GyroBias[2];     // z (ALG) =  Z (Android)
+        algConvention.TimeStamp = pAndroidData->TimeStamp;
+
+        PublishLatestData(&pCtx->LastGyroCookedData, &algConvention);
+
+        //OSP_SetForegroundGyroscopeMeasurement(pAndroidData->TimeStamp, algConvention.data.preciseData);
+        break;
+
+    default:
+        break;
+    }
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      ProcessBackgroundData
+ *          Converts a data packet taken off the queue for background processing and feeds it to the
+ *          calibration code. Constant work per packet.
+ *
+ ***************************************************************************************************/
+static void ProcessBackgroundData(OSP_Context_t *pCtx, _SensorDataBuffer_t *pData)
+{
+    Common_3AxisResult_t AndoidProcessedData;
+    MagCalibration_t MagCal;
+    //Common_3AxisResult_t algConvention;
+
+    // now send the processed data to the appropriate entry points in the alg calibration code.
+    switch( ((_SenDesc_t*)pData->Handle)->pSenDesc->SensorType ) {
+
+    case SENSOR_ACCELEROMETER_UNCALIBRATED:
+        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
+        if(ConvertSensorData(
+            pCtx,
+            pData,
+            &AndoidProcessedData,
+            &pCtx->LastBackgroundTimeStamp,
+            &pCtx->LastBackgroundTimeStampExtension,
+            &pCtx->BackgroundTimeExtender) == ERROR)
+            break;
+
+        // accel stillness gates the gyro bias estimate
+        GyroBiasEstimator_SetAccelerometerMeasurement(&pCtx->GyroBiasEst, AndoidProcessedData.TimeStamp,
+            AndoidProcessedData.data.preciseData);
+
+#if 0 //Nothing else to be done for background processing at this time!
+        // convert to algorithm convention.
+        algConvention.accuracy = QFIXEDPOINTPRECISE;
+        algConvention.data.preciseData[0] = AndoidProcessedData.data.preciseData[1];  // x (ALG) =  Y (Android)
+        algConvention.data.preciseData[1] = -AndoidProcessedData.data.preciseData[0]; // y (ALG) = -X (Android)
+        algConvention.data.preciseData[2] = AndoidProcessedData.data.preciseData[2];  // z (ALG) =  Z (Android)
+        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
+
+        //OSP_SetBackgroundAccelerometerMeasurement(algConvention.TimeStamp, algConvention.data.preciseData);
+#endif
+        break;
+
+    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
+        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
+        if(ConvertSensorData(
+            pCtx,
+            pData,
+            &AndoidProcessedData,
+            &pCtx->LastBackgroundTimeStamp,
+            &pCtx->LastBackgroundTimeStampExtension,
+            &pCtx->BackgroundTimeExtender) == ERROR)
+            break;
+
+        // constant work per sample, the fit itself is only solved every so many samples
+        if(MagCalibrator_SetMagnetometerMeasurement(&pCtx->MagCal, AndoidProcessedData.TimeStamp,
+            AndoidProcessedData.data.extendedData) && MagCalibrator_Solve(&pCtx->MagCal)) {
+            MagCalibrator_GetCalibration(&pCtx->MagCal, &MagCal);
+
+            // publish the new offset to foreground processing
+            pCtx->EnterCritical();
+            memcpy(pCtx->MagBias, MagCal.HardIronOffset, sizeof(pCtx->MagBias));
+            pCtx->ExitCritical();
+
+            // and let the host store it
+            if(((_SenDesc_t*)pData->Handle)->Flags & SENSOR_FLAG_HAVE_CAL_CALLBACK) {
+                ((_SenDesc_t*)pData->Handle)->pSenDesc->pOptionalWriteCalDataCallback(
+                    (InputSensorHandle_t)pData->Handle, &MagCal, sizeof(MagCal), AndoidProcessedData.TimeStamp);
+            }
+        }
+
+#if 0 //Nothing else to be done for background processing at this time!
+        // convert to algorithm convention.
+        algConvention.accuracy = QFIXEDPOINTEXTENDED;
+        algConvention.data.extendedData[0] = AndoidProcessedData.data.extendedData[1];   // x (ALG) =  Y (Android)
+        algConvention.data.extendedData[1] = -AndoidProcessedData.data.extendedData[0];  // y (ALG) = -X (Android)
+        algConvention.data.extendedData[2] = AndoidProcessedData.data.extendedData[2];   // z (ALG) =  Z (Android)
+        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
+
+        //OSP_SetBackgroundMagnetometerMeasurement(algConvention.TimeStamp, algConvention.data.extendedData);
+#endif
+        break;
+
+    case SENSOR_GYROSCOPE_UNCALIBRATED:
+        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
+        if(ConvertSensorData(
+            pCtx,
+            pData,
+            &AndoidProcessedData,
+            &pCtx->LastBackgroundTimeStamp,
+            &pCtx->LastBackgroundTimeStampExtension,
+            &pCtx->BackgroundTimeExtender) == ERROR)
+            break;
+
+        // publish a new bias estimate to the uncalibrated gyro output of foreground processing
+        if(GyroBiasEstimator_SetGyroscopeMeasurement(&pCtx->GyroBiasEst, AndoidProcessedData.TimeStamp,
+            AndoidProcessedData.data.preciseData)) {
+            pCtx->EnterCritical();
+            GyroBiasEstimator_GetBias(&pCtx->GyroBiasEst, pCtx->GyroBias);
+            pCtx->ExitCritical();
+        }
+
+#if 0 //Nothing else to be done for background processing at this time!
+        // convert to algorithm convention.
+        algConvention.accuracy = QFIXEDPOINTPRECISE;
+        algConvention.data.preciseData[0] = AndoidProcessedData.data.preciseData[1];  // x (ALG) =  Y (Android)
+        algConvention.data.preciseData[1] = -AndoidProcessedData.data.preciseData[0]; // y (ALG) = -X (Android)
+        algConvention.data.preciseData[2] = AndoidProcessedData.data.preciseData[2];  // z (ALG) =  Z (Android)
+        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
+
+        //OSP_SetBackgroundGyroscopeMeasurement(algConvention.TimeStamp, algConvention.data.preciseData);
+#endif
+        break;
+
+    default:
+        break;
+    }
+}
+
 /*-------------------------------------------------------------------------------------------------*\
  |    A P I     F U N C T I O N S
 \*-------------------------------------------------------------------------------------------------*/
@@ -900,27 +1589,38 @@ static int16_t ConvertSensorData(
  * @fn      OSP_Initialize
  *          Does internal initializations that the library requires.
  *
+ * @param   pCtx - OUTPUT library context to set up. The caller provides the storage, which must
+ *          stay valid for as long as the context is used
  * @param   pSystemDesc - INPUT pointer to a struct that describes things like time tick conversion
  *          value
  *
  * @return  status as specified in OSP_Types.h
  *
  ***************************************************************************************************/
-osp_status_t OSP_Initialize(const SystemDescriptor_t* pSystemDesc)
+osp_status_t OSP_Initialize(OSP_Context_t *pCtx, const SystemDescriptor_t* pSystemDesc)
 {
-    _SubscribedResults = 0;     // by definition, we are not subscribed to any results
-    memset(_SensorTable, 0, sizeof(_SensorTable));   // init the sensor table
-    memset(_ResultTable, 0, sizeof(_ResultTable));   // init the result table also
+    if((pCtx == NULL) || (pSystemDesc == NULL))                 // just in case
+        return OSP_STATUS_NULL_POINTER;
+
+    // by definition, we are not subscribed to any results, sensor & result tables, dispatch lists,
+    // queue, time stamps and biases all start out cleared
+    memset(pCtx, 0, sizeof(OSP_Context_t));
+    pCtx->SensorDataNqPtr = SENSOR_DATA_Q_SIZE - 1;
 
     if(ValidateSystemDescriptor(pSystemDesc) == ERROR)
         return (osp_status_t)OSP_STATUS_DESCRIPTOR_INVALID;
-    _pPlatformDesc = pSystemDesc;
+    pCtx->pPlatformDesc = pSystemDesc;
+    pCtx->EnterCritical = (OSP_CriticalSectionCallback_t)&NullRoutine;
+    pCtx->ExitCritical = (OSP_CriticalSectionCallback_t)&NullRoutine;
     if((pSystemDesc->EnterCritical != NULL) && (pSystemDesc->ExitCritical != NULL)) {
-        EnterCritical = pSystemDesc->EnterCritical;
-        ExitCritical = pSystemDesc->ExitCritical;
+        pCtx->EnterCritical = pSystemDesc->EnterCritical;
+        pCtx->ExitCritical = pSystemDesc->ExitCritical;
     }
 
-    OSP_InitializeAlgorithms();
+    OSP_InitializeAlgorithms(&pCtx->Alg, pCtx);
+    GyroBiasEstimator_Init(&pCtx->GyroBiasEst);
+    MagCalibrator_Init(&pCtx->MagCal);
+    CYCLE_COUNTER_ENABLE();
 
     return OSP_STATUS_OK;
 }
@@ -929,7 +1629,10 @@ osp_status_t OSP_Initialize(const SystemDescriptor_t* pSystemDesc)
 /****************************************************************************************************
  * @fn      OSP_RegisterInputSensor
  *          Tells the Open-Sensor-Platform Library what kind of sensor inputs it has to work with.
+ *          The raw data conversion (axis mapping, offsets, scale factors, data width) is taken from
+ *          the descriptor here; changing it afterwards needs the sensor registered again.
  *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
  * @param   pSensorDescriptor INPUT pointer to data which describes all the details of this sensor
  *          and its current operating mode; e.g. sensor type, SI unit conversion factor
  * @param   pReturnedHandle OUTPUT a handle to use when feeding data in via OSP_SetData()
@@ -937,11 +1640,12 @@ osp_status_t OSP_Initialize(const SystemDescriptor_t* pSystemDesc)
  * @return  status as specified in OSP_Types.h
  *
  ***************************************************************************************************/
-osp_status_t OSP_RegisterInputSensor(SensorDescriptor_t *pSensorDescriptor,
+osp_status_t OSP_RegisterInputSensor(OSP_Context_t *pCtx, SensorDescriptor_t *pSensorDescriptor,
     InputSensorHandle_t *pReturnedHandle)
 {
     int16_t status;
     int16_t index;
+    uint8_t accuracy;
     osp_bool_t haveCalData = FALSE;
 
     // Find 1st available slot in the sensor descriptor table, insert descriptor pointer, clear flags
@@ -950,7 +1654,7 @@ osp_status_t OSP_RegisterInputSensor(SensorDescriptor_t *pSensorDescriptor,
     if((pSensorDescriptor == NULL) || (pReturnedHandle == NULL))      // just in case
         return OSP_STATUS_NULL_POINTER;
 
-    if(FindSensorTableIndexByType(pSensorDescriptor->SensorType) != ERROR) { // is this sensor type already registered?
+    if(FindSensorTableIndexByType(pCtx, pSensorDescriptor->SensorType) != ERROR) { // is this sensor type already registered?
         *pReturnedHandle = NULL;
         return OSP_STATUS_ALREADY_REGISTERED;
     }
@@ -967,22 +1671,39 @@ osp_status_t OSP_RegisterInputSensor(SensorDescriptor_t *pSensorDescriptor,
     haveCalData = haveCalData; //Avoid compiler warning for now!
 
     // If room in the sensor table, enter it and return the handle, else return OSP_STATUS_NO_MORE_HANDLES
-    index = FindEmptySensorTableIndex();
+    index = FindEmptySensorTableIndex(pCtx);
     if(index != ERROR) {
-        _SensorTable[index].pSenDesc = pSensorDescriptor;
-        _SensorTable[index].Flags = 0;
-        *pReturnedHandle = (InputSensorHandle_t)&_SensorTable[index];
+        pCtx->SensorTable[index].pSenDesc = pSensorDescriptor;
+        pCtx->SensorTable[index].Flags = 0;
+        *pReturnedHandle = (InputSensorHandle_t)&pCtx->SensorTable[index];
     } else {
         return OSP_STATUS_NO_MORE_HANDLES;
     }
 
     // setup any flags for this sensor
     if (pSensorDescriptor->pOptionalWriteCalDataCallback != NULL)  // set the flag for the optional sensor calibration changed callback
-        _SensorTable[index].Flags |= SENSOR_FLAG_HAVE_CAL_CALLBACK;
+        pCtx->SensorTable[index].Flags |= SENSOR_FLAG_HAVE_CAL_CALLBACK;
     else
-        _SensorTable[index].Flags &= ~SENSOR_FLAG_HAVE_CAL_CALLBACK;
+        pCtx->SensorTable[index].Flags &= ~SENSOR_FLAG_HAVE_CAL_CALLBACK;
+
+    pCtx->SensorTable[index].Flags &= ~SENSOR_FLAG_IN_USE;         // by definition, this sensor isn't in use yet.
 
-    _SensorTable[index].Flags &= ~SENSOR_FLAG_IN_USE;               // by definition, this sensor isn't in use yet.
+    // resolve the raw data conversion once, foreground and background processing share it
+    switch(pSensorDescriptor->SensorType) {
+    case SENSOR_ACCELEROMETER_UNCALIBRATED:
+    case SENSOR_GYROSCOPE_UNCALIBRATED:
+        accuracy = QFIXEDPOINTPRECISE;
+        break;
+    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
+        accuracy = QFIXEDPOINTEXTENDED;
+        break;
+    default:
+        return OSP_STATUS_OK;                                       // not converted
+    }
+    if((pSensorDescriptor->pSensorSpecificData != NULL) &&
+        (BuildSensorConvPlan(pSensorDescriptor->pSensorSpecificData, accuracy,
+            &pCtx->SensorTable[index].ConvPlan) == NO_ERROR))
+        pCtx->SensorTable[index].Flags |= SENSOR_FLAG_HAVE_CONV_PLAN;
 
     return OSP_STATUS_OK;
 }
@@ -992,12 +1713,13 @@ osp_status_t OSP_RegisterInputSensor(SensorDescriptor_t *pSensorDescriptor,
  * @fn      OSP_UnregisterInputSensor
  *          Call to remove an sensor from OSP's known set of inputs.
  *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
  * @param   handle INPUT a handle to the input sensor you want to unregister
  *
  * @return  status as specified in OSP_Types.h
  *
  ***************************************************************************************************/
-osp_status_t OSP_UnregisterInputSensor(InputSensorHandle_t sensorHandle)
+osp_status_t OSP_UnregisterInputSensor(OSP_Context_t *pCtx, InputSensorHandle_t sensorHandle)
 {
     int16_t index;
     // Check the sensor table to be sure we have a valid entry, if so we need to check
@@ -1005,16 +1727,16 @@ osp_status_t OSP_UnregisterInputSensor(InputSensorHandle_t sensorHandle)
     // SensorHandle and the appropriate error code.
     // We also need to mark all data for this sensor that is in the input queue as invalid (make handle = NULL).
 
-    index = FindSensorTableIndexByHandle(sensorHandle);
+    index = FindSensorTableIndexByHandle(pCtx, sensorHandle);
     if(index == ERROR) {                            // test for valid handle
         return OSP_STATUS_NOT_REGISTERED;
     }
 
     //Invalidate queued data for this sensor
-    InvalidateQueuedDataByHandle(sensorHandle);
+    InvalidateQueuedDataByHandle(pCtx, sensorHandle);
 
     // Invalidate the descriptor entry
-    _SensorTable[index].pSenDesc = NULL;
+    pCtx->SensorTable[index].pSenDesc = NULL;
 
 
     return OSP_STATUS_OK;
@@ -1026,58 +1748,75 @@ osp_status_t OSP_UnregisterInputSensor(InputSensorHandle_t sensorHandle)
  *          Queues sensor data which will be processed by OSP_DoForegroundProcessing() and
  *          OSP_DoBackgroundProcessing()
  *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
  * @param   sensorHandle INPUT requires a valid handle as returned by OSP_RegisterInputSensor()
  * @param   data INPUT pointer to timestamped raw sensor data
  *
  * @return  status as specified in OSP_Types.h
  *
  ***************************************************************************************************/
-osp_status_t OSP_SetData(InputSensorHandle_t sensorHandle, TriAxisSensorRawData_t *data)
+osp_status_t OSP_SetData(OSP_Context_t *pCtx, InputSensorHandle_t sensorHandle, TriAxisSensorRawData_t *data)
 {
-    register osp_status_t FgStatus = 0;
-    register osp_status_t BgStatus = 0;
-
+    osp_status_t status = OSP_STATUS_OK;
 
     if (data == NULL)                                           // just in case
         return OSP_STATUS_NULL_POINTER;
     if(sensorHandle == NULL)                                    // just in case
         return OSP_STATUS_INVALID_HANDLE;
-    if(FindSensorTableIndexByHandle(sensorHandle) == ERROR)
+    if(FindSensorTableIndexByHandle(pCtx, sensorHandle) == ERROR)
         return OSP_STATUS_INVALID_HANDLE;
 
     if( ((_SenDesc_t *)sensorHandle)->Flags & SENSOR_FLAG_IN_USE ) { // if this sensor is not used by a result, ignore data
-
-        // put sensor data into the foreground queue
-        FgStatus = OSP_STATUS_QUEUE_FULL;                       // assume queue full
-        EnterCritical();                                        // no interrupts while we diddle the queues
-        if(_SensorFgDataQCnt < SENSOR_FG_DATA_Q_SIZE) {         // check for room in the foreground queue
-            _SensorFgDataQCnt++;                                //  if so, show one more in the queue
-            if(++_SensorFgDataNqPtr == SENSOR_FG_DATA_Q_SIZE) { //  bump the enqueue pointer and check for pointer wrap, rewind if so
-                _SensorFgDataNqPtr = 0;
-            }
-            FgStatus = OSP_STATUS_OK;                           // FG queue isn't full
-        }
-        _SensorFgDataQueue[_SensorFgDataNqPtr].Handle = sensorHandle;
-        memcpy(&_SensorFgDataQueue[_SensorFgDataNqPtr].Data, data, sizeof(TriAxisSensorRawData_t)); // put data in queue (room or not)
-
-        // put sensor data into the background queue
-        BgStatus = OSP_STATUS_QUEUE_FULL;                       //    assume queue full
-        if(_SensorBgDataQCnt < SENSOR_BG_DATA_Q_SIZE) {         // check for room in the background queue
-            _SensorBgDataQCnt++;                                //  if so, show one more in the queue
-            if(++_SensorBgDataNqPtr == SENSOR_BG_DATA_Q_SIZE) { //  bump the enqueue pointer and check for pointer wrap, rewind if so
-                _SensorBgDataNqPtr = 0;
-            }
-            BgStatus = OSP_STATUS_OK;                           //    FG queue isn't full
-        }
-        _SensorBgDataQueue[_SensorBgDataNqPtr].Handle = sensorHandle;
-        memcpy(&_SensorBgDataQueue[_SensorBgDataNqPtr].Data, data, sizeof(TriAxisSensorRawData_t)); // put data in queue (room or not)
-        ExitCritical();
+        // put sensor data into the queue shared by foreground and background processing
+        pCtx->EnterCritical();                                  // no interrupts while we diddle the queue
+        status = EnQueueSensorData(pCtx, sensorHandle, data);
+        pCtx->ExitCritical();
     }
 
-    if((FgStatus == OSP_STATUS_QUEUE_FULL) || (BgStatus == OSP_STATUS_QUEUE_FULL))
-        return OSP_STATUS_QUEUE_FULL;
-    else
-        return OSP_STATUS_OK;
+    return status;
+}
+
+
+/****************************************************************************************************
+ * @fn      OSP_SetDataBatch
+ *          Queues a burst of sensor data (e.g. read from a sensor's hardware FIFO) which will be
+ *          processed by OSP_DoForegroundProcessing() and OSP_DoBackgroundProcessing(). The handle is
+ *          validated once and the burst queued under a single critical section. Samples that do not
+ *          fit without overrunning either consumer are not accepted; nothing queued is overwritten.
+ *          On a partial accept the caller still owns samples[accepted..count-1]: it can resubmit
+ *          them after the next OSP_DoForegroundProcessing()/OSP_DoBackgroundProcessing() call has
+ *          drained the queue, or drop them. A burst larger than SENSOR_DATA_Q_SIZE is never
+ *          accepted whole.
+ *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
+ * @param   sensorHandle INPUT requires a valid handle as returned by OSP_RegisterInputSensor()
+ * @param   samples INPUT array of timestamped raw sensor data, oldest first
+ * @param   count INPUT number of samples in the array
+ *
+ * @return  number of samples accepted (leading part of the array), or status as specified in
+ *          OSP_Types.h if the call is invalid
+ *
+ ***************************************************************************************************/
+int32_t OSP_SetDataBatch(OSP_Context_t *pCtx, InputSensorHandle_t sensorHandle, TriAxisSensorRawData_t samples[],
+    uint16_t count)
+{
+    uint16_t accepted;
+
+    if (samples == NULL)                                        // just in case
+        return OSP_STATUS_NULL_POINTER;
+    if(sensorHandle == NULL)                                    // just in case
+        return OSP_STATUS_INVALID_HANDLE;
+    if(FindSensorTableIndexByHandle(pCtx, sensorHandle) == ERROR)
+        return OSP_STATUS_INVALID_HANDLE;
+
+    if( !(((_SenDesc_t *)sensorHandle)->Flags & SENSOR_FLAG_IN_USE) ) // if this sensor is not used by a result, ignore data
+        return count;
+
+    pCtx->EnterCritical();                                      // no interrupts while we diddle the queue
+    accepted = EnQueueSensorDataBurst(pCtx, sensorHandle, samples, count);
+    pCtx->ExitCritical();
+
+    return accepted;
 }
 
 
@@ -1085,198 +1824,44 @@ osp_status_t OSP_SetData(InputSensorHandle_t sensorHandle, TriAxisSensorRawData_
  * @fn      OSP_DoForegroundProcessing
  *          Triggers computation for primary algorithms  e.g ROTATION_VECTOR
  *
- * @param   none
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
  *
  * @return  status as specified in OSP_Types.h
  *
  ***************************************************************************************************/
-osp_status_t OSP_DoForegroundProcessing(void)
+osp_status_t OSP_DoForegroundProcessing(OSP_Context_t *pCtx)
 {
     _SensorDataBuffer_t data;
     Common_3AxisResult_t AndoidProcessedData;
-    AndroidUnCalResult_t AndoidUncalProcessedData;
-    int16_t index;
-    Common_3AxisResult_t algConvention;
+    SensorType_t type;
+    osp_status_t status;
 
     // Get next sensor data packet from the queue. If nothing in the queue, return OSP_STATUS_IDLE.
     // If we get a data packet that has a sensor handle of NULL, we should drop it and get the next one,
     // a NULL handle is an indicator that the data is from a sensor that has been replaced or that the data is stale.
-
-    EnterCritical();                                        // no interrupts while we diddle the queue
-
-    // ignore any data marked as stale.
-    while( (_SensorFgDataQueue[_SensorFgDataDqPtr].Handle == NULL) && (_SensorFgDataQCnt != 0) ) {
-        _SensorFgDataQCnt--;                                // stale data, show one less in the queue
-        if(++_SensorFgDataDqPtr == SENSOR_FG_DATA_Q_SIZE)   //  and check for pointer wrap, rewind if so
-            _SensorFgDataDqPtr = 0;
-    }
-
-    // now see if there is any data to process.
-    if(_SensorFgDataQCnt == 0) {                            // check for queue empty
-        ExitCritical();
+    if(DeQueueSensorData(pCtx, &pCtx->SensorFgDataCursor, &data) == ERROR)
         return OSP_STATUS_IDLE;                 // nothing left in the queue, let the caller know that
-    }
-
-    // There is at least 1 data packet in the queue, get it.
-    memcpy(&data, &_SensorFgDataQueue[_SensorFgDataDqPtr], sizeof(_SensorDataBuffer_t)); // remove data from queue
-    _SensorFgDataQCnt--;                                // show one less in the queue
-    if(++_SensorFgDataDqPtr == SENSOR_FG_DATA_Q_SIZE)   //  and check for pointer wrap, rewind if so
-        _SensorFgDataDqPtr = 0;
-    ExitCritical();
 
     // now send the processed data to the appropriate entry points in the alg code.
-    switch( ((_SenDesc_t*)data.Handle)->pSenDesc->SensorType ) {
-
-    case SENSOR_ACCELEROMETER_UNCALIBRATED:
+    type = ((_SenDesc_t*)data.Handle)->pSenDesc->SensorType;
+    status = CheckForegroundData(&data);
+    if(status == OSP_STATUS_OK) {
         // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
-        if (((_SenDesc_t*)data.Handle)->pSenDesc->DataConvention == DATA_CONVENTION_RAW) {
-            ConvertSensorData(
-                &data,
-                &AndoidProcessedData,
-                QFIXEDPOINTPRECISE,
-                &_sensorLastForegroundTimeStamp,
-                &_sensorLastForegroundTimeStampExtension);
-        } else {
-            //!TODO - Other data conventions support not implemented yet
-            return OSP_STATUS_NOT_IMPLEMENTED;
-        }
-
-        // Do uncalibrated accel call back here (Android conventions)
-        if (_SubscribedResults & (1LL << SENSOR_ACCELEROMETER_UNCALIBRATED)) {
-            index = FindResultTableIndexByType(SENSOR_ACCELEROMETER_UNCALIBRATED);
-            if (index != ERROR) {
-                if (_ResultTable[index].pResDesc->DataConvention == DATA_CONVENTION_ANDROID) {
-                        memcpy(&AndoidUncalProcessedData.ucAccel.X,
-                            AndoidProcessedData.data.preciseData,
-                            (sizeof(NTPRECISE)*3));
-                        memcpy(&AndoidUncalProcessedData.ucAccel.X_offset,
-                            _accel_bias, (sizeof(NTPRECISE)*3));
-                        AndoidUncalProcessedData.ucAccel.TimeStamp = AndoidProcessedData.TimeStamp;
-
-                        _ResultTable[index].pResDesc->pOutputReadyCallback(
-                            (OutputSensorHandle_t)&_ResultTable[index], &AndoidUncalProcessedData.ucAccel);
-                }
-            } else {
-                return OSP_STATUS_ERROR;
-            }
-        }
-
-        // convert to algorithm convention before feeding data to algorithms.
-        algConvention.accuracy = QFIXEDPOINTPRECISE;
-        algConvention.data.preciseData[0] = AndoidProcessedData.data.preciseData[1];  // x (ALG) =  Y (Android)
-        algConvention.data.preciseData[1] = -AndoidProcessedData.data.preciseData[0]; // y (ALG) = -X (Android)
-        algConvention.data.preciseData[2] = AndoidProcessedData.data.preciseData[2];  // z (ALG) =  Z (Android)
-        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
-
-        memcpy(&_LastAccelCookedData, &algConvention, sizeof(Common_3AxisResult_t));
-
-        //OSP_SetForegroundAccelerometerMeasurement(algConvention.TimeStamp, algConvention.data.preciseData);
-        // Send data on to algorithms
-        OSP_SetAccelerometerMeasurement(algConvention.TimeStamp, algConvention.data.preciseData);
-
-        // Do linear accel and gravity processing if needed
-        // ... TODO
-        break;
-
-    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
-        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
-        if (((_SenDesc_t*)data.Handle)->pSenDesc->DataConvention == DATA_CONVENTION_RAW) {
-            ConvertSensorData(
-                &data,
-                &AndoidProcessedData,
-                QFIXEDPOINTEXTENDED,
-                &_sensorLastForegroundTimeStamp,
-                &_sensorLastForegroundTimeStampExtension);
-        } else {
-            //!TODO - Other data conventions support not implemented yet
-            return OSP_STATUS_NOT_IMPLEMENTED;
-        }
-
-        // Do uncalibrated mag call back here (Android conventions)
-        if (_SubscribedResults & (1LL << SENSOR_MAGNETIC_FIELD_UNCALIBRATED)) {
-            index = FindResultTableIndexByType(SENSOR_MAGNETIC_FIELD_UNCALIBRATED);
-            if (index != ERROR) {
-                if (_ResultTable[index].pResDesc->DataConvention == DATA_CONVENTION_ANDROID) {
-                        memcpy(&AndoidUncalProcessedData.ucMag.X,
-                            AndoidProcessedData.data.extendedData,
-                            (sizeof(NTEXTENDED)*3));
-                        memcpy(&AndoidUncalProcessedData.ucMag.X_hardIron_offset,
-                            _mag_bias, (sizeof(NTEXTENDED)*3));
-                        AndoidUncalProcessedData.ucMag.TimeStamp = AndoidProcessedData.TimeStamp;
-
-                        _ResultTable[index].pResDesc->pOutputReadyCallback(
-                            (OutputSensorHandle_t)&_ResultTable[index], &AndoidUncalProcessedData.ucMag);
-                } else {
-                    return OSP_STATUS_ERROR;
-                }
-            }
-        }
-
-        // convert to algorithm convention before feeding data to algs.
-        algConvention.accuracy = QFIXEDPOINTEXTENDED;
-        algConvention.data.extendedData[0] = AndoidProcessedData.data.extendedData[1];  // x (ALG) =  Y (Android)
-        algConvention.data.extendedData[1] = -AndoidProcessedData.data.extendedData[0]; // y (ALG) = -X (Android)
-        algConvention.data.extendedData[2] = AndoidProcessedData.data.extendedData[2];  // z (ALG) =  Z (Android)
-        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
-
-        memcpy(&_LastMagCookedData, &algConvention, sizeof(Common_3AxisResult_t));
-
-        //OSP_SetForegroundMagnetometerMeasurement(AndoidProcessedData.TimeStamp, algConvention.data.extendedData);
-        break;
-
-    case SENSOR_GYROSCOPE_UNCALIBRATED:
-        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
-        if (((_SenDesc_t*)data.Handle)->pSenDesc->DataConvention == DATA_CONVENTION_RAW) {
-            ConvertSensorData(
-                &data,
-                &AndoidProcessedData,
-                QFIXEDPOINTPRECISE,
-                &_sensorLastForegroundTimeStamp,
-                &_sensorLastForegroundTimeStampExtension);
-        } else {
-            //!TODO - Other data conventions support not implemented yet
-            return OSP_STATUS_NOT_IMPLEMENTED;
-        }
-
-        // Do uncalibrated mag call back here (Android conventions)
-        if (_SubscribedResults & (1LL << SENSOR_GYROSCOPE_UNCALIBRATED)) {
-            index = FindResultTableIndexByType(SENSOR_GYROSCOPE_UNCALIBRATED);
-            if (index != ERROR) {
-                if (_ResultTable[index].pResDesc->DataConvention == DATA_CONVENTION_ANDROID) {
-                        memcpy(&AndoidUncalProcessedData.ucGyro.X,
-                            AndoidProcessedData.data.preciseData,
-                            (sizeof(NTPRECISE)*3));
-                        memcpy(&AndoidUncalProcessedData.ucGyro.X_drift_offset,
-                            _gyro_bias, (sizeof(NTPRECISE)*3));
-                        AndoidUncalProcessedData.ucGyro.TimeStamp = AndoidProcessedData.TimeStamp;
-
-                        _ResultTable[index].pResDesc->pOutputReadyCallback(
-                            (OutputSensorHandle_t)&_ResultTable[index], &AndoidUncalProcessedData.ucGyro);
-                } else {
-                    return OSP_STATUS_ERROR;
-                }
-            }
-        }
-
-        // convert to algorithm convention before feeding data to algs.
-        algConvention.accuracy = QFIXEDPOINTPRECISE;
-        algConvention.data.preciseData[0] = AndoidProcessedData.data.preciseData[1];  // x (ALG) =  Y (Android)
-        algConvention.data.preciseData[1] = -AndoidProcessedData.data.preciseData[0]; // y (ALG) = -X (Android)
-        algConvention.data.preciseData[2] = AndoidProcessedData.data.preciseData[2];  // z (ALG) =  Z (Android)
-        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
-
-        memcpy(&_LastGyroCookedData, &algConvention, sizeof(Common_3AxisResult_t));
-
-        //OSP_SetForegroundGyroscopeMeasurement(AndoidProcessedData.TimeStamp, algConvention.data.preciseData);
-        break;
-
-    default:
-        break;
+        if(ConvertSensorData(
+            pCtx,
+            &data,
+            &AndoidProcessedData,
+            &pCtx->LastForegroundTimeStamp,
+            &pCtx->LastForegroundTimeStampExtension,
+            &pCtx->ForegroundTimeExtender) == NO_ERROR)
+            status = DispatchForegroundData(pCtx, type, &AndoidProcessedData);
     }
+    if(status < OSP_STATUS_OK)
+        return status;
 
     // all done for now, return OSP_STATUS_IDLE if no more data in the queue, else return OSP_STATUS_OK
 
-    if(_SensorFgDataQCnt == 0)
+    if(pCtx->SensorFgDataCursor.QCnt == 0)
         return OSP_STATUS_IDLE;                 // nothing left in the queue, let the caller know that
     else
         return OSP_STATUS_OK;                   // more to process
@@ -1284,130 +1869,169 @@ osp_status_t OSP_DoForegroundProcessing(void)
 
 
 /****************************************************************************************************
- * @fn      OSP_DoBackgroundProcessing
- *          Triggers computation for less time critical background algorithms, e.g. sensor calibration
+ * @fn      OSP_DoForegroundProcessingBudget
+ *          Same as OSP_DoForegroundProcessing() but drains the queue in batches taken under a single
+ *          critical section. Time stamps are extended in queue order, then the batch is converted
+ *          one sensor at a time with the block conversion kernel and handed to the algorithms, so
+ *          the conversion plan is resolved once per sensor. Stops after maxSamples or once
+ *          maxCycles (DWT cycle counter) have elapsed; the cycle budget is checked between batches
+ *          and is not enforced on cores without a cycle counter.
  *
- * @param   none
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
+ * @param   maxSamples INPUT maximum number of data packets to process
+ * @param   maxCycles INPUT CPU cycle budget for this call, 0 for no limit
  *
- * @return  status as specified in OSP_Types.h
+ * @return  number of data packets left in the queue (0 when idle), or status as specified in
+ *          OSP_Types.h on error
  *
  ***************************************************************************************************/
-osp_status_t OSP_DoBackgroundProcessing(void)
+int32_t OSP_DoForegroundProcessingBudget(OSP_Context_t *pCtx, uint16_t maxSamples, uint32_t maxCycles)
 {
-    _SensorDataBuffer_t data;
-    Common_3AxisResult_t AndoidProcessedData;
-    //Common_3AxisResult_t algConvention;
-
-    // Get next sensor data packet from the queue. If nothing in the queue, return OSP_STATUS_IDLE.
-    // If we get a data packet that has a sensor handle of NULL, we should drop it and get the next one,
-    // a NULL handle is an indicator that the data is from a sensor that has been replaced and that the data is stale.
-
-    EnterCritical();                                        // no interrupts while we diddle the queue
-
-    // ignore any data marked as stale.
-    while( (_SensorBgDataQueue[_SensorBgDataDqPtr].Handle == NULL) && (_SensorBgDataQCnt != 0) ) {
-        _SensorBgDataQCnt--;                                // stale data, show one less in the queue
-        if(++_SensorBgDataDqPtr == SENSOR_BG_DATA_Q_SIZE)   //  and check for pointer wrap, rewind if so
-            _SensorBgDataDqPtr = 0;
-    }
-
-    // now see if there is any data to process.
-    if(_SensorBgDataQCnt == 0) {                // check for queue empty
-        ExitCritical();
-        return OSP_STATUS_IDLE;                 // nothing left in the queue, let the caller know that
-    }
-
-    // There is at least 1 data packet in the queue, get it.
-    memcpy(&data, &_SensorBgDataQueue[_SensorBgDataDqPtr], sizeof(_SensorDataBuffer_t)); // remove data from queue
-    _SensorBgDataQCnt--;                                // show one less in the queue
-    if(++_SensorBgDataDqPtr == SENSOR_BG_DATA_Q_SIZE)   //  and check for pointer wrap, rewind if so
-        _SensorBgDataDqPtr = 0;
-
-    ExitCritical();
-
-    // now send the processed data to the appropriate entry points in the alg calibration code.
-    switch( ((_SenDesc_t*)data.Handle)->pSenDesc->SensorType ) {
+    _SensorDataBuffer_t batch[FG_BATCH_SIZE];
+    NTTIME timeStamp[FG_BATCH_SIZE];
+    osp_status_t pending[FG_BATCH_SIZE];
+    const TriAxisSensorRawData_t *pRunRaw[FG_BATCH_SIZE];
+    Common_3AxisResult_t AndoidProcessedData[FG_BATCH_SIZE];
+    const _SenDesc_t *pSensor;
+    osp_status_t status = OSP_STATUS_OK;
+    osp_status_t dispatchStatus;
+    uint32_t startCycles = GET_CYCLE_COUNT();
+    uint16_t processed = 0;
+    uint16_t count, runCount, i, j;
+    InputSensorHandle_t handle;
+
+    while(processed < maxSamples) {
+        count = maxSamples - processed;
+        if(count > FG_BATCH_SIZE)
+            count = FG_BATCH_SIZE;
+        count = DeQueueSensorDataBatch(pCtx, &pCtx->SensorFgDataCursor, batch, count);
+        if(count == 0)
+            break;                              // nothing left in the queue
+        processed += count;
+
+        // time stamps must be extended in queue order, do them before regrouping the batch
+        for(i = 0; i < count; i++) {
+            pending[i] = CheckForegroundData(&batch[i]);
+            if(pending[i] == OSP_STATUS_OK)
+                ExtendSensorTimeStamp(pCtx, batch[i].Data.TimeStamp, &timeStamp[i],
+                    &pCtx->LastForegroundTimeStamp, &pCtx->LastForegroundTimeStampExtension,
+                    &pCtx->ForegroundTimeExtender);
+            else if((pending[i] < OSP_STATUS_OK) && (status == OSP_STATUS_OK))
+                status = pending[i];
+        }
 
-    case SENSOR_ACCELEROMETER_UNCALIBRATED:
-        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
-        ConvertSensorData(
-            &data,
-            &AndoidProcessedData,
-            QFIXEDPOINTPRECISE,
-            &_sensorLastBackgroundTimeStamp,
-            &_sensorLastBackgroundTimeStampExtension);
+        // convert and feed the algorithms one sensor at a time, keeping queue order within each sensor
+        for(i = 0; i < count; i++) {
+            if(pending[i] != OSP_STATUS_OK)
+                continue;                       // already dispatched or nothing to dispatch
+            handle = batch[i].Handle;
+            for(j = i, runCount = 0; j < count; j++) {
+                if((pending[j] != OSP_STATUS_OK) || (batch[j].Handle != handle))
+                    continue;
+                pRunRaw[runCount] = &batch[j].Data;
+                AndoidProcessedData[runCount++].TimeStamp = timeStamp[j];
+                pending[j] = OSP_STATUS_IDLE;   // done with this one
+            }
 
-#if 0 //Nothing to be done for background processing at this time!
-        // convert to algorithm convention.
-        algConvention.accuracy = QFIXEDPOINTPRECISE;
-        algConvention.data.preciseData[0] = AndoidProcessedData.data.preciseData[1];  // x (ALG) =  Y (Android)
-        algConvention.data.preciseData[1] = -AndoidProcessedData.data.preciseData[0]; // y (ALG) = -X (Android)
-        algConvention.data.preciseData[2] = AndoidProcessedData.data.preciseData[2];  // z (ALG) =  Z (Android)
-        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
+            pSensor = (const _SenDesc_t *)handle;
+            if(!(pSensor->Flags & SENSOR_FLAG_HAVE_CONV_PLAN))
+                continue;
+            ConvertSensorDataBlock(&pSensor->ConvPlan, pRunRaw, AndoidProcessedData, runCount);
 
-        //OSP_SetBackgroundAccelerometerMeasurement(algConvention.TimeStamp, algConvention.data.preciseData);
-#endif
-        break;
+            for(j = 0; j < runCount; j++) {
+                dispatchStatus = DispatchForegroundData(pCtx, pSensor->pSenDesc->SensorType, &AndoidProcessedData[j]);
+                if((dispatchStatus < OSP_STATUS_OK) && (status == OSP_STATUS_OK))
+                    status = dispatchStatus;
+            }
+        }
 
-    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
-        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
-        ConvertSensorData(
-            &data,
-            &AndoidProcessedData,
-            QFIXEDPOINTEXTENDED,
-            &_sensorLastBackgroundTimeStamp,
-            &_sensorLastBackgroundTimeStampExtension);
+        if(status != OSP_STATUS_OK)
+            return status;
 
-#if 0 //Nothing to be done for background processing at this time!
-        // convert to algorithm convention.
-        algConvention.accuracy = QFIXEDPOINTEXTENDED;
-        algConvention.data.extendedData[0] = AndoidProcessedData.data.extendedData[1];   // x (ALG) =  Y (Android)
-        algConvention.data.extendedData[1] = -AndoidProcessedData.data.extendedData[0];  // y (ALG) = -X (Android)
-        algConvention.data.extendedData[2] = AndoidProcessedData.data.extendedData[2];   // z (ALG) =  Z (Android)
-        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
+        if((maxCycles != 0) && ((uint32_t)(GET_CYCLE_COUNT() - startCycles) >= maxCycles))
+            break;                              // out of time, let the caller yield
+    }
 
-        //OSP_SetBackgroundMagnetometerMeasurement(algConvention.TimeStamp, algConvention.data.extendedData);
-#endif
-        break;
+    return pCtx->SensorFgDataCursor.QCnt;
+}
 
-    case SENSOR_GYROSCOPE_UNCALIBRATED:
-        // Now we have a copy of the data to be processed. We need to apply any and all input conversions.
-        ConvertSensorData(
-            &data,
-            &AndoidProcessedData,
-            QFIXEDPOINTPRECISE,
-            &_sensorLastBackgroundTimeStamp,
-            &_sensorLastBackgroundTimeStampExtension);
 
-#if 0 //Nothing to be done for background processing at this time!
-        // convert to algorithm convention.
-        algConvention.accuracy = QFIXEDPOINTPRECISE;
-        algConvention.data.preciseData[0] = AndoidProcessedData.data.preciseData[1];  // x (ALG) =  Y (Android)
-        algConvention.data.preciseData[1] = -AndoidProcessedData.data.preciseData[0]; // y (ALG) = -X (Android)
-        algConvention.data.preciseData[2] = AndoidProcessedData.data.preciseData[2];  // z (ALG) =  Z (Android)
-        algConvention.TimeStamp = AndoidProcessedData.TimeStamp;
+/****************************************************************************************************
+ * @fn      OSP_DoBackgroundProcessing
+ *          Triggers computation for less time critical background algorithms, e.g. sensor calibration
+ *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
+ *
+ * @return  status as specified in OSP_Types.h
+ *
+ ***************************************************************************************************/
+osp_status_t OSP_DoBackgroundProcessing(OSP_Context_t *pCtx)
+{
+    _SensorDataBuffer_t data;
 
-        //OSP_SetBackgroundGyroscopeMeasurement(algConvention.TimeStamp, algConvention.data.preciseData);
-#endif
-        break;
+    // Get next sensor data packet from the queue. If nothing in the queue, return OSP_STATUS_IDLE.
+    // If we get a data packet that has a sensor handle of NULL, we should drop it and get the next one,
+    // a NULL handle is an indicator that the data is from a sensor that has been replaced and that the data is stale.
+    if(DeQueueSensorData(pCtx, &pCtx->SensorBgDataCursor, &data) == ERROR)
+        return OSP_STATUS_IDLE;                 // nothing left in the queue, let the caller know that
 
-    default:
-        break;
-    }
+    ProcessBackgroundData(pCtx, &data);
 
     // all done for now, return OSP_STATUS_IDLE if no more data in the queue, else return OSP_STATUS_OK
-    if(_SensorBgDataQCnt == 0)
+    if(pCtx->SensorBgDataCursor.QCnt == 0)
         return OSP_STATUS_IDLE;                 // nothing left in the queue, let the caller know that
     else
         return OSP_STATUS_OK;                   // more to process
 }
 
 
+/****************************************************************************************************
+ * @fn      OSP_DoBackgroundProcessingBudget
+ *          Same as OSP_DoBackgroundProcessing() but drains the queue in batches taken under a single
+ *          critical section. Stops after maxSamples or once maxCycles (DWT cycle counter) have
+ *          elapsed. Background work per data packet is constant, so on cores without a cycle counter
+ *          (Cortex-M0/M0+) maxSamples alone bounds the time taken.
+ *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
+ * @param   maxSamples INPUT maximum number of data packets to process
+ * @param   maxCycles INPUT CPU cycle budget for this call, 0 for no limit
+ *
+ * @return  number of data packets left in the queue (0 when idle)
+ *
+ ***************************************************************************************************/
+int32_t OSP_DoBackgroundProcessingBudget(OSP_Context_t *pCtx, uint16_t maxSamples, uint32_t maxCycles)
+{
+    _SensorDataBuffer_t batch[BG_BATCH_SIZE];
+    uint32_t startCycles = GET_CYCLE_COUNT();
+    uint16_t processed = 0;
+    uint16_t count, i;
+
+    while(processed < maxSamples) {
+        count = maxSamples - processed;
+        if(count > BG_BATCH_SIZE)
+            count = BG_BATCH_SIZE;
+        count = DeQueueSensorDataBatch(pCtx, &pCtx->SensorBgDataCursor, batch, count);
+        if(count == 0)
+            break;                              // nothing left in the queue
+        processed += count;
+
+        for(i = 0; i < count; i++)
+            ProcessBackgroundData(pCtx, &batch[i]);
+
+        if((maxCycles != 0) && ((uint32_t)(GET_CYCLE_COUNT() - startCycles) >= maxCycles))
+            break;                              // out of time, let the caller yield
+    }
+
+    return pCtx->SensorBgDataCursor.QCnt;
+}
+
+
 /****************************************************************************************************
  * @fn      OSP_SubscribeOutputSensor
  *          Call for each Open-Sensor-Platform result (STEP_COUNT, ROTATION_VECTOR, etc) you want
  *          computed and output
  *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
  * @param   pSensorDescriptor INPUT pointer to data which describes the details of how the fusion
  *          should be computed: e.g output rate, sensors to use, etc.
  * @param   pOutputHandle OUTPUT a handle to be used for OSP_UnsubscribeOutputSensor()
@@ -1416,16 +2040,17 @@ osp_status_t OSP_DoBackgroundProcessing(void)
  *          available or licensed
  *
  ***************************************************************************************************/
-osp_status_t OSP_SubscribeOutputSensor(SensorDescriptor_t *pSensorDescriptor,
+osp_status_t OSP_SubscribeOutputSensor(OSP_Context_t *pCtx, SensorDescriptor_t *pSensorDescriptor,
     OutputSensorHandle_t *pOutputHandle)
 {
     int16_t index;
+    osp_bool_t directOutput;
 
     if((pSensorDescriptor == NULL) || (pOutputHandle == NULL) ||
         (pSensorDescriptor->pOutputReadyCallback == NULL)) // just in case
         return OSP_STATUS_NULL_POINTER;
 
-    if(FindResultTableIndexByType(pSensorDescriptor->SensorType) != ERROR) { // is this result type already subscribed?
+    if(FindResultTableIndexByType(pCtx, pSensorDescriptor->SensorType) != ERROR) { // is this result type already subscribed?
         *pOutputHandle = NULL;
         return OSP_STATUS_ALREADY_SUBSCRIBED;
     }
@@ -1435,9 +2060,25 @@ osp_status_t OSP_SubscribeOutputSensor(SensorDescriptor_t *pSensorDescriptor,
     if(ValidateResultDescriptor(pSensorDescriptor) == ERROR)
         return OSP_STATUS_DESCRIPTOR_INVALID;
 
+    // uncalibrated results are output straight from the input sensor data (of the same type),
+    // in Android conventions only
+    switch (pSensorDescriptor->SensorType) {
+    case SENSOR_ACCELEROMETER_UNCALIBRATED:
+    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
+    case SENSOR_GYROSCOPE_UNCALIBRATED:
+        if(pSensorDescriptor->DataConvention != DATA_CONVENTION_ANDROID)
+            return OSP_STATUS_UNSUPPORTED_FEATURE;
+        directOutput = TRUE;
+        break;
+
+    default:
+        directOutput = FALSE;
+        break;
+    }
+
     // Check for room in the result table, if no room, return OSP_STATUS_NO_MORE_HANDLES
 
-    index = FindEmptyResultTableIndex();
+    index = FindEmptyResultTableIndex(pCtx);
     if(index == ERROR) {                                    // if no room in the result table, return the error
         *pOutputHandle = NULL;                              //  and set the handle to NULL, so we can check for it later
         return OSP_STATUS_NO_MORE_HANDLES;
@@ -1446,7 +2087,7 @@ osp_status_t OSP_SubscribeOutputSensor(SensorDescriptor_t *pSensorDescriptor,
     // check to be sure that we have all sensors registered that we need for this result. If so, mark them as "in use".
     // if not, return OSP_STATUS_NOT_REGISTERED, and set the result handle to NULL.
 
-    if(ActivateResultSensors(pSensorDescriptor->SensorType) == ERROR) {
+    if(ActivateResultSensors(pCtx, pSensorDescriptor->SensorType) == ERROR) {
         *pOutputHandle = NULL;                              //  and set the handle to NULL, so we can check for it later
         return OSP_STATUS_NOT_REGISTERED;
     }
@@ -1455,31 +2096,31 @@ osp_status_t OSP_SubscribeOutputSensor(SensorDescriptor_t *pSensorDescriptor,
     switch (pSensorDescriptor->SensorType) {
 
     case SENSOR_ACCELEROMETER_UNCALIBRATED:
-        _SubscribedResults |= (1LL << SENSOR_ACCELEROMETER_UNCALIBRATED);
+        pCtx->SubscribedResults |= (1LL << SENSOR_ACCELEROMETER_UNCALIBRATED);
         //Note: Calibrated or uncalibrated result is specified in the descriptor flags
         //For Uncalibrated result no callback needs to be registered with the algorithms
         break;
 
     case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
-        _SubscribedResults |= (1LL << SENSOR_MAGNETIC_FIELD_UNCALIBRATED);
+        pCtx->SubscribedResults |= (1LL << SENSOR_MAGNETIC_FIELD_UNCALIBRATED);
         //Note: Calibrated or uncalibrated result is specified in the descriptor flags
         //For Uncalibrated result no callback needs to be registered with the algorithms
         break;
 
     case SENSOR_GYROSCOPE_UNCALIBRATED:
-        _SubscribedResults |= (1LL << SENSOR_GYROSCOPE_UNCALIBRATED);
+        pCtx->SubscribedResults |= (1LL << SENSOR_GYROSCOPE_UNCALIBRATED);
         //Note: Calibrated or uncalibrated result is specified in the descriptor flags
         //For Uncalibrated result no callback needs to be registered with the algorithms
         break;
 
     case SENSOR_CONTEXT_DEVICE_MOTION:
-        _SubscribedResults |= (1LL << SENSOR_CONTEXT_DEVICE_MOTION);
-        OSP_RegisterSignificantMotionCallback(OnSignificantMotionResult);
+        pCtx->SubscribedResults |= (1LL << SENSOR_CONTEXT_DEVICE_MOTION);
+        OSP_RegisterSignificantMotionCallback(&pCtx->Alg, OnSignificantMotionResult);
         break;
 
     case SENSOR_STEP_COUNTER:
-        _SubscribedResults |= (1LL << SENSOR_STEP_COUNTER);
-        OSP_RegisterStepCallback(OnStepResultsReady);
+        pCtx->SubscribedResults |= (1LL << SENSOR_STEP_COUNTER);
+        OSP_RegisterStepCallback(&pCtx->Alg, OnStepResultsReady);
         break;
 
     default:
@@ -1488,9 +2129,11 @@ osp_status_t OSP_SubscribeOutputSensor(SensorDescriptor_t *pSensorDescriptor,
     }
 
     // Everything is setup, update our result table and return a handle
-    _ResultTable[index].pResDesc = pSensorDescriptor;
-    _ResultTable[index].Flags = 0;
-    *pOutputHandle = (OutputSensorHandle_t *)&_ResultTable[index];
+    pCtx->ResultTable[index].pResDesc = pSensorDescriptor;
+    pCtx->ResultTable[index].Flags = 0;
+    if(directOutput)
+        AddResultDispatch(pCtx, pSensorDescriptor->SensorType, &pCtx->ResultTable[index]);
+    *pOutputHandle = (OutputSensorHandle_t *)&pCtx->ResultTable[index];
 
     return OSP_STATUS_OK;
 }
@@ -1500,13 +2143,14 @@ osp_status_t OSP_SubscribeOutputSensor(SensorDescriptor_t *pSensorDescriptor,
  * @fn      OSP_UnsubscribeOutputSensor
  *          Stops the chain of computation for a registered result
  *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
  * @param   OutputHandle INPUT OutputSensorHandle_t that was received from
  *          OSP_SubscribeOutputSensor()
  *
  * @return  status as specified in OSP_Types.h.
  *
  ***************************************************************************************************/
-osp_status_t OSP_UnsubscribeOutputSensor(OutputSensorHandle_t OutputHandle)
+osp_status_t OSP_UnsubscribeOutputSensor(OSP_Context_t *pCtx, OutputSensorHandle_t OutputHandle)
 {
     int16_t index;
 
@@ -1514,37 +2158,37 @@ osp_status_t OSP_UnsubscribeOutputSensor(OutputSensorHandle_t OutputHandle)
     // Also check that the handle points to a currently subscribed result, if not return OSP_STATUS_NOT_SUBSCRIBED.
     if(OutputHandle == NULL)      // just in case
         return OSP_STATUS_INVALID_HANDLE;
-    index = FindResultTableIndexByHandle(OutputHandle);
-    if((index == ERROR) || (_ResultTable[index].pResDesc == NULL))  // test for active subscription for this handle
+    index = FindResultTableIndexByHandle(pCtx, OutputHandle);
+    if((index == ERROR) || (pCtx->ResultTable[index].pResDesc == NULL)) // test for active subscription for this handle
         return OSP_STATUS_NOT_SUBSCRIBED;
 
     // Check to see if any of the other results that are still subscribed needs to use the sensors
     // that we used. If not, mark those sensors as unused so that data from them will not be processed.
     // All data in the input queues from sensors that we mark as unused should be marked as stale. We
     // will also send a "sensor off" if that facility is available.
-    DeactivateResultSensors(_ResultTable[index].pResDesc->SensorType);
+    DeactivateResultSensors(pCtx, pCtx->ResultTable[index].pResDesc->SensorType);
 
     // Now make sure that we won't call the users callback for this result
-    switch (_ResultTable[index].pResDesc->SensorType) {
+    switch (pCtx->ResultTable[index].pResDesc->SensorType) {
 
     case SENSOR_ACCELEROMETER_UNCALIBRATED:
-        _SubscribedResults &= ~(1LL << SENSOR_ACCELEROMETER_UNCALIBRATED);
+        pCtx->SubscribedResults &= ~(1LL << SENSOR_ACCELEROMETER_UNCALIBRATED);
         break;
 
     case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
-        _SubscribedResults &= ~(1LL << SENSOR_MAGNETIC_FIELD_UNCALIBRATED);
+        pCtx->SubscribedResults &= ~(1LL << SENSOR_MAGNETIC_FIELD_UNCALIBRATED);
         break;
 
     case SENSOR_GYROSCOPE_UNCALIBRATED:
-        _SubscribedResults &= ~(1LL << SENSOR_GYROSCOPE_UNCALIBRATED);
+        pCtx->SubscribedResults &= ~(1LL << SENSOR_GYROSCOPE_UNCALIBRATED);
         break;
 
     case SENSOR_CONTEXT_DEVICE_MOTION:
-        _SubscribedResults &= ~(1LL << SENSOR_CONTEXT_DEVICE_MOTION);
+        pCtx->SubscribedResults &= ~(1LL << SENSOR_CONTEXT_DEVICE_MOTION);
         break;
 
     case SENSOR_STEP_COUNTER:
-        _SubscribedResults &= ~(1LL << SENSOR_STEP_COUNTER);
+        pCtx->SubscribedResults &= ~(1LL << SENSOR_STEP_COUNTER);
         break;
 
     default:
@@ -1553,8 +2197,9 @@ osp_status_t OSP_UnsubscribeOutputSensor(OutputSensorHandle_t OutputHandle)
     }
 
     // remove result table entry.
-    _ResultTable[index].pResDesc = NULL;
-    _ResultTable[index].Flags = 0;
+    RemoveResultDispatch(pCtx, &pCtx->ResultTable[index]);
+    pCtx->ResultTable[index].pResDesc = NULL;
+    pCtx->ResultTable[index].Flags = 0;
 
     return OSP_STATUS_OK;
 }
@@ -1580,25 +2225,489 @@ osp_status_t OSP_GetVersion(const OSP_Library_Version_t **pVersionStruct)
  * @fn      OSP_UpdateTime
  *          Used to update internal RTC extension counters
  *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
  * @param   rawCounts RTC counter value
  *
  * @return  status as specified in OSP_Types.h
  *
  ***************************************************************************************************/
-OSP_STATUS_t    OSP_UpdateTime( uint64_t rawCounts )
+OSP_STATUS_t    OSP_UpdateTime( OSP_Context_t *pCtx, uint64_t rawCounts )
+{
+    pCtx->EnterCritical();
+    pCtx->LastForegroundTimeStamp = (uint32_t)(rawCounts & 0xFFFFFFFF);
+    pCtx->LastForegroundTimeStampExtension = (uint32_t)(rawCounts >> 32);
+
+    pCtx->LastBackgroundTimeStamp = (uint32_t)(rawCounts & 0xFFFFFFFF);
+    pCtx->LastBackgroundTimeStampExtension = (uint32_t)(rawCounts >> 32);
+    pCtx->ExitCritical();
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      OSP_GetInputQueueOverruns
+ *          Returns the number of sensor data packets foreground and background processing each lost
+ *          because they fell a full input queue behind
+ *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
+ * @param   pFgOverruns OUTPUT data packets lost to foreground processing (may be NULL)
+ * @param   pBgOverruns OUTPUT data packets lost to background processing (may be NULL)
+ *
+ * @return  status as specified in OSP_Types.h
+ *
+ ***************************************************************************************************/
+osp_status_t OSP_GetInputQueueOverruns(OSP_Context_t *pCtx, uint32_t *pFgOverruns, uint32_t *pBgOverruns)
+{
+    pCtx->EnterCritical();
+    if(pFgOverruns != NULL)
+        *pFgOverruns = pCtx->SensorFgDataCursor.OverrunCnt;
+    if(pBgOverruns != NULL)
+        *pBgOverruns = pCtx->SensorBgDataCursor.OverrunCnt;
+    pCtx->ExitCritical();
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      OSP_GetLatestData
+ *          Returns the latest calibrated sample of a base sensor, in algorithm convention, as last
+ *          fed to the algorithms by foreground processing. Takes no critical section and needs no
+ *          result subscription, so it may be called from any task or from an interrupt handler.
+ *
+ * @param   pCtx INPUT library context set up by OSP_Initialize()
+ * @param   SensorType INPUT input sensor type: accelerometer, magnetometer or gyroscope
+ *          (uncalibrated)
+ * @param   pData OUTPUT latest sample
+ *
+ * @return  status as specified in OSP_Types.h. OSP_STATUS_IDLE if no sample was processed yet.
+ *
+ ***************************************************************************************************/
+osp_status_t OSP_GetLatestData(OSP_Context_t *pCtx, SensorType_t SensorType, Common_3AxisResult_t *pData)
 {
-    EnterCritical();
-    _sensorLastForegroundTimeStamp = (uint32_t)(rawCounts & 0xFFFFFFFF);
-    _sensorLastForegroundTimeStampExtension = (uint32_t)(rawCounts >> 32);
+    _LatestData_t *pLatest;
+    uint32_t seq;
+
+    if (pData == NULL)
+        return OSP_STATUS_NULL_POINTER;
+
+    switch (SensorType) {
+    case SENSOR_ACCELEROMETER_UNCALIBRATED:
+        pLatest = &pCtx->LastAccelCookedData;
+        break;
+    case SENSOR_MAGNETIC_FIELD_UNCALIBRATED:
+        pLatest = &pCtx->LastMagCookedData;
+        break;
+    case SENSOR_GYROSCOPE_UNCALIBRATED:
+        pLatest = &pCtx->LastGyroCookedData;
+        break;
+    default:
+        return OSP_STATUS_UNKNOWN_REQUEST;
+    }
 
-    _sensorLastBackgroundTimeStamp = (uint32_t)(rawCounts & 0xFFFFFFFF);
-    _sensorLastBackgroundTimeStampExtension = (uint32_t)(rawCounts >> 32);
-    ExitCritical();
+    // Buf[seq & 1] is only written again by sample seq+2, which first sets Started. If that
+    // happened while copying, take the then latest sample.
+    do {
+        seq = pLatest->Completed;
+        if (seq == 0)
+            return OSP_STATUS_IDLE;
+        MEMORY_BARRIER();
+        memcpy(pData, &pLatest->Buf[seq & 1], sizeof(Common_3AxisResult_t));
+        MEMORY_BARRIER();
+    } while ((uint32_t)(pLatest->Started - seq) > 1);
 
     return OSP_STATUS_OK;
 }
 
 
+#ifdef TEST_CONVERT
+/*
+ * Raw data conversion test: the portable and the M4 block kernels against the per-axis conversion
+ * they replaced, for every axis mapping and sign, for contiguous and odd data width masks and at
+ * the saturation limits; then cycles (target, DWT) or ns (host) per sample of each. Build this file
+ * with -DTEST_CONVERT, for the host or the Cortex-M4 target.
+ */
+#include <stdio.h>
+#if !defined(__CORTEX_M)
+# include <time.h>
+#endif
+
+#define TEST_BLOCK                      32
+#define TEST_RUNS                       1000
+#define TEST_NUM(a)                     (sizeof(a) / sizeof((a)[0]))
+
+static TriAxisSensorRawData_t TestRaw[TEST_BLOCK];
+static const TriAxisSensorRawData_t *TestRawPtr[TEST_BLOCK];
+static Common_3AxisResult_t TestRef[TEST_BLOCK], TestM4[TEST_BLOCK], TestOld[TEST_BLOCK];
+static uint32_t TestSeed = 12345;
+
+static uint32_t TestRand(void)
+{
+    TestSeed = TestSeed * 1664525UL + 1013904223UL;
+    return TestSeed;
+}
+
+static uint32_t TestNow(void)
+{
+#if defined(__CORTEX_M)
+    return GET_CYCLE_COUNT();
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000UL + ts.tv_nsec);
+#endif
+}
+
+/* Per-axis conversion as done before the block kernels, one sample */
+static void ConvertSensorDataOld(
+    InputSensorSpecificData_t *pInpSensData,
+    const TriAxisSensorRawData_t *pRaw,
+    Common_3AxisResult_t *pCookedData,
+    uint8_t accuracy)
+{
+    uint16_t i;
+    unsigned char negative;
+    unsigned char source;
+
+    pCookedData->accuracy = accuracy;
+    for (i = 0; i < 3; i++) {
+        negative = 0;
+        switch (pInpSensData->AxisMapping[i]) {
+        case AXIS_MAP_UNUSED:
+            pCookedData->data.preciseData[i] = 0;
+            continue;
+        case AXIS_MAP_NEGATIVE_X:
+            negative = 1;
+        case AXIS_MAP_POSITIVE_X:
+            source = 0;
+            break;
+        case AXIS_MAP_NEGATIVE_Y:
+            negative = 1;
+        case AXIS_MAP_POSITIVE_Y:
+            source = 1;
+            break;
+        case AXIS_MAP_NEGATIVE_Z:
+            negative = 1;
+        case AXIS_MAP_POSITIVE_Z:
+        default:
+            source = 2;
+            break;
+        }
+        pCookedData->data.preciseData[i] = ScaleSensorData(pRaw->Data[source],
+            pInpSensData->DataWidthMask,
+            pInpSensData->ConversionOffset[i],
+            pInpSensData->ConversionScale[i]);
+        if (negative)   // two's complement negate, as the old code compiled to
+            pCookedData->data.preciseData[i] = (int32_t)(0U - (uint32_t)pCookedData->data.preciseData[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t masks[] = { 0xFFFF, 0xFFF, 0xFFFFFF, 0xFFFFFFFF, 0xFFF0 };
+    static const uint8_t accuracies[] = { QFIXEDPOINTPRECISE, QFIXEDPOINTEXTENDED };
+    static const AxisMapType_t axes[] = { AXIS_MAP_UNUSED,
+        AXIS_MAP_POSITIVE_X, AXIS_MAP_NEGATIVE_X, AXIS_MAP_POSITIVE_Y,
+        AXIS_MAP_NEGATIVE_Y, AXIS_MAP_POSITIVE_Z, AXIS_MAP_NEGATIVE_Z };
+    InputSensorSpecificData_t sens;
+    _SensorConvPlan_t plan;
+    uint32_t m, a, x, y, z, n, i, k, run, t0;
+    uint32_t refT = 0, m4T = 0, oldT = 0;
+    uint32_t cases = 0, fail = 0, clamped = 0, satHigh = 0, satLow = 0;
+    int32_t want, top;
+
+    CYCLE_COUNTER_ENABLE();
+    memset(&sens, 0, sizeof(sens));
+    for (n = 0; n < TEST_BLOCK; n++)
+        TestRawPtr[n] = &TestRaw[n];
+
+    for (m = 0; m < TEST_NUM(masks); m++)
+    for (a = 0; a < TEST_NUM(accuracies); a++)
+    for (x = 0; x < TEST_NUM(axes); x++)
+    for (y = 0; y < TEST_NUM(axes); y++)
+    for (z = 0; z < TEST_NUM(axes); z++)
+    for (k = 0; k < 3; k++) {
+        sens.DataWidthMask = masks[m];
+        sens.AxisMapping[0] = axes[x];
+        sens.AxisMapping[1] = axes[y];
+        sens.AxisMapping[2] = axes[z];
+        for (i = 0; i < 3; i++) {
+            // k = 0 random, 1 full scale (saturates), 2 small offset and unit scale
+            sens.ConversionOffset[i] = (k == 2) ? (int32_t)(TestRand() % 64) - 32 : (int32_t)(TestRand() & masks[m] >> 4);
+            sens.ConversionScale[i] = (k == 1) ? ((i & 1) ? (int32_t)SATURATE_INT_MIN : (int32_t)SATURATE_INT_MAX) :
+                (k == 2) ? 1 : (int32_t)(TestRand() >> (TestRand() & 15));
+            if ((k == 0) && (TestRand() & 1))
+                sens.ConversionScale[i] = -sens.ConversionScale[i];
+        }
+
+        // raw words: range edges of the data width first, then random
+        top = (int32_t)(masks[m] >> 1);
+        for (n = 0; n < TEST_BLOCK; n++) {
+            for (i = 0; i < 3; i++) {
+                switch ((n + i) % 6) {
+                case 0:  TestRaw[n].Data[i] = top;           break;
+                case 1:  TestRaw[n].Data[i] = ~top;          break;
+                case 2:  TestRaw[n].Data[i] = 0;             break;
+                case 3:  TestRaw[n].Data[i] = -1;            break;
+                default: TestRaw[n].Data[i] = (int32_t)TestRand(); break;
+                }
+            }
+        }
+
+        if (BuildSensorConvPlan(&sens, accuracies[a], &plan) == ERROR) {
+            printf("FAIL plan mask %08lx\n", (unsigned long)masks[m]);
+            fail++;
+            continue;
+        }
+        ConvertSensorDataBlockRef(&plan, TestRawPtr, TestRef, TEST_BLOCK);
+        ConvertSensorDataBlock(&plan, TestRawPtr, TestM4, TEST_BLOCK);
+        for (n = 0; n < TEST_BLOCK; n++)
+            ConvertSensorDataOld(&sens, &TestRaw[n], &TestOld[n], accuracies[a]);
+
+        for (n = 0; n < TEST_BLOCK; n++) {
+            for (i = 0; i < 3; i++) {
+                want = TestOld[n].data.preciseData[i];
+                // negated saturated minimum used to wrap, it now clamps
+                if ((want == (int32_t)SATURATE_INT_MIN) && (sens.AxisMapping[i] != AXIS_MAP_UNUSED) &&
+                    ((sens.AxisMapping[i] - AXIS_MAP_POSITIVE_X) & 1)) {
+                    want = (int32_t)SATURATE_INT_MAX;
+                    clamped++;
+                }
+                if (want == (int32_t)SATURATE_INT_MAX)
+                    satHigh++;
+                if (want == (int32_t)SATURATE_INT_MIN)
+                    satLow++;
+                if ((TestRef[n].data.preciseData[i] != want) || (TestM4[n].data.preciseData[i] != want) ||
+                    (TestRef[n].accuracy != accuracies[a]) || (TestM4[n].accuracy != accuracies[a])) {
+                    if (fail++ < 10)
+                        printf("FAIL mask %08lx map %d %d %d axis %lu raw %ld: ref %ld m4 %ld old %ld\n",
+                            (unsigned long)masks[m], sens.AxisMapping[0], sens.AxisMapping[1],
+                            sens.AxisMapping[2], (unsigned long)i, (long)TestRaw[n].Data[plan.Source[i] < 0 ? 0 : plan.Source[i]],
+                            (long)TestRef[n].data.preciseData[i], (long)TestM4[n].data.preciseData[i],
+                            (long)TestOld[n].data.preciseData[i]);
+                }
+            }
+        }
+        cases++;
+    }
+    printf("%lu cases x %d samples, %lu saturated high, %lu low, %lu negated minimum clamped, %lu failed\n",
+        (unsigned long)cases, TEST_BLOCK, (unsigned long)satHigh, (unsigned long)satLow,
+        (unsigned long)clamped, (unsigned long)fail);
+
+    // 16-bit accelerometer, swapped and inverted axes
+    sens.DataWidthMask = 0xFFFF;
+    sens.AxisMapping[0] = AXIS_MAP_NEGATIVE_Y;
+    sens.AxisMapping[1] = AXIS_MAP_POSITIVE_X;
+    sens.AxisMapping[2] = AXIS_MAP_NEGATIVE_Z;
+    for (i = 0; i < 3; i++) {
+        sens.ConversionOffset[i] = 0;
+        sens.ConversionScale[i] = 0x9CE;    // about 9.81 / 4096 in Q24
+    }
+    BuildSensorConvPlan(&sens, QFIXEDPOINTPRECISE, &plan);
+    for (n = 0; n < TEST_BLOCK; n++)
+        for (i = 0; i < 3; i++)
+            TestRaw[n].Data[i] = (int16_t)TestRand();
+
+    for (run = 0; run < TEST_RUNS; run++) {
+        t0 = TestNow();
+        ConvertSensorDataBlockRef(&plan, TestRawPtr, TestRef, TEST_BLOCK);
+        refT += TestNow() - t0;
+        t0 = TestNow();
+        ConvertSensorDataBlock(&plan, TestRawPtr, TestM4, TEST_BLOCK);
+        m4T += TestNow() - t0;
+        t0 = TestNow();
+        for (n = 0; n < TEST_BLOCK; n++)
+            ConvertSensorDataOld(&sens, &TestRaw[n], &TestOld[n], QFIXEDPOINTPRECISE);
+        oldT += TestNow() - t0;
+    }
+#if defined(__CORTEX_M)
+# define TEST_UNIT                      "cycles"
+#else
+# define TEST_UNIT                      "ns"
+#endif
+    printf("%s per sample: per-axis %.1f, ref %.1f, m4 %.1f\n", TEST_UNIT,
+        (float)oldT / (TEST_RUNS * TEST_BLOCK), (float)refT / (TEST_RUNS * TEST_BLOCK),
+        (float)m4T / (TEST_RUNS * TEST_BLOCK));
+
+    return fail != 0;
+}
+#endif
+
+
+#ifdef TEST_TIMECONV
+/*
+ * Time stamp conversion test: the 128-bit (where the compiler has it), UMULL and 32-bit multiply
+ * paths and the incremental conversion of a _TimeExtender_t against the full conversion done
+ * before them, over counter low word wraps, 2^32 steps, counters moving back, factor changes and
+ * saturation. Build this file with -DTEST_TIMECONV.
+ */
+#include <stdio.h>
+
+static uint32_t TestSeed = 4321;
+
+static uint32_t TestRand(void)
+{
+    TestSeed = TestSeed * 1664525UL + 1013904223UL;
+    return TestSeed;
+}
+
+/* Time conversion as done before the incremental conversion, always a full multiply */
+static osp_bool_t GetTimeFromCounterOld(
+    NTTIME * pTime,
+    TIMECOEFFICIENT counterToTimeConversionFactor,
+    uint32_t counterHigh,
+    uint32_t counterLow)
+{
+    NTTIME ret = 0;
+    uint32_t high1,low1;
+    uint32_t high2,low2;
+    const uint32_t roundfactor = (1 << (Q32DIFF-1)) ;
+    if (counterToTimeConversionFactor & 0x80000000) {
+        counterToTimeConversionFactor = ~counterToTimeConversionFactor + 1;
+    }
+
+    UMul32(counterToTimeConversionFactor, counterLow, &high1, &low1);
+    UMul32(counterToTimeConversionFactor, counterHigh, &high2, &low2);
+
+    low2 += high1;
+    if (low2 < high1) {
+        high2++;
+    }
+
+    //round things
+    low1 += roundfactor;
+
+    //check overflow
+    if (low1 < roundfactor) {
+        low2++;
+        if (low2 ==0) {
+            high2++;
+        }
+    }
+
+    //right shift by Q32DIFF to make this into a Q24 number from a Q32 number
+    low1 >>= Q32DIFF;
+    low1 |= (low2 << (32 -  Q32DIFF) );
+    low2 >>= Q32DIFF;
+    low2 |= (high2 << (32 -  Q32DIFF) );
+    high2 >>= Q32DIFF;
+
+    if (high2 || low2 & 0x80000000) {
+        //saturation!!!!!
+        *pTime = 0x7FFFFFFFFFFFFFFFLL;
+        return FALSE;
+    }
+
+    ret = low2;
+    ret <<= 32;
+    ret |= low1;
+
+    *pTime = ret;
+
+    return TRUE;
+}
+
+static uint32_t TestFail;
+
+/* One conversion through the extender, checked against the full conversion */
+static void TestConvert(_TimeExtender_t *pExtender, TIMECOEFFICIENT factor, uint64_t counter)
+{
+    NTTIME time, want;
+    osp_bool_t ok, wantOk;
+
+    wantOk = GetTimeFromCounterOld(&want, factor, (uint32_t)(counter >> 32), (uint32_t)counter);
+    ok = GetTimeFromCounter(pExtender, &time, factor, (uint32_t)(counter >> 32), (uint32_t)counter);
+    if ((ok != wantOk) || (time != want)) {
+        if (TestFail++ < 10)
+            printf("FAIL factor %08lx counter %08lx%08lx: %d %016llx, want %d %016llx\n",
+                (unsigned long)factor, (unsigned long)(counter >> 32), (unsigned long)counter,
+                ok, (unsigned long long)time, wantOk, (unsigned long long)want);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const TIMECOEFFICIENT factors[] = {
+        0x00418937,     // 1 us counter, U32Q32 seconds
+        0x10C6F7A1,     // 16 MHz / 256 prescaled
+        0x00000001, 0x7FFFFFFF, 0x80000000, 0x80000001, 0xFFFFFFFF
+    };
+    static const uint64_t steps[] = {
+        1, 0xFFFF, 0xFFFFFFFFULL, 0x100000000ULL, 0x100000001ULL, 0x123456789ULL
+    };
+    _TimeExtender_t ext;
+    TIMECOEFFICIENT factor;
+    uint64_t counter, hi[3];
+    uint32_t lo[3], f, i, n, mulCases = 0, mulFail = 0, convCases = 0;
+
+    // multiply paths, random and edge operands
+    for (n = 0; n < 1000000; n++) {
+        factor = (n < 8) ? ((n & 1) ? 0xFFFFFFFF : 0) : TestRand();
+        counter = (n < 8) ? ((n & 2) ? ~0ULL : 0) | ((n & 4) ? 1 : 0) :
+            ((uint64_t)TestRand() << 32 | TestRand()) >> (TestRand() & 63);
+#if defined(TIME_MUL_INT128)
+        MulTimeCounterInt128(factor, (uint32_t)(counter >> 32), (uint32_t)counter, &hi[0], &lo[0]);
+#else
+        MulTimeCounter32(factor, (uint32_t)(counter >> 32), (uint32_t)counter, &hi[0], &lo[0]);
+#endif
+        MulTimeCounterLong(factor, (uint32_t)(counter >> 32), (uint32_t)counter, &hi[1], &lo[1]);
+        MulTimeCounter32(factor, (uint32_t)(counter >> 32), (uint32_t)counter, &hi[2], &lo[2]);
+        if ((hi[0] != hi[1]) || (hi[0] != hi[2]) || (lo[0] != lo[1]) || (lo[0] != lo[2])) {
+            if (mulFail++ < 10)
+                printf("FAIL multiply %08lx x %016llx\n", (unsigned long)factor, (unsigned long long)counter);
+        }
+        mulCases++;
+    }
+
+    // incremental conversion; one extender throughout so that factor changes are exercised
+    memset(&ext, 0, sizeof(ext));
+    for (f = 0; f < sizeof(factors) / sizeof(factors[0]); f++) {
+        // counter low word wraps, fixed and random steps
+        counter = 0xFFFFFF00ULL - 1000;
+        for (n = 0; n < 100000; n++) {
+            TestConvert(&ext, factors[f], counter);
+            counter += (n < 2000) ? 1 : (TestRand() >> (TestRand() & 31));
+            convCases++;
+        }
+        for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+            for (n = 0; n < 1000; n++) {
+                TestConvert(&ext, factors[f], counter);
+                counter += steps[i];
+                convCases++;
+            }
+        }
+
+        // counter moving back
+        for (n = 0; n < 1000; n++) {
+            TestConvert(&ext, factors[f], counter);
+            counter -= TestRand() & 0xFFFF;
+            convCases++;
+        }
+
+        // up to and past saturation
+        counter = (~0ULL / ((factors[f] & 0x80000000) ? (~factors[f] + 1) : factors[f] | 1)) << 7;
+        for (n = 0; n < 1000; n++) {
+            TestConvert(&ext, factors[f], counter - 500 * 0x10000ULL + n * 0x10000ULL);
+            convCases++;
+        }
+
+        // factor changes back and forth at the same counter
+        for (n = 0; n < 1000; n++) {
+            counter = 0x100000000ULL * (n & 7) + TestRand();
+            TestConvert(&ext, factors[(f + n) % (sizeof(factors) / sizeof(factors[0]))], counter);
+            TestConvert(&ext, factors[f], counter + (n & 0xFF));
+            convCases += 2;
+        }
+    }
+
+    printf("%lu multiplies, %lu failed; %lu conversions, %lu failed\n", (unsigned long)mulCases,
+        (unsigned long)mulFail, (unsigned long)convCases, (unsigned long)TestFail);
+    return (mulFail != 0) || (TestFail != 0);
+}
+#endif
+
 /*-------------------------------------------------------------------------------------------------*\
  |    E N D   O F   F I L E
 \*-------------------------------------------------------------------------------------------------*/
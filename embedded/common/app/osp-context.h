@@ -0,0 +1,166 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if !defined (OSP_CONTEXT_H)
+#define   OSP_CONTEXT_H
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#ifndef OSP_CONTEXT_API
+#define OSP_CONTEXT_API
+#endif
+#include "osp-api.h"
+#include "osp_embeddedalgcalls.h"
+#include "gyrobiasestimator.h"
+#include "magcalibrator.h"
+
+/*
+ * All state of the library lives in an OSP_Context_t. The caller owns the storage (static, stack or
+ * heap) and passes it to every OSP_xxx() call; OSP_Initialize() sets it up. Independent contexts
+ * may be driven from different threads at the same time, each context on its own is not thread
+ * safe beyond what its EnterCritical/ExitCritical callbacks provide.
+ *
+ * The members are private to osp-api.c and are only visible here so that the context can be
+ * allocated by the caller.
+ */
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+#define MAX_SENSOR_DESCRIPTORS          8
+#define MAX_RESULT_DESCRIPTORS          5
+
+/* Shared sensor data queue. Targets that hand whole hardware FIFO bursts (16-32 samples) to
+ * OSP_SetDataBatch() raise it from the build. */
+#ifndef SENSOR_DATA_Q_SIZE
+#define SENSOR_DATA_Q_SIZE              8
+#endif
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    T Y P E   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+/* Raw to fixed point conversion of an input sensor, resolved from its descriptor */
+typedef struct {
+    int8_t Source[3];               // raw data word feeding each (Android) axis, -1 if axis unused
+    uint8_t Negate[3];              // axis is inverted
+    int32_t Offset[3];              // offset applied to the raw data
+    int32_t Scale[3];               // NTPRECISE or NTEXTENDED scale factor, per accuracy
+    uint32_t Mask;                  // data width mask
+    int8_t SignShift;               // shift that masks & sign extends, -1 if the mask is not contiguous
+    uint8_t Accuracy;               // QFIXEDPOINTPRECISE or QFIXEDPOINTEXTENDED
+} _SensorConvPlan_t;
+
+/* Local structure for keeping tab on active sensors and results */
+typedef struct {
+    SensorDescriptor_t *pSenDesc;
+    uint16_t Flags;                 // in-use, etc
+    _SensorConvPlan_t ConvPlan;     // raw data conversion, built on registration
+} _SenDesc_t;
+
+typedef struct {
+    SensorDescriptor_t *pResDesc;
+    uint16_t Flags;                 // Paused, etc
+} _ResDesc_t;
+
+/* Results output directly from each sample of an input sensor, indexed by input sensor type */
+typedef struct {
+    uint16_t Count;                 // number of subscribed results below
+    _ResDesc_t *pResult[MAX_RESULT_DESCRIPTORS];    // result table entries to call back, in subscription order
+} _ResultDispatch_t;
+
+/* Read cursor of a consumer (foreground/background processing) of the shared sensor data queue */
+typedef struct {
+    uint16_t DqPtr;                 // where to remove next data packet from the queue
+    int16_t QCnt;                   // number of data packets in the queue not yet seen by this consumer
+    uint32_t OverrunCnt;            // data packets this consumer lost because it fell a full queue behind
+} _SensorDataCursor_t;
+
+/* Latest sample of a base sensor for polling. The writer fills the buffer the previous sample is
+ * not in, so a reader needs neither a critical section nor to wait for the writer; it only retries
+ * if two further samples were written while it was copying (see OSP_GetLatestData()). */
+typedef struct {
+    volatile uint32_t Started;      // number of samples whose write has begun
+    volatile uint32_t Completed;    // number of samples written, the last one is in Buf[Completed & 1]
+    Common_3AxisResult_t Buf[2];
+} _LatestData_t;
+
+/* Last counter to time conversion of a consumer, for incremental time stamp conversion */
+typedef struct {
+    uint64_t Counter;               // last converted (extended) counter
+    uint64_t ProdHigh;              // Counter x Factor, bits 32..95
+    uint32_t ProdLow;               // Counter x Factor, bits 0..31
+    TIMECOEFFICIENT Factor;         // conversion factor the product was computed with
+    osp_bool_t Valid;               // product is valid
+} _TimeExtender_t;
+
+/* One instance of the library, OSP_Context_t (osp-api.h) */
+struct _OSP_Context {
+    uint64_t SubscribedResults;     // bit field of currently subscribed results, bit positions
+                                    // same as SensorType_t
+    SystemDescriptor_t const *pPlatformDesc;    // pointer to platform descriptor structure
+
+    // callbacks for entering/exiting a critical section of code (i.e. disable/enable task switch)
+    OSP_CriticalSectionCallback_t EnterCritical;
+    OSP_CriticalSectionCallback_t ExitCritical;
+
+    // pointers to sensor data structures, and local flags
+    _SenDesc_t SensorTable[MAX_SENSOR_DESCRIPTORS];
+
+    // pointers to result data structures, and local flags
+    _ResDesc_t ResultTable[MAX_RESULT_DESCRIPTORS];
+
+    // per input sensor type list of results to call back with each sample, maintained on (un)subscribe
+    _ResultDispatch_t ResultDispatch[SENSOR_ENUM_COUNT];
+
+    // Raw sensor data queue shared by foreground and background processing. Each has its own read
+    // cursor; a slot is reused once both cursors have passed it. Handles and data are kept in
+    // separate arrays so that a burst of samples is copied in contiguously.
+    InputSensorHandle_t SensorDataQHandle[SENSOR_DATA_Q_SIZE];
+    TriAxisSensorRawData_t SensorDataQueue[SENSOR_DATA_Q_SIZE];
+    uint16_t SensorDataNqPtr;                   // where the last data packet was put into the queue
+    _SensorDataCursor_t SensorFgDataCursor;     // foreground processing read cursor
+    _SensorDataCursor_t SensorBgDataCursor;     // background processing read cursor
+
+    uint32_t LastForegroundTimeStamp;           // keep the last time stamp here, we will use it to check for rollover
+    uint32_t LastForegroundTimeStampExtension;  // we will re-create a larger raw time stamp here
+
+    uint32_t LastBackgroundTimeStamp;           // keep the last time stamp here, we will use it to check for rollover
+    uint32_t LastBackgroundTimeStampExtension;  // we will re-create a larger raw time stamp here
+
+    _TimeExtender_t ForegroundTimeExtender;     // last foreground counter to time conversion
+    _TimeExtender_t BackgroundTimeExtender;     // last background counter to time conversion
+
+    NTPRECISE AccelBias[3];         // bias in sensor ticks
+    NTPRECISE GyroBias[3];          // estimated bias, Android convention, updated by background processing
+    NTEXTENDED MagBias[3];          // hard iron offset, Android convention, updated by background processing
+
+    // copy of last data that was sent to the alg. We will
+    // use this for when the user _polls_ for calibrated sensor data.
+    _LatestData_t LastAccelCookedData;
+    _LatestData_t LastMagCookedData;
+    _LatestData_t LastGyroCookedData;
+
+    OSP_AlgContext_t Alg;           // embedded algorithms state
+    GyroBiasEstimator_t GyroBiasEst;    // background gyro bias estimator
+    MagCalibrator_t MagCal;             // background magnetometer calibration
+};
+
+#endif /* OSP_CONTEXT_H */
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
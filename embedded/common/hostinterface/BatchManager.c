@@ -38,8 +38,9 @@
 
 #define MAX_NUMBER_SENSORS                          NUM_SENSOR_TYPE
 
-/* On Change non wakeup sensors are stored locally, it can store up to this define */
-#define NUM_ONCHANGE_NONWAKEUP_SENSOR               (10)
+/* Latest sample of On Change sensors is stored locally, it can store up to this define */
+#define NUM_ONCHANGE_SENSOR                         (16)
+#define INVALID_ONCHANGE_SLOT                       (0xFF)
 
 #define DEFAULT_REPORT_LATENCY                      (-1)
 #define MAX_SAMPLING_FREQ_HZ                        (1100)      /* 110 % of 1KHZ */
@@ -49,6 +50,15 @@
 
 #define DEFAULT_HIGH_THRESHOLD                      (1)
 
+/* Max. report latency (in RTC ticks) used as deadline offset; keeps wrapping deadline compare valid */
+#define MAX_DEADLINE_OFFSET                         (0x3FFFFFFFUL)
+
+/* Host interrupt moderation */
+#define DEFAULT_INT_MODERATION                      BATCH_INT_MODERATION_ADAPTIVE
+#define RTC_TICKS_PER_MIN                           ( ( 60ULL * TIME_1SEC_NS_UNIT ) / RTC_TICK_NS_INT )
+#define SERVICE_LATENCY_DECAY_SHIFT                 (4)     /* Latency estimate decays 1/16 per host service */
+#define SERVICE_LATENCY_HYSTERESIS_SHIFT            (3)     /* Thresholds are updated on 1/8 change of estimate */
+
 /* Queue Sizes Common Definitions */
 #define QUEUE_LOW_THR                               (0)
 #define QUEUE_HIGH_THR                              (1)
@@ -96,6 +106,7 @@ typedef enum _BatchSensorFIFOType
     WAKEUP_FIFO,
     NONWAKEUP_FIFO,
     NONWAKEUP_ONCHANGE_FIFO,
+    WAKEUP_ONCHANGE_FIFO,
     NUM_FIFO_TYPES,
 } BatchSensorFIFOType_t;
 
@@ -108,6 +119,9 @@ typedef struct _BatchSensorParam
     FifoQ_Type_t  QType;                      /* Sensor FIFO Type */
     uint32_t      SampleCnt;                  /* Sample count for sensor*/
     uint32_t      DecimationCnt;              /* Decimation count for sensor*/
+    uint32_t      DeadlineOffset;             /* Report Latency in RTC ticks, added to arrival time */
+    Queue_t       SubQ;                       /* Per-sensor sub-queue of the batching queue */
+    osp_bool_t    isSubQActive;               /* Sub-queue is on the batching queue's active list */
     osp_bool_t    isValidEntry;               /* Flag for Valid entry */
     osp_bool_t    isSensorEnabled;            /* Flag for Sensor Enable status */
 
@@ -116,9 +130,10 @@ typedef struct _BatchSensorParam
 /* Structure to hold Batch Queue parameters */
 typedef struct _BatchQParam
 {
-    Queue_t       *pQ;                        /* pointer to sensor queue */
-    uint64_t      MinReportLatency;           /* min. report latency from sensor list */
+    Queue_t       *pQ;                        /* pointer to aggregate sensor queue */
     uint8_t       NumBatchedSensor;           /* Number of sensor currently batched */
+    uint8_t       NumActiveSensor;            /* Number of sensors with (possibly) non-empty sub-queue */
+    uint8_t       ActiveSensor[MAX_NUMBER_SENSORS]; /* Sensors with (possibly) non-empty sub-queue */
 } BatchQParam_t;
 
 /* Structure to hold Batch Descriptor */
@@ -128,19 +143,21 @@ typedef struct _BatchDescriptor
     BatchQParam_t       BatchQ[NUM_BATCHING_QUEUES];        /* Batching Queues */
 } BatchDescriptor_t;
 
-/* Structures to hold On Change Sensor Sample */
+/* Structures to hold latest On Change Sensor Sample */
 typedef struct _BatchOnChangeSensor
 {
-    BufferHeader_t      Header;               /* Buffer header */
-    HostIFPackets_t     Sample;               /* HiF Packet */
-    ASensorType_t       SensorType;           /* Sensor Type of current HiF Packet */
+    BufferHeader_t      Header;               /* Buffer header; Deadline is that of the oldest unreported change */
+    HostIFPackets_t     Sample;               /* Latest accepted HiF Packet */
     osp_bool_t          ValidFlag;            /* HiF Packet is valid Flag */
+    osp_bool_t          isPending;            /* HiF Packet is not yet reported to host */
 } BatchOnChangeSensor_t;
 
-typedef struct _OnChangeSensorSample
+typedef struct _OnChangeSensorBuffer
 {
-    BatchOnChangeSensor_t   SensorList[NUM_ONCHANGE_NONWAKEUP_SENSOR];      /* On change sensor list */
-    osp_bool_t              Empty;                                          /* Buffer empty flag */
+    BatchOnChangeSensor_t   SensorList[NUM_ONCHANGE_SENSOR];                /* On change sensor samples */
+    uint8_t                 Slot[MAX_NUMBER_SENSORS];                       /* Sensor type to SensorList index */
+    uint8_t                 NumPending[NUM_BATCHING_QUEUES];                /* Number of unreported samples */
+    uint8_t                 PendingSensor[NUM_BATCHING_QUEUES][NUM_ONCHANGE_SENSOR]; /* Sensors with unreported sample */
 } OnChangeSensorBuffer_t;
 
 /* Structure to hold Sensor type, sampling rate and reporting period */
@@ -148,61 +165,77 @@ typedef struct _SensorTypeAndRateMap
 {
     BatchSensorFIFOType_t    FIFOType;              /* Sensor FIFO Type */
     uint64_t                 SamplingRate;          /* Sensor Sampling Rate */
+    uint32_t                 ChangeThreshold;       /* On Change sensors: min. change per element (payload LSB) to report */
 } SensorTypeAndRateMap_t;
 
 
 /*-------------------------------------------------------------------------------------------------*\
  |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
-/* Mapping table for Sensor type to get Sampling rate and FFIO Type */
+/* Mapping table for Sensor type to get Sampling rate and FFIO Type. On Change sensors report any change of
+ * value unless a change threshold (in payload LSB) is given; events must stay on the streaming FIFOs */
 static const SensorTypeAndRateMap_t SensorFifoTypeAndRateMap[MAX_NUMBER_SENSORS] =
 {
-    [SENSOR_META_DATA]                   = { NUM_FIFO_TYPES,          ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_ACCELEROMETER]               = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD       },
-    [SENSOR_GEOMAGNETIC_FIELD]           = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD       },
-    [SENSOR_ORIENTATION]                 = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD      },
-    [SENSOR_GYROSCOPE]                   = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD      },
-    [SENSOR_LIGHT]                       = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_PRESSURE]                    = { NONWAKEUP_FIFO,          PRES_ACTUAL_SAMPLE_PERIOD      },
-    [SENSOR_TEMPERATURE]                 = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_PROXIMITY]                   = { WAKEUP_FIFO,             ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_GRAVITY]                     = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD       },
-    [SENSOR_LINEAR_ACCELERATION]         = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD       },
-    [SENSOR_ROTATION_VECTOR]             = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD      },
-    [SENSOR_RELATIVE_HUMIDITY]           = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_AMBIENT_TEMPERATURE]         = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_MAGNETIC_FIELD_UNCALIBRATED] = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD       },
-    [SENSOR_GAME_ROTATION_VECTOR]        = { NONWAKEUP_FIFO,          GAME_ROTN_ACTUAL_SAMPLE_PERIOD },
-    [SENSOR_GYROSCOPE_UNCALIBRATED]      = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD      },
-    [SENSOR_SIGNIFICANT_MOTION]          = { WAKEUP_FIFO,             ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_STEP_DETECTOR]               = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_STEP_COUNTER]                = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD        },
-    [SENSOR_GEOMAGNETIC_ROTATION_VECTOR] = { NONWAKEUP_FIFO,          GEOMAG_ACTUAL_SAMPLE_PERIOD    },
+    [SENSOR_META_DATA]                   = { NUM_FIFO_TYPES,          ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_ACCELEROMETER]               = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD,       0 },
+    [SENSOR_GEOMAGNETIC_FIELD]           = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD,       0 },
+    [SENSOR_ORIENTATION]                 = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD,      0 },
+    [SENSOR_GYROSCOPE]                   = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD,      0 },
+    [SENSOR_LIGHT]                       = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_PRESSURE]                    = { NONWAKEUP_FIFO,          PRES_ACTUAL_SAMPLE_PERIOD,      0 },
+    [SENSOR_TEMPERATURE]                 = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_PROXIMITY]                   = { WAKEUP_ONCHANGE_FIFO,    ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_GRAVITY]                     = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD,       0 },
+    [SENSOR_LINEAR_ACCELERATION]         = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD,       0 },
+    [SENSOR_ROTATION_VECTOR]             = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD,      0 },
+    [SENSOR_RELATIVE_HUMIDITY]           = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_AMBIENT_TEMPERATURE]         = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_MAGNETIC_FIELD_UNCALIBRATED] = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD,       0 },
+    [SENSOR_GAME_ROTATION_VECTOR]        = { NONWAKEUP_FIFO,          GAME_ROTN_ACTUAL_SAMPLE_PERIOD, 0 },
+    [SENSOR_GYROSCOPE_UNCALIBRATED]      = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD,      0 },
+    [SENSOR_SIGNIFICANT_MOTION]          = { WAKEUP_FIFO,             ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_STEP_DETECTOR]               = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_STEP_COUNTER]                = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SENSOR_GEOMAGNETIC_ROTATION_VECTOR] = { NONWAKEUP_FIFO,          GEOMAG_ACTUAL_SAMPLE_PERIOD,    0 },
 
     /* Private Sensor Type */
-    [PSENSOR_ACCELEROMETER_RAW]          = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD       },
-    [PSENSOR_MAGNETIC_FIELD_RAW]         = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD       },
-    [PSENSOR_GYROSCOPE_RAW]              = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD      },
-    [PSENSOR_LIGHT_UV]                   = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_LIGHT_RGB]                  = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_STEP]                       = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_ACCELEROMETER_UNCALIBRATED] = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD       },
-    [PSENSOR_ORIENTATION]                = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD      },
-    [PSENSOR_CONTEXT_DEVICE_MOTION]      = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_CONTEXT_CARRY]              = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_CONTEXT_POSTURE]            = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_CONTEXT_TRANSPORT]          = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_GESTURE_EVENT]              = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_HEART_RATE]                 = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [SYSTEM_REAL_TIME_CLOCK]             = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD        },
-    [PSENSOR_MAGNETIC_FIELD_ANOMALY]     = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD       },
+    [PSENSOR_ACCELEROMETER_RAW]          = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD,       0 },
+    [PSENSOR_MAGNETIC_FIELD_RAW]         = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD,       0 },
+    [PSENSOR_GYROSCOPE_RAW]              = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD,      0 },
+    [PSENSOR_LIGHT_UV]                   = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_LIGHT_RGB]                  = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_STEP]                       = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_ACCELEROMETER_UNCALIBRATED] = { NONWAKEUP_FIFO,          ACC_ACTUAL_SAMPLE_PERIOD,       0 },
+    [PSENSOR_ORIENTATION]                = { NONWAKEUP_FIFO,          GYRO_ACTUAL_SAMPLE_PERIOD,      0 },
+    [PSENSOR_CONTEXT_DEVICE_MOTION]      = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_CONTEXT_CARRY]              = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_CONTEXT_POSTURE]            = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_CONTEXT_TRANSPORT]          = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_GESTURE_EVENT]              = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_HEART_RATE]                 = { NONWAKEUP_ONCHANGE_FIFO, ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [SYSTEM_REAL_TIME_CLOCK]             = { NONWAKEUP_FIFO,          ON_CHANGE_SAMPLE_PERIOD,        0 },
+    [PSENSOR_MAGNETIC_FIELD_ANOMALY]     = { NONWAKEUP_FIFO,          MAG_ACTUAL_SAMPLE_PERIOD,       0 },
 };
 
 static BatchDescriptor_t BatchDesc;
-static OnChangeSensorBuffer_t NwOnChangeSensorBuffer;   /* for Non-Wakeup-On-Change Sensors */
+static OnChangeSensorBuffer_t OnChangeSensorBuffer;     /* Latest value of On-Change Sensors */
 static osp_bool_t isBatchManagerInitialized = FALSE;
 static FifoQ_Type_t CurrQType = NUM_QUEUE_TYPE;
 
+/* Host interrupt moderation state */
+static BatchIntModeration_t IntModeration = DEFAULT_INT_MODERATION;
+static BatchIntStats_t IntStats;
+static osp_bool_t isHostIntAsserted   = FALSE;  /* Host interrupt line is asserted */
+static osp_bool_t isIntServicePending = FALSE;  /* Host has not dequeued since interrupt was asserted */
+static uint32_t IntAssertTime;                  /* RTC time host interrupt was asserted */
+static uint32_t WakeupWindowStart;              /* RTC time current wake-up counting minute started */
+static uint32_t WakeupWindowCount;              /* Wake-ups in current wake-up counting minute */
+static uint32_t AppliedServiceLatency;          /* Service latency the sub-queue thresholds account for */
+static volatile osp_bool_t isThresholdUpdatePending = FALSE;
+
+/* Host interface driver notified of FIFO flushes */
+static fpBatchFlushHook_t FlushHook = NULL;
+
 static Queue_t *_HiFNonWakeupQueue = NULL;
 static Queue_t *_HiFWakeUpQueue    = NULL;
 static Queue_t *_HiFControlQueue   = NULL;
@@ -219,12 +252,25 @@ DECLARE_BLOCK_POOL( SensorControlResponsePacketPool, HIF_PACKET_SIZE, HIF_CONTRO
 \*-------------------------------------------------------------------------------------------------*/
 static void QHighThresholdCallBack( FifoQ_Type_t QType );
 static void QEmptyCallBack( FifoQ_Type_t QType );
+static void HostIntAssert( void );
+static void UpdateWakeupWindow( uint32_t now );
+static void UpdateHostServiceLatency( void );
+static void UpdateHighThresholds( void );
+static void CheckDeadlineMiss( uint32_t sType, const BufferHeader_t *pHeader, const uint8_t *pPkt );
 static int16_t GetCurrentQType( FifoQ_Type_t *pQType );
-static uint32_t CalculateHighThreshold( BatchDescriptor_t *pBatchDesc, FifoQ_Type_t QType );
-static int16_t FindMinReportLatency( BatchDescriptor_t *pBatchDesc, FifoQ_Type_t QType );
+static uint32_t CalculateHighThreshold( BatchDescriptor_t *pBatchDesc, uint32_t sType );
 static int16_t QInitialize( void );
+static int16_t SensorSubQEnQueue( uint32_t sType, Buffer_t *pBuf );
+static int16_t DeQueueFirst( FifoQ_Type_t QType, osp_bool_t isByArrival, Buffer_t **pBuf, uint32_t *pSType );
+static int16_t DeQueueEarliestDeadline( FifoQ_Type_t QType, Buffer_t **pBuf, uint32_t *pSType );
+static int16_t DeQueueOldest( FifoQ_Type_t QType, Buffer_t **pBuf );
+static void AppendTxList( BatchTxList_t *pList, Buffer_t *pBuf );
+static osp_bool_t IsOnChangeSampleChanged( const uint8_t *pLastPkt, const uint8_t *pNewPkt, uint16_t packetSize,
+                                           uint32_t threshold );
 static int16_t EnqueueOnChangeSensorQ( HostIFPackets_t *pHiFDataPacket, uint16_t packetSize, uint32_t sensorType );
-static int16_t DequeueOnChangeSensorQ( Buffer_t **pBuf );
+static int16_t DequeueOnChangeSensorQ( FifoQ_Type_t QType, uint8_t *pBuf, uint32_t *pLength );
+static int16_t FlushOnChangeSensorQ( uint32_t sensorType );
+static int16_t DiscardPktsFromOnChangeSensorBuf( uint32_t sensorType );
 
 
 /*-------------------------------------------------------------------------------------------------*\
@@ -266,20 +312,20 @@ static void QHighThresholdCallBack( FifoQ_Type_t QType )
         {
             /* Set Host Interrupt to indicate we have data for the Host */
             QEmptyRegister &= ~(QUEUE_NONWAKEUP_EMPTY_BIT);
-            SensorHubAssertInt();
+            HostIntAssert();
         }
         break;
 
     case QUEUE_WAKEUP_TYPE:
         /* If CB is from Wakeup queue then assert host interrupt irrespective of Batch State */
         QEmptyRegister &= ~(QUEUE_WAKEUP_EMPTY_BIT);
-        SensorHubAssertInt();
+        HostIntAssert();
         break;
 
     case QUEUE_CONTROL_RESPONSE_TYPE:
         /* If CB is from Control Response queue then assert host interrupt irrespective of Batch State */
         QEmptyRegister &= ~(QUEUE_CONTROL_RESPONSE_EMPTY_BIT);
-        SensorHubAssertInt();
+        HostIntAssert();
         break;
 
     default:
@@ -303,12 +349,16 @@ static void QEmptyCallBack( FifoQ_Type_t QType )
     switch ( QType )
     {
     case QUEUE_WAKEUP_TYPE:
-        QEmptyRegister |= QUEUE_WAKEUP_EMPTY_BIT;
+        /* Before set empty flag check locally stored On change samples are all reported */
+        if ( OnChangeSensorBuffer.NumPending[QUEUE_WAKEUP_TYPE] == 0 )
+        {
+            QEmptyRegister |= QUEUE_WAKEUP_EMPTY_BIT;
+        }
         break;
 
     case QUEUE_NONWAKEUP_TYPE:
-        /* Before set Non wakeup empty flag check Locally stored NonWakeupOnchange queue empty */
-        if (NwOnChangeSensorBuffer.Empty)
+        /* Before set empty flag check locally stored On change samples are all reported */
+        if ( OnChangeSensorBuffer.NumPending[QUEUE_NONWAKEUP_TYPE] == 0 )
         {
             QEmptyRegister |= QUEUE_NONWAKEUP_EMPTY_BIT;
         }
@@ -325,11 +375,176 @@ static void QEmptyCallBack( FifoQ_Type_t QType )
     /* If all queues are empty deassert Host interrupt pin */
     if ( QEmptyRegister == QUEUE_ALL_EMPTY_MASK )
     {
+        isHostIntAsserted = FALSE;
         SensorHubDeAssertInt();
     }
 }
 
 
+/****************************************************************************************************
+ * @fn      HostIntAssert
+ *          Asserts the host interrupt. A wake-up is counted and its time noted for the host service
+ *          latency measurement when the interrupt was not already asserted.
+ *
+ * @param   none
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+static void HostIntAssert( void )
+{
+    uint32_t now;
+    SETUP_CRITICAL_SECTION();
+
+    ENTER_CRITICAL_SECTION();
+    if ( !isHostIntAsserted )
+    {
+        now = RTC_GetCounter();
+
+        isHostIntAsserted   = TRUE;
+        isIntServicePending = TRUE;
+        IntAssertTime       = now;
+
+        UpdateWakeupWindow( now );
+        WakeupWindowCount++;
+        IntStats.HostWakeups++;
+    }
+    EXIT_CRITICAL_SECTION();
+
+    SensorHubAssertInt();
+}
+
+
+/****************************************************************************************************
+ * @fn      UpdateWakeupWindow
+ *          Closes the wake-up counting minute if it has elapsed and latches its wake-up count
+ *
+ * @param   [IN] now - Current RTC time
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+static void UpdateWakeupWindow( uint32_t now )
+{
+    uint32_t elapsed = now - WakeupWindowStart;
+
+    if ( elapsed >= RTC_TICKS_PER_MIN )
+    {
+        /* No wake-up during the last full minute if more than one minute passed since window start */
+        IntStats.HostWakeupsPerMin = ( elapsed < ( 2 * RTC_TICKS_PER_MIN ) ) ? WakeupWindowCount : 0;
+        WakeupWindowStart = now;
+        WakeupWindowCount = 0;
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      UpdateHostServiceLatency
+ *          Measures the time from host interrupt assertion to the first dequeue by the host. The
+ *          estimate follows increases at once and decays slowly so that sporadic slow responses of the
+ *          host are still covered. A significant change requests threshold re-calculation, which is
+ *          done from task context.
+ *
+ * @param   none
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+static void UpdateHostServiceLatency( void )
+{
+    uint32_t latency;
+    uint32_t estimate;
+    uint32_t hysteresis;
+
+    if ( !isIntServicePending )
+    {
+        return;
+    }
+    isIntServicePending = FALSE;
+
+    latency  = RTC_GetCounter() - IntAssertTime;
+    estimate = IntStats.HostServiceLatency;
+    estimate -= estimate >> SERVICE_LATENCY_DECAY_SHIFT;
+
+    if ( latency > estimate )
+    {
+        estimate = latency;
+    }
+    IntStats.HostServiceLatency = estimate;
+
+    hysteresis = AppliedServiceLatency >> SERVICE_LATENCY_HYSTERESIS_SHIFT;
+
+    if ( ( IntModeration == BATCH_INT_MODERATION_ADAPTIVE ) &&
+         ( ( estimate > ( AppliedServiceLatency + hysteresis ) ) ||
+           ( estimate < ( AppliedServiceLatency - hysteresis ) ) ) )
+    {
+        isThresholdUpdatePending = TRUE;
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      UpdateHighThresholds
+ *          Re-calculates the high threshold of all enabled sensors' sub-queues with the current host
+ *          service latency estimate. Host is interrupted if a sub-queue is already beyond its new
+ *          threshold.
+ *
+ * @param   none
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+static void UpdateHighThresholds( void )
+{
+    uint8_t i;
+    int16_t errCode;
+    uint32_t highThreshold;
+
+    isThresholdUpdatePending = FALSE;
+    AppliedServiceLatency = ( IntModeration == BATCH_INT_MODERATION_ADAPTIVE ) ? IntStats.HostServiceLatency : 0;
+
+    for ( i = 0; i < MAX_NUMBER_SENSORS; i++ )
+    {
+        if ( !BatchDesc.SensorList[i].isSensorEnabled )
+        {
+            continue;
+        }
+
+        highThreshold = CalculateHighThreshold( &BatchDesc, i );
+        errCode = QueueHighThresholdSet( &BatchDesc.SensorList[i].SubQ, highThreshold );
+        ASF_assert( errCode == OSP_STATUS_OK );
+
+        if ( BatchDesc.SensorList[i].SubQ.Size >= highThreshold )
+        {
+            QHighThresholdCallBack( BatchDesc.SensorList[i].QType );
+        }
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      CheckDeadlineMiss
+ *          Counts a deadline miss if the packet being delivered to the host is past its deadline.
+ *          Packets of sensors without report latency and flush complete packets are due at once
+ *          and are not counted.
+ *
+ * @param   [IN] sType   - Sensor Type (base enum)
+ * @param   [IN] pHeader - Buffer header of the packet
+ * @param   [IN] pPkt    - HiF packet
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+static void CheckDeadlineMiss( uint32_t sType, const BufferHeader_t *pHeader, const uint8_t *pPkt )
+{
+    if ( ( BatchDesc.SensorList[sType].DeadlineOffset != 0 ) && ( GetSensorDataFlushStatus( pPkt ) == 0 ) &&
+         M_DeadlineBefore( pHeader->Deadline, RTC_GetCounter() ) )
+    {
+        IntStats.DeadlineMisses++;
+    }
+}
+
+
 /****************************************************************************************************
  * @fn      GetCurrentQType
  *          This is helper function for BatchManagerDeQueue, This function checks various queues
@@ -376,97 +591,236 @@ static int16_t GetCurrentQType( FifoQ_Type_t *pQType )
 
 /****************************************************************************************************
  * @fn      CalculateHighThreshold
- *          Calculate new value of high threshold for new sensor
+ *          Calculate the high threshold (interrupt point) of a sensor's sub-queue. It is the number of
+ *          samples the sensor produces within its report latency, so the host is interrupted when the
+ *          oldest sample of that sensor reaches its deadline. With adaptive moderation the host service
+ *          latency is taken off the report latency so that the host dequeues by the deadline.
  *
  * @param   [IN] pBatchDesc - pointer to batching descriptor structure
- * @param   [IN] QType      - Queue Type
+ * @param   [IN] sType      - Sensor Type (base enum)
  *
  * @return  Calculated high threshold value
  *
  ***************************************************************************************************/
-static uint32_t CalculateHighThreshold( BatchDescriptor_t *pBatchDesc, FifoQ_Type_t QType )
+static uint32_t CalculateHighThreshold( BatchDescriptor_t *pBatchDesc, uint32_t sType )
 {
-    uint8_t i;
-    uint32_t highThr = 0;
+    uint64_t highThr;
+    uint64_t reportLatency;
+    uint64_t serviceLatency;
     uint32_t highThrLimit;
-
-    /* Find min. Report latency before we calculate high threshold value */
-    FindMinReportLatency( pBatchDesc, QType );
+    BatchSensorParam_t *pSensor = &pBatchDesc->SensorList[sType];
 
     /* calculate threshold limit based on FIFO size and a tolerance % to account for Host Wake up time */
-    highThrLimit = ( pBatchDesc->BatchQ[QType].pQ->Capacity * HOST_WAKEUP_TOLERANCE_PERCENT ) / 100 ;
+    highThrLimit = ( pBatchDesc->BatchQ[pSensor->QType].pQ->Capacity * HOST_WAKEUP_TOLERANCE_PERCENT ) / 100 ;
 
-    /* If Min. Report Latency is 0 then Sensor Event should be send as soon as it occurs */
-    if ( ( pBatchDesc->BatchQ[QType].MinReportLatency == 0 ) ||
-         ( pBatchDesc->BatchQ[QType].MinReportLatency == (uint64_t)DEFAULT_REPORT_LATENCY ) )
+    /* If Report Latency is 0 then Sensor Event should be send as soon as it occurs */
+    if ( ( pSensor->ReportLatency == 0 ) ||
+         ( pSensor->ReportLatency == (uint64_t)DEFAULT_REPORT_LATENCY ) )
     {
-        highThr = DEFAULT_HIGH_THRESHOLD;
-        return highThr;
+        return DEFAULT_HIGH_THRESHOLD;
     }
 
-    /* Calculate High threshold value */
-    for ( i = 0; i < MAX_NUMBER_SENSORS; i++ )
+    /* On-Change sensors have no rate; they are reported with the rest of the batch */
+    /* TODO: ensure MRL for On-change sensors */
+    if ( pSensor->ActualSamplingPeriod == ON_CHANGE_SAMPLE_PERIOD )
     {
-        if ( pBatchDesc->SensorList[i].QType != QType )
-        {
-            continue; /* skip Sensors belonging to different Queue type */
-        }
+        return highThrLimit;
+    }
 
-        /* Check only registered sensors for threshold calculation. Also skip On-Change sensors in threshold calculation */
-        if ( ( pBatchDesc->SensorList[i].isSensorEnabled ) &&
-             ( pBatchDesc->SensorList[i].ActualSamplingPeriod != ON_CHANGE_SAMPLE_PERIOD ) )
-        {
-            /* Calculate high threshold value for one sensor entry and accumulate to previous value*/
-            highThr += ( ( pBatchDesc->BatchQ[QType].MinReportLatency) /
-                         ( pBatchDesc->SensorList[i].ActualSamplingPeriod * pBatchDesc->SensorList[i].DecimationCnt ) );
-            DPRINTF( "\r\n High Thrshld = %d\r\n",highThr );
-        }
+    /* Host needs the service latency to dequeue after it is interrupted */
+    reportLatency  = pSensor->ReportLatency;
+    serviceLatency = (uint64_t)AppliedServiceLatency * RTC_TICK_NS_INT;
+
+    if ( reportLatency <= serviceLatency )
+    {
+        return DEFAULT_HIGH_THRESHOLD;
     }
+    reportLatency -= serviceLatency;
 
-    /* If the calculated FIFO threshold based on MRL exceeds the FIFO capacity, report when the FIFO is full */
-    if ( highThr > highThrLimit ) {
+    /* Calculate High threshold value */
+    highThr = reportLatency / ( pSensor->ActualSamplingPeriod * pSensor->DecimationCnt );
+    DPRINTF( "\r\n High Thrshld[%d] = %d\r\n", sType, (uint32_t)highThr );
 
+    /* If the calculated FIFO threshold based on MRL exceeds the FIFO capacity, report when the FIFO is full */
+    if ( highThr > highThrLimit )
+    {
         highThr = highThrLimit;
     }
     else if ( highThr < DEFAULT_HIGH_THRESHOLD )
     {
-        /* If the registered sensors are all ON-CHANGE, the calculated threshold value will be 0 */
-        /* TODO: ensure MRL for On-change sensors */
         highThr = DEFAULT_HIGH_THRESHOLD;
     }
 
-    return highThr;
+    return (uint32_t)highThr;
 }
 
 
 /****************************************************************************************************
- * @fn      FindMinReportLatency
- *          Find Min. Report Latency for given Batching structure
+ * @fn      SensorSubQEnQueue
+ *          Enqueue a packet on the sensor's sub-queue and make sure the sub-queue is on the active
+ *          list of its batching queue so the deadline scheduler considers it.
  *
- * @param   [IN] pBatchDesc - Pointer of Batching Descriptor
- * @param   [IN] QType      - Sensor Queue Type
+ * @param   [IN] sType - Sensor Type (base enum)
+ * @param   [IN] pBuf  - Packet buffer with the Deadline set
  *
- * @return  OSP_STATUS_OK or error code
+ * @return  OSP_STATUS_OK or error code from EnQueue
  *
  ***************************************************************************************************/
-static int16_t FindMinReportLatency( BatchDescriptor_t *pBatchDesc, FifoQ_Type_t QType )
+static int16_t SensorSubQEnQueue( uint32_t sType, Buffer_t *pBuf )
 {
-    uint8_t i;
+    BatchSensorParam_t *pSensor = &BatchDesc.SensorList[sType];
+    BatchQParam_t *pBatchQ = &BatchDesc.BatchQ[pSensor->QType];
+    int16_t status;
+    SETUP_CRITICAL_SECTION();
 
-    /* Set min. Report latency to Max initially */
-    pBatchDesc->BatchQ[QType].MinReportLatency = (uint64_t)DEFAULT_REPORT_LATENCY;
+    /* The active list is shared with the dequeue in host interface ISR. The sub-queue goes on the
+     * list before the packet is enqueued, so a host read raised by the queue callbacks sees it.
+     * EnQueue runs outside the critical section so those callbacks run with interrupts enabled. */
+    ENTER_CRITICAL_SECTION();
+    if ( !pSensor->isSubQActive )
+    {
+        pBatchQ->ActiveSensor[pBatchQ->NumActiveSensor++] = (uint8_t)sType;
+        pSensor->isSubQActive = TRUE;
+    }
+    EXIT_CRITICAL_SECTION();
 
-    /* Search min.Report latency number from Batching Descriptor */
-    for ( i = 0; i < MAX_NUMBER_SENSORS; i++ )
+    status = EnQueue( &pSensor->SubQ, pBuf );
+
+    /* A dequeue in between may have found the sub-queue still empty and dropped it from the list */
+    ENTER_CRITICAL_SECTION();
+    if ( ( !pSensor->isSubQActive ) && ( pSensor->SubQ.pHead != NULL ) )
     {
-        if ( ( pBatchDesc->SensorList[i].QType == QType ) &&
-             ( pBatchDesc->SensorList[i].ReportLatency < pBatchDesc->BatchQ[QType].MinReportLatency ) )
+        pBatchQ->ActiveSensor[pBatchQ->NumActiveSensor++] = (uint8_t)sType;
+        pSensor->isSubQActive = TRUE;
+    }
+    EXIT_CRITICAL_SECTION();
+
+    return status;
+}
+
+
+/****************************************************************************************************
+ * @fn      DeQueueFirst
+ *          Dequeues the head buffer with the earliest deadline, or the earliest arrival, across the
+ *          sensor sub-queues of a batching queue. Each sub-queue is in arrival order so only the head
+ *          of each active sub-queue is compared. Drained sub-queues are removed from the active list.
+ *
+ * @param   [IN]  QType       - Batching queue type (Wakeup/NonWakeup)
+ * @param   [IN]  isByArrival - TRUE to order by arrival time instead of deadline
+ * @param   [OUT] pBuf        - Pointer that returns the dequeued buffer
+ * @param   [OUT] pSType      - Returns the Sensor Type (base enum) of the dequeued buffer, may be NULL
+ *
+ * @return  OSP_STATUS_OK or OSP_STATUS_QUEUE_EMPTY
+ *
+ ***************************************************************************************************/
+static int16_t DeQueueFirst( FifoQ_Type_t QType, osp_bool_t isByArrival, Buffer_t **pBuf, uint32_t *pSType )
+{
+    BatchQParam_t *pBatchQ = &BatchDesc.BatchQ[QType];
+    BatchSensorParam_t *pSensor;
+    Queue_t *pEdfQ = NULL;
+    uint8_t edfSType = 0;
+    uint8_t i = 0;
+    SETUP_CRITICAL_SECTION();
+
+    ENTER_CRITICAL_SECTION();
+    while ( i < pBatchQ->NumActiveSensor )
+    {
+        pSensor = &BatchDesc.SensorList[pBatchQ->ActiveSensor[i]];
+
+        if ( pSensor->SubQ.pHead == NULL )
+        {
+            /* Remove drained sub-queue; order of the active list is not significant */
+            pSensor->isSubQActive = FALSE;
+            pBatchQ->ActiveSensor[i] = pBatchQ->ActiveSensor[--pBatchQ->NumActiveSensor];
+            continue;
+        }
+
+        if ( ( pEdfQ == NULL ) ||
+             ( isByArrival ?
+               M_DeadlineBefore( pSensor->SubQ.pHead->Header.Arrival, pEdfQ->pHead->Header.Arrival ) :
+               M_DeadlineBefore( pSensor->SubQ.pHead->Header.Deadline, pEdfQ->pHead->Header.Deadline ) ) )
         {
-            pBatchDesc->BatchQ[QType].MinReportLatency = pBatchDesc->SensorList[i].ReportLatency;
+            pEdfQ = &pSensor->SubQ;
+            edfSType = pBatchQ->ActiveSensor[i];
         }
+        i++;
     }
+    EXIT_CRITICAL_SECTION();
 
-    return OSP_STATUS_OK;
+    if ( pEdfQ == NULL )
+    {
+        *pBuf = NULL;
+        return OSP_STATUS_QUEUE_EMPTY;
+    }
+
+    if ( pSType != NULL )
+    {
+        *pSType = edfSType;
+    }
+
+    return DeQueue( pEdfQ, pBuf );
+}
+
+
+/****************************************************************************************************
+ * @fn      DeQueueEarliestDeadline
+ *          Earliest-deadline-first dequeue across the sensor sub-queues of a batching queue
+ *
+ * @param   [IN]  QType  - Batching queue type (Wakeup/NonWakeup)
+ * @param   [OUT] pBuf   - Pointer that returns the dequeued buffer
+ * @param   [OUT] pSType - Returns the Sensor Type (base enum) of the dequeued buffer, may be NULL
+ *
+ * @return  OSP_STATUS_OK or OSP_STATUS_QUEUE_EMPTY
+ *
+ ***************************************************************************************************/
+static int16_t DeQueueEarliestDeadline( FifoQ_Type_t QType, Buffer_t **pBuf, uint32_t *pSType )
+{
+    return DeQueueFirst( QType, FALSE, pBuf, pSType );
+}
+
+
+/****************************************************************************************************
+ * @fn      DeQueueOldest
+ *          Dequeues the earliest arrived buffer across the sensor sub-queues of a batching queue
+ *
+ * @param   [IN]  QType  - Batching queue type (Wakeup/NonWakeup)
+ * @param   [OUT] pBuf   - Pointer that returns the dequeued buffer
+ *
+ * @return  OSP_STATUS_OK or OSP_STATUS_QUEUE_EMPTY
+ *
+ ***************************************************************************************************/
+static int16_t DeQueueOldest( FifoQ_Type_t QType, Buffer_t **pBuf )
+{
+    return DeQueueFirst( QType, TRUE, pBuf, NULL );
+}
+
+
+/****************************************************************************************************
+ * @fn      AppendTxList
+ *          Links a dequeued pool block at the end of a transmit list
+ *
+ * @param   [IN] pList - Transmit list
+ * @param   [IN] pBuf  - Dequeued pool block
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+static void AppendTxList( BatchTxList_t *pList, Buffer_t *pBuf )
+{
+    pBuf->Header.pNext = NULL;
+
+    if ( pList->pTail == NULL )
+    {
+        pList->pHead = pBuf;
+    }
+    else
+    {
+        pList->pTail->Header.pNext = (uint8_t *)pBuf;
+    }
+    pList->pTail = pBuf;
+
+    pList->NumPkts++;
+    pList->TotalLength += pBuf->Header.Length;
 }
 
 
@@ -532,130 +886,291 @@ static int16_t QInitialize( void )
                                      (void *) QUEUE_CONTROL_RESPONSE_TYPE );
     ASF_assert(errCode == OSP_STATUS_OK);
 
+    /* Aggregate queue threshold only guards capacity; latency is handled by per sensor sub-queues */
+    errCode = QueueHighThresholdSet( _HiFNonWakeupQueue,
+                                     ( HIF_NWKUP_SENSOR_DATA_QUEUE_SIZE * HOST_WAKEUP_TOLERANCE_PERCENT ) / 100 );
+    ASF_assert(errCode == OSP_STATUS_OK);
+
+    errCode = QueueHighThresholdSet( _HiFWakeUpQueue,
+                                     ( HIF_WKUP_SENSOR_DATA_QUEUE_SIZE * HOST_WAKEUP_TOLERANCE_PERCENT ) / 100 );
+    ASF_assert(errCode == OSP_STATUS_OK);
+
     return OSP_STATUS_OK;
 }
 
 
 /****************************************************************************************************
- * @fn      OnChnageSensorEnqueue
- *          Enqueue on change non wakeup sensors in locally Sample pool.
+ * @fn      IsOnChangeSampleChanged
+ *          Compares the payload of a new On Change sensor packet against the last accepted packet of
+ *          the same sensor. Time stamps are not compared. Payload elements are big endian signed values
+ *          of the size given in the packet attribute.
  *
- * @param   [IN] pHiFDataPacket - pointer of control response packet
- * @param   [IN] packetSize - Size of control response packet
- * @param   [IN] sensorType - Type of sensor
+ * @param   [IN] pLastPkt   - Last accepted HiF packet of the sensor
+ * @param   [IN] pNewPkt    - New HiF packet of the sensor
+ * @param   [IN] packetSize - Size of the new HiF packet
+ * @param   [IN] threshold  - Min. change of any element to report, 0 reports any change
  *
- * @return  OSP_STATUS_OK or error code
+ * @return  TRUE if the sample changed enough to be reported, FALSE otherwise
  *
  ***************************************************************************************************/
-static int16_t EnqueueOnChangeSensorQ( HostIFPackets_t *pHiFDataPacket, uint16_t packetSize, uint32_t sensorType )
+static osp_bool_t IsOnChangeSampleChanged( const uint8_t *pLastPkt, const uint8_t *pNewPkt, uint16_t packetSize,
+                                           uint32_t threshold )
 {
-    int16_t i;
+    uint16_t payloadOffset;
+    uint16_t payloadEnd;
+    uint8_t  elemSize;
+    uint8_t  i;
+    int64_t  lastVal;
+    int64_t  newVal;
+
+    payloadOffset = SENSOR_DATA_PKT_HEADER_SIZE +
+        ( ( GetSensorDataTimeStampSize( pNewPkt ) == TIME_STAMP_64_BIT ) ?
+          TIME_STAMP_64_BIT_SIZE_IN_BYTES : TIME_STAMP_32_BIT_SIZE_IN_BYTES );
+    payloadEnd = packetSize - ( ( pNewPkt[PKT_CONTROL_BYTE_OFFSET] & PKT_CRC_MASK ) ? CRC_SIZE : 0 );
+
+    /* Different packet format is always a change */
+    if ( ( payloadEnd <= payloadOffset ) ||
+         ( memcmp( pLastPkt, pNewPkt, SENSOR_DATA_PKT_HEADER_SIZE ) != 0 ) )
+    {
+        return TRUE;
+    }
+
+    if ( threshold == 0 )
+    {
+        return ( memcmp( pLastPkt + payloadOffset, pNewPkt + payloadOffset,
+                            payloadEnd - payloadOffset ) != 0 ) ? TRUE : FALSE;
+    }
 
-    for ( i = 0; i < NUM_ONCHANGE_NONWAKEUP_SENSOR; i++ )
+    elemSize = 1 << GetSensorDataDataSize( pNewPkt );
+
+    for ( ; ( payloadOffset + elemSize ) <= payloadEnd; payloadOffset += elemSize )
     {
-        /* Check packet is available */
-        if ( NwOnChangeSensorBuffer.SensorList[i].ValidFlag )
+        /* Sign extend from MS byte */
+        lastVal = (int8_t)pLastPkt[payloadOffset];
+        newVal  = (int8_t)pNewPkt[payloadOffset];
+
+        for ( i = 1; i < elemSize; i++ )
         {
-            /* Match sensor type before overwriting packet */
-            if ( NwOnChangeSensorBuffer.SensorList[i].SensorType == sensorType )
-            {
-                /* Overwrite data to onChange sensor type */
-                SH_MEMCPY( &(NwOnChangeSensorBuffer.SensorList[i].Sample), pHiFDataPacket, packetSize );
-                NwOnChangeSensorBuffer.SensorList[i].ValidFlag = TRUE;
-                NwOnChangeSensorBuffer.SensorList[i].Header.Length = packetSize;
-                NwOnChangeSensorBuffer.SensorList[i].SensorType = (ASensorType_t)sensorType;
-                NwOnChangeSensorBuffer.Empty = FALSE;
-                return OSP_STATUS_OK;
-            }
+            lastVal = ( lastVal << 8 ) | pLastPkt[payloadOffset + i];
+            newVal  = ( newVal << 8 ) | pNewPkt[payloadOffset + i];
         }
-        else
+
+        if ( ( ( newVal - lastVal ) > (int64_t)threshold ) || ( ( lastVal - newVal ) > (int64_t)threshold ) )
         {
-            /* Copy data to onChange sensor type */
-            SH_MEMCPY( &(NwOnChangeSensorBuffer.SensorList[i].Sample), pHiFDataPacket, packetSize );
-            NwOnChangeSensorBuffer.SensorList[i].ValidFlag = TRUE;
-            NwOnChangeSensorBuffer.SensorList[i].Header.Length = packetSize;
-            NwOnChangeSensorBuffer.SensorList[i].SensorType = (ASensorType_t)sensorType;
-            NwOnChangeSensorBuffer.Empty = FALSE;
-            return OSP_STATUS_OK;
+            return TRUE;
         }
     }
-    return OSP_STATUS_INVALID_PARAMETER;
+
+    return FALSE;
 }
 
 
 /****************************************************************************************************
- * @fn      DequeueOnChangeSensorQ
- *          Dequeue locally stored on change non wakeup sensors.
+ * @fn      EnqueueOnChangeSensorQ
+ *          Coalesce On Change sensor sample in the locally stored latest value table. A sample not yet
+ *          reported is overwritten by the newer one; a sample that did not change from the last
+ *          reported one is dropped. No packet pool block is used for On Change samples.
  *
- * @param   [OUT] pBuf - Buffer pointer to hold sample
+ * @param   [IN] pHiFDataPacket - pointer of sensor data packet
+ * @param   [IN] packetSize - Size of sensor data packet
+ * @param   [IN] sensorType - Type of sensor (base enum)
  *
  * @return  OSP_STATUS_OK or error code
  *
  ***************************************************************************************************/
-static int16_t DequeueOnChangeSensorQ( Buffer_t **pBuf )
+static int16_t EnqueueOnChangeSensorQ( HostIFPackets_t *pHiFDataPacket, uint16_t packetSize, uint32_t sensorType )
 {
-    static int16_t index = 0 ;
+    BatchOnChangeSensor_t *pEntry;
+    FifoQ_Type_t QType = BatchDesc.SensorList[sensorType].QType;
+    osp_bool_t isNewChange = FALSE;
+    SETUP_CRITICAL_SECTION();
 
-    if ( index < NUM_ONCHANGE_NONWAKEUP_SENSOR )
+    if ( OnChangeSensorBuffer.Slot[sensorType] == INVALID_ONCHANGE_SLOT )
     {
-        /* check Valid sample for current sensor */
-        if ( NwOnChangeSensorBuffer.SensorList[index].ValidFlag )
-        {
-            *pBuf = ( Buffer_t *)&NwOnChangeSensorBuffer.SensorList[index].Header;
-            index++;
-        }
-        else
+        return OSP_STATUS_INVALID_PARAMETER;
+    }
+
+    pEntry = &OnChangeSensorBuffer.SensorList[OnChangeSensorBuffer.Slot[sensorType]];
+
+    /* Table entry is read by the dequeue in host interface ISR */
+    ENTER_CRITICAL_SECTION();
+    if ( pEntry->isPending )
+    {
+        /* Supersede unreported sample; deadline stays that of the first unreported change */
+        SH_MEMCPY( &(pEntry->Sample), pHiFDataPacket, packetSize );
+        pEntry->Header.Length = packetSize;
+    }
+    else if ( ( !pEntry->ValidFlag ) ||
+              IsOnChangeSampleChanged( (const uint8_t *)&(pEntry->Sample), (const uint8_t *)pHiFDataPacket,
+                                       packetSize, SensorFifoTypeAndRateMap[sensorType].ChangeThreshold ) )
+    {
+        SH_MEMCPY( &(pEntry->Sample), pHiFDataPacket, packetSize );
+        pEntry->Header.Length   = packetSize;
+        pEntry->Header.Arrival  = RTC_GetCounter();
+        pEntry->Header.Deadline = pEntry->Header.Arrival + BatchDesc.SensorList[sensorType].DeadlineOffset;
+        pEntry->ValidFlag       = TRUE;
+        pEntry->isPending       = TRUE;
+
+        OnChangeSensorBuffer.PendingSensor[QType][OnChangeSensorBuffer.NumPending[QType]++] = (uint8_t)sensorType;
+        isNewChange = TRUE;
+    }
+    EXIT_CRITICAL_SECTION();
+
+    /* Change with no report latency is reported right away, others are reported with the batch */
+    if ( isNewChange && ( BatchDesc.SensorList[sensorType].DeadlineOffset == 0 ) )
+    {
+        QHighThresholdCallBack( QType );
+    }
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      DequeueOnChangeSensorQ
+ *          Dequeue the unreported On Change sample with earliest deadline of the given queue. The
+ *          packet is copied out under critical section as the producer may supersede it.
+ *
+ * @param   [IN]  QType   - Batching queue type (Wakeup/NonWakeup)
+ * @param   [OUT] pBuf    - Buffer where packet is copied
+ * @param   [OUT] pLength - Length of the copied packet
+ *
+ * @return  OSP_STATUS_OK or OSP_STATUS_QUEUE_EMPTY
+ *
+ ***************************************************************************************************/
+static int16_t DequeueOnChangeSensorQ( FifoQ_Type_t QType, uint8_t *pBuf, uint32_t *pLength )
+{
+    BatchOnChangeSensor_t *pEntry;
+    BatchOnChangeSensor_t *pEdfEntry = NULL;
+    uint8_t edfIdx = 0;
+    uint8_t i;
+    SETUP_CRITICAL_SECTION();
+
+    ENTER_CRITICAL_SECTION();
+    for ( i = 0; i < OnChangeSensorBuffer.NumPending[QType]; i++ )
+    {
+        pEntry = &OnChangeSensorBuffer.SensorList[OnChangeSensorBuffer.Slot[OnChangeSensorBuffer.PendingSensor[QType][i]]];
+
+        if ( ( pEdfEntry == NULL ) || M_DeadlineBefore( pEntry->Header.Deadline, pEdfEntry->Header.Deadline ) )
         {
-            index++;
-            return OSP_STATUS_INVALID_PARAMETER;
+            pEdfEntry = pEntry;
+            edfIdx = i;
         }
     }
-    else
+
+    if ( pEdfEntry == NULL )
+    {
+        EXIT_CRITICAL_SECTION();
+        *pLength = 0;
+        return OSP_STATUS_QUEUE_EMPTY;
+    }
+
+    CheckDeadlineMiss( OnChangeSensorBuffer.PendingSensor[QType][edfIdx], &(pEdfEntry->Header),
+                       (const uint8_t *)&(pEdfEntry->Sample) );
+
+    SH_MEMCPY( pBuf, &(pEdfEntry->Sample), pEdfEntry->Header.Length );
+    *pLength = pEdfEntry->Header.Length;
+
+    /* Sample is now the last reported value; order of the pending list is not significant */
+    pEdfEntry->isPending = FALSE;
+    OnChangeSensorBuffer.PendingSensor[QType][edfIdx] =
+        OnChangeSensorBuffer.PendingSensor[QType][--OnChangeSensorBuffer.NumPending[QType]];
+    EXIT_CRITICAL_SECTION();
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      FlushOnChangeSensorQ
+ *          Moves an unreported On Change sample to the sensor's sub-queue so it is delivered ahead of
+ *          the flush complete packet that follows it.
+ *
+ * @param   [IN] sensorType - Type of sensor (base enum)
+ *
+ * @return  OSP_STATUS_OK or error code
+ *
+ ***************************************************************************************************/
+static int16_t FlushOnChangeSensorQ( uint32_t sensorType )
+{
+    Buffer_t *pHifPacket;
+    BatchOnChangeSensor_t *pEntry;
+    int16_t status;
+
+    if ( OnChangeSensorBuffer.Slot[sensorType] == INVALID_ONCHANGE_SLOT )
+    {
+        return OSP_STATUS_OK;
+    }
+
+    pEntry = &OnChangeSensorBuffer.SensorList[OnChangeSensorBuffer.Slot[sensorType]];
+
+    if ( !pEntry->isPending )
+    {
+        return OSP_STATUS_OK;
+    }
+
+    /* On failure the sample stays pending and is reported by a later dequeue */
+    pHifPacket = (Buffer_t *)AllocBlock( SensorDataPacketPool );
+    if ( pHifPacket == NULL )
+    {
+        return OSP_STATUS_MALLOC_FAILED;
+    }
+
+    SH_MEMCPY( &(pHifPacket->DataStart), &(pEntry->Sample), pEntry->Header.Length );
+    pHifPacket->Header.Length   = pEntry->Header.Length;
+    pHifPacket->Header.Deadline = pEntry->Header.Deadline;
+    pHifPacket->Header.Arrival  = pEntry->Header.Arrival;
+
+    status = SensorSubQEnQueue( sensorType, pHifPacket );
+    if ( status != OSP_STATUS_OK )
     {
-        /* We check all sensor in list and now there is no valid entry */
-        NwOnChangeSensorBuffer.Empty = TRUE;
-        index = 0;
-        return OSP_STATUS_QUEUE_EMPTY;
+        FreeBlock( SensorDataPacketPool, pHifPacket );
+        BatchManagerQueueFlush( BatchDesc.SensorList[sensorType].QType );
+        return status;
     }
+
+    /* Queued; take this sensor's sample out of the pending list */
+    DiscardPktsFromOnChangeSensorBuf( sensorType );
+
     return OSP_STATUS_OK;
 }
 
 
 /****************************************************************************************************
  * @fn      DiscardPktsFromOnChangeSensorBuf
- *          Discards packet corresponding to a sensor type from on-change non wakeup local Sample pool.
+ *          Discards unreported packet corresponding to a sensor type from on-change local Sample pool.
  *
- * @param   [IN] sensorType - Type of sensor
+ * @param   [IN] sensorType - Type of sensor (base enum)
  *
  * @return  OSP_STATUS_OK or error code
  *
  ***************************************************************************************************/
 static int16_t DiscardPktsFromOnChangeSensorBuf( uint32_t sensorType )
 {
-    int16_t i;
-    int16_t validPackets = 0;
+    FifoQ_Type_t QType = BatchDesc.SensorList[sensorType].QType;
+    uint8_t i;
+    SETUP_CRITICAL_SECTION();
 
-    for ( i = 0; i < NUM_ONCHANGE_NONWAKEUP_SENSOR; i++ )
+    if ( OnChangeSensorBuffer.Slot[sensorType] == INVALID_ONCHANGE_SLOT )
     {
-        /* Check is valid packet exists for the sensor */
-        if ( NwOnChangeSensorBuffer.SensorList[i].ValidFlag )
-        {
-            validPackets++;
-            if ( NwOnChangeSensorBuffer.SensorList[i].SensorType == sensorType )
-            {
-                NwOnChangeSensorBuffer.SensorList[i].ValidFlag = FALSE;
-                validPackets--;
-             }
-        }
+        return OSP_STATUS_INVALID_PARAMETER;
     }
 
-    /* Mark buffer empty if zero valid packets in it */
-    if ( validPackets == 0 )
+    ENTER_CRITICAL_SECTION();
+    OnChangeSensorBuffer.SensorList[OnChangeSensorBuffer.Slot[sensorType]].isPending = FALSE;
+
+    for ( i = 0; i < OnChangeSensorBuffer.NumPending[QType]; i++ )
     {
-        NwOnChangeSensorBuffer.Empty = TRUE;
+        if ( OnChangeSensorBuffer.PendingSensor[QType][i] == sensorType )
+        {
+            OnChangeSensorBuffer.PendingSensor[QType][i] =
+                OnChangeSensorBuffer.PendingSensor[QType][--OnChangeSensorBuffer.NumPending[QType]];
+            break;
+        }
     }
+    EXIT_CRITICAL_SECTION();
 
-    DPRINTF("\r\n%s: Packets valid: %d\r\n", __FUNCTION__, validPackets );
+    DPRINTF("\r\n%s: Packets pending: %d\r\n", __FUNCTION__, OnChangeSensorBuffer.NumPending[QType] );
 
     return OSP_STATUS_OK;
 }
@@ -677,6 +1192,8 @@ static int16_t DiscardPktsFromOnChangeSensorBuf( uint32_t sensorType )
 int16_t BatchManagerInitialize( void )
 {
     uint8_t i;
+    uint8_t slot;
+    int16_t errCode;
 
     if (!isBatchManagerInitialized)
     {
@@ -701,26 +1218,60 @@ int16_t BatchManagerInitialize( void )
             BatchDesc.SensorList[i].ActualSamplingPeriod    = SensorFifoTypeAndRateMap[i].SamplingRate;
             BatchDesc.SensorList[i].isValidEntry            = FALSE;
             BatchDesc.SensorList[i].isSensorEnabled         = FALSE;
-            /* Use Wake up Queue for Wake up FIFO Sensors and NonWake Up Queue for Non Wake up and Non Wake up on change FIFOs */
-            BatchDesc.SensorList[i].QType                   = ( SensorFifoTypeAndRateMap[i].FIFOType == WAKEUP_FIFO ) ?
+            /* Use Wake up Queue for Wake up FIFO Sensors and NonWake Up Queue for Non Wake up FIFOs */
+            BatchDesc.SensorList[i].QType                   = ( ( SensorFifoTypeAndRateMap[i].FIFOType == WAKEUP_FIFO ) ||
+                                                                ( SensorFifoTypeAndRateMap[i].FIFOType == WAKEUP_ONCHANGE_FIFO ) ) ?
                                                               (WAKEUP_QUEUE):(NONWAKEUP_QUEUE);
             BatchDesc.SensorList[i].DecimationCnt           = 1;
             BatchDesc.SensorList[i].SampleCnt               = 0;
-        }
+            BatchDesc.SensorList[i].DeadlineOffset          = 0;
+            BatchDesc.SensorList[i].isSubQActive            = FALSE;
 
-        /* Initialize min. Report latency to max */
-        BatchDesc.BatchQ[WAKEUP_QUEUE].MinReportLatency       = (uint64_t)DEFAULT_REPORT_LATENCY;
-        BatchDesc.BatchQ[NONWAKEUP_QUEUE].MinReportLatency    = (uint64_t)DEFAULT_REPORT_LATENCY;
+            /* Create sensor sub-queue; it shares the capacity of its batching queue */
+            errCode = QueueInitialize( &BatchDesc.SensorList[i].SubQ,
+                                       BatchDesc.BatchQ[BatchDesc.SensorList[i].QType].pQ->Capacity,
+                                       QUEUE_LOW_THR, QUEUE_HIGH_THR );
+            ASF_assert( errCode == OSP_STATUS_OK );
+
+            errCode = QueueAttachParent( &BatchDesc.SensorList[i].SubQ,
+                                         BatchDesc.BatchQ[BatchDesc.SensorList[i].QType].pQ );
+            ASF_assert( errCode == OSP_STATUS_OK );
+
+            errCode = QueueRegisterCallBack( &BatchDesc.SensorList[i].SubQ, QUEUE_HIGH_THRESHOLD_CB,
+                                             (fpQueueEvtCallback_t) QHighThresholdCallBack,
+                                             (void *)BatchDesc.SensorList[i].QType );
+            ASF_assert( errCode == OSP_STATUS_OK );
+        }
 
         BatchDesc.BatchQ[WAKEUP_QUEUE].NumBatchedSensor       = 0;
         BatchDesc.BatchQ[NONWAKEUP_QUEUE].NumBatchedSensor    = 0;
+        BatchDesc.BatchQ[WAKEUP_QUEUE].NumActiveSensor        = 0;
+        BatchDesc.BatchQ[NONWAKEUP_QUEUE].NumActiveSensor     = 0;
 
-        /* Initialize on change non wakeup sensor list */
-        for (i = 0; i < NUM_ONCHANGE_NONWAKEUP_SENSOR; i++)
+        /* Assign a latest value slot to each on change sensor */
+        slot = 0;
+        for ( i = 0; i < MAX_NUMBER_SENSORS; i++ )
         {
-            NwOnChangeSensorBuffer.SensorList[i].ValidFlag = FALSE;
-            NwOnChangeSensorBuffer.Empty = TRUE;
+            if ( ( SensorFifoTypeAndRateMap[i].FIFOType == NONWAKEUP_ONCHANGE_FIFO ) ||
+                 ( SensorFifoTypeAndRateMap[i].FIFOType == WAKEUP_ONCHANGE_FIFO ) )
+            {
+                ASF_assert( slot < NUM_ONCHANGE_SENSOR );
+                OnChangeSensorBuffer.SensorList[slot].ValidFlag = FALSE;
+                OnChangeSensorBuffer.SensorList[slot].isPending = FALSE;
+                OnChangeSensorBuffer.Slot[i] = slot++;
+            }
+            else
+            {
+                OnChangeSensorBuffer.Slot[i] = INVALID_ONCHANGE_SLOT;
+            }
         }
+        OnChangeSensorBuffer.NumPending[WAKEUP_QUEUE]    = 0;
+        OnChangeSensorBuffer.NumPending[NONWAKEUP_QUEUE] = 0;
+
+        /* Start host interrupt statistics */
+        memset( &IntStats, 0, sizeof(IntStats) );
+        WakeupWindowStart = RTC_GetCounter();
+        WakeupWindowCount = 0;
 
         isBatchManagerInitialized = TRUE;
 
@@ -776,8 +1327,9 @@ int16_t BatchManagerSensorRegister( ASensorType_t SensorType, uint64_t SamplingP
     BatchParam.RequestedSamplingPeriod = SamplingPeriod;
     BatchParam.ReportLatency = ReportLatency;
 
-    /* calculate decimation factor */
-    BatchDesc.SensorList[sType].DecimationCnt = ( SamplingPeriod / SensorSamplingPeriod );
+    /* calculate decimation factor; on change sensors have no sampling period and are not decimated */
+    BatchDesc.SensorList[sType].DecimationCnt =
+        ( SensorSamplingPeriod != ON_CHANGE_SAMPLE_PERIOD ) ? ( SamplingPeriod / SensorSamplingPeriod ) : 1;
 
     if ( BatchDesc.SensorList[sType].DecimationCnt == 0 )
     {
@@ -820,7 +1372,6 @@ int16_t BatchManagerSensorEnable( ASensorType_t SensorType )
     uint32_t          highThreshold;
     int16_t           errCode   = OSP_STATUS_INVALID_PARAMETER;
     BatchStateType_t  currState;
-    FifoQ_Type_t      QType;
     uint32_t          sType;
 
     /* Change sensor base */
@@ -840,9 +1391,6 @@ int16_t BatchManagerSensorEnable( ASensorType_t SensorType )
 
     BatchDesc.SensorList[sType].isSensorEnabled = TRUE;
 
-    /* get current queue type */
-    QType = BatchDesc.SensorList[sType].QType;
-
     /* Change state to Batch Active if it is in Idle state */
     errCode = BatchStateGet( &currState );
     ASF_assert( errCode == OSP_STATUS_OK );
@@ -853,11 +1401,26 @@ int16_t BatchManagerSensorEnable( ASensorType_t SensorType )
         ASF_assert( errCode == OSP_STATUS_OK );
     }
 
+    /* Deadline offset of the sensor's samples: report latency in RTC ticks */
+    if ( BatchDesc.SensorList[sType].ReportLatency == (uint64_t)DEFAULT_REPORT_LATENCY )
+    {
+        BatchDesc.SensorList[sType].DeadlineOffset = 0;
+    }
+    else if ( ( BatchDesc.SensorList[sType].ReportLatency / RTC_TICK_NS_INT ) > MAX_DEADLINE_OFFSET )
+    {
+        BatchDesc.SensorList[sType].DeadlineOffset = MAX_DEADLINE_OFFSET;
+    }
+    else
+    {
+        BatchDesc.SensorList[sType].DeadlineOffset =
+            (uint32_t)( BatchDesc.SensorList[sType].ReportLatency / RTC_TICK_NS_INT );
+    }
+
     /* Calculate and validate High threshold value */
-    highThreshold = CalculateHighThreshold( &BatchDesc, QType );
+    highThreshold = CalculateHighThreshold( &BatchDesc, sType );
 
-    /* Set High Threshold value for given queue */
-    errCode = QueueHighThresholdSet( BatchDesc.BatchQ[QType].pQ, highThreshold );
+    /* Set High Threshold value for the sensor's sub-queue */
+    errCode = QueueHighThresholdSet( &BatchDesc.SensorList[sType].SubQ, highThreshold );
 
     return errCode;
 }
@@ -921,11 +1484,9 @@ int16_t BatchManagerSensorDisable( ASensorType_t sensorType )
 {
     FifoQ_Type_t      QType;
     Buffer_t          *pTempHifPacket;
-    uint32_t          highThreshold;
     uint32_t          sType;
     uint32_t          size;
     int16_t           errCode   = OSP_STATUS_INVALID_PARAMETER;
-    int16_t           stat;
 
 
     /* Change sensor base */
@@ -950,43 +1511,27 @@ int16_t BatchManagerSensorDisable( ASensorType_t sensorType )
     BatchDesc.SensorList[sType].SampleCnt       = 0;
     BatchDesc.SensorList[sType].isSensorEnabled = FALSE;
 
-    /* Calculate New High threshold value */
-    highThreshold = CalculateHighThreshold( &BatchDesc, QType );
-
-    /* Set New High Threshold value for given queue */
-    errCode = QueueHighThresholdSet( BatchDesc.BatchQ[QType].pQ, highThreshold );
-
-    /* Check if sensor FIFO type is Non Wake up On Change FIFO */
-    if ( SensorFifoTypeAndRateMap[sType].FIFOType == NONWAKEUP_ONCHANGE_FIFO )
+    /* Check if sensor FIFO type is On Change FIFO */
+    if ( ( SensorFifoTypeAndRateMap[sType].FIFOType == NONWAKEUP_ONCHANGE_FIFO ) ||
+         ( SensorFifoTypeAndRateMap[sType].FIFOType == WAKEUP_ONCHANGE_FIFO ) )
     {
         DiscardPktsFromOnChangeSensorBuf( sType );
+
+        /* First sample after re-enable is always reported */
+        OnChangeSensorBuffer.SensorList[OnChangeSensorBuffer.Slot[sType]].ValidFlag = FALSE;
     }
 
     /* Get current Queue size */
     QueueGetSize( BatchDesc.BatchQ[QType].pQ, &size );    /* get number of entries */
     DPRINTF( "\r\nQueue size before discard = %d\r\n", size );
 
-    /* Discard packets for the disabled sensor from appropriate Queue
+    /* Discard packets for the disabled sensor from its sub-queue
      * This is done so as to not retain and transfer stale sensor data when sensor is re-enabled
      */
-    while ( size > 0 )
+    while ( DeQueue( &BatchDesc.SensorList[sType].SubQ, &pTempHifPacket ) == OSP_STATUS_OK )
     {
-        stat = DeQueue( BatchDesc.BatchQ[QType].pQ , &pTempHifPacket );
-        ASF_assert( pTempHifPacket->Header.Length >= SENSOR_DATA_PKT_HEADER_SIZE );    /*  check packet validity */
-
-        /* check the packet header for sensor type */
-        if ( ( *( &(pTempHifPacket->DataStart ) + PKT_SENSOR_ID_BYTE_OFFSET ) & SENSOR_TYPE_MASK ) == sType )
-        {
-            errCode = FreeBlock( SensorDataPacketPool, pTempHifPacket );
-            ASF_assert( errCode == OSP_STATUS_OK );
-        }
-        else
-        {
-             /* enqueue back if it belongs to a different sensor */
-             stat = EnQueue( BatchDesc.BatchQ[QType].pQ , pTempHifPacket );
-             ASF_assert( stat == OSP_STATUS_OK );
-        }
-        size--;
+        errCode = FreeBlock( SensorDataPacketPool, pTempHifPacket );
+        ASF_assert( errCode == OSP_STATUS_OK );
     }
 
     QueueGetSize( BatchDesc.BatchQ[QType].pQ, &size );    /* get number of entries */
@@ -1053,6 +1598,15 @@ int16_t BatchManagerSensorDataEnQueue( HostIFPackets_t *pHiFDataPacket, uint16_t
     BatchSensorFIFOType_t   FIFOType;
     FifoQ_Type_t                QType;
     uint8_t                 isFlushCompletePacket;
+    uint32_t                arrivalTime;
+    osp_bool_t              isOnChange;
+    int16_t                 flushStatus = OSP_STATUS_OK;
+
+    /* Apply thresholds for changed host service latency */
+    if ( isThresholdUpdatePending )
+    {
+        UpdateHighThresholds();
+    }
 
     BatchManagerGetSensorQueueType( (ASensorType_t) sensorType, &QType );
     isFlushCompletePacket = GetSensorDataFlushStatus( ( const uint8_t *) pHiFDataPacket);
@@ -1069,6 +1623,15 @@ int16_t BatchManagerSensorDataEnQueue( HostIFPackets_t *pHiFDataPacket, uint16_t
         }
     }
 
+    FIFOType = SensorFifoTypeAndRateMap[sensorType].FIFOType;
+    isOnChange = ( ( FIFOType == NONWAKEUP_ONCHANGE_FIFO ) || ( FIFOType == WAKEUP_ONCHANGE_FIFO ) ) ? TRUE : FALSE;
+
+    if ( isOnChange && ( isFlushCompletePacket == 0 ) )
+    {
+        /* On change samples are coalesced in the latest value table */
+        return EnqueueOnChangeSensorQ( pHiFDataPacket, packetSize, sensorType );
+    }
+
     /* Allocate Packet from Sensor Data Pool */
     pHifPacket = (Buffer_t *)AllocBlock( SensorDataPacketPool );
 
@@ -1078,21 +1641,33 @@ int16_t BatchManagerSensorDataEnQueue( HostIFPackets_t *pHiFDataPacket, uint16_t
         return OSP_STATUS_MALLOC_FAILED;
     }
 
-    FIFOType = SensorFifoTypeAndRateMap[sensorType].FIFOType;
-
     /* Copy packet to Packet pool */
     SH_MEMCPY( &(pHifPacket->DataStart), pHiFDataPacket, packetSize );
 
     /* update length of packet */
     pHifPacket->Header.Length = packetSize;
 
+    /* Delivery deadline: arrival time + sensor report latency. Flush-complete is due immediately */
+    arrivalTime = RTC_GetCounter();
+    pHifPacket->Header.Arrival  = arrivalTime;
+    pHifPacket->Header.Deadline = ( isFlushCompletePacket == 0 ) ?
+        ( arrivalTime + BatchDesc.SensorList[sensorType].DeadlineOffset ) : arrivalTime;
+
+    if ( isOnChange )
+    {
+        /* Unreported sample must reach the host ahead of the flush complete packet. The flush complete
+         * packet already holds its block, so it is sent even if the sample cannot be queued; the
+         * sample then stays pending and its error is returned. */
+        flushStatus = FlushOnChangeSensorQ( sensorType );
+    }
+
     /* EnQueue packet based on Sensor Type */
     switch ( FIFOType )
     {
     case NONWAKEUP_FIFO:
     case NONWAKEUP_ONCHANGE_FIFO:
         /* EnQueue Packet */
-        status = EnQueue(_HiFNonWakeupQueue , pHifPacket);
+        status = SensorSubQEnQueue( sensorType, pHifPacket );
 
         /* Check queue is full */
         if(status == OSP_STATUS_QUEUE_FULL)
@@ -1103,15 +1678,17 @@ int16_t BatchManagerSensorDataEnQueue( HostIFPackets_t *pHiFDataPacket, uint16_t
 
             if ( currBatchState == BATCH_ACTIVE_HOST_SUSPEND )
             {
-                /* queue is full and host is suspended so Old packet needs to removed to make space for new packets.*/
-                DeQueue( _HiFNonWakeupQueue, &pTempHifPacket );
-
-                /* Free Block from PacketPool */
-                status = FreeBlock( SensorDataPacketPool, pTempHifPacket );
-                ASF_assert( status == OSP_STATUS_OK );
+                /* queue is full and host is suspended so the oldest packet needs to removed to make
+                   space for new packets. The host may have drained the queue in the meantime. */
+                if ( DeQueueOldest( NONWAKEUP_QUEUE, &pTempHifPacket ) == OSP_STATUS_OK )
+                {
+                    /* Free Block from PacketPool */
+                    status = FreeBlock( SensorDataPacketPool, pTempHifPacket );
+                    ASF_assert( status == OSP_STATUS_OK );
+                }
 
                 /* EnQueue packet again */
-                status = EnQueue( _HiFNonWakeupQueue , pHifPacket );
+                status = SensorSubQEnQueue( sensorType, pHifPacket );
                 ASF_assert( status == OSP_STATUS_OK );
             }
             else
@@ -1119,16 +1696,12 @@ int16_t BatchManagerSensorDataEnQueue( HostIFPackets_t *pHiFDataPacket, uint16_t
                 status = BatchManagerQueueFlush( QUEUE_NONWAKEUP_TYPE );
             }
         }
-        /* If non wakeup on change sensor then save packet in locally */
-        if ( ( FIFOType == NONWAKEUP_ONCHANGE_FIFO ) && ( isFlushCompletePacket == 0 ) )
-        {
-            status = EnqueueOnChangeSensorQ( pHiFDataPacket, packetSize, sensorType );
-        }
         break;
 
     case WAKEUP_FIFO:
+    case WAKEUP_ONCHANGE_FIFO:
         /* EnQueue Packet */
-        status = EnQueue( _HiFWakeUpQueue , pHifPacket );
+        status = SensorSubQEnQueue( sensorType, pHifPacket );
 
         /* Check queue is full */
         if (status == OSP_STATUS_QUEUE_FULL)
@@ -1141,7 +1714,7 @@ int16_t BatchManagerSensorDataEnQueue( HostIFPackets_t *pHiFDataPacket, uint16_t
         status = OSP_STATUS_INVALID_PARAMETER;
         break;
     }
-    return status;
+    return ( status == OSP_STATUS_OK ) ? flushStatus : status;
 }
 
 
@@ -1162,6 +1735,7 @@ int16_t BatchManagerDeQueue( uint8_t *pBuf, uint32_t *pLength )
 {
     int16_t status;
     Buffer_t *pHIFPkt;
+    uint32_t sType;
 
     uint32_t bufSize = *pLength;
     uint32_t bufSizeMin;
@@ -1174,6 +1748,9 @@ int16_t BatchManagerDeQueue( uint8_t *pBuf, uint32_t *pLength )
 
     *pLength = 0; //Set length to zero in case we return error status
 
+    /* Host is servicing the interrupt */
+    UpdateHostServiceLatency();
+
     do
     {
         /* Get Current queue type */
@@ -1188,11 +1765,13 @@ int16_t BatchManagerDeQueue( uint8_t *pBuf, uint32_t *pLength )
         switch( CurrQType )
         {
         case QUEUE_NONWAKEUP_TYPE:
-            /* DeQueue packet from the non Wake up queue */
-            status = DeQueue( _HiFNonWakeupQueue, &pHIFPkt );
+            /* DeQueue most urgent packet from the non Wake up sensor sub-queues */
+            status = DeQueueEarliestDeadline( QUEUE_NONWAKEUP_TYPE, &pHIFPkt, &sType );
 
             if ( status == OSP_STATUS_OK )
             {
+                CheckDeadlineMiss( sType, &(pHIFPkt->Header), &(pHIFPkt->DataStart) );
+
                 /* Copy packet to given buffer */
                 SH_MEMCPY( pBuf + *pLength, &(pHIFPkt->DataStart), pHIFPkt->Header.Length );
 
@@ -1207,23 +1786,11 @@ int16_t BatchManagerDeQueue( uint8_t *pBuf, uint32_t *pLength )
             /* If Non Wakeup queue is Empty check Local On change Sensor Packets */
             else if ( status == OSP_STATUS_QUEUE_EMPTY)
             {
-                /* Dequeue packet from on change sensor */
-                do
-                {
-                    status = DequeueOnChangeSensorQ( &pHIFPkt );
-                } while ( status == OSP_STATUS_INVALID_PARAMETER );
-
-                /* If it is valid packet then */
-                if ( status == OSP_STATUS_OK )
-                {
-                    /* Copy packet to given buffer */
-                    SH_MEMCPY( pBuf + *pLength, &(pHIFPkt->DataStart), pHIFPkt->Header.Length );
+                /* Copy unreported on change sample to given buffer */
+                status = DequeueOnChangeSensorQ( QUEUE_NONWAKEUP_TYPE, pBuf + *pLength, &pktLen );
+                *pLength += pktLen;
 
-                    /* update length of DeQueue packet */
-                    pktLen = pHIFPkt->Header.Length;
-                    *pLength += pktLen;
-                }
-                else
+                if ( status == OSP_STATUS_QUEUE_EMPTY )
                 {
                     /* Set Non wakeup queue Empty bit */
                     QEmptyCallBack(QUEUE_NONWAKEUP_TYPE);
@@ -1232,11 +1799,13 @@ int16_t BatchManagerDeQueue( uint8_t *pBuf, uint32_t *pLength )
             break;
 
         case QUEUE_WAKEUP_TYPE:
-            /* DeQueue packet from the Wake up queue */
-            status = DeQueue( _HiFWakeUpQueue, &pHIFPkt );
+            /* DeQueue most urgent packet from the Wake up sensor sub-queues */
+            status = DeQueueEarliestDeadline( QUEUE_WAKEUP_TYPE, &pHIFPkt, &sType );
 
             if ( status == OSP_STATUS_OK )
             {
+                CheckDeadlineMiss( sType, &(pHIFPkt->Header), &(pHIFPkt->DataStart) );
+
                 /* Copy packet to given buffer */
                 SH_MEMCPY( pBuf + *pLength, &(pHIFPkt->DataStart), pHIFPkt->Header.Length );
 
@@ -1248,6 +1817,19 @@ int16_t BatchManagerDeQueue( uint8_t *pBuf, uint32_t *pLength )
                 status = FreeBlock( SensorDataPacketPool, pHIFPkt );
                 ASF_assert(status == OSP_STATUS_OK);
             }
+            /* If Wakeup queue is Empty check Local On change Sensor Packets */
+            else if ( status == OSP_STATUS_QUEUE_EMPTY)
+            {
+                /* Copy unreported on change sample to given buffer */
+                status = DequeueOnChangeSensorQ( QUEUE_WAKEUP_TYPE, pBuf + *pLength, &pktLen );
+                *pLength += pktLen;
+
+                if ( status == OSP_STATUS_QUEUE_EMPTY )
+                {
+                    /* Set Wakeup queue Empty bit */
+                    QEmptyCallBack(QUEUE_WAKEUP_TYPE);
+                }
+            }
             break;
 
         case QUEUE_CONTROL_RESPONSE_TYPE:
@@ -1349,6 +1931,12 @@ int16_t BatchManagerQueueFlush( FifoQ_Type_t qType )
     /* Start queue threshold call back */
     QHighThresholdCallBack( qType );
 
+    /* Let host interface driver carry whole FIFO in one transfer */
+    if ( ( FlushHook != NULL ) && ( qType != QUEUE_CONTROL_RESPONSE_TYPE ) )
+    {
+        FlushHook();
+    }
+
     return OSP_STATUS_OK;
 }
 
@@ -1394,6 +1982,279 @@ int16_t BatchManagerGetSensorQueueType( ASensorType_t sensorType, FifoQ_Type_t *
 }
 
 
+/****************************************************************************************************
+ * @fn      BatchManagerSetIntModeration
+ *          Selects how the host interrupt point of batched sensors is calculated. Fixed mode
+ *          interrupts when a sensor's samples span its report latency; adaptive mode interrupts
+ *          earlier by the measured host service latency.
+ *
+ * @param   [IN] mode - Host interrupt moderation mode
+ *
+ * @return  OSP_STATUS_OK or error code
+ *
+ ***************************************************************************************************/
+int16_t BatchManagerSetIntModeration( BatchIntModeration_t mode )
+{
+    if ( mode >= NUM_BATCH_INT_MODERATION )
+    {
+        return OSP_STATUS_INVALID_PARAMETER;
+    }
+
+    IntModeration = mode;
+
+    /* Re-calculate thresholds of enabled sensors for the new mode */
+    UpdateHighThresholds();
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      BatchManagerGetIntStats
+ *          Returns host interrupt statistics
+ *
+ * @param   [OUT] pStats - Host interrupt statistics
+ *
+ * @return  OSP_STATUS_OK or error code
+ *
+ ***************************************************************************************************/
+int16_t BatchManagerGetIntStats( BatchIntStats_t *pStats )
+{
+    SETUP_CRITICAL_SECTION();
+
+    if ( pStats == NULL )
+    {
+        return OSP_STATUS_NULL_POINTER;
+    }
+
+    ENTER_CRITICAL_SECTION();
+    UpdateWakeupWindow( RTC_GetCounter() );
+    *pStats = IntStats;
+    EXIT_CRITICAL_SECTION();
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      BatchManagerDeQueueList
+ *          DeQueue HiF packets the same way as BatchManagerDeQueue but, instead of copying them to a
+ *          transfer buffer, link their pool blocks into a transmit (DMA descriptor) list. Unreported
+ *          On Change samples are copied to pool blocks for the purpose. A Control Response packet is
+ *          always returned on a list of its own. The list must be released with
+ *          BatchManagerReleaseList once the host transfer is complete.
+ *
+ * @param   [OUT] pList - Transmit list
+ * @param   [IN] maxLength - Max. bytes the host transfer can carry
+ *
+ * @return  OSP_STATUS_OK or error code
+ *
+ ***************************************************************************************************/
+int16_t BatchManagerDeQueueList( BatchTxList_t *pList, uint32_t maxLength )
+{
+    int16_t status;
+    Buffer_t *pHIFPkt;
+    uint32_t sType;
+    uint32_t pktLen;
+
+    ASF_assert( pList != NULL );
+    ASF_assert( maxLength > sizeof(HostIFPackets_t) );
+
+    pList->pHead       = NULL;
+    pList->pTail       = NULL;
+    pList->NumPkts     = 0;
+    pList->TotalLength = 0;
+    pList->pPool       = SensorDataPacketPool;
+
+    /* Host is servicing the interrupt */
+    UpdateHostServiceLatency();
+
+    do
+    {
+        /* Get Current queue type */
+        status = GetCurrentQType( &CurrQType );
+
+        /* If all queues are empty */
+        if ( status == OSP_STATUS_QUEUE_EMPTY )
+        {
+            break;
+        }
+
+        switch( CurrQType )
+        {
+        case QUEUE_NONWAKEUP_TYPE:
+        case QUEUE_WAKEUP_TYPE:
+            /* DeQueue most urgent packet from the sensor sub-queues */
+            status = DeQueueEarliestDeadline( CurrQType, &pHIFPkt, &sType );
+
+            if ( status == OSP_STATUS_OK )
+            {
+                CheckDeadlineMiss( sType, &(pHIFPkt->Header), &(pHIFPkt->DataStart) );
+                AppendTxList( pList, pHIFPkt );
+            }
+            /* If queue is Empty check Local On change Sensor Packets */
+            else if ( status == OSP_STATUS_QUEUE_EMPTY )
+            {
+                pHIFPkt = (Buffer_t *)AllocBlock( SensorDataPacketPool );
+
+                /* Pool exhausted; samples go out with the next transfer */
+                if ( pHIFPkt == NULL )
+                {
+                    return ( pList->NumPkts > 0 ) ? OSP_STATUS_OK : OSP_STATUS_MALLOC_FAILED;
+                }
+
+                /* Copy unreported on change sample to pool block */
+                status = DequeueOnChangeSensorQ( CurrQType, &(pHIFPkt->DataStart), &pktLen );
+
+                if ( status == OSP_STATUS_OK )
+                {
+                    pHIFPkt->Header.Length = pktLen;
+                    AppendTxList( pList, pHIFPkt );
+                }
+                else
+                {
+                    status = FreeBlock( SensorDataPacketPool, pHIFPkt );
+                    ASF_assert( status == OSP_STATUS_OK );
+
+                    /* Set queue Empty bit */
+                    QEmptyCallBack( CurrQType );
+                }
+            }
+            break;
+
+        case QUEUE_CONTROL_RESPONSE_TYPE:
+            /* do not mix control response packet with sensor data packets */
+            if ( pList->NumPkts > 0 )
+            {
+                return OSP_STATUS_OK;
+            }
+
+            /* DeQueue packet from Control Response queue */
+            status = DeQueue( _HiFControlQueue, &pHIFPkt );
+
+            if ( status == OSP_STATUS_OK )
+            {
+                pList->pPool = SensorControlResponsePacketPool;
+                AppendTxList( pList, pHIFPkt );
+            }
+            return status;
+
+        default:
+            return OSP_STATUS_INVALID_PARAMETER;
+        }
+
+    } while ( ( maxLength - pList->TotalLength ) >= sizeof(HostIFPackets_t) );
+
+    return ( pList->NumPkts > 0 ) ? OSP_STATUS_OK : status;
+}
+
+
+/****************************************************************************************************
+ * @fn      BatchManagerReleaseList
+ *          Returns the pool blocks of a transmit list once the host transfer is complete
+ *
+ * @param   [IN] pList - Transmit list returned by BatchManagerDeQueueList
+ *
+ * @return  OSP_STATUS_OK or error code
+ *
+ ***************************************************************************************************/
+int16_t BatchManagerReleaseList( BatchTxList_t *pList )
+{
+    Buffer_t *pBuf;
+    Buffer_t *pNext;
+    int16_t status;
+
+    if ( pList == NULL )
+    {
+        return OSP_STATUS_NULL_POINTER;
+    }
+
+    for ( pBuf = pList->pHead; pBuf != NULL; pBuf = pNext )
+    {
+        pNext = (Buffer_t *)pBuf->Header.pNext;
+
+        status = FreeBlock( pList->pPool, pBuf );
+        ASF_assert( status == OSP_STATUS_OK );
+    }
+
+    pList->pHead       = NULL;
+    pList->pTail       = NULL;
+    pList->NumPkts     = 0;
+    pList->TotalLength = 0;
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      BatchManagerTxCursorInit
+ *          Positions a read cursor at the start of a transmit list
+ *
+ * @param   [OUT] pCursor - Read cursor
+ * @param   [IN] pList - Transmit list
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+void BatchManagerTxCursorInit( BatchTxCursor_t *pCursor, const BatchTxList_t *pList )
+{
+    pCursor->pBuf   = pList->pHead;
+    pCursor->Offset = 0;
+}
+
+
+/****************************************************************************************************
+ * @fn      BatchManagerTxCursorRead
+ *          Reads bytes from a transmit list across descriptor boundaries, for drivers that feed a bus
+ *          FIFO rather than a DMA channel
+ *
+ * @param   [IN/OUT] pCursor - Read cursor
+ * @param   [OUT] pDst - Destination for the bytes read
+ * @param   [IN] length - Number of bytes to read
+ *
+ * @return  Number of bytes read, less than length at end of list
+ *
+ ***************************************************************************************************/
+uint32_t BatchManagerTxCursorRead( BatchTxCursor_t *pCursor, uint8_t *pDst, uint32_t length )
+{
+    const uint8_t *pData;
+    uint32_t numRead = 0;
+
+    while ( ( numRead < length ) && ( pCursor->pBuf != NULL ) )
+    {
+        if ( pCursor->Offset >= pCursor->pBuf->Header.Length )
+        {
+            pCursor->pBuf   = (const Buffer_t *)pCursor->pBuf->Header.pNext;
+            pCursor->Offset = 0;
+            continue;
+        }
+
+        pData = M_GetBufferDataStart( pCursor->pBuf );
+        pDst[numRead++] = pData[pCursor->Offset++];
+    }
+
+    return numRead;
+}
+
+
+/****************************************************************************************************
+ * @fn      BatchManagerRegisterFlushHook
+ *          Registers the host interface driver hook called when a sensor data FIFO is flushed, so
+ *          the driver can stream the whole FIFO as a transmit list in a single host transfer
+ *
+ * @param   [IN] pfHook - Flush hook, NULL to unregister
+ *
+ * @return  OSP_STATUS_OK
+ *
+ ***************************************************************************************************/
+int16_t BatchManagerRegisterFlushHook( fpBatchFlushHook_t pfHook )
+{
+    FlushHook = pfHook;
+
+    return OSP_STATUS_OK;
+}
+
+
 /*-------------------------------------------------------------------------------------------------*\
  |    E N D   O F   F I L E
 \*-------------------------------------------------------------------------------------------------*/
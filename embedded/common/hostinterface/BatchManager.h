@@ -32,6 +32,49 @@
 /*-------------------------------------------------------------------------------------------------*\
  |    T Y P E   D E F I N I T I O N S
 \*-------------------------------------------------------------------------------------------------*/
+/* Host interrupt moderation modes */
+typedef enum _BatchIntModeration
+{
+    BATCH_INT_MODERATION_FIXED,       /* Interrupt when a sensor's samples span its report latency */
+    BATCH_INT_MODERATION_ADAPTIVE,    /* Interrupt ahead of that by the measured host service latency */
+    NUM_BATCH_INT_MODERATION
+} BatchIntModeration_t;
+
+/* Host interrupt statistics */
+typedef struct _BatchIntStats
+{
+    uint32_t HostWakeups;             /* Host interrupts asserted since initialization */
+    uint32_t HostWakeupsPerMin;       /* Host interrupts asserted during the last full minute */
+    uint32_t DeadlineMisses;          /* Sensor packets delivered after their report latency expired */
+    uint32_t HostServiceLatency;      /* Estimated interrupt to dequeue latency of host, in RTC ticks */
+} BatchIntStats_t;
+
+/* Transmit list of a batched FIFO flush. The dequeued pool blocks are linked through their buffer
+ * headers, which serve as scatter-gather (DMA) descriptors: packet at M_GetBufferDataStart(),
+ * Header.Length bytes long, next descriptor at Header.pNext. No transfer buffer copy is made and the
+ * list is not limited by the size of one. The blocks belong to the list until it is released.
+ */
+typedef struct _BatchTxList
+{
+    Buffer_t    *pHead;               /* First descriptor, NULL if list is empty */
+    Buffer_t    *pTail;               /* Last descriptor */
+    uint32_t    NumPkts;              /* Number of packets (descriptors) on the list */
+    uint32_t    TotalLength;          /* Total bytes described by the list */
+    void        *pPool;               /* Pool the blocks are returned to on release */
+} BatchTxList_t;
+
+/* Read position in a transmit list for drivers that feed a bus FIFO from it */
+typedef struct _BatchTxCursor
+{
+    const Buffer_t *pBuf;             /* Current descriptor */
+    uint32_t    Offset;               /* Bytes of current descriptor already read */
+} BatchTxCursor_t;
+
+/* Flush hook; lets a host interface driver know that a FIFO is being flushed to the host. The
+ * transmit list it then dequeues is not limited to that FIFO: it carries the wakeup FIFO ahead of
+ * the non-wakeup one, so both are flushed.
+ */
+typedef void (*fpBatchFlushHook_t)( void );
 
 /*-------------------------------------------------------------------------------------------------*\
  |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
@@ -56,6 +99,13 @@ int16_t BatchManagerControlResponseEnQueue( HostIFPackets_t *pHiFControlPacket,
 int16_t BatchManagerQueueFlush( FifoQ_Type_t qType);
 uint32_t BatchManagerMaxQCount( void );
 int16_t BatchManagerGetSensorQueueType( ASensorType_t sensorType, FifoQ_Type_t *sensorQType );
+int16_t BatchManagerSetIntModeration( BatchIntModeration_t mode );
+int16_t BatchManagerGetIntStats( BatchIntStats_t *pStats );
+int16_t BatchManagerDeQueueList( BatchTxList_t *pList, uint32_t maxLength );
+int16_t BatchManagerReleaseList( BatchTxList_t *pList );
+void BatchManagerTxCursorInit( BatchTxCursor_t *pCursor, const BatchTxList_t *pList );
+uint32_t BatchManagerTxCursorRead( BatchTxCursor_t *pCursor, uint8_t *pDst, uint32_t length );
+int16_t BatchManagerRegisterFlushHook( fpBatchFlushHook_t pfHook );
 
 #endif /* BATCH_MANAGER_H */
 /*-------------------------------------------------------------------------------------------------*\
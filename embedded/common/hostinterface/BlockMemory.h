@@ -36,8 +36,12 @@
  * @param [IN]size - Size in bytes of each memory block that will be allocated from the pool
  * @param [IN]cnt - Number of blocks the pool should contain
  */
-#define DECLARE_BLOCK_POOL(pool,size,cnt)     uint32_t pool[(((size)+3)/4)*(cnt) + 5]
-/* Note: +5 is to account for size (in 32-bit values) of local block structure (BlkMem_t) */
+#define DECLARE_BLOCK_POOL(pool,size,cnt)     uint32_t pool[(((size)+3)/4)*(cnt) + BLK_MEM_HDR_WORDS]
+/* Note: BLK_MEM_HDR_WORDS is the size (in 32-bit values) of local block structure (BlkMem_t), i.e.
+ * 2 pointers and 3 counters padded to pointer alignment. This is 5 on target and 8 on a 64-bit
+ * host (simulator) build. */
+#define BLK_MEM_HDR_WORDS                     ((((2*sizeof(void *)) + (3*sizeof(uint32_t)) + sizeof(void *) - 1) / \
+                                                sizeof(void *)) * sizeof(void *) / sizeof(uint32_t))
 
 
 /*-------------------------------------------------------------------------------------------------*\
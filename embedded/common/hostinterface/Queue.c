@@ -74,12 +74,6 @@ Queue_t *QueueCreate( uint32_t capacity, uint32_t lowThreshold, uint32_t highThr
 {
     Queue_t *pQ;
 
-    /* Sanity check capacity and threshold values */
-    if ((capacity <= lowThreshold) || (capacity <= highThreshold) || (lowThreshold >= highThreshold))
-    {
-        return NULL;
-    }
-
     /* Initialize the memory pool for the queue objects */
     if (!QPoolInitialized)
     {
@@ -93,22 +87,77 @@ Queue_t *QueueCreate( uint32_t capacity, uint32_t lowThreshold, uint32_t highThr
     {
         return NULL;
     }
-    else
-    {
-        /* It is important to clear the queue structure */
-        memset( pQ, 0, sizeof(Queue_t));
-    }
 
     /* Initialize queue */
-    pQ->Capacity = capacity;
-    pQ->HighThres = highThreshold;
-    pQ->LowThres = lowThreshold;
+    if (QueueInitialize( pQ, capacity, lowThreshold, highThreshold ) != OSP_STATUS_OK)
+    {
+        FreeBlock( QObjectPool, pQ );
+        return NULL;
+    }
 
     /* Return reference to the queue */
     return pQ;
 }
 
 
+/****************************************************************************************************
+ * @fn      QueueInitialize
+ *          Initializes an application provided (e.g. statically allocated) queue object with the
+ *          given parameters. As with QueueCreate no memory is allocated for the buffers.
+ *
+ * @param   [IN]pMyQ - Pointer to the queue object to initialize
+ * @param   [IN]capacity - Max capacity of the queue
+ * @param   [IN]lowThreshold - Queue size low threshold. Used to trigger low threshold callback
+ * @param   [IN]highThreshold - Queue size high threshold. Used to trigger high threshold callback
+ *
+ * @return  OSP_STATUS_OK or OSP_STATUS_INVALID_PARAMETER if capacity/thresholds are inconsistent
+ *
+ ***************************************************************************************************/
+int16_t QueueInitialize( Queue_t *pMyQ, uint32_t capacity, uint32_t lowThreshold, uint32_t highThreshold )
+{
+    /* Sanity check capacity and threshold values */
+    if ((capacity <= lowThreshold) || (capacity <= highThreshold) || (lowThreshold >= highThreshold))
+    {
+        return (OSP_STATUS_INVALID_PARAMETER);
+    }
+
+    /* It is important to clear the queue structure */
+    memset( pMyQ, 0, sizeof(Queue_t));
+
+    pMyQ->Capacity = capacity;
+    pMyQ->HighThres = highThreshold;
+    pMyQ->LowThres = lowThreshold;
+
+    return OSP_STATUS_OK;
+}
+
+
+/****************************************************************************************************
+ * @fn      QueueAttachParent
+ *          Makes the given (empty) queue a sub-queue of the parent queue. Buffers enqueued on the
+ *          sub-queue are counted against the parent's capacity & thresholds and the parent's
+ *          empty/low/high/full callbacks are invoked as the aggregate count changes. The sub-queue's
+ *          own high threshold callback (if registered) is still invoked for the sub-queue's count.
+ *
+ * @param   [IN]pSubQ - Pointer to an empty queue previously created/initialized
+ * @param   [IN]pParentQ - Pointer to the aggregate queue
+ *
+ * @return  OSP_STATUS_OK or OSP_STATUS_INVALID_PARAMETER
+ *
+ ***************************************************************************************************/
+int16_t QueueAttachParent( Queue_t *pSubQ, Queue_t *pParentQ )
+{
+    /* Nesting of sub-queues is not supported */
+    if ((pSubQ == pParentQ) || (pSubQ->Size != 0) || (pParentQ->pParent != NULL))
+    {
+        return (OSP_STATUS_INVALID_PARAMETER);
+    }
+
+    pSubQ->pParent = pParentQ;
+    return OSP_STATUS_OK;
+}
+
+
 /****************************************************************************************************
  * @fn      EnQueue
  *          Called by application to enqueue the given buffer in the queue (FIFO order). Note that
@@ -123,18 +172,20 @@ Queue_t *QueueCreate( uint32_t capacity, uint32_t lowThreshold, uint32_t highThr
  ***************************************************************************************************/
 int16_t EnQueue( Queue_t *pMyQ, Buffer_t *pBuf )
 {
+    Queue_t *pSubQ = NULL;
     SETUP_CRITICAL_SECTION();
 
     ENTER_CRITICAL_SECTION();
-    /* Check if queue is already full */
-    if (pMyQ->Size == pMyQ->Capacity)
+    /* Check if queue (or the aggregate queue it belongs to) is already full */
+    if ((pMyQ->Size == pMyQ->Capacity) ||
+        ((pMyQ->pParent != NULL) && (pMyQ->pParent->Size == pMyQ->pParent->Capacity)))
     {
         EXIT_CRITICAL_SECTION();
         return (OSP_STATUS_QUEUE_FULL);
     }
 
     /* Enqueue the buffer */
-    if (pMyQ->Size == 0)
+    if (pMyQ->pHead == NULL)
     {
         pMyQ->pHead = pBuf; //Add to head
     }
@@ -147,6 +198,24 @@ int16_t EnQueue( Queue_t *pMyQ, Buffer_t *pBuf )
     pBuf->Header.pNext = NULL;
     pMyQ->Size++;
 
+    /* For a sub-queue the remaining accounting is done on the aggregate queue */
+    if (pMyQ->pParent != NULL)
+    {
+        pSubQ = pMyQ;
+        pMyQ = pMyQ->pParent;
+        pMyQ->Size++;
+    }
+
+    /* Check for sub-queue high threshold */
+    if ((pSubQ != NULL) && (pSubQ->HighThres < pSubQ->Capacity) && (pSubQ->Size == pSubQ->HighThres) &&
+        (pSubQ->pfCB[QUEUE_HIGH_THRESHOLD_CB] != NULL))
+    {
+        EXIT_CRITICAL_SECTION();
+
+        pSubQ->pfCB[QUEUE_HIGH_THRESHOLD_CB]( pSubQ->pCbArg[QUEUE_HIGH_THRESHOLD_CB] );
+        ENTER_CRITICAL_SECTION();
+    }
+
     /* Check for high threshold */
     if ((pMyQ->HighThres < pMyQ->Capacity) && (pMyQ->Size == pMyQ->HighThres))
     {
@@ -195,7 +264,8 @@ int16_t DeQueue( Queue_t *pMyQ, Buffer_t **pBuf )
     SETUP_CRITICAL_SECTION();
 
     ENTER_CRITICAL_SECTION();
-    if (pMyQ->Size == 0)
+    /* Note: Size of an aggregate queue also counts buffers held on its sub-queues */
+    if (pMyQ->pHead == NULL)
     {
         EXIT_CRITICAL_SECTION();
 
@@ -215,6 +285,13 @@ int16_t DeQueue( Queue_t *pMyQ, Buffer_t **pBuf )
         }
 
         pMyQ->Size--;
+
+        /* For a sub-queue the callbacks are driven by the aggregate queue count */
+        if (pMyQ->pParent != NULL)
+        {
+            pMyQ = pMyQ->pParent;
+            pMyQ->Size--;
+        }
         /* Invoke relevant callbacks... */
         if (pMyQ->Size == 0)
         {
@@ -46,10 +46,15 @@ typedef enum {
     NUM_CB_IDS
 } Q_CBId_t;
 
+/* Macro to compare wrapping deadlines (see BufferHeader_t). Valid for differences < 2^31 units */
+#define M_DeadlineBefore(a,b)           ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+
 /* Buffer structure for use in the queue for forming linked list */
 typedef struct _BufferHeader {
     uint8_t  *pNext;     //Pointer to next buffer
     uint32_t Length;     //Store length of the payload
+    uint32_t Deadline;   //Delivery deadline (application defined wrapping time units) for scheduling
+    uint32_t Arrival;    //Time the data arrived, same units as Deadline, orders buffers by age
 } BufferHeader_t;
 
 typedef struct _Buffer {
@@ -57,7 +62,11 @@ typedef struct _Buffer {
     uint8_t        DataStart;   //Place holder for data payload start
 } Buffer_t;
 
-/* General purpose queue structure. Holds any buffer or packet defined as Buffer_t */
+/* General purpose queue structure. Holds any buffer or packet defined as Buffer_t. A queue may be
+ * attached to a parent (aggregate) queue as a sub-queue: buffers are linked on the sub-queue but
+ * are also counted against the parent's capacity and thresholds, and the parent's callbacks are
+ * invoked as the aggregate count changes.
+ */
 typedef struct _Queue {
     Buffer_t    *pHead;     //Head
     Buffer_t    *pTail;     //Tail
@@ -67,6 +76,7 @@ typedef struct _Queue {
     uint32_t    Size;       //Number of buffers currently on the queue
     fpQueueEvtCallback_t pfCB[NUM_CB_IDS];
     void        *pCbArg[NUM_CB_IDS];
+    struct _Queue *pParent; //Aggregate queue this queue belongs to as a sub-queue (NULL if none)
 } Queue_t;
 
 
@@ -82,6 +92,8 @@ typedef struct _Queue {
  |    P U B L I C   F U N C T I O N   D E C L A R A T I O N S
 \*-------------------------------------------------------------------------------------------------*/
 Queue_t *QueueCreate( uint32_t capacity, uint32_t lowThreshold, uint32_t highThreshold );
+int16_t QueueInitialize( Queue_t *pMyQ, uint32_t capacity, uint32_t lowThreshold, uint32_t highThreshold );
+int16_t QueueAttachParent( Queue_t *pSubQ, Queue_t *pParentQ );
 int16_t EnQueue( Queue_t *myQ, Buffer_t *pBuf );
 int16_t DeQueue( Queue_t *myQ, Buffer_t **pBuf );
 int16_t QueueRegisterCallBack( Queue_t *pMyQ, Q_CBId_t cbid, fpQueueEvtCallback_t pFunc, void *pUser );
@@ -39,6 +39,7 @@
 #define CAUSE_TIMESTAMP_DELAY_REQ    8
 #define GC_RESPONSE_SIZE             3
 #define MAX_CONFIG_CMD_SZ            64  //TBD. Common definition with SPI slave drive
+#define I2C_FLUSH_MAX_SZ             0xFFFF  //Max. Get-Cause data size (16-bit) carrying a FIFO flush
 
 
 /*-------------------------------------------------------------------------------------------------*\
@@ -73,6 +74,7 @@ typedef struct __HOSTIF_Ctrl_t {
     uint8_t rxBuff[RX_LENGTH];   /* Rx buffer */
     uint8_t *txBuff_next;
     uint16_t txLength_next;
+    const Buffer_t *pTxDesc;     /* Current descriptor when streaming a flush transmit list */
 } Hostif_Ctrl_t;
 
 
@@ -85,6 +87,11 @@ static uint32_t _GCBufferSz = sizeof(_GCBuffer);
 static HostGCResponse_t _GCResponse;
 static uint8_t _CtrlReqBuf[MAX_CONFIG_CMD_SZ];
 
+/* FIFO flush streaming */
+static BatchTxList_t _TxList;
+static osp_bool_t _isListTx = FALSE;
+static volatile osp_bool_t _isFlushPending = FALSE;
+
 static Hostif_Ctrl_t g_hostif;
 static i2c_t slave_i2c_handle;
 
@@ -101,6 +108,33 @@ static i2c_t slave_i2c_handle;
  |    P R I V A T E     F U N C T I O N S
 \*-------------------------------------------------------------------------------------------------*/
 
+/****************************************************************************************************
+ * @fn      Hostif_FlushHook
+ *          Batch Manager hook called on a FIFO flush. The next Get-Cause streams the wakeup and
+ *          non-wakeup FIFOs from the flush transmit list in one transfer.
+ *
+ ***************************************************************************************************/
+static void Hostif_FlushHook( void )
+{
+    _isFlushPending = TRUE;
+}
+
+
+/****************************************************************************************************
+ * @fn      Hostif_ReleaseTxList
+ *          Returns the packets of a sent (or abandoned) flush transmit list to the Batch Manager
+ *
+ ***************************************************************************************************/
+static void Hostif_ReleaseTxList( void )
+{
+    if (_isListTx)
+    {
+        BatchManagerReleaseList( &_TxList );
+        _isListTx = FALSE;
+    }
+}
+
+
 /****************************************************************************************************
  * @fn      Hostif_TxNext
  *          This function get calls after a transmit has complete. This function will setup another
@@ -121,9 +155,20 @@ static void Hostif_TxNext(void)
         g_hostif.txLength = g_hostif.txLength_next;
         g_hostif.txBuff_next = NULL;
         g_hostif.txLength_next = 0;
+    } else if ((g_hostif.pTxDesc != NULL) && (g_hostif.pTxDesc->Header.pNext != NULL)) {
+        /* Continue with the next packet of the flush transmit list */
+        g_hostif.pTxDesc = (const Buffer_t *)g_hostif.pTxDesc->Header.pNext;
+        g_hostif.txBuff = M_GetBufferDataStart(g_hostif.pTxDesc);
+        g_hostif.txLength = g_hostif.pTxDesc->Header.Length;
     } else {
         g_hostif.txBuff = NULL;
         g_hostif.txLength = 0;
+
+        /* Last packet of a flush transmit list is sent */
+        if (g_hostif.pTxDesc != NULL) {
+            g_hostif.pTxDesc = NULL;
+            Hostif_ReleaseTxList();
+        }
     }
 
     i_tx_size = g_hostif.txLength > 0 ? g_hostif.txLength -1 : 0;
@@ -147,6 +192,7 @@ static int32_t processHostCommand(uint8_t *rx_buf, uint16_t length, uint8_t i2c_
     MessageBuffer *pData = NULLP;
     uint16_t pktlen;
     uint8_t  packetID;
+    uint8_t  *pGCData = _GCBuffer;
     int16_t  status;
     BatchStateType_t BatchState;
 
@@ -156,10 +202,28 @@ static int32_t processHostCommand(uint8_t *rx_buf, uint16_t length, uint8_t i2c_
     case HOST_GET_CAUSE:
         if(i2c_operation == I2C_READ_IN_PROGRESS)
         {
-            _GCBufferSz = sizeof(_GCBuffer);
-            /* Dequeue Get Cause response packet into local buffer */
-            BatchManagerDeQueue( _GCBuffer, &_GCBufferSz );
-            packetID = GetPacketID( _GCBuffer );
+            /* Host did not read all of previous flush */
+            Hostif_ReleaseTxList();
+
+            if (_isFlushPending)
+            {
+                /* FIFO flush - stream queued packets straight from the pool blocks */
+                _isFlushPending = FALSE;
+                BatchManagerDeQueueList( &_TxList, I2C_FLUSH_MAX_SZ );
+                _isListTx = TRUE;
+                _GCBufferSz = _TxList.TotalLength;
+                if (_TxList.pHead != NULL)
+                {
+                    pGCData = M_GetBufferDataStart( _TxList.pHead );
+                }
+            }
+            else
+            {
+                _GCBufferSz = sizeof(_GCBuffer);
+                /* Dequeue Get Cause response packet into local buffer */
+                BatchManagerDeQueue( _GCBuffer, &_GCBufferSz );
+            }
+            packetID = GetPacketID( pGCData );
 
             if(packetID == PKID_SENSOR_DATA)
             {
@@ -167,12 +231,13 @@ static int32_t processHostCommand(uint8_t *rx_buf, uint16_t length, uint8_t i2c_
             }
             else
             {
-                uint8_t paramId = GetControlParameterID( _GCBuffer );
+                uint8_t paramId = GetControlParameterID( pGCData );
 
                 if (paramId == PARAM_ID_TIME_SYNC_FOLLOW_UP)
                 {
                     _GCResponse.Cause = CAUSE_TIMESTAMP_DELAY_REQ;
                     _GCBufferSz = 0; //No packet transfer needed.
+                    Hostif_ReleaseTxList();
                 }
                 else
                 {
@@ -207,8 +272,17 @@ static int32_t processHostCommand(uint8_t *rx_buf, uint16_t length, uint8_t i2c_
     case HOST_GC_GET_DATA:
         if(i2c_operation == I2C_READ_IN_PROGRESS)
         {
-            /* Dequeue Get Cause data packet into local buffer */
-            Hostif_QueueTx( ( uint8_t *) &(_GCBuffer), (uint16_t)(_GCBufferSz) );
+            if (_isListTx && (_TxList.pHead != NULL))
+            {
+                /* Stream flush transmit list packet by packet; see Hostif_TxNext */
+                Hostif_QueueTx( M_GetBufferDataStart( _TxList.pHead ), (uint16_t)(_TxList.pHead->Header.Length) );
+                g_hostif.pTxDesc = _TxList.pHead;
+            }
+            else
+            {
+                /* Dequeue Get Cause data packet into local buffer */
+                Hostif_QueueTx( ( uint8_t *) &(_GCBuffer), (uint16_t)(_GCBufferSz) );
+            }
         }
         break;
 
@@ -314,6 +388,7 @@ void Hostif_QueueTx(uint8_t *pBuf, uint16_t size)
     i2c_slave_write(&slave_i2c_handle, pBuf, size);
     g_hostif.txLength_next = 0;
     g_hostif.txBuff_next = NULL;
+    g_hostif.pTxDesc = NULL;
 }
 
 
@@ -375,6 +450,9 @@ void Hostif_I2C_Init(void)
     /* Setup slave address to respond to */
     i2c_slave_mode(&slave_i2c_handle,1);
 
+    /* Stream FIFO flushes from the Batch Manager transmit list */
+    BatchManagerRegisterFlushHook( Hostif_FlushHook );
+
     /* init host interrupt pin */
     Chip_GPIO_SetPinDIROutput(LPC_GPIO_PORT, HOSTIF_IRQ_PORT, HOSTIF_IRQ_PIN);
     /* de-assert interrupt line to high to indicate Host/AP that
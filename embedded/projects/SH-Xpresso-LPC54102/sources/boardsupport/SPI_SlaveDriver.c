@@ -55,6 +55,7 @@
 
 /* Misc... */
 #define SPI_TX_BUF_SZ                   256
+#define SPI_FLUSH_MAX_SZ                (64*1024) //Max. length of Get-Cause data carrying a FIFO flush
 #define FIFO_PERM_SZ                    6
 
 /*-------------------------------------------------------------------------------------------------*\
@@ -85,6 +86,7 @@ typedef struct _SPIState
     uint32_t Remain;    //Remaining length to be transmitted/received
     uint16_t Cause;     //Cause identifier for current transaction
     uint32_t BufIdx;    //Current transmit index of SPI buffer
+    osp_bool_t isListTx;//Data is streamed from the flush transmit list instead of SPI buffer
 } SPIState_t;
 
 /*-------------------------------------------------------------------------------------------------*\
@@ -103,6 +105,11 @@ static uint32_t _BufferSz = sizeof(_SpiTxBuffer);
 static uint8_t _ConfigBuffer[MAX_CONFIG_CMD_SZ];
 static uint8_t _ControlRequestBuffer[MAX_CONFIG_CMD_SZ];
 
+/* FIFO flush streaming */
+static BatchTxList_t _TxList;
+static BatchTxCursor_t _TxCursor;
+static volatile osp_bool_t _isFlushPending = FALSE;
+
 
 /*-------------------------------------------------------------------------------------------------*\
  |    F O R W A R D   F U N C T I O N   D E C L A R A T I O N S
@@ -221,6 +228,48 @@ static void SPIResetFIFOandStates( void )
 
     _SpiState.State = SPI_IDLE;
     _TranState = TSTATE_IDLE;
+
+    /* Transaction is over; return flushed packets to the Batch Manager pool */
+    if (_SpiState.isListTx)
+    {
+        BatchManagerReleaseList( &_TxList );
+        _SpiState.isListTx = FALSE;
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      SPIFlushHook
+ *          Batch Manager hook called on a FIFO flush. The next Get-Cause streams the wakeup and
+ *          non-wakeup FIFOs from the flush transmit list in one transaction.
+ *
+ ***************************************************************************************************/
+static void SPIFlushHook( void )
+{
+    _isFlushPending = TRUE;
+}
+
+
+/****************************************************************************************************
+ * @fn      SPIGetTxByte
+ *          Helper routine that returns the next transmit byte from the SPI buffer or flush list
+ *
+ ***************************************************************************************************/
+static uint8_t SPIGetTxByte( void )
+{
+    uint8_t txByte = 0;
+
+    if (_SpiState.isListTx)
+    {
+        BatchManagerTxCursorRead( &_TxCursor, &txByte, 1 );
+    }
+    else
+    {
+        txByte = _SpiTxBuffer[_SpiState.BufIdx];
+    }
+    _SpiState.BufIdx++;
+
+    return txByte;
 }
 
 
@@ -231,18 +280,19 @@ static void SPIResetFIFOandStates( void )
  ***************************************************************************************************/
 void AddDataToFIFO( uint32_t txFifoAvail )
 {
+    uint16_t txDat;
+
     while ((txFifoAvail > 0) && (_SpiState.Remain > 0))
     {
         if ((_SpiState.BufIdx + 1) < _SpiState.BufLength)
         {
-            LPC_FIFO->spi[SPI_IF_IDX].TXDATSPI_DATA = (_SpiTxBuffer[_SpiState.BufIdx] << 8) |
-                _SpiTxBuffer[_SpiState.BufIdx+1];
-            _SpiState.BufIdx += 2;
+            txDat = SPIGetTxByte() << 8;
+            txDat |= SPIGetTxByte();
+            LPC_FIFO->spi[SPI_IF_IDX].TXDATSPI_DATA = txDat;
         }
         else if ((_SpiState.BufIdx + 1) == _SpiState.BufLength)
         {
-            LPC_FIFO->spi[SPI_IF_IDX].TXDATSPI_DATA = (_SpiTxBuffer[_SpiState.BufIdx] << 8);
-            _SpiState.BufIdx += 1;
+            LPC_FIFO->spi[SPI_IF_IDX].TXDATSPI_DATA = (SPIGetTxByte() << 8);
         }
         else if (_SpiState.Remain != 0)
         {
@@ -289,9 +339,21 @@ static void SPI_CommandHandler( uint16_t rcvDat )
         {
             _SpiState.State = SPI_GETCAUSE_T2;
 
-            /* Get packets from application and fill the local transmit buffer */
-            _BufferSz = sizeof(_SpiTxBuffer);
-            BatchManagerDeQueue( _SpiTxBuffer, &_BufferSz );
+            if (_isFlushPending)
+            {
+                /* FIFO flush - stream queued packets straight from the pool blocks */
+                _isFlushPending = FALSE;
+                BatchManagerDeQueueList( &_TxList, SPI_FLUSH_MAX_SZ );
+                BatchManagerTxCursorInit( &_TxCursor, &_TxList );
+                _SpiState.isListTx = TRUE;
+                _BufferSz = _TxList.TotalLength;
+            }
+            else
+            {
+                /* Get packets from application and fill the local transmit buffer */
+                _BufferSz = sizeof(_SpiTxBuffer);
+                BatchManagerDeQueue( _SpiTxBuffer, &_BufferSz );
+            }
             _SpiState.Cause     = CAUSE_SENSOR_DATA_READY;
             _SpiState.BufLength = _BufferSz;
             _SpiState.Remain    = ((_BufferSz + 3)/4) << 1; //16-bit data size in 32-bit multiple
@@ -423,6 +485,9 @@ void SPISlaveSetup( void )
     SPISetupFIFO();
     SPISlaveHardwareSetup();
 
+    /* Stream FIFO flushes from the Batch Manager transmit list */
+    BatchManagerRegisterFlushHook( SPIFlushHook );
+
     /* Setup FIFO interrupt handling. Only RX threshold interrupt is enabled since in
        Slave mode enabling TX threshold with cause continuous interrupt (as observed) */
     Chip_FIFOSPI_EnableInts(LPC_FIFO, SPI_IF_IDX, LPC_PERIPFIFO_INT_RXTH);
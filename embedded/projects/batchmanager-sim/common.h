@@ -0,0 +1,58 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if !defined (COMMON_H)
+#define   COMMON_H
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+/* Host (Linux) replacement of embedded/common/app/common.h for the Batch Manager simulator */
+#include <stdio.h>
+#include <assert.h>
+#include "main.h"
+#include "osp-types.h"
+#include "osp-sensors.h"
+#include "sim_platform.h"
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+/* Critical Section Locks - same semantics as target; the simulated interrupt mask is checked for
+ * balance before the host side (ISR) code runs */
+#define OS_SETUP_CRITICAL()                     int wasMasked
+#define OS_ENTER_CRITICAL()                     wasMasked = SimDisableIrq()
+#define OS_LEAVE_CRITICAL()                     if (!wasMasked) SimEnableIrq()
+
+/* Asserts always abort in the simulator */
+#define ASF_assert( condition )                         assert( condition )
+#define ASF_assert_var( condition, var1, var2, var3 )   assert( condition )
+#define ASF_assert_fatal( condition )                   assert( condition )
+#define ASF_assert_msg( condition, message )            assert( condition )
+
+#define D0_printf( format, ... )        printf( format, ## __VA_ARGS__ )
+#define D1_printf( format, ... )        ((void)0)
+#define D2_printf( format, ... )        ((void)0)
+
+/* Host interrupt line */
+#define SensorHubAssertInt()            SimSetHostInt( 1 )
+#define SensorHubDeAssertInt()          SimSetHostInt( 0 )
+
+#endif /* COMMON_H */
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
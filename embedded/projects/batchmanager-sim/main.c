@@ -0,0 +1,983 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*! \file                                                                    *
+ *                                                                           *
+ *  \brief Scenario driver for the host (Linux) build of the Batch Manager.
+ *
+ *  Replays sensor rates, batch()/report latency settings and host suspend/
+ *  resume timelines against BatchManager.c, BatchState.c, Queue.c and
+ *  BlockMemory.c in simulated time, then reports drop rate, worst case
+ *  latency, packet pool occupancy and bytes per dequeue so that the HIF pool
+ *  sizes and queue thresholds can be tuned offline.
+ *
+ ****************************************************************************/
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "common.h"
+#include "BlockMemory.h"
+#include "SensorPackets.h"
+#include "BatchState.h"
+#include "BatchManager.h"
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+/* Sensor data packet pool of BatchManager.c */
+extern uint32_t SensorDataPacketPool[];
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E   C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+#define MS_TO_NS(ms)                    ( (uint64_t)(ms) * 1000000ULL )
+#define SEC_TO_NS(s)                    ( (uint64_t)(s) * 1000000000ULL )
+#define NS_TO_MS(ns)                    ( (double)(ns) / 1000000.0 )
+
+#define MAX_SIM_SENSORS                 8
+#define MAX_DEQUEUE_BUF_SIZE            4096
+#define MAX_DEQUEUE_PER_SERVICE         100000
+#define MAX_HELD_BLOCKS                 1024
+#define NO_EVENT                        (~0ULL)
+
+#define M_NumElements(a)                ( sizeof(a) / sizeof((a)[0]) )
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E   T Y P E   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+/* How a simulated sensor produces data */
+typedef enum _SimReportMode
+{
+    SIM_CONTINUOUS,                 /* Sample every period, value changes every sample */
+    SIM_ON_CHANGE,                  /* Sample every period, value changes every ChangeEvery samples */
+    SIM_ONE_SHOT,                   /* Event every ChangeEvery periods, nothing in between */
+} SimReportMode_t;
+
+/* Simulated sensor and its batch() request */
+typedef struct _SimSensor
+{
+    ASensorType_t       SensorType;
+    SimReportMode_t     ReportMode;
+    uint64_t            HwPeriodNs;         /* Period the hub produces samples at */
+    uint64_t            SamplingPeriodNs;   /* Requested sampling period */
+    uint64_t            ReportLatencyNs;    /* Requested max. report latency */
+    uint32_t            ChangeEvery;        /* On change/one shot sensors */
+} SimSensor_t;
+
+/* Host timeline */
+typedef enum _SimHostAction
+{
+    HOST_SUSPEND,
+    HOST_RESUME,
+    HOST_FLUSH,
+    HOST_LATENCY,                   /* Host service latency changes, e.g. host gets busy */
+    HOST_POOL_HOLD,                 /* Packet pool taken by others, e.g. a leak, down to FreeBlocks */
+    HOST_POOL_RELEASE,
+} SimHostAction_t;
+
+typedef struct _SimHostEvent
+{
+    uint64_t            TimeNs;
+    SimHostAction_t     Action;
+    ASensorType_t       SensorType;         /* HOST_FLUSH only */
+    uint64_t            LatencyNs;          /* HOST_LATENCY only */
+    uint32_t            FreeBlocks;         /* HOST_POOL_HOLD only */
+} SimHostEvent_t;
+
+typedef struct _SimScenario
+{
+    const char              *pName;
+    const char              *pDescription;
+    uint64_t                DurationNs;
+    uint64_t                HostServiceLatencyNs;   /* Interrupt to first dequeue, host awake */
+    uint64_t                HostResumeLatencyNs;    /* Interrupt to first dequeue, host suspended */
+    uint32_t                DeQueueBufSize;         /* Host transfer buffer size */
+    const SimSensor_t       *pSensors;
+    uint8_t                 NumSensors;
+    const SimHostEvent_t    *pHostEvents;
+    uint8_t                 NumHostEvents;
+} SimScenario_t;
+
+/* Run time state and results of a simulated sensor */
+typedef struct _SimSensorStats
+{
+    uint64_t            NextSampleNs;
+    uint32_t            Decimation;
+    uint32_t            SampleCnt;          /* Samples produced */
+    uint32_t            ChangeCnt;          /* Samples that carried a new value */
+    uint32_t            EnqueueFailCnt;     /* Enqueue returned an error */
+    uint32_t            DeliveredCnt;       /* Data packets received by host */
+    uint32_t            FlushCnt;           /* Flush complete packets received by host */
+    uint32_t            FlushFailCnt;       /* Flush request returned an error */
+    uint64_t            MaxLatencyNs;
+    uint64_t            SumLatencyNs;
+    uint32_t            LateCnt;            /* Data packets delivered after the requested report latency */
+    uint8_t             SensorIdByte;       /* To match received packets */
+    uint8_t             IsPrivate;
+    uint16_t            PacketSize;
+    int32_t             Value;
+} SimSensorStats_t;
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+/* Scenario: host awake, mix of report latencies */
+static const SimSensor_t _StreamSensors[] =
+{
+    { SENSOR_ACCELEROMETER,         SIM_CONTINUOUS, ACC_ACTUAL_SAMPLE_PERIOD,  MS_TO_NS(20),  SEC_TO_NS(1),    0 },
+    { SENSOR_GYROSCOPE,             SIM_CONTINUOUS, GYRO_ACTUAL_SAMPLE_PERIOD, MS_TO_NS(10),  MS_TO_NS(200),   0 },
+    { SENSOR_GEOMAGNETIC_FIELD,     SIM_CONTINUOUS, MAG_ACTUAL_SAMPLE_PERIOD,  MS_TO_NS(40),  0,               0 },
+};
+
+/* Scenario: long batches while host is suspended, wake up events meanwhile */
+static const SimSensor_t _SuspendSensors[] =
+{
+    { SENSOR_ACCELEROMETER,         SIM_CONTINUOUS, ACC_ACTUAL_SAMPLE_PERIOD,       MS_TO_NS(20), SEC_TO_NS(5), 0   },
+    { SENSOR_GAME_ROTATION_VECTOR,  SIM_CONTINUOUS, GAME_ROTN_ACTUAL_SAMPLE_PERIOD, MS_TO_NS(20), SEC_TO_NS(5), 0   },
+    { SENSOR_SIGNIFICANT_MOTION,    SIM_ONE_SHOT,   MS_TO_NS(20),                   MS_TO_NS(20), 0,            250 },
+};
+
+static const SimHostEvent_t _SuspendTimeline[] =
+{
+    { SEC_TO_NS(2),  HOST_SUSPEND, SENSOR_META_DATA },
+    { SEC_TO_NS(20), HOST_RESUME,  SENSOR_META_DATA },
+};
+
+/* Scenario: on change sensor next to a batched stream, with a flush */
+static const SimSensor_t _OnChangeSensors[] =
+{
+    { SENSOR_ACCELEROMETER,         SIM_CONTINUOUS, ACC_ACTUAL_SAMPLE_PERIOD,  MS_TO_NS(20),  SEC_TO_NS(2),   0  },
+    { SENSOR_STEP_COUNTER,          SIM_ON_CHANGE,  MS_TO_NS(20),              MS_TO_NS(20),  SEC_TO_NS(2),   30 },
+};
+
+static const SimHostEvent_t _OnChangeTimeline[] =
+{
+    { SEC_TO_NS(5),  HOST_FLUSH,   SENSOR_ACCELEROMETER },
+};
+
+/* Scenario: host awake, its service latency ramps from 20ms to 160ms and back in 10ms steps */
+static const SimSensor_t _BusyHostSensors[] =
+{
+    { SENSOR_ACCELEROMETER,         SIM_CONTINUOUS, ACC_ACTUAL_SAMPLE_PERIOD,  MS_TO_NS(20),  MS_TO_NS(500),  0 },
+    { SENSOR_GYROSCOPE,             SIM_CONTINUOUS, GYRO_ACTUAL_SAMPLE_PERIOD, MS_TO_NS(20),  SEC_TO_NS(1),   0 },
+};
+
+/* Scenario: step counter flushed with its pending sample while the packet pool is exhausted */
+static const SimSensor_t _PoolOutSensors[] =
+{
+    { SENSOR_ACCELEROMETER,         SIM_CONTINUOUS, ACC_ACTUAL_SAMPLE_PERIOD,  MS_TO_NS(20),  SEC_TO_NS(2),   0  },
+    { SENSOR_STEP_COUNTER,          SIM_ON_CHANGE,  MS_TO_NS(20),              MS_TO_NS(20),  SEC_TO_NS(2),   30 },
+};
+
+static const SimHostEvent_t _PoolOutTimeline[] =
+{
+    { MS_TO_NS(5000), HOST_POOL_HOLD,    SENSOR_META_DATA,    0, 0 },
+    { MS_TO_NS(5000), HOST_FLUSH,        SENSOR_STEP_COUNTER          },
+    { MS_TO_NS(5500), HOST_POOL_HOLD,    SENSOR_META_DATA,    0, 1 },
+    { MS_TO_NS(5500), HOST_FLUSH,        SENSOR_STEP_COUNTER          },
+    { MS_TO_NS(6000), HOST_POOL_RELEASE, SENSOR_META_DATA             },
+};
+
+#define BUSY_STEP(n)    { SEC_TO_NS(5) + (n) * MS_TO_NS(350), HOST_LATENCY, SENSOR_META_DATA, MS_TO_NS(20 + 10 * (n)) }
+#define IDLE_STEP(n)    { SEC_TO_NS(20) + (n) * MS_TO_NS(350), HOST_LATENCY, SENSOR_META_DATA, MS_TO_NS(150 - 10 * (n)) }
+
+static const SimHostEvent_t _BusyHostTimeline[] =
+{
+    BUSY_STEP(1),  BUSY_STEP(2),  BUSY_STEP(3),  BUSY_STEP(4),  BUSY_STEP(5),  BUSY_STEP(6),  BUSY_STEP(7),
+    BUSY_STEP(8),  BUSY_STEP(9),  BUSY_STEP(10), BUSY_STEP(11), BUSY_STEP(12), BUSY_STEP(13), BUSY_STEP(14),
+    IDLE_STEP(0),  IDLE_STEP(1),  IDLE_STEP(2),  IDLE_STEP(3),  IDLE_STEP(4),  IDLE_STEP(5),  IDLE_STEP(6),
+    IDLE_STEP(7),  IDLE_STEP(8),  IDLE_STEP(9),  IDLE_STEP(10), IDLE_STEP(11), IDLE_STEP(12), IDLE_STEP(13),
+};
+
+static const SimScenario_t _Scenarios[] =
+{
+    {
+        "stream", "Host awake; 1s, 200ms and 0 report latency streams",
+        SEC_TO_NS(10), MS_TO_NS(2), MS_TO_NS(50), 256,
+        _StreamSensors, M_NumElements(_StreamSensors), NULL, 0
+    },
+    {
+        "suspend", "5s batches, host suspended 2s-20s, significant motion every 5s",
+        SEC_TO_NS(25), MS_TO_NS(2), MS_TO_NS(50), 256,
+        _SuspendSensors, M_NumElements(_SuspendSensors), _SuspendTimeline, M_NumElements(_SuspendTimeline)
+    },
+    {
+        "onchange", "Step counter next to a 2s accel batch, accel flush at 5s",
+        SEC_TO_NS(10), MS_TO_NS(2), MS_TO_NS(50), 256,
+        _OnChangeSensors, M_NumElements(_OnChangeSensors), _OnChangeTimeline, M_NumElements(_OnChangeTimeline)
+    },
+    {
+        "busyhost", "Host awake, service latency 20ms ramping to 160ms at 5s-10s and back at 20s-25s",
+        SEC_TO_NS(30), MS_TO_NS(20), MS_TO_NS(50), 256,
+        _BusyHostSensors, M_NumElements(_BusyHostSensors), _BusyHostTimeline, M_NumElements(_BusyHostTimeline)
+    },
+    {
+        "poolout", "Step counter flushes at 5s with no free packet and at 5.5s with one, pool back at 6s",
+        SEC_TO_NS(10), MS_TO_NS(2), MS_TO_NS(50), 256,
+        _PoolOutSensors, M_NumElements(_PoolOutSensors), _PoolOutTimeline, M_NumElements(_PoolOutTimeline)
+    },
+};
+
+static SimSensorStats_t _Stats[MAX_SIM_SENSORS];
+static uint8_t  _DeQueueBuf[MAX_DEQUEUE_BUF_SIZE];
+static osp_bool_t _HostSuspended = FALSE;
+static uint64_t _HostServiceNs   = NO_EVENT;
+static uint64_t _HostServiceLatencyNs;
+static uint64_t _LatencyGuardNs   = 0;
+static osp_bool_t _isListMode     = FALSE;
+static osp_bool_t _isFlushPending = FALSE;
+static void     *_HeldBlocks[MAX_HELD_BLOCKS];
+static uint32_t _NumHeldBlocks;
+
+/* Overall results */
+static uint32_t _DeQueueCnt;
+static uint64_t _DeQueueBytes;
+static uint32_t _MaxDeQueueBytes;
+static uint32_t _HostServiceCnt;
+static uint32_t _PoolTotal;
+static uint32_t _PoolPeakUsed;
+static uint64_t _PoolUsedSum;
+static uint32_t _PoolSampleCnt;
+static uint32_t _UnknownPktCnt;
+static uint32_t _ListDeQueueCnt;
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P R I V A T E     F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/****************************************************************************************************
+ * @fn      FormatSimSample
+ *          Formats a HIF packet for the simulated sensor the same way the host interface task does
+ *
+ * @param   [IN]  pSensor - Simulated sensor
+ * @param   [IN]  tsNs    - Sample time stamp
+ * @param   [IN]  value   - Sample value
+ * @param   [OUT] pPacket - Formatted packet
+ *
+ * @return  Packet size or -Error code
+ *
+ ***************************************************************************************************/
+static int32_t FormatSimSample( const SimSensor_t *pSensor, uint64_t tsNs, int32_t value, HostIFPackets_t *pPacket )
+{
+    switch ( pSensor->SensorType )
+    {
+    case SENSOR_STEP_COUNTER:
+        {
+            StepCounter_t stepCountData;
+
+            stepCountData.TimeStamp.TS64 = tsNs;
+            stepCountData.NumStepsTotal  = (uint64_t)value;
+            return FormatStepCounterPkt( pPacket, &stepCountData, pSensor->SensorType );
+        }
+
+    case SENSOR_SIGNIFICANT_MOTION:
+        {
+            SignificantMotion_t motionData;
+
+            motionData.TimeStamp.TS64 = tsNs;
+            motionData.MotionDetected = 1;
+            return FormatSignificantMotionPktFixP( pPacket, &motionData, pSensor->SensorType );
+        }
+
+    case SENSOR_ROTATION_VECTOR:
+    case SENSOR_GEOMAGNETIC_ROTATION_VECTOR:
+    case SENSOR_GAME_ROTATION_VECTOR:
+        {
+            QuaternionFixP_t quatFixPData;
+
+            quatFixPData.TimeStamp.TS64 = tsNs;
+            quatFixPData.Quat[0] = value;
+            quatFixPData.Quat[1] = -value;
+            quatFixPData.Quat[2] = value;
+            quatFixPData.Quat[3] = -value;
+            return FormatQuaternionPktFixP( pPacket, &quatFixPData, pSensor->SensorType );
+        }
+
+    default:
+        {
+            CalibratedFixP_t calFixPData;
+
+            calFixPData.TimeStamp.TS64 = tsNs;
+            calFixPData.Axis[0] = value;
+            calFixPData.Axis[1] = -value;
+            calFixPData.Axis[2] = value;
+            return FormatCalibratedPktFixP( pPacket, &calFixPData, pSensor->SensorType );
+        }
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      FindSimSensor
+ *          Finds the simulated sensor a received packet belongs to
+ *
+ ***************************************************************************************************/
+static int FindSimSensor( const SimScenario_t *pScenario, const uint8_t *pPkt )
+{
+    int i;
+
+    for ( i = 0; i < pScenario->NumSensors; i++ )
+    {
+        if ( ( _Stats[i].SensorIdByte == pPkt[PKT_SENSOR_ID_BYTE_OFFSET] ) &&
+             ( _Stats[i].IsPrivate == GetAndroidOrPrivateField( pPkt ) ) )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/****************************************************************************************************
+ * @fn      ReadTimeStamp64
+ *          Reads the big endian 64-bit time stamp of a sensor data packet
+ *
+ ***************************************************************************************************/
+static uint64_t ReadTimeStamp64( const uint8_t *pPkt )
+{
+    uint64_t ts = 0;
+    int i;
+
+    for ( i = 0; i < TIME_STAMP_64_BIT_SIZE_IN_BYTES; i++ )
+    {
+        ts = ( ts << 8 ) | pPkt[PKT_TIMESTAMP_OFFSET + i];
+    }
+    return ts;
+}
+
+
+/****************************************************************************************************
+ * @fn      SamplePoolOccupancy
+ *          Records sensor data packet pool occupancy
+ *
+ ***************************************************************************************************/
+static void SamplePoolOccupancy( void )
+{
+    uint32_t used;
+
+    GetPoolStats( SensorDataPacketPool, &_PoolTotal, &used );
+
+    if ( used > _PoolPeakUsed )
+    {
+        _PoolPeakUsed = used;
+    }
+    _PoolUsedSum += used;
+    _PoolSampleCnt++;
+}
+
+
+/****************************************************************************************************
+ * @fn      HostReceive
+ *          Splits a dequeued buffer into packets and accounts them to their sensors
+ *
+ ***************************************************************************************************/
+static void HostReceive( const SimScenario_t *pScenario, const uint8_t *pBuf, uint32_t length )
+{
+    uint32_t offset = 0;
+    uint64_t latency;
+    int idx;
+
+    while ( offset < length )
+    {
+        const uint8_t *pPkt = pBuf + offset;
+
+        idx = FindSimSensor( pScenario, pPkt );
+        if ( ( idx < 0 ) || ( GetPacketID( pPkt ) != PKID_SENSOR_DATA ) )
+        {
+            /* Cannot find the size of an unknown packet; drop rest of buffer */
+            _UnknownPktCnt++;
+            return;
+        }
+
+        if ( GetSensorDataFlushStatus( pPkt ) )
+        {
+            _Stats[idx].FlushCnt++;
+            offset += SENSOR_DATA_PKT_HEADER_SIZE;
+            continue;
+        }
+
+        latency = SimGetTimeNs() - ReadTimeStamp64( pPkt );
+        if ( ( pScenario->pSensors[idx].ReportLatencyNs != 0 ) && ( latency > pScenario->pSensors[idx].ReportLatencyNs ) )
+        {
+            _Stats[idx].LateCnt++;
+        }
+        _Stats[idx].DeliveredCnt++;
+        _Stats[idx].SumLatencyNs += latency;
+        if ( latency > _Stats[idx].MaxLatencyNs )
+        {
+            _Stats[idx].MaxLatencyNs = latency;
+        }
+        offset += _Stats[idx].PacketSize;
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      SimFlushHook
+ *          Batch Manager flush hook; next host transfer carries both sensor FIFOs
+ *
+ ***************************************************************************************************/
+static void SimFlushHook( void )
+{
+    _isFlushPending = TRUE;
+}
+
+
+/****************************************************************************************************
+ * @fn      DeQueueTxList
+ *          Dequeues a flush transmit list and streams it into the host buffer as the bus drivers do
+ *
+ ***************************************************************************************************/
+static uint32_t DeQueueTxList( void )
+{
+    BatchTxList_t txList;
+    BatchTxCursor_t cursor;
+    uint32_t length;
+
+    BatchManagerDeQueueList( &txList, MAX_DEQUEUE_BUF_SIZE );
+    BatchManagerTxCursorInit( &cursor, &txList );
+    length = BatchManagerTxCursorRead( &cursor, _DeQueueBuf, MAX_DEQUEUE_BUF_SIZE );
+    ASF_assert( length == txList.TotalLength );
+    BatchManagerReleaseList( &txList );
+    _ListDeQueueCnt++;
+
+    return length;
+}
+
+
+/****************************************************************************************************
+ * @fn      HostService
+ *          Host side of the interface: dequeues one transfer buffer at a time while the interrupt
+ *          is asserted, as the SPI/I2C host drivers do
+ *
+ ***************************************************************************************************/
+static void HostService( const SimScenario_t *pScenario )
+{
+    uint32_t length;
+    uint32_t count = 0;
+
+    /* Host interface ISR never runs with interrupts masked */
+    ASF_assert( !SimIsIrqMasked() );
+
+    _HostServiceCnt++;
+
+    while ( SimGetHostInt() && ( count++ < MAX_DEQUEUE_PER_SERVICE ) )
+    {
+        if ( _isFlushPending )
+        {
+            _isFlushPending = FALSE;
+            length = DeQueueTxList();
+        }
+        else
+        {
+            length = pScenario->DeQueueBufSize;
+            BatchManagerDeQueue( _DeQueueBuf, &length );
+        }
+
+        if ( length == 0 )
+        {
+            break;
+        }
+
+        _DeQueueCnt++;
+        _DeQueueBytes += length;
+        if ( length > _MaxDeQueueBytes )
+        {
+            _MaxDeQueueBytes = length;
+        }
+        HostReceive( pScenario, _DeQueueBuf, length );
+    }
+    ASF_assert( count < MAX_DEQUEUE_PER_SERVICE );
+}
+
+
+/****************************************************************************************************
+ * @fn      ScheduleHostService
+ *          Schedules host service of an asserted interrupt after the host's response latency
+ *
+ ***************************************************************************************************/
+static void ScheduleHostService( const SimScenario_t *pScenario )
+{
+    if ( SimGetHostInt() && ( _HostServiceNs == NO_EVENT ) )
+    {
+        _HostServiceNs = SimGetHostIntAssertTimeNs() +
+            ( _HostSuspended ? pScenario->HostResumeLatencyNs : _HostServiceLatencyNs );
+
+        if ( _HostServiceNs < SimGetTimeNs() )
+        {
+            _HostServiceNs = SimGetTimeNs();
+        }
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      HoldPoolBlocks
+ *          Takes sensor data packets from the pool until only the given number is left
+ *
+ ***************************************************************************************************/
+static void HoldPoolBlocks( uint32_t freeBlocks )
+{
+    uint32_t total;
+    uint32_t used;
+
+    GetPoolStats( SensorDataPacketPool, &total, &used );
+    while ( ( total - used ) < freeBlocks )
+    {
+        ASF_assert( _NumHeldBlocks > 0 );
+        FreeBlock( SensorDataPacketPool, _HeldBlocks[--_NumHeldBlocks] );
+        used--;
+    }
+    while ( ( total - used ) > freeBlocks )
+    {
+        ASF_assert( _NumHeldBlocks < MAX_HELD_BLOCKS );
+        _HeldBlocks[_NumHeldBlocks] = AllocBlock( SensorDataPacketPool );
+        ASF_assert( _HeldBlocks[_NumHeldBlocks] != NULL );
+        _NumHeldBlocks++;
+        used++;
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      FindSimSensorType
+ *          Finds the simulated sensor of a sensor type
+ *
+ ***************************************************************************************************/
+static int FindSimSensorType( const SimScenario_t *pScenario, ASensorType_t sensorType )
+{
+    int i;
+
+    for ( i = 0; i < pScenario->NumSensors; i++ )
+    {
+        if ( pScenario->pSensors[i].SensorType == sensorType )
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/****************************************************************************************************
+ * @fn      HostAction
+ *          Executes a host timeline event the way the host interface drivers/config manager do
+ *
+ ***************************************************************************************************/
+static void HostAction( const SimScenario_t *pScenario, const SimHostEvent_t *pEvent )
+{
+    HostIFPackets_t packet;
+    FifoQ_Type_t qType;
+    int32_t length;
+    int16_t status;
+    int idx;
+
+    switch ( pEvent->Action )
+    {
+    case HOST_SUSPEND:
+        _HostSuspended = TRUE;
+        status = BatchStateSet( BATCH_ACTIVE_HOST_SUSPEND );
+        ASF_assert( status == OSP_STATUS_OK );
+        break;
+
+    case HOST_RESUME:
+        _HostSuspended = FALSE;
+        status = BatchStateSet( BATCH_ACTIVE );
+        ASF_assert( status == OSP_STATUS_OK );
+
+        /* Host collects data batched while it was suspended */
+        BatchManagerQueueFlush( QUEUE_NONWAKEUP_TYPE );
+        break;
+
+    case HOST_FLUSH:
+        length = FormatFlushCompletePacket( &packet, pEvent->SensorType );
+        ASF_assert( length > 0 );
+        status = BatchManagerSensorDataEnQueue( &packet, (uint16_t)length, pEvent->SensorType );
+        if ( status != OSP_STATUS_OK )
+        {
+            idx = FindSimSensorType( pScenario, pEvent->SensorType );
+            ASF_assert( idx >= 0 );
+            _Stats[idx].FlushFailCnt++;
+        }
+        BatchManagerGetSensorQueueType( pEvent->SensorType, &qType );
+        BatchManagerQueueFlush( qType );
+        break;
+
+    case HOST_LATENCY:
+        _HostServiceLatencyNs = pEvent->LatencyNs;
+        break;
+
+    case HOST_POOL_HOLD:
+        HoldPoolBlocks( pEvent->FreeBlocks );
+        break;
+
+    case HOST_POOL_RELEASE:
+        while ( _NumHeldBlocks > 0 )
+        {
+            FreeBlock( SensorDataPacketPool, _HeldBlocks[--_NumHeldBlocks] );
+        }
+        break;
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      ProduceSample
+ *          Produces the next sample of a simulated sensor and hands it to the Batch Manager
+ *
+ ***************************************************************************************************/
+static void ProduceSample( const SimSensor_t *pSensor, SimSensorStats_t *pStats )
+{
+    HostIFPackets_t packet;
+    int32_t length;
+    int16_t status;
+    osp_bool_t isChange = TRUE;
+
+    switch ( pSensor->ReportMode )
+    {
+    case SIM_ON_CHANGE:
+        isChange = ( ( pStats->SampleCnt % pSensor->ChangeEvery ) == 0 ) ? TRUE : FALSE;
+        break;
+
+    case SIM_ONE_SHOT:
+        if ( ( ( pStats->SampleCnt + 1 ) % pSensor->ChangeEvery ) != 0 )
+        {
+            pStats->SampleCnt++;
+            return;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    pStats->SampleCnt++;
+    if ( isChange )
+    {
+        pStats->ChangeCnt++;
+        pStats->Value++;
+    }
+
+    length = FormatSimSample( pSensor, SimGetTimeNs(), pStats->Value, &packet );
+    ASF_assert( length > 0 );
+
+    status = BatchManagerSensorDataEnQueue( &packet, (uint16_t)length, pSensor->SensorType );
+    if ( status != OSP_STATUS_OK )
+    {
+        pStats->EnqueueFailCnt++;
+    }
+
+    SamplePoolOccupancy();
+}
+
+
+/****************************************************************************************************
+ * @fn      SetupSensors
+ *          Initializes the Batch Manager and sets up the scenario's sensors as the config manager
+ *          does for batch() and enable requests
+ *
+ ***************************************************************************************************/
+static void SetupSensors( const SimScenario_t *pScenario )
+{
+    HostIFPackets_t packet;
+    const SimSensor_t *pSensor;
+    uint64_t period;
+    uint64_t reportLatency;
+    int32_t length;
+    int16_t status;
+    uint8_t i;
+
+    status = BatchStateInitialize();
+    ASF_assert( status == OSP_STATUS_OK );
+    status = BatchStateSet( BATCH_IDLE );
+    ASF_assert( status == OSP_STATUS_OK );
+    status = BatchManagerInitialize();
+    ASF_assert( status == OSP_STATUS_OK );
+
+    for ( i = 0; i < pScenario->NumSensors; i++ )
+    {
+        pSensor = &pScenario->pSensors[i];
+
+        /* A latency guard is taken off the request, as done to meet deadlines with fixed moderation */
+        reportLatency = pSensor->ReportLatencyNs;
+        if ( reportLatency > _LatencyGuardNs )
+        {
+            reportLatency -= _LatencyGuardNs;
+        }
+        status = BatchManagerSensorRegister( pSensor->SensorType, pSensor->SamplingPeriodNs, reportLatency );
+        ASF_assert( status == OSP_STATUS_OK );
+        status = BatchManagerSensorEnable( pSensor->SensorType );
+        ASF_assert( status == OSP_STATUS_OK );
+
+        /* Decimation as applied by the Batch Manager */
+        period = ( pSensor->SamplingPeriodNs > pSensor->HwPeriodNs ) ? pSensor->SamplingPeriodNs : pSensor->HwPeriodNs;
+        _Stats[i].Decimation   = ( pSensor->ReportMode == SIM_CONTINUOUS ) ? (uint32_t)( period / pSensor->HwPeriodNs ) : 1;
+        _Stats[i].NextSampleNs = pSensor->HwPeriodNs;
+
+        /* Packet identification for the receive side */
+        length = FormatSimSample( pSensor, 0, 0, &packet );
+        ASF_assert( length > 0 );
+        _Stats[i].SensorIdByte = ((uint8_t *)&packet)[PKT_SENSOR_ID_BYTE_OFFSET];
+        _Stats[i].IsPrivate    = GetAndroidOrPrivateField( (uint8_t *)&packet );
+        _Stats[i].PacketSize   = (uint16_t)length;
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      RunScenario
+ *          Runs the scenario in simulated time
+ *
+ ***************************************************************************************************/
+static void RunScenario( const SimScenario_t *pScenario )
+{
+    uint64_t now;
+    uint64_t next;
+    uint8_t hostEventIdx = 0;
+    uint8_t i;
+
+    _HostServiceLatencyNs = pScenario->HostServiceLatencyNs;
+    SetupSensors( pScenario );
+
+    for ( ;; )
+    {
+        /* Find next event */
+        next = pScenario->DurationNs;
+        for ( i = 0; i < pScenario->NumSensors; i++ )
+        {
+            if ( _Stats[i].NextSampleNs < next )
+            {
+                next = _Stats[i].NextSampleNs;
+            }
+        }
+        if ( ( hostEventIdx < pScenario->NumHostEvents ) && ( pScenario->pHostEvents[hostEventIdx].TimeNs < next ) )
+        {
+            next = pScenario->pHostEvents[hostEventIdx].TimeNs;
+        }
+        if ( _HostServiceNs < next )
+        {
+            next = _HostServiceNs;
+        }
+
+        if ( next >= pScenario->DurationNs )
+        {
+            break;
+        }
+
+        SimSetTimeNs( next );
+        now = next;
+
+        while ( ( hostEventIdx < pScenario->NumHostEvents ) && ( pScenario->pHostEvents[hostEventIdx].TimeNs == now ) )
+        {
+            HostAction( pScenario, &pScenario->pHostEvents[hostEventIdx++] );
+        }
+
+        for ( i = 0; i < pScenario->NumSensors; i++ )
+        {
+            if ( _Stats[i].NextSampleNs == now )
+            {
+                ProduceSample( &pScenario->pSensors[i], &_Stats[i] );
+                _Stats[i].NextSampleNs += pScenario->pSensors[i].HwPeriodNs;
+            }
+        }
+
+        if ( _HostServiceNs == now )
+        {
+            _HostServiceNs = NO_EVENT;
+            HostService( pScenario );
+        }
+        ScheduleHostService( pScenario );
+    }
+
+    /* End of scenario: host wakes up and collects everything still batched */
+    SimSetTimeNs( pScenario->DurationNs );
+    if ( _HostSuspended )
+    {
+        SimHostEvent_t resume = { pScenario->DurationNs, HOST_RESUME, SENSOR_META_DATA };
+        HostAction( pScenario, &resume );
+    }
+    BatchManagerQueueFlush( QUEUE_NONWAKEUP_TYPE );
+    BatchManagerQueueFlush( QUEUE_WAKEUP_TYPE );
+    HostService( pScenario );
+}
+
+
+/****************************************************************************************************
+ * @fn      PrintResults
+ *          Prints the scenario results
+ *
+ ***************************************************************************************************/
+static void PrintResults( const SimScenario_t *pScenario )
+{
+    const SimSensor_t *pSensor;
+    SimSensorStats_t *pStats;
+    BatchIntStats_t intStats;
+    uint32_t expected;
+    uint32_t totalExpected = 0;
+    uint32_t totalDelivered = 0;
+    uint32_t totalLate = 0;
+    uint32_t totalFlushFail = 0;
+    uint64_t worstLatency = 0;
+    uint8_t i;
+
+    printf( "\nScenario '%s': %s\n", pScenario->pName, pScenario->pDescription );
+    printf( "%-8s %8s %9s %9s %9s %7s %6s %10s %10s\n", "sensor", "samples", "expected", "delivered",
+            "lost", "lost%", "flush", "avg-ms", "worst-ms" );
+
+    for ( i = 0; i < pScenario->NumSensors; i++ )
+    {
+        pSensor = &pScenario->pSensors[i];
+        pStats  = &_Stats[i];
+
+        /* Streams expect every decimated sample, on change and one shot sensors every new value */
+        expected = ( pSensor->ReportMode == SIM_CONTINUOUS ) ?
+                   ( pStats->SampleCnt + pStats->Decimation - 1 ) / pStats->Decimation : pStats->ChangeCnt;
+
+        printf( "%-8d %8u %9u %9u %9d %6.2f%% %6u %10.2f %10.2f\n", pSensor->SensorType, pStats->SampleCnt, expected,
+                pStats->DeliveredCnt, (int)( expected - pStats->DeliveredCnt ),
+                expected ? ( 100.0 * ( (double)expected - pStats->DeliveredCnt ) / expected ) : 0.0,
+                pStats->FlushCnt,
+                pStats->DeliveredCnt ? NS_TO_MS( pStats->SumLatencyNs / pStats->DeliveredCnt ) : 0.0,
+                NS_TO_MS( pStats->MaxLatencyNs ) );
+
+        totalExpected  += expected;
+        totalDelivered += pStats->DeliveredCnt;
+        totalLate      += pStats->LateCnt;
+        totalFlushFail += pStats->FlushFailCnt;
+        if ( pStats->MaxLatencyNs > worstLatency )
+        {
+            worstLatency = pStats->MaxLatencyNs;
+        }
+    }
+
+    BatchManagerGetIntStats( &intStats );
+
+    printf( "\nDrop/coalesce rate  : %.2f%% (%u of %u)\n",
+            totalExpected ? ( 100.0 * ( (double)totalExpected - totalDelivered ) / totalExpected ) : 0.0,
+            totalExpected - totalDelivered, totalExpected );
+    printf( "Worst case latency  : %.2f ms\n", NS_TO_MS( worstLatency ) );
+    printf( "Packet pool         : peak %u / %u blocks, mean %.1f\n", _PoolPeakUsed, _PoolTotal,
+            _PoolSampleCnt ? (double)_PoolUsedSum / _PoolSampleCnt : 0.0 );
+    printf( "Dequeues            : %u, %.1f bytes/dequeue (max %u of %u)\n", _DeQueueCnt,
+            _DeQueueCnt ? (double)_DeQueueBytes / _DeQueueCnt : 0.0, _MaxDeQueueBytes, pScenario->DeQueueBufSize );
+    printf( "Host services       : %u, host wake-ups %u, deadline misses %u\n", _HostServiceCnt,
+            intStats.HostWakeups, intStats.DeadlineMisses );
+    printf( "Late packets        : %.2f%% (%u of %u) after the requested report latency\n",
+            totalDelivered ? ( 100.0 * totalLate / totalDelivered ) : 0.0, totalLate, totalDelivered );
+    if ( _isListMode )
+    {
+        printf( "Flush list transfers: %u\n", _ListDeQueueCnt );
+    }
+    if ( totalFlushFail )
+    {
+        printf( "Flush errors        : %u flush requests returned an error\n", totalFlushFail );
+    }
+    if ( _UnknownPktCnt )
+    {
+        printf( "Unknown packets     : %u\n", _UnknownPktCnt );
+    }
+}
+
+
+/****************************************************************************************************
+ * @fn      PrintUsage
+ *
+ ***************************************************************************************************/
+static void PrintUsage( const char *pProgName )
+{
+    uint8_t i;
+
+    printf( "Usage: %s [-fixed] [-guard <ms>] [-list] <scenario>\n", pProgName );
+    printf( "  -fixed   use fixed host interrupt moderation\n" );
+    printf( "  -guard   take <ms> off every report latency request\n" );
+    printf( "  -list    carry FIFO flushes in one transfer from the flush transmit list\n" );
+    printf( "Scenarios:\n" );
+    for ( i = 0; i < M_NumElements(_Scenarios); i++ )
+    {
+        printf( "  %-10s %s\n", _Scenarios[i].pName, _Scenarios[i].pDescription );
+    }
+}
+
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C     F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+int main( int argc, char **argv )
+{
+    const SimScenario_t *pScenario = NULL;
+    osp_bool_t isFixedModeration = FALSE;
+    int argIdx;
+    uint8_t i;
+
+    for ( argIdx = 1; argIdx < argc; argIdx++ )
+    {
+        if ( strcmp( argv[argIdx], "-fixed" ) == 0 )
+        {
+            isFixedModeration = TRUE;
+            continue;
+        }
+        if ( ( strcmp( argv[argIdx], "-guard" ) == 0 ) && ( ( argIdx + 1 ) < argc ) )
+        {
+            _LatencyGuardNs = MS_TO_NS( strtoul( argv[++argIdx], NULL, 10 ) );
+            continue;
+        }
+        if ( strcmp( argv[argIdx], "-list" ) == 0 )
+        {
+            _isListMode = TRUE;
+            continue;
+        }
+
+        for ( i = 0; i < M_NumElements(_Scenarios); i++ )
+        {
+            if ( strcmp( argv[argIdx], _Scenarios[i].pName ) == 0 )
+            {
+                pScenario = &_Scenarios[i];
+            }
+        }
+    }
+
+    /* Batch Manager can only be initialized once per process, so one scenario per run */
+    if ( pScenario == NULL )
+    {
+        PrintUsage( argv[0] );
+        return 1;
+    }
+
+    ASF_assert( pScenario->NumSensors <= MAX_SIM_SENSORS );
+    ASF_assert( pScenario->DeQueueBufSize <= MAX_DEQUEUE_BUF_SIZE );
+
+    if ( isFixedModeration )
+    {
+        BatchManagerSetIntModeration( BATCH_INT_MODERATION_FIXED );
+    }
+
+    if ( _isListMode )
+    {
+        BatchManagerRegisterFlushHook( SimFlushHook );
+    }
+
+    RunScenario( pScenario );
+    PrintResults( pScenario );
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
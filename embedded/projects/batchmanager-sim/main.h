@@ -0,0 +1,85 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if !defined (MAIN_H)
+#define   MAIN_H
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include "osp-types.h"
+#include <stddef.h>
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    C O N S T A N T S   &   M A C R O S
+\*-------------------------------------------------------------------------------------------------*/
+/* Sensor rates of the simulated hub; keep in step with the target project main.h */
+#define MAG_DECIMATE_FACTOR                1
+#define ACCEL_SAMPLE_DECIMATE              1
+#define GYRO_SAMPLE_DECIMATE               1
+#define PRESSURE_SAMPLE_DECIMATE           1
+
+#define MAG_SAMPLE_RATE                    25    // in HZ
+#define ACC_SAMPLE_RATE                    63   // 62.5HZ
+#define GYRO_SAMPLE_RATE                   100
+#define PRESSURE_SAMPLE_RATE               25
+#define GEOMAG_SAMPLE_RATE                 25
+#define GAME_ROTATION_SAMPLE_RATE          50
+#define ON_CHANGE_SAMPLE_RATE              0
+
+
+#define MAG_SAMPLE_PERIOD                  ( 1000000000UL / MAG_SAMPLE_RATE           )    // in ns
+#define ACC_SAMPLE_PERIOD                  ( 1000000000UL / ACC_SAMPLE_RATE           )
+#define GYRO_SAMPLE_PERIOD                 ( 1000000000UL / GYRO_SAMPLE_RATE          )
+#define PRES_SAMPLE_PERIOD                 ( 1000000000UL / PRESSURE_SAMPLE_RATE      )
+#define GEOMAG_SAMPLE_PERIOD               ( 1000000000UL / GEOMAG_SAMPLE_RATE        )
+#define GAME_ROTATION_SAMPLE_PERIOD        ( 1000000000UL / GAME_ROTATION_SAMPLE_RATE )
+#define ON_CHANGE_SAMPLE_PERIOD            (0)
+
+#define MAG_ACTUAL_SAMPLE_PERIOD           ( MAG_SAMPLE_PERIOD   *  MAG_DECIMATE_FACTOR       )
+#define ACC_ACTUAL_SAMPLE_PERIOD           ( ACC_SAMPLE_PERIOD   *  ACCEL_SAMPLE_DECIMATE     )
+#define GYRO_ACTUAL_SAMPLE_PERIOD          ( GYRO_SAMPLE_PERIOD  *  GYRO_SAMPLE_DECIMATE      )
+#define PRES_ACTUAL_SAMPLE_PERIOD          ( PRES_SAMPLE_PERIOD  *  PRESSURE_SAMPLE_DECIMATE  )
+#define GEOMAG_ACTUAL_SAMPLE_PERIOD        ( GEOMAG_SAMPLE_PERIOD                             )
+#define GAME_ROTN_ACTUAL_SAMPLE_PERIOD     ( GAME_ROTATION_SAMPLE_PERIOD                      )
+
+/* Simulated 32KHz RTC */
+#define RTC_TICK_NS_INT                    30518
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    T Y P E   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+/* Queues (FIFOs) used in the Sensor Hub */
+typedef enum
+{
+    QUEUE_WAKEUP_TYPE,              //Queue for wakeup sensor packets
+    QUEUE_NONWAKEUP_TYPE,           //Queue for non-wakeup sensor packets
+    QUEUE_CONTROL_RESPONSE_TYPE,    //Queue for Control Response packets
+    NUM_QUEUE_TYPE
+} FifoQ_Type_t;
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+/* RTC Counter (simulated time) */
+uint32_t RTC_GetCounter( void );
+uint64_t RTC_GetCounter64( void );
+
+#endif /* MAIN_H */
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
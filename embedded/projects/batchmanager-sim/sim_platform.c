@@ -0,0 +1,163 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include "common.h"
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    S T A T I C   V A R I A B L E S   D E F I N I T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+static uint64_t _SimTimeNs         = 0;
+static int      _SimIrqMasked      = 0;
+static int      _SimHostIntLevel   = 0;
+static uint64_t _SimHostIntAssertNs = 0;
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C     F U N C T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+
+/****************************************************************************************************
+ * @fn      SimSetTimeNs
+ *          Advances the simulated time. Time never goes backwards.
+ *
+ * @param   [IN] nsTime - New simulated time in ns
+ *
+ * @return  none
+ *
+ ***************************************************************************************************/
+void SimSetTimeNs( uint64_t nsTime )
+{
+    ASF_assert( nsTime >= _SimTimeNs );
+    _SimTimeNs = nsTime;
+}
+
+
+/****************************************************************************************************
+ * @fn      SimGetTimeNs
+ *          Returns the simulated time in ns
+ *
+ ***************************************************************************************************/
+uint64_t SimGetTimeNs( void )
+{
+    return _SimTimeNs;
+}
+
+
+/****************************************************************************************************
+ * @fn      RTC_GetCounter
+ *          Simulated 32KHz RTC counter (lower 32 bits)
+ *
+ ***************************************************************************************************/
+uint32_t RTC_GetCounter( void )
+{
+    return (uint32_t)( _SimTimeNs / RTC_TICK_NS_INT );
+}
+
+
+/****************************************************************************************************
+ * @fn      RTC_GetCounter64
+ *          Simulated 32KHz RTC counter
+ *
+ ***************************************************************************************************/
+uint64_t RTC_GetCounter64( void )
+{
+    return ( _SimTimeNs / RTC_TICK_NS_INT );
+}
+
+
+/****************************************************************************************************
+ * @fn      SimDisableIrq
+ *          Masks simulated interrupts
+ *
+ * @return  Previous mask state, same as __disable_irq() on target
+ *
+ ***************************************************************************************************/
+int SimDisableIrq( void )
+{
+    int wasMasked = _SimIrqMasked;
+
+    _SimIrqMasked = 1;
+    return wasMasked;
+}
+
+
+/****************************************************************************************************
+ * @fn      SimEnableIrq
+ *          Unmasks simulated interrupts
+ *
+ ***************************************************************************************************/
+void SimEnableIrq( void )
+{
+    _SimIrqMasked = 0;
+}
+
+
+/****************************************************************************************************
+ * @fn      SimIsIrqMasked
+ *          Returns non-zero if simulated interrupts are masked
+ *
+ ***************************************************************************************************/
+int SimIsIrqMasked( void )
+{
+    return _SimIrqMasked;
+}
+
+
+/****************************************************************************************************
+ * @fn      SimSetHostInt
+ *          Drives the simulated host interrupt line, noting the time of each assertion
+ *
+ * @param   [IN] level - 1 to assert, 0 to deassert
+ *
+ ***************************************************************************************************/
+void SimSetHostInt( int level )
+{
+    if ( level && !_SimHostIntLevel )
+    {
+        _SimHostIntAssertNs = _SimTimeNs;
+    }
+    _SimHostIntLevel = level;
+}
+
+
+/****************************************************************************************************
+ * @fn      SimGetHostInt
+ *          Returns the simulated host interrupt line level
+ *
+ ***************************************************************************************************/
+int SimGetHostInt( void )
+{
+    return _SimHostIntLevel;
+}
+
+
+/****************************************************************************************************
+ * @fn      SimGetHostIntAssertTimeNs
+ *          Returns the simulated time the host interrupt was last asserted
+ *
+ ***************************************************************************************************/
+uint64_t SimGetHostIntAssertTimeNs( void )
+{
+    return _SimHostIntAssertNs;
+}
+
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
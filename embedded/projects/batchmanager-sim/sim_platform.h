@@ -0,0 +1,46 @@
+/* Open Sensor Platform Project
+ * https://github.com/sensorplatforms/open-sensor-platform
+ *
+ * Copyright (C) 2015 Audience Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#if !defined (SIM_PLATFORM_H)
+#define   SIM_PLATFORM_H
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    I N C L U D E   F I L E S
+\*-------------------------------------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*-------------------------------------------------------------------------------------------------*\
+ |    P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+\*-------------------------------------------------------------------------------------------------*/
+/* Simulated time */
+void     SimSetTimeNs( uint64_t nsTime );
+uint64_t SimGetTimeNs( void );
+
+/* Simulated interrupt mask used by the critical section macros */
+int      SimDisableIrq( void );
+void     SimEnableIrq( void );
+int      SimIsIrqMasked( void );
+
+/* Simulated host interrupt line */
+void     SimSetHostInt( int level );
+int      SimGetHostInt( void );
+uint64_t SimGetHostIntAssertTimeNs( void );
+
+#endif /* SIM_PLATFORM_H */
+/*-------------------------------------------------------------------------------------------------*\
+ |    E N D   O F   F I L E
+\*-------------------------------------------------------------------------------------------------*/
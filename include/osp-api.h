@@ -210,6 +210,18 @@ typedef union {
     Android_RotationVectorResultData_t rotvec;
 } OSP_InputSensorData_t;
 
+//! Union structure to encapsulate the result types passed to the result ready callbacks.
+typedef union {
+    Android_TriAxisPreciseData_t q24data;
+    Android_TriAxisExtendedData_t q12data;
+    Android_UncalibratedTriAxisPreciseData_t uncal_q24data;
+    Android_UncalibratedTriAxisExtendedData_t uncal_q12data;
+    Android_OrientationResultData_t orientdata;
+    Android_BooleanResultData_t booldata;
+    Android_StepCounterResultData_t stepcount;
+    Android_RotationVectorResultData_t rotvec;
+} OSP_ResultData_t;
+
 //! callback type used when the library needs to do an atomic operation
 /*!
  *  This is absolutely necessary in systems that do background calibration.
@@ -344,6 +356,18 @@ typedef struct  {
     void* OptionData;                           //!<  used in conjunction with Flags
 } ResultDescriptor_t;
 
+//! one time stamped input sample for OSP_ProcessBlock()
+typedef struct  {
+    InputSensorHandle_t Handle;                 //!<  handle returned from OSP_RegisterInputSensor()
+    OSP_InputSensorData_t Data;                 //!<  sample, as passed to OSP_SetInputData()
+} OSP_InputSample_t;
+
+//! one result written by OSP_ProcessBlock()
+typedef struct  {
+    ASensorType_t SensorType;                   //!<  subscribed result type
+    OSP_ResultData_t Data;                      //!<  result, as passed to the result ready callback
+} OSP_ResultSample_t;
+
 
 
 
@@ -355,6 +379,26 @@ typedef struct  {
 } OSP_Library_Version_t;
 
 
+#ifdef OSP_CONTEXT_API
+//! one instance of the sensor hub library (embedded/common/app/osp-api.c)
+/*!
+ *  The caller owns the storage; the members are in osp-context.h only so that it
+ *  can be allocated. OSP_Initialize() sets it up.
+ */
+typedef struct _OSP_Context OSP_Context_t;
+
+//! calibrated sample of a base sensor (Accel/Mag/Gyro), as returned by OSP_GetLatestData()
+typedef struct  {
+    NTTIME TimeStamp;               //!< time stamp
+    uint8_t accuracy;               //!< QFIXEDPOINTPRECISE or QFIXEDPOINTEXTENDED, tells the data apart
+    union {
+        NTEXTENDED  extendedData[3];    //!< processed sensor data
+        NTPRECISE   preciseData[3];     //!< processed sensor data
+    } data;
+} Common_3AxisResult_t;
+#endif
+
+
 /*-------------------------------------------------------------------------------------------------*\
  |    E X T E R N A L   V A R I A B L E S   &   F U N C T I O N S
 \*-------------------------------------------------------------------------------------------------*/
@@ -366,6 +410,11 @@ typedef struct  {
 /*-------------------------------------------------------------------------------------------------*\
  |    A P I   F U N C T I O N   D E C L A R A T I O N S
 \*-------------------------------------------------------------------------------------------------*/
+/*
+ * The sensor hub library (embedded/common/app/osp-api.c) keeps its state in a caller-owned
+ * OSP_Context_t and is built with OSP_CONTEXT_API defined; its API follows the libOSP one below.
+ */
+#if !defined(OSP_CONTEXT_API)
 
 //! Call immediately at startup to initialize the Open-Sensor-Platform algorithm
 //! library and inform it of system characteristics
@@ -444,7 +493,7 @@ OSP_STATUS_t     OSP_ReplaceInputSensor(SensorDescriptor_t *pSensorDescriptor,
  *
  *  Queuing data for un-registered sensors (or as sensors that).
  *  Queue size defaults to 8, though is implementation dependent and available
- *  via SENSOR_FG_DATA_Q_SIZE.
+ *  via SENSOR_DATA_Q_SIZE.
  *
  *  \param sensorHandle INPUT requires a valid handle as returned by
  *      OSP_RegisterInputSensor()
@@ -492,6 +541,33 @@ OSP_STATUS_t     OSP_DoForegroundProcessing(void);
  */
 OSP_STATUS_t     OSP_DoBackgroundProcessing(void);
 
+//! feeds a block of recorded samples and collects the results in an array
+/*!
+ *  Equivalent to OSP_SetInputData() followed by OSP_DoForegroundProcessing()
+ *  for each sample in turn, and gives the same results, but they are written
+ *  to outputs[] in the order they are produced instead of going to the result
+ *  ready callbacks. Intended for reprocessing of logged sessions.
+ *
+ *  \note implemented by libOSP (algorithm/osp)
+ *  \note the samples are converted a chunk at a time. While only the inputs,
+ *      gravity, linear acceleration, step counter and significant motion are
+ *      subscribed, gravity and linear acceleration are filtered a chunk at a
+ *      time too; other results need a foreground pass per sample
+ *
+ *  \param inputs INPUT samples in time order, sensors interleaved
+ *  \param n INPUT number of samples
+ *  \param outputs OUTPUT results of all subscribed result types
+ *  \param maxOutputs INPUT size of outputs[]
+ *  \param pOutputCount OUTPUT number of results produced, results beyond
+ *      maxOutputs are dropped
+ *
+ *  \return OSP_STATUS_BUFFER_TOO_SMALL if results were dropped, else status
+ *      as specified in OSP_Types.h
+ */
+OSP_STATUS_t     OSP_ProcessBlock(const OSP_InputSample_t *inputs, uint32_t n,
+                    OSP_ResultSample_t *outputs, uint32_t maxOutputs,
+                    uint32_t *pOutputCount);
+
 //! call for each Open-Sensor-Platform result (STEP_COUNT, ROTATION_VECTOR, etc)
 //! you want computed and output
 /*!
@@ -562,6 +638,103 @@ OSP_STATUS_t     OSP_GetLibraryVersion(const OSP_Library_Version_t **ppVersionSt
  */
 OSP_STATUS_t    OSP_UpdateTime( uint64_t rawCounts );
 
+#else /* OSP_CONTEXT_API */
+
+//! initializes a library context; call before anything else on that context
+/*!
+ *  \param pCtx OUTPUT context to set up, owned by the caller
+ *  \param pSystemDesc INPUT time tick conversion and critical section callbacks,
+ *         must stay valid for the life of the context
+ *
+ *  \return status as specified in OSP_Types.h
+ */
+osp_status_t OSP_Initialize(OSP_Context_t *pCtx, const SystemDescriptor_t* pSystemDesc);
+
+//! registers an input sensor with a context, see the libOSP equivalent
+osp_status_t OSP_RegisterInputSensor(OSP_Context_t *pCtx, SensorDescriptor_t *pSensorDescriptor,
+    InputSensorHandle_t *pReturnedHandle);
+
+//! removes an input sensor from a context
+osp_status_t OSP_UnregisterInputSensor(OSP_Context_t *pCtx, InputSensorHandle_t sensorHandle);
+
+//! queues one raw sample for foreground and background processing
+osp_status_t OSP_SetData(OSP_Context_t *pCtx, InputSensorHandle_t sensorHandle, TriAxisSensorRawData_t *data);
+
+//! queues a burst of raw samples (e.g. a sensor hardware FIFO read) under one critical section
+/*!
+ *  Samples that do not fit without overrunning either consumer are not accepted,
+ *  nothing queued is overwritten. On a partial accept the caller still owns
+ *  samples[accepted..count-1] and may resubmit them after processing has drained
+ *  the queue, or drop them.
+ *
+ *  \param pCtx INPUT library context
+ *  \param sensorHandle INPUT handle returned by OSP_RegisterInputSensor()
+ *  \param samples INPUT time stamped raw samples, oldest first
+ *  \param count INPUT number of samples
+ *
+ *  \return number of samples accepted (leading part of the array), or a negative
+ *          status as specified in OSP_Types.h if the call is invalid
+ */
+int32_t OSP_SetDataBatch(OSP_Context_t *pCtx, InputSensorHandle_t sensorHandle, TriAxisSensorRawData_t samples[],
+    uint16_t count);
+
+//! runs the time critical algorithms on one queued sample
+osp_status_t OSP_DoForegroundProcessing(OSP_Context_t *pCtx);
+
+//! foreground processing of queued samples in batches, within a sample and CPU cycle budget
+/*!
+ *  \param pCtx INPUT library context
+ *  \param maxSamples INPUT maximum number of samples to process
+ *  \param maxCycles INPUT CPU cycle budget (DWT cycle counter), 0 for no limit; not
+ *         enforced on cores without a cycle counter
+ *
+ *  \return number of samples left in the queue (0 when idle), or a negative status
+ *          as specified in OSP_Types.h
+ */
+int32_t OSP_DoForegroundProcessingBudget(OSP_Context_t *pCtx, uint16_t maxSamples, uint32_t maxCycles);
+
+//! runs the calibration algorithms on one queued sample
+osp_status_t OSP_DoBackgroundProcessing(OSP_Context_t *pCtx);
+
+//! background processing of queued samples in batches, within a sample and CPU cycle budget
+/*!
+ *  \return number of samples left in the queue (0 when idle)
+ */
+int32_t OSP_DoBackgroundProcessingBudget(OSP_Context_t *pCtx, uint16_t maxSamples, uint32_t maxCycles);
+
+//! requests a result from a context, see the libOSP equivalent
+osp_status_t OSP_SubscribeOutputSensor(OSP_Context_t *pCtx, SensorDescriptor_t *pSensorDescriptor,
+    OutputSensorHandle_t *pOutputHandle);
+
+//! stops a result requested with OSP_SubscribeOutputSensor()
+osp_status_t OSP_UnsubscribeOutputSensor(OSP_Context_t *pCtx, OutputSensorHandle_t OutputHandle);
+
+//! version of the library; shared by all contexts
+osp_status_t OSP_GetVersion(const OSP_Library_Version_t **pVersionStruct);
+
+//! number of samples foreground and background processing each lost to a full input queue
+/*!
+ *  \param pFgOverruns OUTPUT samples lost to foreground processing, may be NULL
+ *  \param pBgOverruns OUTPUT samples lost to background processing, may be NULL
+ *
+ *  \return status as specified in OSP_Types.h
+ */
+osp_status_t OSP_GetInputQueueOverruns(OSP_Context_t *pCtx, uint32_t *pFgOverruns, uint32_t *pBgOverruns);
+
+//! latest calibrated sample of a base sensor, as last fed to the algorithms
+/*!
+ *  Takes no critical section and needs no subscription, so it may be called from
+ *  any task or interrupt handler.
+ *
+ *  \param SensorType INPUT accelerometer, magnetometer or gyroscope (uncalibrated)
+ *  \param pData OUTPUT latest sample
+ *
+ *  \return status as specified in OSP_Types.h, OSP_STATUS_IDLE if there is no sample yet
+ */
+osp_status_t OSP_GetLatestData(OSP_Context_t *pCtx, SensorType_t SensorType, Common_3AxisResult_t *pData);
+
+#endif /* OSP_CONTEXT_API */
+
 
 #ifdef __cplusplus
 }